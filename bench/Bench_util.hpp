@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+#include <cstddef>
+#include <cstdio>
+
+//host benchmarks, run as gtest cases next to the tests
+//they print their numbers and assert only that the work was done, build them with optimization
+
+//time iter calls of func after a short warm up, ns per call
+template<typename FUNC>
+double bench_ns_per_op(const size_t iter, FUNC&& func)
+{
+	for(size_t i = 0; i < (iter / 16); i++)
+	{
+		func(i);
+	}
+
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < iter; i++)
+	{
+		func(i);
+	}
+	const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(iter);
+}
+
+inline void bench_report(const char* const name, const double val, const char* const unit)
+{
+	printf("[ BENCH    ] %-60s %10.1f %s\n", name, val, unit);
+}
+
+//keeps a result alive so the measured work is not optimized away
+template<typename T>
+void bench_keep(const T& val)
+{
+	static volatile T sink;
+	sink = val;
+	(void)sink;
+}
+
+//wait policy for host threads, gives up the cpu instead of spinning
+template<size_t NUM_CH>
+class Bench_wait_yield
+{
+public:
+	void wait(const size_t ch)
+	{
+		std::this_thread::yield();
+	}
+	void notify(const size_t ch)
+	{
+
+	}
+	void notify_isr(const size_t ch)
+	{
+
+	}
+};
@@ -0,0 +1,128 @@
+#include "libusb_dev_cpp/class/hid/hid_usb.hpp"
+
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include "Fake_driver.hpp"
+#include "Bench_util.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+
+#include <cstdio>
+
+namespace
+{
+	typedef EP_buffer_mgr_lockfree<2, 2, 64, 4> Buffer_mgr;
+
+	//a HS bus clocked by the bench, one microframe per step
+	class Hs_fake_driver : public Fake_driver
+	{
+	public:
+		USB_common::USB_SPEED get_speed() const override {return USB_common::USB_SPEED::HS;}
+		uint16_t get_frame_number() override {return m_uframe;}
+
+		uint16_t m_uframe = 0;
+	};
+
+	class HID_class_bench : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			tx_mgr = std::make_unique<Buffer_mgr>();
+			driver.set_tx_buffer(tx_mgr.get());
+
+			ASSERT_TRUE(hid.initialize(&driver, 0, 0x81));
+			ASSERT_TRUE(hid.configure(8));
+		}
+
+		//bInterval = 1 on HS, the host polls the IN ep once per microframe after the app has run
+		//every period microframes the app calls send_report burst times
+		HID_class::Latency_stats run(const size_t num_uframe, const size_t period, const size_t burst)
+		{
+			hid.reset_latency_stats();
+
+			std::array<uint8_t, 8> report;
+			report.fill(0);
+
+			for(size_t i = 0; i < num_uframe; i++)
+			{
+				driver.m_uframe = uint16_t(i & 0x3FFF);
+
+				if((i % period) == 0)
+				{
+					for(size_t j = 0; j < burst; j++)
+					{
+						report[0] = uint8_t(i);
+						report[1] = uint8_t(j);
+						hid.send_report(report.data(), report.size());
+					}
+				}
+
+				if(driver.get_sent_count(1) != 0)
+				{
+					driver.complete_tx(1);
+				}
+
+				driver.m_acked[1].clear();
+			}
+
+			return hid.get_latency_stats();
+		}
+
+		void report(const char* const name, const HID_class::Latency_stats& stats)
+		{
+			char label[64];
+
+			snprintf(label, sizeof(label), "%s, mean", name);
+			bench_report(label, double(stats.sum) / double(stats.count), "uframe");
+			snprintf(label, sizeof(label), "%s, max", name);
+			bench_report(label, stats.max, "uframe");
+			snprintf(label, sizeof(label), "%s, dropped", name);
+			bench_report(label, stats.dropped, "");
+		}
+
+		std::unique_ptr<Buffer_mgr> tx_mgr;
+		Hs_fake_driver driver;
+		HID_class hid;
+	};
+
+	//microframes from send_report to the host ACK, 0 is the same 125us microframe
+	TEST_F(HID_class_bench, report_to_wire_latency)
+	{
+		constexpr size_t NUM_UFRAME = 80000;
+
+		//slower than the poll rate, each report leaves in the poll right after it
+		const HID_class::Latency_stats sparse = run(NUM_UFRAME, 8, 1);
+		report("1 report per 8 uframes", sparse);
+		EXPECT_EQ(sparse.count, NUM_UFRAME / 8);
+		EXPECT_EQ(sparse.max, 0);
+		EXPECT_EQ(sparse.dropped, 0U);
+
+		//at the poll rate
+		const HID_class::Latency_stats every = run(NUM_UFRAME, 1, 1);
+		report("1 report per uframe", every);
+		EXPECT_EQ(every.count, NUM_UFRAME);
+		EXPECT_EQ(every.max, 0);
+
+		//faster than the poll rate, the newest waits one poll behind the report in the fifo
+		//the first uframe loads one and drops 2, after that 3 of the 4 are dropped each uframe
+		const HID_class::Latency_stats burst = run(NUM_UFRAME, 1, 4);
+		report("4 reports per uframe", burst);
+		EXPECT_EQ(burst.max, 1);
+		EXPECT_EQ(burst.dropped, (NUM_UFRAME * 3) - 1);
+
+		//host cpu per report, send_report through the ACK callback
+		const double ns = bench_ns_per_op(1000000, [this](const size_t i)
+			{
+				const uint8_t data[8] = {uint8_t(i)};
+				hid.send_report(data, sizeof(data));
+				driver.complete_tx(1);
+				driver.m_acked[1].clear();
+			}
+		);
+		bench_report("send_report + ACK", ns, "ns");
+	}
+}
@@ -0,0 +1,194 @@
+#include "libusb_dev_cpp/core/usb_core.hpp"
+#include "libusb_dev_cpp/descriptor/Device_descriptor.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include "Fake_driver.hpp"
+#include "Bench_util.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <chrono>
+#include <memory>
+
+namespace
+{
+	typedef EP_buffer_mgr_lockfree<4, 4, 64, 4> Buffer_mgr;
+
+	//runs a setup packet from the raw 8 bytes to the response in m_tx_buffer, no event queue and no data stage
+	class Bench_core : public USB_core
+	{
+	public:
+		USB_common::USB_RESP decode_and_process(const Setup_packet::Setup_packet_array& pkt)
+		{
+			m_setup_packet.deserialize(pkt);
+			m_tx_buffer.reset();
+			return process_request(&m_setup_packet);
+		}
+
+		size_t get_response_size() const
+		{
+			return m_tx_buffer.size();
+		}
+
+		void set_configured(const uint8_t cfg)
+		{
+			m_configuration = cfg;
+		}
+	};
+
+	//counts the PHY clock gate calls the core makes on suspend and resume
+	class Bench_driver : public Fake_driver
+	{
+	public:
+		bool set_phy_clock_gate(const bool gate) override
+		{
+			m_gated = gate;
+			m_num_gate++;
+			return true;
+		}
+
+		bool m_gated = false;
+		size_t m_num_gate = 0;
+	};
+
+	class USB_core_bench : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			ep0_mgr = std::make_unique<Buffer_mgr>();
+			rx_mgr  = std::make_unique<Buffer_mgr>();
+			tx_mgr  = std::make_unique<Buffer_mgr>();
+			driver.set_ep0_buffer(ep0_mgr.get());
+			driver.set_rx_buffer(rx_mgr.get());
+			driver.set_tx_buffer(tx_mgr.get());
+
+			ASSERT_TRUE(core.initialize(&driver, 64, Buffer_adapter_tx(tx_mem.data(), tx_mem.size()), Buffer_adapter_rx(rx_mem.data(), rx_mem.size())));
+			core.poll_driver();
+		}
+
+		Bench_driver driver;
+		std::unique_ptr<Buffer_mgr> ep0_mgr;
+		std::unique_ptr<Buffer_mgr> rx_mgr;
+		std::unique_ptr<Buffer_mgr> tx_mgr;
+
+		std::array<uint8_t, 256> tx_mem;
+		std::array<uint8_t, 256> rx_mem;
+
+		Bench_core core;
+	};
+
+	struct Std_request_case
+	{
+		const char* name;
+		Setup_packet::Setup_packet_array pkt;
+		size_t response_len;
+	};
+
+	//decode to response for each standard request the dispatch table serves, on a configured device
+	TEST_F(USB_core_bench, std_request_decode_to_response)
+	{
+		constexpr size_t ITER = 2000000;
+
+		Device_descriptor dev;
+		dev.bcdUSB             = USB_common::build_bcd(2, 0, 0);
+		dev.bDeviceClass       = 0;
+		dev.bDeviceSubClass    = 0;
+		dev.bDeviceProtocol    = 0;
+		dev.bMaxPacketSize0    = 64;
+		dev.idVendor           = 0x1234;
+		dev.idProduct          = 0x5678;
+		dev.bcdDevice          = USB_common::build_bcd(1, 0, 0);
+		dev.iManufacturer      = 0;
+		dev.iProduct           = 0;
+		dev.iSerialNumber      = 0;
+		dev.bNumConfigurations = 1;
+
+		Descriptor_table table;
+		table.set_device_descriptor(dev, 0);
+		core.set_descriptor_table(&table);
+		core.set_configured(1);
+
+		const std::array<Std_request_case, 8> cases = {{
+			{"GET_STATUS(device)",         {0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00}, 2},
+			{"GET_DESCRIPTOR(device)",     {0x80, 0x06, 0x00, 0x01, 0x00, 0x00, 0x12, 0x00}, 18},
+			{"GET_CONFIGURATION",          {0x80, 0x08, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00}, 1},
+			{"GET_INTERFACE",              {0x81, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00}, 1},
+			{"SET_INTERFACE(alt 0)",       {0x01, 0x0B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 0},
+			{"GET_STATUS(ep)",             {0x82, 0x00, 0x00, 0x00, 0x81, 0x00, 0x02, 0x00}, 2},
+			{"CLEAR_FEATURE(ep halt)",     {0x02, 0x01, 0x00, 0x00, 0x81, 0x00, 0x00, 0x00}, 0},
+			{"SYNC_FRAME",                 {0x82, 0x0C, 0x00, 0x00, 0x81, 0x00, 0x02, 0x00}, 2}
+		}};
+
+		for(const Std_request_case& c : cases)
+		{
+			size_t num_ack = 0;
+			const double ns = bench_ns_per_op(ITER, [&](const size_t i)
+				{
+					num_ack += (core.decode_and_process(c.pkt) == USB_common::USB_RESP::ACK) ? 1 : 0;
+				}
+			);
+
+			bench_report(c.name, ns, "ns");
+
+			EXPECT_EQ(num_ack, ITER + (ITER / 16)) << c.name;
+			EXPECT_EQ(core.get_response_size(), c.response_len) << c.name;
+		}
+	}
+
+	//SUSPEND then WAKEUP through the event queue, with callbacks and PHY clock gating
+	//there is no loopback driver, the fake driver posts the events the way a driver isr does
+	TEST_F(USB_core_bench, suspend_resume_latency)
+	{
+		constexpr size_t ITER = 500000;
+
+		driver.post(USB_common::USB_EVENTS::RESET, 0);
+		driver.post(USB_common::USB_EVENTS::ENUM_DONE, 0);
+		while(core.poll_event_loop())
+		{
+
+		}
+
+		size_t num_suspend = 0;
+		size_t num_resume = 0;
+		core.set_suspend_callback([&num_suspend](void* ctx, const USB_core::LINK_STATE state){num_suspend++;}, nullptr);
+		core.set_resume_callback([&num_resume](void* ctx){num_resume++;}, nullptr);
+		core.set_clock_gating(true);
+
+		//the core reads a timestamp on every suspend and resume for Power_stats, keep that cost in the round trip
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		core.set_timestamp_callback(
+			[&t0](void* ctx)
+			{
+				return uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+			},
+			nullptr
+		);
+		core.reset_power_stats();
+
+		size_t num_safe = 0;
+		const double ns = bench_ns_per_op(ITER, [&](const size_t i)
+			{
+				driver.post(USB_common::USB_EVENTS::SUSPEND, 0);
+				core.poll_event_loop();
+				num_safe += core.is_safe_to_sleep() ? 1 : 0;
+
+				driver.post(USB_common::USB_EVENTS::WAKEUP, 0);
+				core.poll_event_loop();
+			}
+		);
+
+		//Power_stats keeps the worst case, on a shared host that is scheduler noise, so only the mean is reported
+		bench_report("suspend + resume round trip through the event queue", ns, "ns");
+
+		const size_t num_cycle = ITER + (ITER / 16);
+		EXPECT_EQ(num_suspend, num_cycle);
+		EXPECT_EQ(num_resume, num_cycle);
+		EXPECT_EQ(num_safe, num_cycle);
+		EXPECT_EQ(driver.m_num_gate, num_cycle * 2);
+		EXPECT_FALSE(driver.m_gated);
+		EXPECT_EQ(core.get_link_state(), USB_core::LINK_STATE::L0);
+		EXPECT_EQ(core.get_power_stats().entries[size_t(USB_core::LINK_STATE::L2)], num_cycle);
+	}
+}
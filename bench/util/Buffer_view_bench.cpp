@@ -0,0 +1,216 @@
+#include "libusb_dev_cpp/core/usb_core.hpp"
+#include "libusb_dev_cpp/descriptor/Configuration_descriptor.hpp"
+#include "libusb_dev_cpp/descriptor/Endpoint_descriptor.hpp"
+#include "libusb_dev_cpp/descriptor/Interface_descriptor.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include "Bench_util.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+
+//only uses api that predates Buffer_view, so the same file builds against the tree before user-045 for the before numbers
+namespace
+{
+	//just enough driver for ep0, the bench plays the isr
+	class Ep0_bench_driver : public usb_driver_base
+	{
+	public:
+		bool initialize() override {return true;}
+		void get_info() override {}
+		bool enable() override {return true;}
+		bool disable() override {return true;}
+		bool connect() override {return true;}
+		bool disconnect() override {return true;}
+		bool set_address(const uint8_t addr) override {return true;}
+		bool ep_config(const ep_cfg& ep) override {return true;}
+		bool ep_unconfig(const uint8_t ep) override {return true;}
+		bool ep_is_stalled(const uint8_t ep) override {return false;}
+		void ep_stall(const uint8_t ep) override {m_stalls++;}
+		void ep_unstall(const uint8_t ep) override {}
+		int ep_write(const uint8_t ep, const uint8_t* buf, const uint16_t len) override {return len;}
+		int ep_read(const uint8_t ep, uint8_t* const buf, const uint16_t max_len) override {return 0;}
+		uint16_t get_frame_number() override {return 0;}
+		size_t get_serial_number(uint8_t* const buf, const size_t maxlen) override {return 0;}
+		USB_common::USB_SPEED get_speed() const override {return USB_common::USB_SPEED::FS;}
+		void poll(const USB_common::Event_callback& func) override {}
+		const ep_cfg& get_ep0_config() const override {return m_ep0;}
+		bool get_rx_ep_config(const uint8_t addr, ep_cfg* const out_ep) override {return false;}
+		bool get_tx_ep_config(const uint8_t addr, ep_cfg* const out_ep) override {return false;}
+		void set_data0(const uint8_t ep) override {}
+		const Setup_packet::Setup_packet_array* get_last_setup_packet() const override {return &m_setup;}
+
+		Buffer_adapter_base* wait_rx_buffer(const uint8_t ep) override {return nullptr;}
+		void release_rx_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override {}
+		Buffer_adapter_base* wait_tx_buffer(const uint8_t ep) override {return nullptr;}
+		bool enqueue_tx_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override {return true;}
+
+		ep_cfg m_ep0;
+		Setup_packet::Setup_packet_array m_setup;
+		size_t m_stalls = 0;
+	};
+
+	class Ep0_bench_core : public USB_core
+	{
+	public:
+		void setup()
+		{
+			handle_ep0_setup(USB_common::USB_EVENTS::CTRL_SETUP_PHASE_DONE, 0);
+		}
+		void rx()
+		{
+			handle_ep0_rx(USB_common::USB_EVENTS::EP_RX, 0);
+		}
+	};
+
+	void init_config(Configuration_descriptor* const cfg)
+	{
+		cfg->bNumInterfaces      = 1;
+		cfg->bConfigurationValue = 1;
+		cfg->iConfiguration      = 0;
+		cfg->bmAttributes        = 0x80;
+		cfg->bMaxPower           = 50;
+		cfg->wTotalLength        = 9 + 9 + 7 + 7;
+	}
+
+	Interface_descriptor make_iface()
+	{
+		Interface_descriptor iface;
+		iface.bInterfaceNumber   = 0;
+		iface.bAlternateSetting  = 0;
+		iface.bNumEndpoints      = 2;
+		iface.bInterfaceClass    = 0xFF;
+		iface.bInterfaceSubClass = 0;
+		iface.bInterfaceProtocol = 0;
+		iface.iInterface         = 0;
+		return iface;
+	}
+
+	Endpoint_descriptor make_ep(const uint8_t addr)
+	{
+		Endpoint_descriptor ep;
+		ep.bEndpointAddress = addr;
+		ep.bmAttributes     = Endpoint_descriptor::build_bmAttributes(Endpoint_descriptor::ATTRIBUTE_TRANSFER::BULK);
+		ep.wMaxPacketSize   = 64;
+		ep.bInterval        = 0;
+		return ep;
+	}
+
+	//a config + iface + 2 ep block, the body of a GET_DESCRIPTOR(CONFIGURATION)
+	TEST(Buffer_view_bench, descriptor_serialize)
+	{
+		Configuration_descriptor cfg;
+		init_config(&cfg);
+		const Interface_descriptor iface   = make_iface();
+		const Endpoint_descriptor ep_in    = make_ep(0x81);
+		const Endpoint_descriptor ep_out   = make_ep(0x01);
+
+		std::array<uint8_t, 64> mem;
+		Buffer_adapter_tx out;
+
+		size_t total = 0;
+		const double ns = bench_ns_per_op(5000000, [&](const size_t i)
+			{
+				out.reset(mem.data(), mem.size());
+				cfg.serialize(&out);
+				iface.serialize(&out);
+				ep_in.serialize(&out);
+				ep_out.serialize(&out);
+				total += out.size();
+			}
+		);
+
+		bench_report("config + iface + 2 ep descriptors into a tx buffer", ns, "ns");
+		EXPECT_EQ(out.size(), 32U);
+		bench_keep(total);
+	}
+
+	//eg a reply built a byte at a time
+	TEST(Buffer_view_bench, single_byte_insert)
+	{
+		std::array<uint8_t, 64> mem;
+		Buffer_adapter_tx out;
+
+		size_t total = 0;
+		const double ns = bench_ns_per_op(5000000, [&](const size_t i)
+			{
+				out.reset(mem.data(), mem.size());
+				for(uint8_t j = 0; j < 32; j++)
+				{
+					out.insert(uint8_t(i + j));
+				}
+				total += out.size();
+			}
+		);
+
+		bench_report("32 single byte inserts into a tx buffer", ns, "ns");
+		EXPECT_EQ(out.size(), 32U);
+		bench_keep(total);
+	}
+
+	//a 4096 byte vendor OUT data stage in 64 byte packets through handle_ep0_rx
+	TEST(Buffer_view_bench, ep0_out_throughput)
+	{
+		constexpr size_t XFER_LEN = 4096;
+		constexpr size_t PKT_LEN  = 64;
+		constexpr size_t NUM_XFER = 20000;
+
+		typedef EP_buffer_mgr_lockfree<1, 4, PKT_LEN, 4> Ep0_mgr;
+		std::unique_ptr<Ep0_mgr> ep0_mgr = std::make_unique<Ep0_mgr>();
+
+		Ep0_bench_driver driver;
+		driver.m_ep0.num  = 0;
+		driver.m_ep0.size = PKT_LEN;
+		driver.m_ep0.type = usb_driver_base::EP_TYPE::CONTROL;
+		driver.set_ep0_buffer(ep0_mgr.get());
+
+		std::unique_ptr<std::array<uint8_t, XFER_LEN>> rx_mem = std::make_unique<std::array<uint8_t, XFER_LEN>>();
+		std::array<uint8_t, 64> tx_mem;
+		Buffer_adapter_tx tx;
+		tx.reset(tx_mem.data(), tx_mem.size());
+		Buffer_adapter_rx rx;
+		rx.reset(rx_mem->data(), rx_mem->size());
+
+		Ep0_bench_core core;
+		ASSERT_TRUE(core.initialize(&driver, PKT_LEN, tx, rx));
+
+		size_t num_done = 0;
+		core.register_request(Request_type::TYPE::VENDOR, Request_type::RECIPIENT::DEVICE, 0x01,
+			[&num_done](void* ctx, Setup_packet* const setup, Buffer_adapter_rx* const in, Buffer_adapter_tx* const out)
+			{
+				num_done += (in->size() == XFER_LEN) ? 1 : 0;
+				return USB_common::USB_RESP::ACK;
+			},
+			nullptr
+		);
+
+		const Setup_packet::Setup_packet_array setup = {0x40, 0x01, 0x00, 0x00, 0x00, 0x00, uint8_t(XFER_LEN & 0xFF), uint8_t(XFER_LEN >> 8)};
+
+		std::array<uint8_t, PKT_LEN> pkt;
+		pkt.fill(0xA5);
+
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		for(size_t i = 0; i < NUM_XFER; i++)
+		{
+			driver.m_setup = setup;
+			core.setup();
+			for(size_t p = 0; p < (XFER_LEN / PKT_LEN); p++)
+			{
+				Buffer_adapter_base* const buf = ep0_mgr->poll_allocate_buffer(0);
+				buf->reset();
+				buf->insert(pkt.data(), pkt.size());
+				ep0_mgr->poll_enqueue_buffer(0, buf);
+				core.rx();
+			}
+		}
+		const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+		const double sec = std::chrono::duration<double>(t1 - t0).count();
+		bench_report("ep0 OUT data stage, 4096 B in 64 B packets", double(NUM_XFER * XFER_LEN) / sec / 1e6, "MB/s");
+
+		EXPECT_EQ(num_done, NUM_XFER);
+		EXPECT_EQ(driver.m_stalls, 0U);
+	}
+}
@@ -0,0 +1,442 @@
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+#include "libusb_dev_cpp/util/Lockfree_index_stack.hpp"
+
+#include "Bench_util.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	//the shape of EP_buffer_mgr_freertos on a host, a locked free list for the Object_pool and a locked queue for the Queue_static_pod
+	template<size_t NUM_EP, size_t BUFFER_DEPTH, size_t BUFFER_LEN, size_t BUFFER_ALLIGN>
+	class Locked_buffer_mgr : public EP_buffer_mgr_base
+	{
+	public:
+
+		Locked_buffer_mgr()
+		{
+			for(size_t ep = 0; ep < NUM_EP; ep++)
+			{
+				m_active[ep] = nullptr;
+				for(Buffer_type& buf : m_storage[ep])
+				{
+					m_free[ep].push_back(&buf);
+				}
+			}
+		}
+
+		size_t get_num_ep() const override
+		{
+			return NUM_EP;
+		}
+		bool set_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			m_active[ep] = buf;
+			return true;
+		}
+		Buffer_adapter_base* get_buffer(const uint8_t ep) override
+		{
+			return m_active[ep];
+		}
+
+		Buffer_adapter_base* poll_allocate_buffer_isr(const uint8_t ep) override
+		{
+			return poll_allocate_buffer(ep);
+		}
+		Buffer_adapter_base* poll_allocate_buffer(const uint8_t ep) override
+		{
+			std::lock_guard<std::mutex> lock(m_pool_mutex[ep]);
+			if(m_free[ep].empty())
+			{
+				return nullptr;
+			}
+
+			Buffer_adapter_base* const buf = m_free[ep].back();
+			m_free[ep].pop_back();
+			return buf;
+		}
+		Buffer_adapter_base* wait_allocate_buffer(const uint8_t ep) override
+		{
+			Buffer_adapter_base* buf = nullptr;
+			while((buf = poll_allocate_buffer(ep)) == nullptr)
+			{
+				std::this_thread::yield();
+			}
+			return buf;
+		}
+
+		bool poll_enqueue_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			return poll_enqueue_buffer(ep, buf);
+		}
+		bool poll_enqueue_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			std::lock_guard<std::mutex> lock(m_queue_mutex[ep]);
+			if(m_queue[ep].size() >= BUFFER_DEPTH)
+			{
+				return false;
+			}
+
+			m_queue[ep].push_back(buf);
+			return true;
+		}
+
+		Buffer_adapter_base* poll_dequeue_buffer_isr(const uint8_t ep) override
+		{
+			return poll_dequeue_buffer(ep);
+		}
+		Buffer_adapter_base* poll_dequeue_buffer(const uint8_t ep) override
+		{
+			std::lock_guard<std::mutex> lock(m_queue_mutex[ep]);
+			if(m_queue[ep].empty())
+			{
+				return nullptr;
+			}
+
+			Buffer_adapter_base* const buf = m_queue[ep].front();
+			m_queue[ep].pop_front();
+			return buf;
+		}
+		Buffer_adapter_base* wait_dequeue_buffer(const uint8_t ep) override
+		{
+			Buffer_adapter_base* buf = nullptr;
+			while((buf = poll_dequeue_buffer(ep)) == nullptr)
+			{
+				std::this_thread::yield();
+			}
+			return buf;
+		}
+
+		void release_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			release_buffer(ep, buf);
+		}
+		void release_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			std::lock_guard<std::mutex> lock(m_pool_mutex[ep]);
+			m_free[ep].push_back(buf);
+		}
+
+	protected:
+
+		typedef EP_buffer_array<BUFFER_LEN, BUFFER_ALLIGN> Buffer_type;
+
+		std::array<std::array<Buffer_type, BUFFER_DEPTH>, NUM_EP> m_storage;
+		std::array<Buffer_adapter_base*, NUM_EP> m_active;
+
+		std::array<std::mutex, NUM_EP> m_pool_mutex;
+		std::array<std::vector<Buffer_adapter_base*>, NUM_EP> m_free;
+
+		std::array<std::mutex, NUM_EP> m_queue_mutex;
+		std::array<std::deque<Buffer_adapter_base*>, NUM_EP> m_queue;
+	};
+
+	//EP_buffer_mgr_lockfree before its per ep state was grouped on cache lines
+	//the same free stack and ring logic, each kind of state in a parallel array, so neighboring eps share lines
+	template<size_t NUM_EP, size_t BUFFER_DEPTH, size_t BUFFER_LEN, size_t BUFFER_ALLIGN>
+	class Packed_lockfree_mgr : public EP_buffer_mgr_base
+	{
+	public:
+
+		Packed_lockfree_mgr()
+		{
+			for(size_t ep = 0; ep < NUM_EP; ep++)
+			{
+				m_free[ep].fill();
+				m_active[ep].store(nullptr);
+				m_head[ep].store(0);
+				m_tail[ep].store(0);
+			}
+		}
+
+		size_t get_num_ep() const override
+		{
+			return NUM_EP;
+		}
+		bool set_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			m_active[ep] = buf;
+			return true;
+		}
+		Buffer_adapter_base* get_buffer(const uint8_t ep) override
+		{
+			return m_active[ep];
+		}
+
+		Buffer_adapter_base* poll_allocate_buffer_isr(const uint8_t ep) override
+		{
+			return poll_allocate_buffer(ep);
+		}
+		Buffer_adapter_base* poll_allocate_buffer(const uint8_t ep) override
+		{
+			uint16_t idx = 0;
+			if(!m_free[ep].pop(&idx))
+			{
+				return nullptr;
+			}
+
+			Buffer_type* const buf = &m_storage[ep][idx];
+			buf->reset();
+			return buf;
+		}
+		Buffer_adapter_base* wait_allocate_buffer(const uint8_t ep) override
+		{
+			Buffer_adapter_base* buf = nullptr;
+			while((buf = poll_allocate_buffer(ep)) == nullptr)
+			{
+				std::this_thread::yield();
+			}
+			return buf;
+		}
+
+		bool poll_enqueue_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			return poll_enqueue_buffer(ep, buf);
+		}
+		bool poll_enqueue_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			const size_t tail = m_tail[ep].load(std::memory_order_relaxed);
+			if((tail - m_head[ep].load(std::memory_order_acquire)) == BUFFER_DEPTH)
+			{
+				return false;
+			}
+
+			m_ring[ep][tail % BUFFER_DEPTH] = buf;
+			m_tail[ep].store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		Buffer_adapter_base* poll_dequeue_buffer_isr(const uint8_t ep) override
+		{
+			return poll_dequeue_buffer(ep);
+		}
+		Buffer_adapter_base* poll_dequeue_buffer(const uint8_t ep) override
+		{
+			const size_t head = m_head[ep].load(std::memory_order_relaxed);
+			if(head == m_tail[ep].load(std::memory_order_acquire))
+			{
+				return nullptr;
+			}
+
+			Buffer_adapter_base* const buf = m_ring[ep][head % BUFFER_DEPTH];
+			m_head[ep].store(head + 1, std::memory_order_release);
+			return buf;
+		}
+		Buffer_adapter_base* wait_dequeue_buffer(const uint8_t ep) override
+		{
+			Buffer_adapter_base* buf = nullptr;
+			while((buf = poll_dequeue_buffer(ep)) == nullptr)
+			{
+				std::this_thread::yield();
+			}
+			return buf;
+		}
+
+		void release_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			release_buffer(ep, buf);
+		}
+		void release_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+		{
+			const Buffer_type* const ptr = static_cast<const Buffer_type*>(buf);
+			m_free[ep].push(uint16_t(ptr - m_storage[ep].data()));
+		}
+
+	protected:
+
+		typedef EP_buffer_array<BUFFER_LEN, BUFFER_ALLIGN> Buffer_type;
+
+		std::array<Lockfree_index_stack<BUFFER_DEPTH>, NUM_EP> m_free;
+		std::array<std::atomic<Buffer_adapter_base*>, NUM_EP> m_active;
+		std::array<std::atomic<size_t>, NUM_EP> m_head;
+		std::array<std::atomic<size_t>, NUM_EP> m_tail;
+		std::array<std::array<Buffer_adapter_base*, BUFFER_DEPTH>, NUM_EP> m_ring;
+
+		std::array<std::array<Buffer_type, BUFFER_DEPTH>, NUM_EP> m_storage;
+	};
+
+	typedef EP_buffer_mgr_lockfree<1, 4, 64, 4, Bench_wait_yield> Lockfree_mgr;
+	typedef Locked_buffer_mgr<1, 4, 64, 4> Baseline_mgr;
+
+	//one buffer through alloc / enqueue / dequeue / release on one thread, through the base class like the driver and core
+	double single_thread_cycle(EP_buffer_mgr_base* const mgr, const size_t iter)
+	{
+		return bench_ns_per_op(iter, [mgr](const size_t i)
+			{
+				Buffer_adapter_base* const buf = mgr->poll_allocate_buffer(0);
+				buf->reset();
+				buf->insert(uint8_t(i));
+				mgr->poll_enqueue_buffer(0, buf);
+				Buffer_adapter_base* const out = mgr->poll_dequeue_buffer(0);
+				bench_keep(out->data()[0]);
+				mgr->release_buffer(0, out);
+			}
+		);
+	}
+
+	//a producer thread plays the driver isr and a consumer thread the app task, ns per buffer
+	double two_thread_stream(EP_buffer_mgr_base* const mgr, const size_t iter, size_t* const out_count)
+	{
+		size_t count = 0;
+
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+		std::thread producer([mgr, iter]()
+			{
+				for(size_t i = 0; i < iter; i++)
+				{
+					Buffer_adapter_base* const buf = mgr->wait_allocate_buffer(0);
+					buf->reset();
+					buf->insert(uint8_t(i));
+					while(!mgr->poll_enqueue_buffer(0, buf))
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+		);
+
+		std::thread consumer([mgr, iter, &count]()
+			{
+				for(size_t i = 0; i < iter; i++)
+				{
+					Buffer_adapter_base* const buf = mgr->wait_dequeue_buffer(0);
+					if(buf->data()[0] == uint8_t(i))
+					{
+						count++;
+					}
+					mgr->release_buffer(0, buf);
+				}
+			}
+		);
+
+		producer.join();
+		consumer.join();
+
+		const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+		*out_count = count;
+		return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(iter);
+	}
+
+	TEST(EP_buffer_mgr_bench, single_thread_cycle)
+	{
+		constexpr size_t ITER = 2000000;
+
+		std::unique_ptr<Lockfree_mgr> lockfree = std::make_unique<Lockfree_mgr>();
+		std::unique_ptr<Baseline_mgr> baseline = std::make_unique<Baseline_mgr>();
+
+		bench_report("alloc/enqueue/dequeue/release, EP_buffer_mgr_lockfree", single_thread_cycle(lockfree.get(), ITER), "ns");
+		bench_report("alloc/enqueue/dequeue/release, mutex + deque baseline", single_thread_cycle(baseline.get(), ITER), "ns");
+
+		//every buffer came back
+		for(size_t i = 0; i < 4; i++)
+		{
+			EXPECT_NE(lockfree->poll_allocate_buffer(0), nullptr);
+			EXPECT_NE(baseline->poll_allocate_buffer(0), nullptr);
+		}
+	}
+
+	TEST(EP_buffer_mgr_bench, two_thread_stream)
+	{
+		constexpr size_t ITER = 200000;
+
+		std::unique_ptr<Lockfree_mgr> lockfree = std::make_unique<Lockfree_mgr>();
+		std::unique_ptr<Baseline_mgr> baseline = std::make_unique<Baseline_mgr>();
+
+		size_t count = 0;
+		bench_report("producer + consumer thread, EP_buffer_mgr_lockfree", two_thread_stream(lockfree.get(), ITER, &count), "ns/buffer");
+		EXPECT_EQ(count, ITER);
+
+		bench_report("producer + consumer thread, mutex + deque baseline", two_thread_stream(baseline.get(), ITER, &count), "ns/buffer");
+		EXPECT_EQ(count, ITER);
+	}
+
+	//per ep a producer thread plays the driver isr and a consumer thread the app task, all eps at once
+	//ns per buffer round trip over all eps, and the bytes the layout costs
+	template<typename MGR>
+	double per_ep_threads(MGR* const mgr, const size_t num_ep, const size_t iter, size_t* const out_count)
+	{
+		std::atomic<size_t> count(0);
+
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+		std::vector<std::thread> threads;
+		for(uint8_t ep = 0; ep < num_ep; ep++)
+		{
+			threads.emplace_back([mgr, ep, iter]()
+				{
+					for(size_t i = 0; i < iter; i++)
+					{
+						Buffer_adapter_base* const buf = mgr->wait_allocate_buffer(ep);
+						buf->insert(uint8_t(i));
+						mgr->set_buffer(ep, buf);
+						while(!mgr->poll_enqueue_buffer(ep, buf))
+						{
+							std::this_thread::yield();
+						}
+					}
+				}
+			);
+			threads.emplace_back([mgr, ep, iter, &count]()
+				{
+					size_t ok = 0;
+					for(size_t i = 0; i < iter; i++)
+					{
+						Buffer_adapter_base* const buf = mgr->wait_dequeue_buffer(ep);
+						bench_keep(mgr->get_buffer(ep));
+						if(buf->data()[0] == uint8_t(i))
+						{
+							ok++;
+						}
+						mgr->release_buffer(ep, buf);
+					}
+					count += ok;
+				}
+			);
+		}
+
+		for(std::thread& t : threads)
+		{
+			t.join();
+		}
+
+		const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+		*out_count = count;
+		return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(iter * num_ep);
+	}
+
+	//false sharing only shows with the threads on different cores, on one core both layouts run the same
+	TEST(EP_buffer_mgr_bench, per_ep_threads)
+	{
+		constexpr size_t NUM_EP = 4;
+		constexpr size_t ITER   = 200000;
+
+		typedef EP_buffer_mgr_lockfree<NUM_EP, 8, 64, 32, Bench_wait_yield> Grouped_mgr;
+		typedef Packed_lockfree_mgr<NUM_EP, 8, 64, 32> Packed_mgr;
+
+		std::unique_ptr<Grouped_mgr> grouped = std::make_unique<Grouped_mgr>();
+		std::unique_ptr<Packed_mgr> packed = std::make_unique<Packed_mgr>();
+
+		printf("[ BENCH    ] %zu eps, %zu threads on %u hardware threads, CACHE_LINE_SIZE %zu\n", NUM_EP, 2 * NUM_EP, std::thread::hardware_concurrency(), CACHE_LINE_SIZE);
+
+		size_t count = 0;
+		bench_report("per ep producer + consumer, ep state on its own lines", per_ep_threads(grouped.get(), NUM_EP, ITER, &count), "ns/buffer");
+		EXPECT_EQ(count, NUM_EP * ITER);
+
+		bench_report("per ep producer + consumer, parallel arrays", per_ep_threads(packed.get(), NUM_EP, ITER, &count), "ns/buffer");
+		EXPECT_EQ(count, NUM_EP * ITER);
+
+		bench_report("sizeof, ep state on its own lines", double(sizeof(Grouped_mgr)), "bytes");
+		bench_report("sizeof, parallel arrays", double(sizeof(Packed_mgr)), "bytes");
+	}
+}
@@ -0,0 +1,123 @@
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_slab.hpp"
+
+#include "Bench_util.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+
+namespace
+{
+	//one stream of the mixed workload, in_flight transfers of len bytes queued on ep at once
+	struct Mixed_stream
+	{
+		uint8_t ep;
+		size_t len;
+		size_t in_flight;
+	};
+
+	//8 byte interrupt reports, 512 byte HS bulk packets, and a 4096 byte multi packet transfer
+	constexpr std::array<Mixed_stream, 3> MIXED_WORKLOAD = {{
+		{0, 8,    8},
+		{1, 512,  4},
+		{2, 4096, 1}
+	}};
+
+	struct Mixed_result
+	{
+		size_t payload = 0;
+		size_t held    = 0;
+		size_t failed  = 0;
+	};
+
+	//queue every stream's transfers, then drain them
+	//a transfer larger than a buffer is split over several, payload / held is the share of the held buffers carrying data
+	template<typename ALLOC>
+	Mixed_result mixed_round(EP_buffer_mgr_base* const mgr, ALLOC&& alloc)
+	{
+		Mixed_result res;
+
+		for(const Mixed_stream& s : MIXED_WORKLOAD)
+		{
+			for(size_t i = 0; i < s.in_flight; i++)
+			{
+				size_t rem = s.len;
+				while(rem > 0)
+				{
+					Buffer_adapter_base* const buf = alloc(s.ep, rem);
+					if(!buf)
+					{
+						res.failed++;
+						break;
+					}
+
+					const size_t n = std::min(rem, buf->max_size());
+					buf->resize(n);
+					buf->data()[0] = uint8_t(i);
+					res.payload += n;
+					res.held    += buf->max_size();
+					rem         -= n;
+
+					mgr->poll_enqueue_buffer(s.ep, buf);
+				}
+			}
+		}
+
+		for(const Mixed_stream& s : MIXED_WORKLOAD)
+		{
+			for(Buffer_adapter_base* buf = mgr->poll_dequeue_buffer(s.ep); buf; buf = mgr->poll_dequeue_buffer(s.ep))
+			{
+				mgr->release_buffer(s.ep, buf);
+			}
+		}
+
+		return res;
+	}
+
+	//the slab sizes to the workload, the fixed manager needs 512 B buffers for the bulk ep and 8 of them per ep for the 4096 B transfer
+	typedef EP_buffer_mgr_lockfree<3, 8, 512, 4> Fixed_mgr;
+	typedef EP_buffer_mgr_slab<3, 4, EP_buffer_wait_spin, Slab_class<64, 8>, Slab_class<512, 4>, Slab_class<4096, 1>> Slab_mgr;
+
+	constexpr size_t FIXED_STORAGE = 3 * 8 * 512;
+	constexpr size_t SLAB_STORAGE  = (64 * 8) + (512 * 4) + (4096 * 1);
+
+	TEST(EP_buffer_mgr_slab_bench, mixed_workload)
+	{
+		constexpr size_t ITER = 200000;
+
+		std::unique_ptr<Fixed_mgr> fixed = std::make_unique<Fixed_mgr>();
+		std::unique_ptr<Slab_mgr> slab   = std::make_unique<Slab_mgr>();
+
+		Mixed_result fixed_res;
+		const double fixed_ns = bench_ns_per_op(ITER, [&](const size_t i)
+			{
+				fixed_res = mixed_round(fixed.get(), [&fixed](const uint8_t ep, const size_t len){return fixed->poll_allocate_buffer(ep);});
+			}
+		);
+
+		Mixed_result slab_res;
+		const double slab_ns = bench_ns_per_op(ITER, [&](const size_t i)
+			{
+				slab_res = mixed_round(slab.get(), [&slab](const uint8_t ep, const size_t len){return slab->poll_allocate_buffer(ep, len);});
+			}
+		);
+
+		bench_report("buffer storage, EP_buffer_mgr_lockfree 3 ep x 8 x 512", FIXED_STORAGE, "B");
+		bench_report("buffer storage, EP_buffer_mgr_slab 64x8 + 512x4 + 4096x1", SLAB_STORAGE, "B");
+		bench_report("sizeof, EP_buffer_mgr_lockfree", sizeof(Fixed_mgr), "B");
+		bench_report("sizeof, EP_buffer_mgr_slab", sizeof(Slab_mgr), "B");
+		bench_report("payload per byte held, EP_buffer_mgr_lockfree", 100.0 * double(fixed_res.payload) / double(fixed_res.held), "%");
+		bench_report("payload per byte held, EP_buffer_mgr_slab", 100.0 * double(slab_res.payload) / double(slab_res.held), "%");
+		bench_report("mixed round, EP_buffer_mgr_lockfree", fixed_ns, "ns");
+		bench_report("mixed round, EP_buffer_mgr_slab", slab_ns, "ns");
+
+		//both carry the whole workload, 8 x 8 + 4 x 512 + 4096
+		EXPECT_EQ(fixed_res.failed, 0U);
+		EXPECT_EQ(slab_res.failed, 0U);
+		EXPECT_EQ(fixed_res.payload, 6208U);
+		EXPECT_EQ(slab_res.payload, 6208U);
+	}
+}
@@ -0,0 +1,224 @@
+#include "libusb_dev_cpp/util/Descriptor_table.hpp"
+
+#include "Bench_util.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+#include <new>
+
+#include <cstdlib>
+
+//counts heap use while g_count_heap is set, this replaces the global operator new for the whole bench binary
+namespace
+{
+	bool g_count_heap = false;
+	size_t g_heap_bytes = 0;
+	size_t g_heap_allocs = 0;
+}
+
+void* operator new(const size_t len)
+{
+	if(g_count_heap)
+	{
+		g_heap_bytes += len;
+		g_heap_allocs++;
+	}
+
+	void* const ptr = malloc((len != 0) ? len : 1);
+	if(!ptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return ptr;
+}
+//out of line, so gcc does not see free paired with operator new at the inlined call sites
+__attribute__((noinline)) void operator delete(void* const ptr) noexcept
+{
+	free(ptr);
+}
+__attribute__((noinline)) void operator delete(void* const ptr, const size_t len) noexcept
+{
+	free(ptr);
+}
+
+namespace
+{
+	//a device, one 3 iface / 5 ep configuration, and 4 strings
+	class Flat_bench_descriptors
+	{
+	public:
+		Flat_bench_descriptors()
+		{
+			for(Interface_descriptor& iface : m_iface)
+			{
+				iface.bInterfaceNumber   = 0;
+				iface.bAlternateSetting  = 0;
+				iface.bNumEndpoints      = 0;
+				iface.bInterfaceClass    = 0;
+				iface.bInterfaceSubClass = 0;
+				iface.bInterfaceProtocol = 0;
+				iface.iInterface         = 0;
+			}
+			for(Endpoint_descriptor& ep : m_ep)
+			{
+				ep.bEndpointAddress = 0x81;
+				ep.bmAttributes     = Endpoint_descriptor::build_bmAttributes(Endpoint_descriptor::ATTRIBUTE_TRANSFER::BULK);
+				ep.set_speed_params(64, 0, 512, 0);
+			}
+		}
+
+		void fill(Descriptor_table* const table)
+		{
+			Device_descriptor dev;
+			dev.bcdUSB             = USB_common::build_bcd(2, 0, 0);
+			dev.bDeviceClass       = 0;
+			dev.bDeviceSubClass    = 0;
+			dev.bDeviceProtocol    = 0;
+			dev.bMaxPacketSize0    = 64;
+			dev.idVendor           = 0x1234;
+			dev.idProduct          = 0x5678;
+			dev.bcdDevice          = USB_common::build_bcd(1, 0, 0);
+			dev.iManufacturer      = 1;
+			dev.iProduct           = 2;
+			dev.iSerialNumber      = 3;
+			dev.bNumConfigurations = 1;
+			table->set_device_descriptor(dev, 0);
+
+			std::shared_ptr<Configuration_descriptor> cfg = std::make_shared<Configuration_descriptor>();
+			cfg->bNumInterfaces      = 3;
+			cfg->bConfigurationValue = 1;
+			cfg->iConfiguration      = 0;
+			cfg->bmAttributes        = 0x80;
+			cfg->bMaxPower           = 50;
+			for(Interface_descriptor& iface : m_iface)
+			{
+				cfg->get_desc_list().push_back(&iface);
+			}
+			for(Endpoint_descriptor& ep : m_ep)
+			{
+				cfg->get_desc_list().push_back(&ep);
+			}
+			cfg->wTotalLength = cfg->get_total_size();
+			table->set_config_descriptor(cfg, 0);
+
+			const std::array<const char*, 4> strings = {"Suburban Embedded", "Test device", "0123456789AB", "CDC"};
+			for(size_t i = 0; i < strings.size(); i++)
+			{
+				String_descriptor_base str;
+				str.assign(strings[i]);
+				table->set_string_descriptor(str, String_descriptor_zero::LANGID::ENUS, uint8_t(i + 1));
+			}
+		}
+
+	protected:
+		std::array<Interface_descriptor, 3> m_iface;
+		std::array<Endpoint_descriptor, 5> m_ep;
+	};
+
+	TEST(Flat_desc_table_bench, heap_bytes)
+	{
+		Flat_bench_descriptors desc;
+
+		g_heap_bytes  = 0;
+		g_heap_allocs = 0;
+		g_count_heap  = true;
+
+		//the table object itself is counted with its map and shared_ptr nodes
+		std::unique_ptr<Descriptor_table> table = std::make_unique<Descriptor_table>();
+		desc.fill(table.get());
+
+		const size_t obj_bytes  = g_heap_bytes;
+		const size_t obj_allocs = g_heap_allocs;
+
+		g_heap_bytes  = 0;
+		g_heap_allocs = 0;
+
+		ASSERT_TRUE(table->build_flat_table());
+
+		g_count_heap = false;
+
+		bench_report("object tables, heap bytes", obj_bytes, "B");
+		bench_report("object tables, allocations", obj_allocs, "");
+		bench_report("flat table, heap bytes held", table->get_flat_table().get_heap_size(), "B");
+		bench_report("flat table, allocations during build", g_heap_allocs, "");
+
+		EXPECT_LT(table->get_flat_table().get_heap_size(), obj_bytes);
+	}
+
+	TEST(Flat_desc_table_bench, lookup)
+	{
+		constexpr size_t ITER = 2000000;
+
+		Flat_bench_descriptors desc;
+		Descriptor_table table;
+		desc.fill(&table);
+		ASSERT_TRUE(table.build_flat_table());
+
+		const Flat_desc_table& flat = table.get_flat_table();
+
+		std::array<uint8_t, 512> mem;
+		Buffer_adapter_tx tx;
+
+		//string, map + shared_ptr lookup then serialize vs a flat lookup then copy
+		size_t obj_str_len = 0;
+		const double obj_str_ns = bench_ns_per_op(ITER, [&](const size_t i)
+			{
+				String_desc_table::String_desc_ptr str = table.get_string_descriptor(String_descriptor_zero::LANGID::ENUS, uint8_t((i & 3) + 1));
+				tx.reset(mem.data(), mem.size());
+				str->serialize(&tx);
+				obj_str_len += tx.size();
+			}
+		);
+
+		size_t flat_str_len = 0;
+		const double flat_str_ns = bench_ns_per_op(ITER, [&](const size_t i)
+			{
+				const uint8_t* ptr = nullptr;
+				size_t len = 0;
+				flat.find(uint8_t(USB_common::DESCRIPTOR_TYPE::STRING), uint8_t((i & 3) + 1), uint16_t(String_descriptor_zero::LANGID::ENUS), &ptr, &len);
+				tx.reset(mem.data(), mem.size());
+				tx.insert(ptr, len);
+				flat_str_len += tx.size();
+			}
+		);
+
+		//configuration with its children at HS
+		size_t obj_cfg_len = 0;
+		const double obj_cfg_ns = bench_ns_per_op(ITER / 10, [&](const size_t i)
+			{
+				Config_desc_table::Config_desc_ptr cfg = table.get_config_descriptor(0);
+				tx.reset(mem.data(), mem.size());
+				cfg->serialize(&tx);
+				for(const Descriptor_base* node = cfg->get_desc_list().front<Descriptor_base>(); node; node = node->next<Descriptor_base>())
+				{
+					node->serialize_for_speed(&tx, USB_common::USB_SPEED::HS);
+				}
+				obj_cfg_len += tx.size();
+			}
+		);
+
+		size_t flat_cfg_len = 0;
+		const double flat_cfg_ns = bench_ns_per_op(ITER / 10, [&](const size_t i)
+			{
+				const uint8_t* ptr = nullptr;
+				size_t len = 0;
+				flat.find(uint8_t(USB_common::DESCRIPTOR_TYPE::CONFIGURATION), 0, uint16_t(USB_common::USB_SPEED::HS), &ptr, &len);
+				tx.reset(mem.data(), mem.size());
+				tx.insert(ptr, len);
+				flat_cfg_len += tx.size();
+			}
+		);
+
+		bench_report("string lookup + copy, map + shared_ptr", obj_str_ns, "ns");
+		bench_report("string lookup + copy, Flat_desc_table", flat_str_ns, "ns");
+		bench_report("configuration lookup + copy, objects", obj_cfg_ns, "ns");
+		bench_report("configuration lookup + copy, Flat_desc_table", flat_cfg_ns, "ns");
+
+		//both paths sent the same bytes
+		EXPECT_EQ(obj_str_len, flat_str_len);
+		EXPECT_EQ(obj_cfg_len, flat_cfg_len);
+	}
+}
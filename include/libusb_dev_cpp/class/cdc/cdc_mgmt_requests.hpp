@@ -89,7 +89,7 @@ public:
 	bool serialize(Buffer_adapter_tx* const out_array) const;
 
 	bool deserialize(const Line_coding_array& array);
-	bool deserialize(const Buffer_adapter_base* buf);
+	bool deserialize(const Buffer_adapter_rx* buf);
 };
 
 class SET_LINE_CODING
@@ -48,7 +48,8 @@ public:
 	}
 
 
-	bool serialize(Buffer_adapter_base* const out_array) const
+	template <typename POLICY>
+	bool serialize(Buffer_view_T<uint8_t, POLICY>* const out_array) const
 	{
 		out_array->reset();
 
@@ -133,7 +134,8 @@ public:
 		bmUartState = Byte_util::set_bv_16(bmUartState, set, 0);
 	}
 
-	bool serialize(Buffer_adapter_base* const out_array) const
+	template <typename POLICY>
+	bool serialize(Buffer_view_T<uint8_t, POLICY>* const out_array) const
 	{
 		out_array->reset();
 
@@ -148,7 +150,8 @@ public:
 		return true;
 	}
 
-	bool deserialize(const Buffer_adapter_base* buf)
+	template <typename POLICY>
+	bool deserialize(const Buffer_view_T<uint8_t, POLICY>* buf)
 	{
 		if(buf->size() != 2)
 		{
@@ -178,7 +181,8 @@ public:
 	uint32_t DLBitRate;
 	uint32_t ULBitRate;
 
-	bool serialize(Buffer_adapter_base* const out_array) const
+	template <typename POLICY>
+	bool serialize(Buffer_view_T<uint8_t, POLICY>* const out_array) const
 	{
 		out_array->reset();
 
@@ -200,9 +204,10 @@ public:
 		return true;
 	}
 
-	bool deserialize(const Buffer_adapter_base* buf)
+	template <typename POLICY>
+	bool deserialize(const Buffer_view_T<uint8_t, POLICY>* buf)
 	{
-		if(buf->size() != 2)
+		if(buf->size() != 8)
 		{
 			return false;
 		}
@@ -226,7 +231,8 @@ class ResponseAvailable
 		m_notify_packet.wLength = 0;
 	}
 
-	bool serialize(Buffer_adapter_base* const out_array) const
+	template <typename POLICY>
+	bool serialize(Buffer_view_T<uint8_t, POLICY>* const out_array) const
 	{
 		out_array->reset();
 
@@ -0,0 +1,58 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace HID
+{
+	constexpr static uint8_t HID_INTERFACE_CLASS_CODE = 0x03;
+
+	enum class HID_INTERFACE_SUBCLASS_CODE : uint8_t
+	{
+		NONE = 0x00,
+		BOOT = 0x01
+	};
+
+	enum class HID_INTERFACE_PROTO_CODE : uint8_t
+	{
+		NONE     = 0x00,
+		KEYBOARD = 0x01,
+		MOUSE    = 0x02
+	};
+
+	enum class DESCRIPTOR_TYPE : uint8_t
+	{
+		HID      = 0x21,
+		REPORT   = 0x22,
+		PHYSICAL = 0x23
+	};
+
+	enum class HID_REQUESTS : uint8_t
+	{
+		GET_REPORT   = 0x01,
+		GET_IDLE     = 0x02,
+		GET_PROTOCOL = 0x03,
+		SET_REPORT   = 0x09,
+		SET_IDLE     = 0x0A,
+		SET_PROTOCOL = 0x0B
+	};
+
+	enum class REPORT_TYPE : uint8_t
+	{
+		INPUT   = 0x01,
+		OUTPUT  = 0x02,
+		FEATURE = 0x03
+	};
+
+	enum class PROTOCOL : uint8_t
+	{
+		BOOT   = 0x00,
+		REPORT = 0x01
+	};
+}
@@ -0,0 +1,52 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/class/hid/hid.hpp"
+
+#include "libusb_dev_cpp/descriptor/Descriptor_base.hpp"
+
+#include <array>
+#include <tuple>
+
+namespace HID
+{
+
+//HID class descriptor, placed after the HID interface descriptor and before its endpoints
+//we only support a single report descriptor per interface
+class HID_descriptor : public Descriptor_base
+{
+public:
+	HID_descriptor()
+	{
+		bcdHID            = 0x0111;
+		bCountryCode      = 0;
+		wDescriptorLength = 0;
+	}
+
+	typedef std::array<uint8_t, 9> HID_descriptor_array;
+
+	bool serialize(HID_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	constexpr static uint8_t bLength = 9;
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(DESCRIPTOR_TYPE::HID);
+	uint16_t bcdHID;
+	uint8_t  bCountryCode;
+	constexpr static uint8_t bNumDescriptors = 1;
+	constexpr static uint8_t bReportDescriptorType = static_cast<uint8_t>(DESCRIPTOR_TYPE::REPORT);
+	uint16_t wDescriptorLength;
+
+	static_assert(std::tuple_size<HID_descriptor_array>::value == bLength);
+};
+
+}
@@ -0,0 +1,243 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <array>
+
+#include <cstdint>
+#include <cstddef>
+
+//compile time HID report descriptor builder
+//items are encoded as short items with the smallest data field that holds the value
+//
+//typedef HID::Report::Report_descriptor<
+//	HID::Report::Usage_page<HID::Report::USAGE_PAGE::GENERIC_DESKTOP>,
+//	HID::Report::Usage<0x02>,
+//	HID::Report::Collection<HID::Report::COLLECTION::APPLICATION>,
+//		...
+//	HID::Report::End_collection
+//	> Mouse_report_desc;
+//
+//Mouse_report_desc::data is a constexpr std::array<uint8_t, N> ready to hand to HID_class
+namespace HID
+{
+namespace Report
+{
+	enum class ITEM_TYPE : uint8_t
+	{
+		MAIN     = 0x00,
+		GLOBAL   = 0x01,
+		LOCAL    = 0x02,
+		RESERVED = 0x03
+	};
+
+	enum class MAIN_TAG : uint8_t
+	{
+		INPUT          = 0x08,
+		OUTPUT         = 0x09,
+		COLLECTION     = 0x0A,
+		FEATURE        = 0x0B,
+		END_COLLECTION = 0x0C
+	};
+
+	enum class GLOBAL_TAG : uint8_t
+	{
+		USAGE_PAGE       = 0x00,
+		LOGICAL_MINIMUM  = 0x01,
+		LOGICAL_MAXIMUM  = 0x02,
+		PHYSICAL_MINIMUM = 0x03,
+		PHYSICAL_MAXIMUM = 0x04,
+		UNIT_EXPONENT    = 0x05,
+		UNIT             = 0x06,
+		REPORT_SIZE      = 0x07,
+		REPORT_ID        = 0x08,
+		REPORT_COUNT     = 0x09,
+		PUSH             = 0x0A,
+		POP              = 0x0B
+	};
+
+	enum class LOCAL_TAG : uint8_t
+	{
+		USAGE         = 0x00,
+		USAGE_MINIMUM = 0x01,
+		USAGE_MAXIMUM = 0x02
+	};
+
+	//usage pages are open ended, so these are plain values and not an enum class
+	namespace USAGE_PAGE
+	{
+		constexpr uint16_t GENERIC_DESKTOP = 0x0001;
+		constexpr uint16_t SIMULATION      = 0x0002;
+		constexpr uint16_t KEYBOARD        = 0x0007;
+		constexpr uint16_t LED             = 0x0008;
+		constexpr uint16_t BUTTON          = 0x0009;
+		constexpr uint16_t CONSUMER        = 0x000C;
+		constexpr uint16_t VENDOR          = 0xFF00;
+	}
+
+	namespace COLLECTION
+	{
+		constexpr uint8_t PHYSICAL       = 0x00;
+		constexpr uint8_t APPLICATION    = 0x01;
+		constexpr uint8_t LOGICAL        = 0x02;
+		constexpr uint8_t REPORT         = 0x03;
+		constexpr uint8_t NAMED_ARRAY    = 0x04;
+		constexpr uint8_t USAGE_SWITCH   = 0x05;
+		constexpr uint8_t USAGE_MODIFIER = 0x06;
+	}
+
+	//flags for Input, Output, and Feature items, OR them together
+	namespace MAIN_FLAGS
+	{
+		constexpr uint32_t DATA           = 0x000;
+		constexpr uint32_t CONSTANT       = 0x001;
+		constexpr uint32_t ARRAY          = 0x000;
+		constexpr uint32_t VARIABLE       = 0x002;
+		constexpr uint32_t ABSOLUTE       = 0x000;
+		constexpr uint32_t RELATIVE       = 0x004;
+		constexpr uint32_t NO_WRAP        = 0x000;
+		constexpr uint32_t WRAP           = 0x008;
+		constexpr uint32_t LINEAR         = 0x000;
+		constexpr uint32_t NON_LINEAR     = 0x010;
+		constexpr uint32_t PREFERRED      = 0x000;
+		constexpr uint32_t NO_PREFERRED   = 0x020;
+		constexpr uint32_t NO_NULL        = 0x000;
+		constexpr uint32_t NULL_STATE     = 0x040;
+		constexpr uint32_t NON_VOLATILE   = 0x000;
+		constexpr uint32_t VOLATILE       = 0x080;
+		constexpr uint32_t BIT_FIELD      = 0x000;
+		constexpr uint32_t BUFFERED_BYTES = 0x100;
+	}
+
+	constexpr size_t get_unsigned_data_len(const uint32_t val)
+	{
+		if(val <= 0xFFU)
+		{
+			return 1;
+		}
+		else if(val <= 0xFFFFU)
+		{
+			return 2;
+		}
+
+		return 4;
+	}
+
+	constexpr size_t get_signed_data_len(const int32_t val)
+	{
+		if((val >= -128) && (val <= 127))
+		{
+			return 1;
+		}
+		else if((val >= -32768) && (val <= 32767))
+		{
+			return 2;
+		}
+
+		return 4;
+	}
+
+	//bSize field of the item prefix, 4 bytes is coded as 3
+	constexpr uint8_t get_size_code(const size_t len)
+	{
+		return (len == 4) ? 3 : static_cast<uint8_t>(len);
+	}
+
+	template<ITEM_TYPE TYPE, uint8_t TAG, uint32_t VALUE, size_t LEN>
+	struct Short_item_base
+	{
+		static_assert((LEN == 0) || (LEN == 1) || (LEN == 2) || (LEN == 4), "Short item data must be 0, 1, 2, or 4 bytes");
+		static_assert(TAG < 16, "Short item tag must fit in 4 bits");
+
+		constexpr static size_t size = LEN + 1;
+		constexpr static uint8_t prefix = static_cast<uint8_t>((TAG << 4) | (static_cast<uint8_t>(TYPE) << 2) | get_size_code(LEN));
+
+		template<size_t N>
+		constexpr static size_t write(std::array<uint8_t, N>& out, const size_t idx)
+		{
+			out[idx] = prefix;
+			for(size_t i = 0; i < LEN; i++)
+			{
+				out[idx + 1 + i] = static_cast<uint8_t>((VALUE >> (8U*i)) & 0xFFU);
+			}
+
+			return size;
+		}
+	};
+
+	template<ITEM_TYPE TYPE, uint8_t TAG, uint32_t VALUE>
+	using Short_item = Short_item_base<TYPE, TAG, VALUE, get_unsigned_data_len(VALUE)>;
+
+	//sign extended values, eg logical minimum -127 is 0x81 and not 0xFFFFFF81
+	template<ITEM_TYPE TYPE, uint8_t TAG, int32_t VALUE>
+	using Signed_short_item = Short_item_base<TYPE, TAG, static_cast<uint32_t>(VALUE), get_signed_data_len(VALUE)>;
+
+	template<ITEM_TYPE TYPE, uint8_t TAG>
+	using Short_item_no_data = Short_item_base<TYPE, TAG, 0, 0>;
+
+	//Main items
+	template<uint32_t FLAGS>
+	using Input = Short_item<ITEM_TYPE::MAIN, static_cast<uint8_t>(MAIN_TAG::INPUT), FLAGS>;
+	template<uint32_t FLAGS>
+	using Output = Short_item<ITEM_TYPE::MAIN, static_cast<uint8_t>(MAIN_TAG::OUTPUT), FLAGS>;
+	template<uint32_t FLAGS>
+	using Feature = Short_item<ITEM_TYPE::MAIN, static_cast<uint8_t>(MAIN_TAG::FEATURE), FLAGS>;
+	template<uint8_t TYPE>
+	using Collection = Short_item<ITEM_TYPE::MAIN, static_cast<uint8_t>(MAIN_TAG::COLLECTION), TYPE>;
+	using End_collection = Short_item_no_data<ITEM_TYPE::MAIN, static_cast<uint8_t>(MAIN_TAG::END_COLLECTION)>;
+
+	//Global items
+	template<uint16_t PAGE>
+	using Usage_page = Short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::USAGE_PAGE), PAGE>;
+	template<int32_t VAL>
+	using Logical_minimum = Signed_short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::LOGICAL_MINIMUM), VAL>;
+	template<int32_t VAL>
+	using Logical_maximum = Signed_short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::LOGICAL_MAXIMUM), VAL>;
+	template<int32_t VAL>
+	using Physical_minimum = Signed_short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::PHYSICAL_MINIMUM), VAL>;
+	template<int32_t VAL>
+	using Physical_maximum = Signed_short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::PHYSICAL_MAXIMUM), VAL>;
+	template<int32_t VAL>
+	using Unit_exponent = Signed_short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::UNIT_EXPONENT), VAL>;
+	template<uint32_t VAL>
+	using Unit = Short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::UNIT), VAL>;
+	template<uint32_t BITS>
+	using Report_size = Short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::REPORT_SIZE), BITS>;
+	template<uint8_t ID>
+	using Report_id = Short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::REPORT_ID), ID>;
+	template<uint32_t COUNT>
+	using Report_count = Short_item<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::REPORT_COUNT), COUNT>;
+	using Push = Short_item_no_data<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::PUSH)>;
+	using Pop  = Short_item_no_data<ITEM_TYPE::GLOBAL, static_cast<uint8_t>(GLOBAL_TAG::POP)>;
+
+	//Local items
+	template<uint32_t USAGE>
+	using Usage = Short_item<ITEM_TYPE::LOCAL, static_cast<uint8_t>(LOCAL_TAG::USAGE), USAGE>;
+	template<uint32_t USAGE>
+	using Usage_minimum = Short_item<ITEM_TYPE::LOCAL, static_cast<uint8_t>(LOCAL_TAG::USAGE_MINIMUM), USAGE>;
+	template<uint32_t USAGE>
+	using Usage_maximum = Short_item<ITEM_TYPE::LOCAL, static_cast<uint8_t>(LOCAL_TAG::USAGE_MAXIMUM), USAGE>;
+
+	template<typename... ITEMS>
+	class Report_descriptor
+	{
+	public:
+
+		constexpr static size_t size = (ITEMS::size + ... + 0);
+
+		typedef std::array<uint8_t, size> Report_descriptor_array;
+
+		constexpr static Report_descriptor_array data = []()
+		{
+			Report_descriptor_array out{};
+			size_t idx = 0;
+			((idx += ITEMS::write(out, idx)), ...);
+			return out;
+		}();
+	};
+}
+}
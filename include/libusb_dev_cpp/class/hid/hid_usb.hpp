@@ -0,0 +1,147 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/class/usb_class.hpp"
+
+#include "libusb_dev_cpp/class/hid/hid.hpp"
+#include "libusb_dev_cpp/class/hid/hid_desc.hpp"
+
+#include "libusb_dev_cpp/driver/usb_driver_base.hpp"
+
+#include "freertos_cpp_util/Mutex_static.hpp"
+
+#include <array>
+#include <functional>
+
+//HID interface with one interrupt IN endpoint
+//
+//send_report keeps the newest report loaded in the IN endpoint so the host gets it on the next poll
+//while a report is in the fifo, newer reports overwrite a single pending slot that is loaded on XFRC
+//stale reports are dropped and never queued behind newer ones
+//
+//SET_IDLE / GET_IDLE only take report id 0, the rate for all reports, other ids are stalled
+class HID_class : public USB_class
+{
+public:
+
+	constexpr static size_t MAX_REPORT_SIZE = 64;
+
+	//fill buf_to_host with the requested report, return false to stall
+	typedef std::function<bool (void*, const HID::REPORT_TYPE, const uint8_t, Buffer_adapter_tx* const)> Get_report_callback;
+	//consume the report in buf_from_host, return false to stall
+	typedef std::function<bool (void*, const HID::REPORT_TYPE, const uint8_t, const Buffer_adapter_rx* const)> Set_report_callback;
+
+	//report latency between send_report and XFRC
+	//units are (micro)frames as reported by usb_driver_base::get_frame_number, 125us on HS and 1ms on FS
+	struct Latency_stats
+	{
+		uint32_t count;
+		uint32_t sum;
+		uint16_t min;
+		uint16_t max;
+		//reports overwritten in the pending slot before they were loaded
+		uint32_t dropped;
+	};
+
+	HID_class();
+	~HID_class() override;
+
+	bool initialize(usb_driver_base* const driver, const uint8_t iface, const uint8_t in_ep);
+
+	//call from the set configuration callback
+	bool configure(const size_t in_ep_size);
+	//call when the configuration is cleared or on bus reset
+	void unconfigure();
+
+	//desc must remain valid, eg a HID::Report::Report_descriptor<...>::data
+	void set_report_descriptor(const uint8_t* const desc, const size_t len);
+	void set_hid_descriptor(const HID::HID_descriptor& desc)
+	{
+		m_hid_desc = desc;
+		m_hid_desc.wDescriptorLength = m_report_desc_len;
+	}
+
+	void set_get_report_callback(const Get_report_callback& callback, void* ctx)
+	{
+		m_get_report_callback_func = callback;
+		m_get_report_callback_ctx = ctx;
+	}
+
+	void set_set_report_callback(const Set_report_callback& callback, void* ctx)
+	{
+		m_set_report_callback_func = callback;
+		m_set_report_callback_ctx = ctx;
+	}
+
+	//non blocking, safe to call from any task
+	//false before initialize and configure, or if len is larger than the ep
+	bool send_report(const uint8_t* const report, const size_t len);
+
+	USB_common::USB_RESP handle_class_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host) override;
+	USB_common::USB_RESP handle_std_iface_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host) override;
+
+	HID::PROTOCOL get_protocol() const
+	{
+		return m_protocol;
+	}
+
+	//idle rate in 4ms units from SET_IDLE, 0 is indefinite
+	//advisory, the class does not resend reports, an app that wants idle repeats calls send_report at this rate
+	uint8_t get_idle_rate() const
+	{
+		return m_idle_rate;
+	}
+
+	Latency_stats get_latency_stats();
+	void reset_latency_stats();
+
+protected:
+
+	void handle_in_complete(const USB_common::USB_EVENTS event, const uint8_t ep);
+
+	//m_mutex must be held
+	bool load_report(const uint8_t* const report, const size_t len, const uint16_t frame);
+	uint16_t get_frame_delta(const uint16_t start, const uint16_t end) const;
+
+	usb_driver_base* m_driver;
+	uint8_t m_iface;
+	uint8_t m_in_ep;
+	size_t m_in_ep_size;
+	bool m_configured;
+
+	const uint8_t* m_report_desc;
+	size_t m_report_desc_len;
+	HID::HID_descriptor m_hid_desc;
+
+	HID::PROTOCOL m_protocol;
+	uint8_t m_idle_rate;
+
+	Get_report_callback m_get_report_callback_func;
+	void* m_get_report_callback_ctx;
+
+	Set_report_callback m_set_report_callback_func;
+	void* m_set_report_callback_ctx;
+
+	Mutex_static m_mutex;
+
+	//a report is loaded in the IN ep
+	bool m_in_busy;
+	uint16_t m_in_frame;
+
+	//newest report not yet loaded
+	bool m_pending_valid;
+	uint16_t m_pending_frame;
+	size_t m_pending_len;
+	std::array<uint8_t, MAX_REPORT_SIZE> m_pending;
+
+	//last report sent, used for GET_REPORT if there is no callback
+	size_t m_last_len;
+	std::array<uint8_t, MAX_REPORT_SIZE> m_last;
+
+	Latency_stats m_stats;
+};
@@ -0,0 +1,153 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//USB Audio Class 2.0
+namespace UAC2
+{
+	constexpr static uint8_t AUDIO_INTERFACE_CLASS_CODE = 0x01;
+	constexpr static uint8_t AUDIO_FUNCTION_CLASS_CODE  = 0x01;
+
+	enum class AUDIO_INTERFACE_SUBCLASS_CODE : uint8_t
+	{
+		UNDEFINED      = 0x00,
+		AUDIOCONTROL   = 0x01,
+		AUDIOSTREAMING = 0x02,
+		MIDISTREAMING  = 0x03
+	};
+
+	enum class AUDIO_INTERFACE_PROTO_CODE : uint8_t
+	{
+		UNDEFINED        = 0x00,
+		IP_VERSION_02_00 = 0x20
+	};
+
+	enum class AUDIO_FUNCTION_CATEGORY : uint8_t
+	{
+		UNDEFINED            = 0x00,
+		DESKTOP_SPEAKER      = 0x01,
+		HOME_THEATER         = 0x02,
+		MICROPHONE           = 0x03,
+		HEADSET              = 0x04,
+		TELEPHONE            = 0x05,
+		CONVERTER            = 0x06,
+		VOICE_SOUND_RECORDER = 0x07,
+		IO_BOX               = 0x08,
+		MUSICAL_INSTRUMENT   = 0x09,
+		PRO_AUDIO            = 0x0A,
+		AUDIO_VIDEO          = 0x0B,
+		CONTROL_PANEL        = 0x0C,
+		OTHER                = 0xFF
+	};
+
+	enum class AC_DESCRIPTOR_SUBTYPE : uint8_t
+	{
+		UNDEFINED             = 0x00,
+		HEADER                = 0x01,
+		INPUT_TERMINAL        = 0x02,
+		OUTPUT_TERMINAL       = 0x03,
+		MIXER_UNIT            = 0x04,
+		SELECTOR_UNIT         = 0x05,
+		FEATURE_UNIT          = 0x06,
+		EFFECT_UNIT           = 0x07,
+		PROCESSING_UNIT       = 0x08,
+		EXTENSION_UNIT        = 0x09,
+		CLOCK_SOURCE          = 0x0A,
+		CLOCK_SELECTOR        = 0x0B,
+		CLOCK_MULTIPLIER      = 0x0C,
+		SAMPLE_RATE_CONVERTER = 0x0D
+	};
+
+	enum class AS_DESCRIPTOR_SUBTYPE : uint8_t
+	{
+		UNDEFINED   = 0x00,
+		AS_GENERAL  = 0x01,
+		FORMAT_TYPE = 0x02,
+		ENCODER     = 0x03,
+		DECODER     = 0x04
+	};
+
+	enum class EP_DESCRIPTOR_SUBTYPE : uint8_t
+	{
+		UNDEFINED  = 0x00,
+		EP_GENERAL = 0x01
+	};
+
+	enum class FORMAT_TYPE : uint8_t
+	{
+		UNDEFINED = 0x00,
+		TYPE_I    = 0x01,
+		TYPE_II   = 0x02,
+		TYPE_III  = 0x03,
+		TYPE_IV   = 0x04
+	};
+
+	//bmFormats for TYPE_I
+	enum class FORMAT_TYPE_I : uint32_t
+	{
+		PCM        = 0x00000001,
+		PCM8       = 0x00000002,
+		IEEE_FLOAT = 0x00000004,
+		ALAW       = 0x00000008,
+		MULAW      = 0x00000010,
+		RAW_DATA   = 0x80000000
+	};
+
+	enum class TERMINAL_TYPE : uint16_t
+	{
+		USB_UNDEFINED       = 0x0100,
+		USB_STREAMING       = 0x0101,
+		USB_VENDOR_SPECIFIC = 0x01FF,
+		INPUT_UNDEFINED     = 0x0200,
+		MICROPHONE          = 0x0201,
+		OUTPUT_UNDEFINED    = 0x0300,
+		SPEAKER             = 0x0301,
+		HEADPHONES          = 0x0302,
+		LINE_CONNECTOR      = 0x0603,
+		SPDIF_INTERFACE     = 0x0605
+	};
+
+	enum class CLOCK_TYPE : uint8_t
+	{
+		EXTERNAL              = 0x00,
+		INTERNAL_FIXED        = 0x01,
+		INTERNAL_VARIABLE     = 0x02,
+		INTERNAL_PROGRAMMABLE = 0x03
+	};
+
+	enum class UAC2_REQUESTS : uint8_t
+	{
+		UNDEFINED = 0x00,
+		CUR       = 0x01,
+		RANGE     = 0x02,
+		MEM       = 0x03
+	};
+
+	enum class CS_CONTROL_SELECTOR : uint8_t
+	{
+		UNDEFINED           = 0x00,
+		SAM_FREQ_CONTROL    = 0x01,
+		CLOCK_VALID_CONTROL = 0x02
+	};
+
+	enum class CX_CONTROL_SELECTOR : uint8_t
+	{
+		UNDEFINED              = 0x00,
+		CLOCK_SELECTOR_CONTROL = 0x01
+	};
+
+	//2 bit control fields in bmControls
+	enum class CONTROL_ACCESS : uint8_t
+	{
+		NONE       = 0x00,
+		READ_ONLY  = 0x01,
+		READ_WRITE = 0x03
+	};
+}
@@ -0,0 +1,312 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/class/uac2/uac2.hpp"
+
+#include "libusb_dev_cpp/core/usb_common.hpp"
+
+#include "libusb_dev_cpp/descriptor/Descriptor_base.hpp"
+
+#include <array>
+#include <tuple>
+#include <vector>
+
+namespace UAC2
+{
+
+class AC_header_descriptor : public Descriptor_base
+{
+public:
+	AC_header_descriptor()
+	{
+		bcdADC       = 0x0200;
+		bCategory    = static_cast<uint8_t>(AUDIO_FUNCTION_CATEGORY::UNDEFINED);
+		wTotalLength = 0;
+		bmControls   = 0;
+	}
+
+	typedef std::array<uint8_t, 9> AC_header_descriptor_array;
+
+	bool serialize(AC_header_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	constexpr static uint8_t bLength = 9;
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CLASS_SPECIFIC_INTERFACE);
+	constexpr static uint8_t bDescriptorSubtype = static_cast<uint8_t>(AC_DESCRIPTOR_SUBTYPE::HEADER);
+	uint16_t bcdADC;
+	uint8_t  bCategory;
+	//total length of the class specific AC interface descriptors, including this one
+	uint16_t wTotalLength;
+	uint8_t  bmControls;
+
+	static_assert(std::tuple_size<AC_header_descriptor_array>::value == bLength);
+};
+
+class Clock_source_descriptor : public Descriptor_base
+{
+public:
+	Clock_source_descriptor()
+	{
+		bClockID       = 0;
+		bmAttributes   = static_cast<uint8_t>(CLOCK_TYPE::INTERNAL_FIXED);
+		bmControls     = 0;
+		bAssocTerminal = 0;
+		iClockSource   = 0;
+	}
+
+	typedef std::array<uint8_t, 8> Clock_source_descriptor_array;
+
+	bool serialize(Clock_source_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	void set_sam_freq_control(const CONTROL_ACCESS access)
+	{
+		bmControls = (bmControls & ~0x03) | (static_cast<uint8_t>(access) << 0);
+	}
+
+	void set_clock_valid_control(const CONTROL_ACCESS access)
+	{
+		bmControls = (bmControls & ~0x0C) | (static_cast<uint8_t>(access) << 2);
+	}
+
+	constexpr static uint8_t bLength = 8;
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CLASS_SPECIFIC_INTERFACE);
+	constexpr static uint8_t bDescriptorSubtype = static_cast<uint8_t>(AC_DESCRIPTOR_SUBTYPE::CLOCK_SOURCE);
+	uint8_t bClockID;
+	uint8_t bmAttributes;
+	uint8_t bmControls;
+	uint8_t bAssocTerminal;
+	uint8_t iClockSource;
+
+	static_assert(std::tuple_size<Clock_source_descriptor_array>::value == bLength);
+};
+
+class Clock_selector_descriptor : public Descriptor_base
+{
+public:
+	Clock_selector_descriptor()
+	{
+		bClockID       = 0;
+		bmControls     = 0;
+		iClockSelector = 0;
+	}
+
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return 7 + baCSourceID.size();
+	}
+
+	void set_clock_selector_control(const CONTROL_ACCESS access)
+	{
+		bmControls = (bmControls & ~0x03) | (static_cast<uint8_t>(access) << 0);
+	}
+
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CLASS_SPECIFIC_INTERFACE);
+	constexpr static uint8_t bDescriptorSubtype = static_cast<uint8_t>(AC_DESCRIPTOR_SUBTYPE::CLOCK_SELECTOR);
+	uint8_t bClockID;
+	//bNrInPins is baCSourceID.size()
+	std::vector<uint8_t> baCSourceID;
+	uint8_t bmControls;
+	uint8_t iClockSelector;
+};
+
+class Input_terminal_descriptor : public Descriptor_base
+{
+public:
+	Input_terminal_descriptor()
+	{
+		bTerminalID     = 0;
+		wTerminalType   = static_cast<uint16_t>(TERMINAL_TYPE::USB_STREAMING);
+		bAssocTerminal  = 0;
+		bCSourceID      = 0;
+		bNrChannels     = 0;
+		bmChannelConfig = 0;
+		iChannelNames   = 0;
+		bmControls      = 0;
+		iTerminal       = 0;
+	}
+
+	typedef std::array<uint8_t, 17> Input_terminal_descriptor_array;
+
+	bool serialize(Input_terminal_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	constexpr static uint8_t bLength = 17;
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CLASS_SPECIFIC_INTERFACE);
+	constexpr static uint8_t bDescriptorSubtype = static_cast<uint8_t>(AC_DESCRIPTOR_SUBTYPE::INPUT_TERMINAL);
+	uint8_t  bTerminalID;
+	uint16_t wTerminalType;
+	uint8_t  bAssocTerminal;
+	uint8_t  bCSourceID;
+	uint8_t  bNrChannels;
+	uint32_t bmChannelConfig;
+	uint8_t  iChannelNames;
+	uint16_t bmControls;
+	uint8_t  iTerminal;
+
+	static_assert(std::tuple_size<Input_terminal_descriptor_array>::value == bLength);
+};
+
+class Output_terminal_descriptor : public Descriptor_base
+{
+public:
+	Output_terminal_descriptor()
+	{
+		bTerminalID    = 0;
+		wTerminalType  = static_cast<uint16_t>(TERMINAL_TYPE::SPEAKER);
+		bAssocTerminal = 0;
+		bSourceID      = 0;
+		bCSourceID     = 0;
+		bmControls     = 0;
+		iTerminal      = 0;
+	}
+
+	typedef std::array<uint8_t, 12> Output_terminal_descriptor_array;
+
+	bool serialize(Output_terminal_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	constexpr static uint8_t bLength = 12;
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CLASS_SPECIFIC_INTERFACE);
+	constexpr static uint8_t bDescriptorSubtype = static_cast<uint8_t>(AC_DESCRIPTOR_SUBTYPE::OUTPUT_TERMINAL);
+	uint8_t  bTerminalID;
+	uint16_t wTerminalType;
+	uint8_t  bAssocTerminal;
+	uint8_t  bSourceID;
+	uint8_t  bCSourceID;
+	uint16_t bmControls;
+	uint8_t  iTerminal;
+
+	static_assert(std::tuple_size<Output_terminal_descriptor_array>::value == bLength);
+};
+
+class AS_general_descriptor : public Descriptor_base
+{
+public:
+	AS_general_descriptor()
+	{
+		bTerminalLink   = 0;
+		bmControls      = 0;
+		bFormatType     = static_cast<uint8_t>(FORMAT_TYPE::TYPE_I);
+		bmFormats       = static_cast<uint32_t>(FORMAT_TYPE_I::PCM);
+		bNrChannels     = 0;
+		bmChannelConfig = 0;
+		iChannelNames   = 0;
+	}
+
+	typedef std::array<uint8_t, 16> AS_general_descriptor_array;
+
+	bool serialize(AS_general_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	constexpr static uint8_t bLength = 16;
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CLASS_SPECIFIC_INTERFACE);
+	constexpr static uint8_t bDescriptorSubtype = static_cast<uint8_t>(AS_DESCRIPTOR_SUBTYPE::AS_GENERAL);
+	uint8_t  bTerminalLink;
+	uint8_t  bmControls;
+	uint8_t  bFormatType;
+	uint32_t bmFormats;
+	uint8_t  bNrChannels;
+	uint32_t bmChannelConfig;
+	uint8_t  iChannelNames;
+
+	static_assert(std::tuple_size<AS_general_descriptor_array>::value == bLength);
+};
+
+class Format_type_I_descriptor : public Descriptor_base
+{
+public:
+	Format_type_I_descriptor()
+	{
+		bSubslotSize   = 0;
+		bBitResolution = 0;
+	}
+
+	typedef std::array<uint8_t, 6> Format_type_I_descriptor_array;
+
+	bool serialize(Format_type_I_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	constexpr static uint8_t bLength = 6;
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CLASS_SPECIFIC_INTERFACE);
+	constexpr static uint8_t bDescriptorSubtype = static_cast<uint8_t>(AS_DESCRIPTOR_SUBTYPE::FORMAT_TYPE);
+	constexpr static uint8_t bFormatType = static_cast<uint8_t>(FORMAT_TYPE::TYPE_I);
+	//bytes per sample slot, 1 - 4
+	uint8_t bSubslotSize;
+	//valid bits in each slot
+	uint8_t bBitResolution;
+
+	static_assert(std::tuple_size<Format_type_I_descriptor_array>::value == bLength);
+};
+
+//class specific descriptor following the standard iso data endpoint descriptor
+class AS_iso_endpoint_descriptor : public Descriptor_base
+{
+public:
+	AS_iso_endpoint_descriptor()
+	{
+		bmAttributes    = 0;
+		bmControls      = 0;
+		bLockDelayUnits = 0;
+		wLockDelay      = 0;
+	}
+
+	typedef std::array<uint8_t, 8> AS_iso_endpoint_descriptor_array;
+
+	bool serialize(AS_iso_endpoint_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	constexpr static uint8_t bLength = 8;
+	constexpr static uint8_t bDescriptorType = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CLASS_SPECIFIC_ENDPOINT);
+	constexpr static uint8_t bDescriptorSubtype = static_cast<uint8_t>(EP_DESCRIPTOR_SUBTYPE::EP_GENERAL);
+	uint8_t  bmAttributes;
+	uint8_t  bmControls;
+	uint8_t  bLockDelayUnits;
+	uint16_t wLockDelay;
+
+	static_assert(std::tuple_size<AS_iso_endpoint_descriptor_array>::value == bLength);
+};
+
+}
@@ -0,0 +1,83 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/core/usb_common.hpp"
+
+#include <array>
+
+#include <cstdint>
+#include <cstddef>
+
+//explicit feedback for an asynchronous iso OUT endpoint
+//
+//the rate is measured as local sample clock ticks per (micro)frame over a window of frames
+//a small proportional trim on the fifo level is added so quantization error in the measurement
+//does not integrate into a slow drift of the fifo level
+//
+//all rates are Q16.16 samples per (micro)frame
+class UAC2_feedback
+{
+public:
+
+	UAC2_feedback();
+
+	void set_rate(const uint32_t sample_rate, const USB_common::USB_SPEED speed);
+
+	//window is in (micro)frames, and should be at least 2^(bInterval-1) of the feedback ep
+	void set_window(const uint32_t frames)
+	{
+		m_window = (frames == 0) ? 1 : frames;
+	}
+
+	//target fifo level in audio frames
+	//trim gain is 1 / 2^trim_shift samples per frame per audio frame of error
+	void set_target_level(const size_t level, const uint8_t trim_shift)
+	{
+		m_target_level = level;
+		m_trim_shift = trim_shift;
+	}
+
+	void reset();
+
+	//frames is the number of (micro)frames since the last call
+	//samples is the number of local sample clock ticks since the last call
+	//fifo_level is the number of audio frames currently buffered
+	void update(const uint32_t frames, const uint32_t samples, const size_t fifo_level);
+
+	uint32_t get_nominal() const
+	{
+		return m_nominal;
+	}
+	uint32_t get_measured() const
+	{
+		return m_measured;
+	}
+	uint32_t get_feedback() const
+	{
+		return m_feedback;
+	}
+
+	//wire format, 10.14 in 3 bytes on FS and 16.16 in 4 bytes on HS
+	typedef std::array<uint8_t, 4> Feedback_array;
+	size_t serialize(Feedback_array* const out_array) const;
+
+protected:
+
+	USB_common::USB_SPEED m_speed;
+
+	uint32_t m_nominal;
+	uint32_t m_measured;
+	uint32_t m_feedback;
+
+	uint32_t m_window;
+	uint32_t m_acc_frames;
+	uint32_t m_acc_samples;
+
+	size_t m_target_level;
+	uint8_t m_trim_shift;
+};
@@ -0,0 +1,145 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/class/usb_class.hpp"
+
+#include "libusb_dev_cpp/class/uac2/uac2.hpp"
+#include "libusb_dev_cpp/class/uac2/uac2_feedback.hpp"
+
+#include "libusb_dev_cpp/driver/usb_driver_base.hpp"
+
+#include "libusb_dev_cpp/util/Sample_fifo.hpp"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+//UAC2 playback function, one async iso OUT data ep with an explicit feedback iso IN ep
+//
+//the application
+//	calls start_streaming / stop_streaming when the streaming interface alt setting changes
+//	calls process from the usb task to move OUT packets into the sample fifo
+//	calls update_feedback at least once per feedback period
+//	calls read_frames from the audio dma isr, the fifo pads underruns with silence
+class UAC2_class : public USB_class
+{
+public:
+
+	constexpr static size_t FIFO_SIZE = 16384;
+
+	//free running count of samples consumed by the local audio clock, eg i2s dma position
+	typedef std::function<uint32_t (void*)> Sample_clock_callback;
+	//called on SET CUR SAM_FREQ_CONTROL, return false to stall
+	typedef std::function<bool (void*, const uint32_t)> Sample_rate_callback;
+
+	UAC2_class();
+	~UAC2_class() override;
+
+	bool initialize(usb_driver_base* const driver, const uint8_t ac_iface, const uint8_t clock_id, const uint8_t out_ep, const uint8_t fb_ep);
+
+	//optional clock selector entity in front of the clock source
+	void set_clock_selector(const uint8_t selector_id, const uint8_t num_pins)
+	{
+		m_clock_selector_id = selector_id;
+		m_clock_selector_pins = num_pins;
+		m_clock_selector_pin = 1;
+	}
+
+	//discrete rates reported by RANGE SAM_FREQ_CONTROL, the first is the default
+	void set_sample_rates(const std::vector<uint32_t>& rates);
+
+	//bytes per audio frame is num_channels * subslot_size
+	void set_format(const uint8_t num_channels, const uint8_t subslot_size)
+	{
+		m_frame_size = size_t(num_channels) * size_t(subslot_size);
+	}
+
+	void set_sample_clock_callback(const Sample_clock_callback& callback, void* ctx)
+	{
+		m_sample_clock_callback_func = callback;
+		m_sample_clock_callback_ctx = ctx;
+	}
+
+	void set_sample_rate_callback(const Sample_rate_callback& callback, void* ctx)
+	{
+		m_sample_rate_callback_func = callback;
+		m_sample_rate_callback_ctx = ctx;
+	}
+
+	bool start_streaming(const size_t out_ep_size);
+	void stop_streaming();
+
+	void process();
+	void update_feedback();
+
+	//consumer side, returns number of real audio frames, the rest of buf is silence
+	size_t read_frames(uint8_t* const buf, const size_t num_frames);
+
+	//audio frames buffered
+	size_t get_fifo_level() const
+	{
+		return (m_frame_size == 0) ? 0 : (m_fifo.size() / m_frame_size);
+	}
+
+	uint32_t get_sample_rate() const
+	{
+		return m_sample_rate;
+	}
+
+	const UAC2_feedback& get_feedback() const
+	{
+		return m_feedback;
+	}
+
+	size_t get_dropped_packet_count() const
+	{
+		return m_dropped_packets;
+	}
+
+	USB_common::USB_RESP handle_class_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host) override;
+
+protected:
+
+	USB_common::USB_RESP handle_clock_source_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host);
+	USB_common::USB_RESP handle_clock_selector_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host);
+
+	void handle_fb_complete(const USB_common::USB_EVENTS event, const uint8_t ep);
+
+	bool load_feedback();
+
+	usb_driver_base* m_driver;
+	uint8_t m_ac_iface;
+	uint8_t m_clock_id;
+	uint8_t m_out_ep;
+	uint8_t m_fb_ep;
+
+	uint8_t m_clock_selector_id;
+	uint8_t m_clock_selector_pins;
+	uint8_t m_clock_selector_pin;
+
+	std::vector<uint32_t> m_sample_rates;
+	uint32_t m_sample_rate;
+	size_t m_frame_size;
+
+	Sample_clock_callback m_sample_clock_callback_func;
+	void* m_sample_clock_callback_ctx;
+
+	Sample_rate_callback m_sample_rate_callback_func;
+	void* m_sample_rate_callback_ctx;
+
+	std::atomic<bool> m_streaming;
+	std::atomic<bool> m_fb_busy;
+
+	uint16_t m_last_frame;
+	uint32_t m_last_sample_clock;
+	UAC2_feedback m_feedback;
+
+	size_t m_dropped_packets;
+
+	Sample_fifo<uint8_t, FIFO_SIZE> m_fifo;
+};
@@ -21,5 +21,21 @@ public:
 
 	virtual USB_common::USB_RESP handle_class_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host) = 0;
 
+	//standard interface requests the core does not know how to handle, eg GET_DESCRIPTOR for class specific descriptors
+	virtual USB_common::USB_RESP handle_std_iface_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host);
+
+	//Request_type::TYPE::VENDOR requests
+	virtual USB_common::USB_RESP handle_vendor_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host);
+
+	//EP_RX / EP_TX on an ep owned by this function, only called when no driver ep callback is bound
+	virtual void handle_ep_event(const USB_common::USB_EVENTS event, const uint8_t ep);
+
+	//called by the core after SET_CONFIGURATION, 0 means unconfigured
+	virtual bool set_configuration(const uint8_t bConfigurationValue);
+
+	//called by the core after SET_INTERFACE, the eps of the new alt setting are already configured
+	//return false to stall the request, the core then restores the previous alt setting
+	virtual bool set_interface(const uint8_t iface, const uint8_t alt);
+
 protected:
 };
\ No newline at end of file
@@ -8,7 +8,10 @@
 
 #include "libusb_dev_cpp/util/Buffer_adapter.hpp"
 
+#include "common_util/Byte_util.hpp"
+
 #include <array>
+#include <tuple>
 
 #include <cstdint>
 
@@ -18,7 +21,27 @@ public:
 
 	typedef std::array<uint8_t, 8> Notification_packet_array;
 
-	bool serialize(Buffer_adapter_base* const out_array) const;
+	//into an ep buffer or a control tx buffer
+	template <typename POLICY>
+	bool serialize(Buffer_view_T<uint8_t, POLICY>* const out_array) const
+	{
+		size_t len = 0;
+
+		len += out_array->insert(bmRequestType);
+
+		len += out_array->insert(bNotification);
+
+		len += out_array->insert(Byte_util::get_b0(wValue));
+		len += out_array->insert(Byte_util::get_b1(wValue));
+
+		len += out_array->insert(Byte_util::get_b0(wIndex));
+		len += out_array->insert(Byte_util::get_b1(wIndex));
+
+		len += out_array->insert(Byte_util::get_b0(wLength));
+		len += out_array->insert(Byte_util::get_b1(wLength));
+
+		return len == std::tuple_size< Notification_packet_array >::value;
+	}
 	bool serialize(Notification_packet_array* const out_array) const;
 	bool deserialize(const Notification_packet_array& in_array);
 
@@ -0,0 +1,79 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/core/usb_common.hpp"
+#include "libusb_dev_cpp/core/Request_type.hpp"
+#include "libusb_dev_cpp/core/Setup_packet.hpp"
+
+#include "libusb_dev_cpp/util/Buffer_adapter.hpp"
+
+#include <array>
+#include <functional>
+#include <map>
+
+//control request handlers keyed on bmRequestType type and recipient, and bRequest
+//standard requests with bRequest < 16 are in a flat array indexed directly from the setup packet
+//everything else, eg class or vendor requests an app wants to take over, is in a map
+class Request_dispatch_table
+{
+public:
+
+	typedef std::function<USB_common::USB_RESP (void*, Setup_packet* const, Buffer_adapter_rx* const, Buffer_adapter_tx* const)> Request_handler;
+
+	constexpr static size_t NUM_STD_RECIPIENTS = 4;
+	constexpr static size_t NUM_STD_REQUESTS   = 16;
+
+	Request_dispatch_table();
+
+	//replaces any handler already registered for the same key
+	bool register_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest, const Request_handler& handler, void* ctx);
+	void unregister_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest);
+
+	bool has_handler(const uint8_t bmRequestType, const uint8_t bRequest) const
+	{
+		return find(bmRequestType, bRequest) != nullptr;
+	}
+
+	//returns false if no handler is registered, out_resp is then untouched
+	bool dispatch(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host, USB_common::USB_RESP* const out_resp) const;
+
+protected:
+
+	struct Handler_entry
+	{
+		Request_handler func;
+		void* ctx;
+	};
+
+	//bmRequestType b6:5 type, b4:0 recipient
+	static uint8_t get_type(const uint8_t bmRequestType)
+	{
+		return (bmRequestType >> 5) & 0x03;
+	}
+	static uint8_t get_recipient(const uint8_t bmRequestType)
+	{
+		return bmRequestType & 0x1F;
+	}
+
+	//recipient in b11:10, type in b9:8, bRequest in b7:0
+	static uint16_t make_key(const uint8_t type, const uint8_t recipient, const uint8_t bRequest)
+	{
+		return (uint16_t(recipient) << 10) | (uint16_t(type) << 8) | uint16_t(bRequest);
+	}
+
+	static bool is_std_slot(const uint8_t type, const uint8_t recipient, const uint8_t bRequest)
+	{
+		return (type == 0) && (recipient < NUM_STD_RECIPIENTS) && (bRequest < NUM_STD_REQUESTS);
+	}
+
+	const Handler_entry* find(const uint8_t bmRequestType, const uint8_t bRequest) const;
+
+	std::array<Handler_entry, NUM_STD_RECIPIENTS * NUM_STD_REQUESTS> m_std_handlers;
+
+	std::map<uint16_t, Handler_entry> m_handlers;
+};
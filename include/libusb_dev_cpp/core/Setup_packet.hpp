@@ -32,11 +32,12 @@ public:
 
 	enum class INTERFACE_REQUEST : uint8_t
 	{
-		GET_STATUS    = 0x00,
-		CLEAR_FEATURE = 0x01,
-		SET_FEATURE   = 0x03,
-		GET_INTERFACE = 0x0A,
-		SET_INTERFACE = 0x11
+		GET_STATUS     = 0x00,
+		CLEAR_FEATURE  = 0x01,
+		SET_FEATURE    = 0x03,
+		GET_DESCRIPTOR = 0x06,
+		GET_INTERFACE  = 0x0A,
+		SET_INTERFACE  = 0x0B
 	};
 
 	enum class ENDPOINT_REQUEST : uint8_t
@@ -44,7 +45,7 @@ public:
 		GET_STATUS    = 0x00,
 		CLEAR_FEATURE = 0x01,
 		SET_FEATURE   = 0x03,
-		SYNC_FRAME    = 0x0A
+		SYNC_FRAME    = 0x0C
 	};
 
 	enum class FEATURE_SELECTOR
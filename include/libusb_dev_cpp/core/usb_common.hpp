@@ -28,6 +28,12 @@ public:
 		EP_TX,
 		WAKEUP,
 		SOF,
+		//LPM L1 entered, the bus is idle until the host or a remote wakeup resumes it with WAKEUP
+		L1_SLEEP,
+		//a PENDING control request was completed, posted by USB_core itself
+		CTRL_DEFERRED_DONE,
+		//request_remote_wakeup started resume signaling, posted by USB_core itself so the usb task times its end
+		REMOTE_WAKEUP,
 		NONE
 	};
 	static constexpr size_t USB_EVENTS_MAX = 8;
@@ -52,7 +58,9 @@ public:
 	{
 		FAIL,
 		ACK,
-		NAK
+		NAK,
+		//answer later with USB_core::complete_deferred_request, ep0 NAKs the host until then
+		PENDING
 	};
 
 	enum class USB_SPEED
@@ -75,6 +83,8 @@ public:
 		OTG                           = 0x09,
 		DEBUG                         = 0x0A,
 		INTERFASE_ASSOCIATION         = 0x0B,
+		BOS                           = 0x0F,
+		DEVICE_CAPABILITY             = 0x10,
 		CLASS_SPECIFIC_INTERFACE      = 0x24,
 		CLASS_SPECIFIC_ENDPOINT       = 0x25
 	};
@@ -8,6 +8,7 @@
 
 #include "libusb_dev_cpp/core/usb_common.hpp"
 
+#include "libusb_dev_cpp/core/Request_dispatch_table.hpp"
 #include "libusb_dev_cpp/core/Setup_packet.hpp"
 
 #include "libusb_dev_cpp/class/usb_class.hpp"
@@ -18,8 +19,15 @@
 #include "libusb_dev_cpp/util/Buffer_adapter.hpp"
 #include "libusb_dev_cpp/util/EP_buffer_mgr_base.hpp"
 
+#include "freertos_cpp_util/Mutex_static.hpp"
 #include "freertos_cpp_util/Queue_static_pod.hpp"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <vector>
+
 class USB_core
 {
 public:
@@ -28,6 +36,48 @@ public:
 	typedef std::function<void (void*)> SofCallback;
 	typedef std::function<void (void*)> ResetCallback;
 
+	//streamed data stage, offset is the position of the chunk in the data stage
+	//OUT, called with each ep0 packet as it arrives, return false to stall
+	typedef std::function<bool (void*, Setup_packet* const, const size_t, const uint8_t* const, const size_t)> Ctrl_stream_rx_callback;
+	//IN, fill up to max_len bytes and return the count, fewer than the ep0 size ends the data stage, negative stalls
+	typedef std::function<int (void*, Setup_packet* const, const size_t, uint8_t* const, const size_t)> Ctrl_stream_tx_callback;
+
+	//free running time base for the power stats, eg a us timer, wraps at 2^32
+	typedef std::function<uint32_t (void*)> Timestamp_callback;
+
+	constexpr static size_t MAX_INTERFACES = 16;
+
+	//USB 2.0 link power states
+	enum class LINK_STATE
+	{
+		//on
+		L0,
+		//LPM sleep
+		L1,
+		//suspend
+		L2
+	};
+	constexpr static size_t NUM_LINK_STATES = 3;
+
+	//called from the usb task on entering L1 or L2, and on return to L0
+	typedef std::function<void (void*, const LINK_STATE)> SuspendCallback;
+	typedef std::function<void (void*)> ResumeCallback;
+
+	struct Power_stats
+	{
+		//time in each state, in timestamp units, up to the call to get_power_stats
+		std::array<uint64_t, NUM_LINK_STATES> residency;
+		//times each state was entered
+		std::array<uint32_t, NUM_LINK_STATES> entries;
+		uint32_t remote_wakeups;
+		//request_remote_wakeup to the resume, in timestamp units
+		uint32_t last_wake_latency;
+		uint32_t max_wake_latency;
+		//time the core spent handling the suspend or resume event, callbacks and clock gating included
+		uint32_t max_suspend_latency;
+		uint32_t max_resume_latency;
+	};
+
 	enum class USB_CMD
 	{
 		ENABLE,
@@ -45,8 +95,110 @@ public:
 	USB_core& operator=(const USB_core& rhs) = delete;
 
 	bool initialize(usb_driver_base* const driver, const uint8_t ep0size, const Buffer_adapter_tx& tx_buf, const Buffer_adapter_rx& rx_buf);
+	//single function device, or the fallback for requests no registered function claims
 	void set_usb_class(USB_class* const usb_class);
+
+	//composite device, register one entry per function
+	//interfaces first_iface .. first_iface+num_iface-1 and the eps in ep_mask are routed to usb_class
+	//build ep_mask with get_ep_mask
+	bool add_usb_class(USB_class* const usb_class, const uint8_t first_iface, const uint8_t num_iface, const uint32_t ep_mask);
+
+	//OUT eps in b15:0, IN eps in b31:16
+	static constexpr uint32_t get_ep_mask(const uint8_t ep)
+	{
+		return ((ep & 0x80U) != 0) ? (1UL << (16U + (ep & 0x0FU))) : (1UL << (ep & 0x0FU));
+	}
+
+	USB_class* get_class_for_iface(const uint8_t iface);
+	USB_class* get_class_for_ep(const uint8_t ep);
+
 	void set_descriptor_table(Descriptor_table* const desc_table);
+
+	//standard requests are served from a dispatch table, register a handler to add one or replace the built in one
+	//class and vendor requests with no registered handler are routed to the owning function
+	bool register_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest, const Request_dispatch_table::Request_handler& handler, void* ctx)
+	{
+		return m_request_table.register_request(type, recipient, bRequest, handler, ctx);
+	}
+	void unregister_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest)
+	{
+		m_request_table.unregister_request(type, recipient, bRequest);
+	}
+
+	//control transfers larger than the control buffers, eg DFU or vendor bulk-over-control
+	//the data stage is passed through the callbacks one ep0 packet at a time instead of being buffered
+	//an OUT request is ACKed once all wLength bytes are consumed, only the tx buffer needs to hold one ep0 packet
+	//either callback may be null if the request only goes one way
+	//register before connecting, or from the usb task between transfers
+	bool register_stream_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest, const Ctrl_stream_rx_callback& rx_callback, const Ctrl_stream_tx_callback& tx_callback, void* ctx);
+	void unregister_stream_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest);
+
+	//alt setting from the last SET_INTERFACE
+	//the set configuration callback configures the alt 0 eps, the core swaps them on SET_INTERFACE
+	uint8_t get_interface_alt(const uint8_t iface) const
+	{
+		return (iface < m_iface_alt.size()) ? m_iface_alt[iface] : 0;
+	}
+
+	bool is_remote_wakeup_enabled();
+
+	//wake the host, from any task
+	//from L2 the host must have set DEVICE_REMOTE_WAKEUP, from L1 the LPM token must have allowed it
+	bool request_remote_wakeup();
+
+	LINK_STATE get_link_state();
+
+	//defaults to the RTOS tick, set before connecting
+	void set_timestamp_callback(const Timestamp_callback& callback, void* ctx)
+	{
+		m_timestamp_callback_func = callback;
+		m_timestamp_callback_ctx = ctx;
+	}
+
+	Power_stats get_power_stats();
+	void reset_power_stats();
+
+	void set_suspend_callback(const SuspendCallback& callback, void* ctx)
+	{
+		m_suspend_callback_func = callback;
+		m_suspend_callback_ctx = ctx;
+	}
+
+	void set_resume_callback(const ResumeCallback& callback, void* ctx)
+	{
+		m_resume_callback_func = callback;
+		m_resume_callback_ctx = ctx;
+	}
+
+	//stop the PHY clock in L2 through the driver, off by default
+	void set_clock_gating(const bool enable)
+	{
+		m_clock_gating = enable;
+	}
+
+	//the link is asleep, no events are waiting for the usb task, no control transfer is running and no IN data is queued
+	//a hint for the idle task before it stops the cpu, an interrupt can make it stale at any time
+	bool is_safe_to_sleep();
+
+	//deferred control requests
+	//a handler that needs slow work reads get_setup_id, returns PENDING, and hands the work to another task
+	//that task calls complete_deferred_request with the same id, ep0 NAKs the host in the meantime
+	//data is copied, up to the tx buffer size, and is ignored for HOST_TO_DEV requests
+	//returns false if the id is stale, eg the host sent a new setup packet or the request timed out
+	bool complete_deferred_request(const uint32_t setup_id, const USB_common::USB_RESP resp, const uint8_t* const data, const size_t len);
+
+	//id of the setup packet being handled, valid inside a request handler
+	uint32_t get_setup_id() const
+	{
+		return m_setup_id;
+	}
+
+	//a PENDING request not completed in time stalls ep0
+	//poll_event_loop(true) wakes up for the deadline, even with no bus traffic
+	void set_deferred_timeout(const std::chrono::milliseconds& timeout)
+	{
+		m_deferred_timeout = timeout;
+	}
 	
 	void set_config_callback(const SetConfigurationCallback& callback, void* ctx)
 	{
@@ -86,29 +238,112 @@ public:
 		return m_driver;
 	}
 
+	//speed negotiated at the last bus reset, use to size eps in the set configuration callback
+	USB_common::USB_SPEED get_speed() const
+	{
+		return m_speed;
+	}
+
 protected:
 
+	//lets the driver post EP_RX for the OUT eps in ep_mask
+	void enable_ep_rx_events(const uint32_t ep_mask);
+
 	bool handle_event(const USB_common::USB_EVENTS evt, const uint8_t ep);
 
 	bool handle_reset();
 	bool handle_enum_done();
 	bool handle_sof();
 
+	bool handle_suspend(const LINK_STATE state);
+	bool handle_resume();
+
+	//account the time in the old state and move to the new one
+	void set_link_state(const LINK_STATE state);
+	uint32_t get_timestamp() const;
+
 	bool handle_ep0_setup(const USB_common::USB_EVENTS event, const uint8_t ep);
 	bool handle_ep0_rx(const USB_common::USB_EVENTS event, const uint8_t ep);
 	bool handle_ep0_tx(const USB_common::USB_EVENTS event, const uint8_t ep);
 
+	//streamed data stage, one ep0 packet per call
+	bool handle_ep0_rx_stream(const USB_common::USB_EVENTS event, const uint8_t ep);
+	void handle_ep0_tx_stream(const uint8_t ep);
+
+	//start the data or status stage for the result of process_request
+	void send_control_response(const USB_common::USB_RESP resp, const USB_common::USB_EVENTS event, const uint8_t ep);
+
+	//mark the current request as waiting, it may already have been completed
+	void start_deferred_request();
+	void handle_deferred_done();
+	void check_deferred_timeout();
+	//ticks until a pending request times out, portMAX_DELAY if none is pending
+	TickType_t get_deferred_wait();
+
+	//resume signaling lasts 1-15ms
+	static constexpr uint32_t REMOTE_WAKEUP_SIGNAL_MS = 10;
+	//ticks until the remote wakeup signaling should end, portMAX_DELAY if not signaling
+	TickType_t get_remote_wakeup_wait();
+	void check_remote_wakeup_end();
+
 	virtual USB_common::USB_RESP process_request(Setup_packet* const req);
 
+	typedef USB_common::USB_RESP (USB_core::*Std_request_handler)(Setup_packet* const req);
+
+	//fill m_request_table with the built in standard request handlers
+	void register_std_requests();
+	void register_std_request(const Request_type::RECIPIENT recipient, const uint8_t bRequest, const Std_request_handler handler);
+
+	//standard requests with no table entry
 	virtual USB_common::USB_RESP handle_std_device_request(Setup_packet* const req);
 	virtual USB_common::USB_RESP handle_std_iface_request(Setup_packet* const req);
 	virtual USB_common::USB_RESP handle_std_ep_request(Setup_packet* const req);
 
+	virtual USB_common::USB_RESP handle_get_status_device(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_clear_feature_device(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_set_feature_device(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_set_address(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_get_descriptor(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_get_configuration(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_set_configuration(Setup_packet* const req);
+
+	virtual USB_common::USB_RESP handle_get_status_iface(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_get_interface(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_set_interface(Setup_packet* const req);
+
+	virtual USB_common::USB_RESP handle_get_status_ep(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_clear_feature_ep(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_set_feature_ep(Setup_packet* const req);
+	virtual USB_common::USB_RESP handle_sync_frame(Setup_packet* const req);
+
+	//serve GET_DESCRIPTOR from the flat table if it was built, returns false on a miss
+	bool handle_get_descriptor_flat(Setup_packet* const req, USB_common::USB_RESP* const out_resp);
+
+	//config descriptor and its children, with speed dependent fields for speed
+	USB_common::USB_RESP serialize_configuration(const uint8_t desc_index, const USB_common::USB_SPEED speed, const USB_common::DESCRIPTOR_TYPE desc_type, const uint16_t wLength);
+
+	//returns true if req was the MS OS 2.0 descriptor set request, the response is in out_resp
+	bool handle_ms_os_20_request(Setup_packet* const req, USB_common::USB_RESP* const out_resp);
+
 	virtual bool set_configuration(const uint8_t bConfigurationValue);
 	virtual bool get_configuration(uint8_t* const bConfigurationValue);
 
+	//pass the new configuration to each registered function
+	bool notify_functions_configuration(const uint8_t bConfigurationValue);
+
+	//eps of each interface alt setting in the active configuration, from the descriptor table
+	bool load_alt_settings(const uint8_t bConfigurationValue);
+	bool has_alt_settings(const uint8_t iface) const;
+	//unconfig the eps of from_alt and config the eps of to_alt
+	bool switch_alt_setting(const uint8_t iface, const uint8_t from_alt, const uint8_t to_alt);
+
 	virtual void handle_ctrl_req_complete();
 
+	//route by recipient, wIndex carries the interface or ep
+	USB_class* get_class_for_request(Setup_packet* const req);
+
+	void handle_ep_event(const USB_common::USB_EVENTS event, const uint8_t ep);
+
 	void stall_control_ep(const uint8_t ep);
 
 	void set_address(const uint8_t addr);
@@ -122,6 +357,7 @@ protected:
 		uint8_t	ep;
 	};
 	Queue_static_pod<usb_core_event, 32> m_event_queue;
+	std::atomic<size_t> m_num_queued_events;
 
 /*
 	enum class USB_DEVICE_STATE
@@ -148,19 +384,103 @@ protected:
 		//status in
 		STATUS_IN,
 		//status out
-		STATUS_OUT
+		STATUS_OUT,
+		//waiting on complete_deferred_request, ep0 NAKs
+		DEFERRED
 	};
 	USB_CONTROL_STATE m_control_state;
 
+	//shared with the task calling complete_deferred_request
+	struct Deferred_request
+	{
+		//process_request returned PENDING
+		bool waiting;
+		//complete_deferred_request was called
+		bool done;
+		USB_common::USB_RESP resp;
+		TickType_t start;
+	};
+	Mutex_static m_deferred_mutex;
+	Deferred_request m_deferred;
+	uint32_t m_setup_id;
+	std::chrono::milliseconds m_deferred_timeout;
+
 	std::function<void()> m_setup_complete_callback;
 
 	usb_driver_base* m_driver;
 	USB_class* m_usb_class;
 
+	struct Function_entry
+	{
+		USB_class* usb_class;
+		uint8_t first_iface;
+		uint8_t num_iface;
+		uint32_t ep_mask;
+	};
+	std::vector<Function_entry> m_functions;
+
 	Setup_packet m_setup_packet;
 
 	uint8_t m_address;
 	uint8_t m_configuration;
+	USB_common::USB_SPEED m_speed;
+
+	bool m_remote_wakeup_enabled;
+	std::array<uint8_t, MAX_INTERFACES> m_iface_alt;
+
+	//shared with tasks calling request_remote_wakeup and get_power_stats
+	Mutex_static m_power_mutex;
+	LINK_STATE m_link_state;
+	uint32_t m_link_state_start;
+	Power_stats m_power_stats;
+	bool m_wake_pending;
+	uint32_t m_wake_start;
+	//the driver is driving resume signaling since m_wake_signal_start
+	bool m_wake_signaling;
+	TickType_t m_wake_signal_start;
+
+	void* m_timestamp_callback_ctx;
+	Timestamp_callback m_timestamp_callback_func;
+
+	bool m_clock_gating;
+
+	void* m_suspend_callback_ctx;
+	SuspendCallback m_suspend_callback_func;
+
+	void* m_resume_callback_ctx;
+	ResumeCallback m_resume_callback_func;
+
+	struct Alt_setting
+	{
+		uint8_t iface;
+		uint8_t alt;
+		std::vector<usb_driver_base::ep_cfg> eps;
+	};
+	std::vector<Alt_setting> m_alt_settings;
+
+	const Alt_setting* find_alt_setting(const uint8_t iface, const uint8_t alt) const;
+
+	Request_dispatch_table m_request_table;
+
+	struct Stream_entry
+	{
+		Ctrl_stream_rx_callback rx_func;
+		Ctrl_stream_tx_callback tx_func;
+		void* ctx;
+	};
+	//recipient in b11:10, type in b9:8, bRequest in b7:0
+	static uint16_t make_stream_key(const uint8_t type, const uint8_t recipient, const uint8_t bRequest)
+	{
+		return (uint16_t(recipient) << 10) | (uint16_t(type) << 8) | uint16_t(bRequest);
+	}
+	const Stream_entry* find_stream_request(const Setup_packet& req) const;
+
+	std::map<uint16_t, Stream_entry> m_stream_handlers;
+
+	//the data stage in progress, null if buffered
+	const Stream_entry* m_stream;
+	size_t m_stream_offset;
+	size_t m_stream_rem;
 
 	//user data
 	Descriptor_table* m_desc_table;
@@ -0,0 +1,359 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+//C++20 coroutines for endpoint I/O, empty unless the compiler has them
+//
+//many endpoint state machines run on the usb task, each one a coroutine with a small frame from a Coro_arena
+//	Usb_coro_task echo(Usb_coro_ep ep)
+//	{
+//		for(;;)
+//		{
+//			Buffer_adapter_base* const buf = co_await ep.read();
+//			...
+//		}
+//	}
+//
+//everything here runs on the usb task, the executor is driven by USB_core's event loop through the driver's per ep callbacks
+//a host test drives it the same way, or through Usb_coro_executor_std from another thread
+
+#if defined(__cpp_impl_coroutine)
+
+#include "libusb_dev_cpp/core/usb_core.hpp"
+
+#include "libusb_dev_cpp/driver/usb_driver_base.hpp"
+#include "libusb_dev_cpp/driver/Tx_token.hpp"
+
+#include "libusb_dev_cpp/util/Coro_arena.hpp"
+
+#include <array>
+#include <coroutine>
+
+#include <cstddef>
+#include <cstdint>
+
+//a detached coroutine, it starts when called and frees its frame when it returns
+//the frame comes from Coro_arena_base::get_default, if that fails the coroutine never runs and is_valid is false
+class Usb_coro_task
+{
+public:
+
+	struct promise_type
+	{
+		Usb_coro_task get_return_object()
+		{
+			return Usb_coro_task(true);
+		}
+
+		static Usb_coro_task get_return_object_on_allocation_failure()
+		{
+			return Usb_coro_task(false);
+		}
+
+		std::suspend_never initial_suspend() noexcept
+		{
+			return std::suspend_never();
+		}
+
+		std::suspend_never final_suspend() noexcept
+		{
+			return std::suspend_never();
+		}
+
+		void return_void()
+		{
+
+		}
+
+		void unhandled_exception()
+		{
+
+		}
+
+		static void* operator new(const size_t len) noexcept;
+		static void operator delete(void* const ptr) noexcept;
+	};
+
+	bool is_valid() const
+	{
+		return m_valid;
+	}
+
+protected:
+
+	explicit Usb_coro_task(const bool valid)
+	{
+		m_valid = valid;
+	}
+
+	bool m_valid;
+};
+
+class Usb_coro_executor;
+
+//one endpoint as seen from a coroutine, cheap to copy
+//one coroutine may wait on each direction of an ep, a second one gets nullptr or false right away
+class Usb_coro_ep
+{
+public:
+
+	class Read_awaitable
+	{
+	public:
+		Read_awaitable(Usb_coro_executor* const exec, const uint8_t ep_addr)
+		{
+			m_exec    = exec;
+			m_ep_addr = ep_addr;
+			m_buf     = nullptr;
+		}
+
+		bool await_ready();
+		bool await_suspend(std::coroutine_handle<> handle);
+		//nullptr if cancelled
+		Buffer_adapter_base* await_resume()
+		{
+			return m_buf;
+		}
+
+	protected:
+		Usb_coro_executor* m_exec;
+		uint8_t m_ep_addr;
+		Buffer_adapter_base* m_buf;
+	};
+
+	class Alloc_awaitable
+	{
+	public:
+		Alloc_awaitable(Usb_coro_executor* const exec, const uint8_t ep_addr)
+		{
+			m_exec    = exec;
+			m_ep_addr = ep_addr;
+			m_buf     = nullptr;
+		}
+
+		bool await_ready();
+		bool await_suspend(std::coroutine_handle<> handle);
+		//an empty buffer, or nullptr if cancelled
+		Buffer_adapter_base* await_resume()
+		{
+			return m_buf;
+		}
+
+	protected:
+		Usb_coro_executor* m_exec;
+		uint8_t m_ep_addr;
+		Buffer_adapter_base* m_buf;
+	};
+
+	//the token lives in the coroutine frame, so the coroutine stays suspended until the driver is done with it
+	class Write_awaitable
+	{
+	public:
+		Write_awaitable(Usb_coro_executor* const exec, const uint8_t ep_addr, Buffer_adapter_base* const buf)
+		{
+			m_exec    = exec;
+			m_ep_addr = ep_addr;
+			m_buf     = buf;
+			m_queued  = false;
+		}
+
+		bool await_ready();
+		bool await_suspend(std::coroutine_handle<> handle);
+		//true if the host took it
+		bool await_resume()
+		{
+			return m_queued && (m_token.get_state() == Tx_token::STATE::DONE);
+		}
+
+		const Tx_token& get_token() const
+		{
+			return m_token;
+		}
+
+	protected:
+		Usb_coro_executor* m_exec;
+		uint8_t m_ep_addr;
+		Buffer_adapter_base* m_buf;
+		bool m_queued;
+		Tx_token m_token;
+	};
+
+	Usb_coro_ep()
+	{
+		m_exec = nullptr;
+		m_ep   = 0;
+	}
+
+	Usb_coro_ep(Usb_coro_executor* const exec, const uint8_t ep)
+	{
+		m_exec = exec;
+		m_ep   = ep;
+	}
+
+	uint8_t get_ep() const
+	{
+		return m_ep;
+	}
+
+	//OUT, wait for a packet, hand the buffer back with release
+	Read_awaitable read()
+	{
+		return Read_awaitable(m_exec, USB_common::get_ep_addr(m_ep));
+	}
+	void release(Buffer_adapter_base* const buf);
+
+	//IN, wait for a free buffer to fill
+	Alloc_awaitable alloc()
+	{
+		return Alloc_awaitable(m_exec, USB_common::get_ep_addr(m_ep));
+	}
+	//IN, send buf and wait until the host has it
+	//needs a driver with Tx_token support
+	Write_awaitable write(Buffer_adapter_base* const buf)
+	{
+		return Write_awaitable(m_exec, USB_common::get_ep_addr(m_ep), buf);
+	}
+
+protected:
+	Usb_coro_executor* m_exec;
+	uint8_t m_ep;
+};
+
+//resumes the coroutines waiting on endpoints
+class Usb_coro_executor
+{
+public:
+
+	static constexpr size_t MAX_EP = 8;
+
+	Usb_coro_executor();
+
+	bool initialize(usb_driver_base* const driver);
+
+	//route the ep's events to its coroutines
+	//this takes the driver's per ep callback, so the ep should not also belong to a class driver
+	bool bind_ep(const uint8_t ep);
+
+	Usb_coro_ep get_ep(const uint8_t ep)
+	{
+		return Usb_coro_ep(this, ep);
+	}
+
+	//from the usb task, bind_ep routes USB_core's events here
+	void handle_ep_event(const USB_common::USB_EVENTS event, const uint8_t ep);
+
+	//wake every read and alloc with nullptr, and every write the driver has given up on
+	//call after the eps are unconfigured, eg on bus reset or SET_CONFIGURATION 0
+	void cancel_all();
+
+	size_t get_num_waiting() const;
+
+protected:
+
+	friend class Usb_coro_ep;
+	friend class Usb_coro_ep::Read_awaitable;
+	friend class Usb_coro_ep::Alloc_awaitable;
+	friend class Usb_coro_ep::Write_awaitable;
+
+	struct Rx_waiter
+	{
+		std::coroutine_handle<> handle;
+		Buffer_adapter_base** out_buf;
+	};
+
+	struct Tx_waiter
+	{
+		std::coroutine_handle<> handle;
+		//alloc when out_buf is set, write otherwise
+		Buffer_adapter_base** out_buf;
+		const Tx_token* token;
+	};
+
+	usb_driver_base* m_driver;
+
+	std::array<Rx_waiter, MAX_EP> m_rx_waiters;
+	std::array<Tx_waiter, MAX_EP> m_tx_waiters;
+};
+
+//control requests as a coroutine
+//	const Usb_coro_control::Request* req = co_await ctrl.next_setup();
+//	ctrl.complete(USB_common::USB_RESP::ACK, data, len);
+//register handle_request with USB_core::register_request or Vendor_class::register_request, ctx is the Usb_coro_control
+//requests are answered through USB_core's deferred path, so ep0 NAKs until complete is called
+class Usb_coro_control
+{
+public:
+
+	//longer data stages should use USB_core::register_stream_request
+	static constexpr size_t MAX_DATA_LEN = 64;
+
+	struct Request
+	{
+		uint32_t setup_id;
+		Setup_packet setup;
+		//HOST_TO_DEV data stage
+		std::array<uint8_t, MAX_DATA_LEN> data;
+		size_t len;
+	};
+
+	class Setup_awaitable
+	{
+	public:
+		explicit Setup_awaitable(Usb_coro_control* const ctrl)
+		{
+			m_ctrl = ctrl;
+			m_req  = nullptr;
+		}
+
+		bool await_ready();
+		bool await_suspend(std::coroutine_handle<> handle);
+		//valid until complete, nullptr if cancelled
+		const Request* await_resume()
+		{
+			return m_req;
+		}
+
+	protected:
+		Usb_coro_control* m_ctrl;
+		const Request* m_req;
+	};
+
+	Usb_coro_control();
+
+	bool initialize(USB_core* const core);
+
+	static USB_common::USB_RESP handle_request(void* ctx, Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host);
+
+	Setup_awaitable next_setup()
+	{
+		return Setup_awaitable(this);
+	}
+
+	//answer the request from next_setup, data is ignored for HOST_TO_DEV requests
+	//returns false if the host has moved on
+	bool complete(const USB_common::USB_RESP resp, const uint8_t* const data, const size_t len);
+
+	//wake the waiter with nullptr
+	void cancel();
+
+protected:
+
+	USB_common::USB_RESP handle_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host);
+
+	USB_core* m_core;
+
+	Request m_req;
+	//m_req arrived and next_setup has not taken it yet
+	bool m_req_ready;
+	//m_req was handed out and not completed
+	bool m_req_active;
+
+	std::coroutine_handle<> m_waiter;
+	const Request** m_waiter_out;
+};
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/core/usb_coro.hpp"
+
+#if defined(__cpp_impl_coroutine)
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+//host side executor, stands in for USB_core's event loop in tests and simulators
+//any thread may post events, the coroutines only run on the thread calling run
+class Usb_coro_executor_std : public Usb_coro_executor
+{
+public:
+
+	//bind the ep callbacks to post_event instead of handle_ep_event, so a fake driver can call them from any thread
+	bool bind_ep(const uint8_t ep)
+	{
+		const uint8_t ep_addr = USB_common::get_ep_addr(ep);
+		if((ep_addr == 0) || (ep_addr >= MAX_EP))
+		{
+			return false;
+		}
+
+		USB_common::Event_callback func = std::bind(&Usb_coro_executor_std::post_event, this, std::placeholders::_1, std::placeholders::_2);
+
+		if(USB_common::is_in_ep(ep))
+		{
+			return m_driver->set_ep_tx_callback(ep_addr, func);
+		}
+
+		return m_driver->set_ep_rx_callback(ep_addr, func);
+	}
+
+	void post_event(const USB_common::USB_EVENTS event, const uint8_t ep)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_events.push_back(Event{event, ep});
+		}
+		m_cv.notify_one();
+	}
+
+	//handle every queued event, returns the number handled
+	size_t run_pending()
+	{
+		size_t num = 0;
+		Event evt;
+		while(pop(&evt, std::chrono::milliseconds(0)))
+		{
+			handle_ep_event(evt.event, evt.ep);
+			num++;
+		}
+
+		return num;
+	}
+
+	//handle events until pred is true, returns false on timeout
+	template<typename PRED>
+	bool run_until(const PRED& pred, const std::chrono::milliseconds& timeout)
+	{
+		const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+
+		while(!pred())
+		{
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if(now >= deadline)
+			{
+				return false;
+			}
+
+			Event evt;
+			if(pop(&evt, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now)))
+			{
+				handle_ep_event(evt.event, evt.ep);
+			}
+		}
+
+		return true;
+	}
+
+protected:
+
+	struct Event
+	{
+		USB_common::USB_EVENTS event;
+		uint8_t ep;
+	};
+
+	bool pop(Event* const out_evt, const std::chrono::milliseconds& timeout)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if(!m_cv.wait_for(lock, timeout, [this](){return !m_events.empty();}))
+		{
+			return false;
+		}
+
+		*out_evt = m_events.front();
+		m_events.pop_front();
+
+		return true;
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::deque<Event> m_events;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/descriptor/Descriptor_base.hpp"
+
+#include "common_util/Intrusive_list.hpp"
+
+#include <array>
+#include <vector>
+
+#include <cstdint>
+
+//Binary device Object Store, read by the host when bcdUSB is 0x0201 or higher
+//device capability descriptors are linked into get_desc_list like the config descriptor children
+class BOS_descriptor : public Descriptor_base
+{
+public:
+
+	BOS_descriptor()
+	{
+
+	}
+
+	BOS_descriptor(const BOS_descriptor& rhs) = delete;
+	BOS_descriptor& operator=(const BOS_descriptor& rhs) = delete;
+
+	typedef std::array<uint8_t, 5> BOS_descriptor_array;
+
+	//wTotalLength and bNumDeviceCaps are computed from the capability list
+	bool serialize(BOS_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	size_t get_total_size() const
+	{
+		size_t total_size = size();
+
+		Descriptor_base const * desc_node = get_desc_list().front<Descriptor_base>();
+		while(desc_node)
+		{
+			total_size += desc_node->size();
+
+			desc_node = desc_node->next<Descriptor_base>();
+		}
+
+		return total_size;
+	}
+
+	size_t get_num_caps() const
+	{
+		size_t num = 0;
+
+		Descriptor_base const * desc_node = get_desc_list().front<Descriptor_base>();
+		while(desc_node)
+		{
+			num++;
+
+			desc_node = desc_node->next<Descriptor_base>();
+		}
+
+		return num;
+	}
+
+	Intrusive_list& get_desc_list()
+	{
+		return m_desc_list;
+	}
+
+	const Intrusive_list& get_desc_list() const
+	{
+		return m_desc_list;
+	}
+
+	static constexpr uint8_t bLength = 5;
+	static constexpr uint8_t bDescriptorType = 0x0F;
+
+protected:
+	Intrusive_list m_desc_list;
+};
+
+class Device_capability_descriptor : public Descriptor_base
+{
+public:
+
+	enum class CAPABILITY_TYPE
+	{
+		WIRELESS_USB                = 0x01,
+		USB20_EXTENSION             = 0x02,
+		SUPERSPEED_USB              = 0x03,
+		CONTAINER_ID                = 0x04,
+		PLATFORM                    = 0x05,
+		POWER_DELIVERY_CAPABILITY   = 0x06,
+		BATTERY_INFO_CAPABILITY     = 0x07,
+		PD_CONSUMER_PORT_CAPABILITY = 0x08,
+		PD_PROVIDER_PORT_CAPABILITY = 0x09,
+		SUPERSPEED_PLUS             = 0x0A,
+		PRECISION_TIME_MEASUREMENT  = 0x0B,
+		WIRELESS_USB_EXT            = 0x0C,
+		BILLBOARD                   = 0x0D,
+		AUTHENTICATION              = 0x0E,
+		BILLBOARD_EX                = 0x0F,
+		CONFIGURATION_SUMMARY       = 0x10
+	};
+
+	static constexpr uint8_t bDescriptorType = 0x10;
+};
+
+//USB 2.0 LPM support, required in the BOS of any HS capable device that reports bcdUSB 0x0201
+class USB20_extension_descriptor : public Device_capability_descriptor
+{
+public:
+
+	USB20_extension_descriptor()
+	{
+		bmAttributes = 0;
+	}
+
+	enum class ATTRIBUTES : uint32_t
+	{
+		LPM               = 0x00000002,
+		BESL_AND_ALT_HIRD = 0x00000004,
+		BASELINE_BESL     = 0x00000008,
+		DEEP_BESL         = 0x00000010
+	};
+
+	typedef std::array<uint8_t, 7> USB20_extension_descriptor_array;
+
+	bool serialize(USB20_extension_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+	bool deserialize(const USB20_extension_descriptor_array& array);
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	void set_lpm(const bool lpm)
+	{
+		set_attribute(ATTRIBUTES::LPM, lpm);
+		set_attribute(ATTRIBUTES::BESL_AND_ALT_HIRD, lpm);
+	}
+
+	//0 - 15, recommended BESL values per USB 2.0 LPM ECN
+	void set_baseline_besl(const uint8_t besl)
+	{
+		set_attribute(ATTRIBUTES::BASELINE_BESL, true);
+		bmAttributes = (bmAttributes & ~0x00000F00UL) | ((uint32_t(besl) & 0x0FU) << 8);
+	}
+	void set_deep_besl(const uint8_t besl)
+	{
+		set_attribute(ATTRIBUTES::DEEP_BESL, true);
+		bmAttributes = (bmAttributes & ~0x0000F000UL) | ((uint32_t(besl) & 0x0FU) << 12);
+	}
+
+	static constexpr uint8_t bLength = 7;
+	static constexpr uint8_t bDevCapabilityType = static_cast<uint8_t>(CAPABILITY_TYPE::USB20_EXTENSION);
+	uint32_t bmAttributes;
+
+protected:
+
+	void set_attribute(const ATTRIBUTES attr, const bool set)
+	{
+		if(set)
+		{
+			bmAttributes |= static_cast<uint32_t>(attr);
+		}
+		else
+		{
+			bmAttributes &= ~static_cast<uint32_t>(attr);
+		}
+	}
+};
+
+//vendor defined capability, identified by a UUID
+class Platform_capability_descriptor : public Device_capability_descriptor
+{
+public:
+
+	typedef std::array<uint8_t, 16> UUID_array;
+
+	Platform_capability_descriptor()
+	{
+		PlatformCapabilityUUID.fill(0);
+	}
+
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return 20 + CapabilityData.size();
+	}
+
+	static constexpr uint8_t bDevCapabilityType = static_cast<uint8_t>(CAPABILITY_TYPE::PLATFORM);
+	//in wire order, the first three fields of a GUID are little endian
+	UUID_array PlatformCapabilityUUID;
+	std::vector<uint8_t> CapabilityData;
+};
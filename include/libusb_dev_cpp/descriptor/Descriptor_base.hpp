@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "libusb_dev_cpp/core/usb_common.hpp"
+
 #include "libusb_dev_cpp/util/Buffer_adapter.hpp"
 
 #include "common_util/Intrusive_list.hpp"
@@ -22,6 +24,12 @@ public:
 
 	virtual bool serialize(Buffer_adapter_tx* const out_array) const = 0;
 
+	//descriptors with speed dependent fields override this, eg endpoint wMaxPacketSize
+	virtual bool serialize_for_speed(Buffer_adapter_tx* const out_array, const USB_common::USB_SPEED speed) const
+	{
+		return serialize(out_array);
+	}
+
 	virtual size_t size() const = 0;
 };
 
@@ -0,0 +1,62 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/descriptor/Descriptor_base.hpp"
+#include "libusb_dev_cpp/descriptor/Device_descriptor.hpp"
+
+#include <array>
+
+#include <cstdint>
+
+//describes the device as it would be at the other speed
+//only a HS capable device has one, a FS only device stalls the request
+class Device_qualifier_descriptor : public Descriptor_base
+{
+public:
+
+	Device_qualifier_descriptor()
+	{
+		bcdUSB             = 0;
+		bDeviceClass       = 0;
+		bDeviceSubClass    = 0;
+		bDeviceProtocol    = 0;
+		bMaxPacketSize0    = 0;
+		bNumConfigurations = 0;
+	}
+
+	//the fields are the same at both speeds for a device with one configuration set
+	explicit Device_qualifier_descriptor(const Device_descriptor& dev_desc)
+	{
+		bcdUSB             = dev_desc.bcdUSB;
+		bDeviceClass       = dev_desc.bDeviceClass;
+		bDeviceSubClass    = dev_desc.bDeviceSubClass;
+		bDeviceProtocol    = dev_desc.bDeviceProtocol;
+		bMaxPacketSize0    = dev_desc.bMaxPacketSize0;
+		bNumConfigurations = dev_desc.bNumConfigurations;
+	}
+
+	typedef std::array<uint8_t, 10> Device_qualifier_descriptor_array;
+
+	bool serialize(Device_qualifier_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+	bool deserialize(const Device_qualifier_descriptor_array& array);
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	static constexpr uint8_t bLength = 10;
+	static constexpr uint8_t bDescriptorType = 0x06;
+	uint16_t bcdUSB;
+	uint8_t  bDeviceClass;
+	uint8_t  bDeviceSubClass;
+	uint8_t  bDeviceProtocol;
+	uint8_t  bMaxPacketSize0;
+	uint8_t  bNumConfigurations;
+};
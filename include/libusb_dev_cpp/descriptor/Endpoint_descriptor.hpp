@@ -39,10 +39,26 @@ public:
 		EXPLICIT_FEEDBACK = 0x02
 	};
 
+	Endpoint_descriptor()
+	{
+		bEndpointAddress = 0;
+		bmAttributes     = 0;
+		wMaxPacketSize   = 0;
+		bInterval        = 0;
+
+		m_speed_adaptive = false;
+		m_fs_wMaxPacketSize = 0;
+		m_fs_bInterval      = 0;
+		m_hs_wMaxPacketSize = 0;
+		m_hs_bInterval      = 0;
+	}
+
 	typedef std::array<uint8_t, 7> Endpoint_descriptor_array;
 
 	bool serialize(Endpoint_descriptor_array* const out_array) const;
 	bool serialize(Buffer_adapter_tx* const out_array) const override;
+	//uses the per speed wMaxPacketSize and bInterval if set_speed_params was called
+	bool serialize_for_speed(Buffer_adapter_tx* const out_array, const USB_common::USB_SPEED speed) const override;
 	bool deserialize(const Endpoint_descriptor_array& array);
 
 	size_t size() const override
@@ -55,10 +71,70 @@ public:
 		return static_cast<ATTRIBUTE_TRANSFER>(bmAttributes & 0x03);
 	}
 
+	//sync and usage type are only valid for isochronous endpoints
+	ATTRIBUTE_SYNCHRONIZATION_TYPE get_ATTRIBUTE_SYNCHRONIZATION_TYPE() const
+	{
+		return static_cast<ATTRIBUTE_SYNCHRONIZATION_TYPE>((bmAttributes >> 2) & 0x03);
+	}
+
+	ATTRIBUTE_USAGE_TYPE get_ATTRIBUTE_USAGE_TYPE() const
+	{
+		return static_cast<ATTRIBUTE_USAGE_TYPE>((bmAttributes >> 4) & 0x03);
+	}
+
+	static constexpr uint8_t build_bmAttributes(const ATTRIBUTE_TRANSFER transfer, const ATTRIBUTE_SYNCHRONIZATION_TYPE sync, const ATTRIBUTE_USAGE_TYPE usage)
+	{
+		return (static_cast<uint8_t>(usage) << 4) | (static_cast<uint8_t>(sync) << 2) | static_cast<uint8_t>(transfer);
+	}
+
+	static constexpr uint8_t build_bmAttributes(const ATTRIBUTE_TRANSFER transfer)
+	{
+		return static_cast<uint8_t>(transfer);
+	}
+
+	//one descriptor for both speeds, the FS values are also used for LS
+	//bInterval is in frames on FS and in 2^(bInterval-1) microframes on HS
+	void set_speed_params(const uint16_t fs_wMaxPacketSize, const uint8_t fs_bInterval, const uint16_t hs_wMaxPacketSize, const uint8_t hs_bInterval)
+	{
+		m_speed_adaptive = true;
+		m_fs_wMaxPacketSize = fs_wMaxPacketSize;
+		m_fs_bInterval      = fs_bInterval;
+		m_hs_wMaxPacketSize = hs_wMaxPacketSize;
+		m_hs_bInterval      = hs_bInterval;
+	}
+
+	uint16_t get_wMaxPacketSize(const USB_common::USB_SPEED speed) const
+	{
+		if(!m_speed_adaptive)
+		{
+			return wMaxPacketSize;
+		}
+
+		return (speed == USB_common::USB_SPEED::HS) ? m_hs_wMaxPacketSize : m_fs_wMaxPacketSize;
+	}
+
+	uint8_t get_bInterval(const USB_common::USB_SPEED speed) const
+	{
+		if(!m_speed_adaptive)
+		{
+			return bInterval;
+		}
+
+		return (speed == USB_common::USB_SPEED::HS) ? m_hs_bInterval : m_fs_bInterval;
+	}
+
 	static constexpr uint8_t bLength = 7;
 	static constexpr uint8_t bDescriptorType = 0x05;
 	uint8_t bEndpointAddress;
 	uint8_t bmAttributes;
 	uint16_t wMaxPacketSize;
 	uint8_t bInterval;
+
+protected:
+
+	bool m_speed_adaptive;
+	uint16_t m_fs_wMaxPacketSize;
+	uint8_t m_fs_bInterval;
+	uint16_t m_hs_wMaxPacketSize;
+	uint8_t m_hs_bInterval;
 };
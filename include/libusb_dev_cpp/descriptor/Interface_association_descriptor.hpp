@@ -0,0 +1,55 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/descriptor/Descriptor_base.hpp"
+
+#include <array>
+
+#include <cstdint>
+
+//groups the interfaces of one function in a composite device
+//place directly in front of the first interface descriptor of the function
+//the device descriptor should use class 0xEF, subclass 0x02, protocol 0x01
+class Interface_association_descriptor : public Descriptor_base
+{
+public:
+
+	static constexpr uint8_t IAD_DEVICE_CLASS    = 0xEF;
+	static constexpr uint8_t IAD_DEVICE_SUBCLASS = 0x02;
+	static constexpr uint8_t IAD_DEVICE_PROTOCOL = 0x01;
+
+	Interface_association_descriptor()
+	{
+		bFirstInterface   = 0;
+		bInterfaceCount   = 0;
+		bFunctionClass    = 0;
+		bFunctionSubClass = 0;
+		bFunctionProtocol = 0;
+		iFunction         = 0;
+	}
+
+	typedef std::array<uint8_t, 8> Interface_association_descriptor_array;
+
+	bool serialize(Interface_association_descriptor_array* const out_array) const;
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+	bool deserialize(const Interface_association_descriptor_array& array);
+
+	size_t size() const override
+	{
+		return bLength;
+	}
+
+	static constexpr uint8_t bLength = 8;
+	static constexpr uint8_t bDescriptorType = 0x0B;
+	uint8_t bFirstInterface;
+	uint8_t bInterfaceCount;
+	uint8_t bFunctionClass;
+	uint8_t bFunctionSubClass;
+	uint8_t bFunctionProtocol;
+	uint8_t iFunction;
+};
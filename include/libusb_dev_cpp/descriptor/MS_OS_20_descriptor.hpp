@@ -0,0 +1,125 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/descriptor/BOS_descriptor.hpp"
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+//Microsoft OS 2.0 descriptor set builder
+//
+//the set is built once into a flat blob and served as is when the host sends the vendor request
+//bRequest = vendor code, wIndex = MS_OS_20_DESCRIPTOR_INDEX
+//
+//single function device:
+//	MS_OS_20_descriptor_set set(0x01);
+//	set.add_compatible_id("WINUSB");
+//	set.add_device_interface_guid("{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}");
+//	set.finalize();
+//
+//composite device, add a configuration subset then a function subset per WinUSB function
+//
+//link the capability from make_platform_capability into the BOS, and set bcdUSB to 0x0201
+class MS_OS_20_descriptor_set
+{
+public:
+
+	static constexpr uint32_t WINDOWS_VERSION_8_1 = 0x06030000;
+	static constexpr uint16_t MS_OS_20_DESCRIPTOR_INDEX = 0x07;
+	static constexpr uint16_t MS_OS_20_SET_ALT_ENUMERATION = 0x08;
+
+	//{D8DD60DF-4589-4CC7-9CD2-659D9E648A9F}
+	static constexpr Platform_capability_descriptor::UUID_array PLATFORM_UUID = {0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C, 0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F};
+
+	enum class DESCRIPTOR_TYPE : uint16_t
+	{
+		SET_HEADER_DESCRIPTOR       = 0x00,
+		SUBSET_HEADER_CONFIGURATION = 0x01,
+		SUBSET_HEADER_FUNCTION      = 0x02,
+		FEATURE_COMPATBLE_ID        = 0x03,
+		FEATURE_REG_PROPERTY        = 0x04,
+		FEATURE_MIN_RESUME_TIME     = 0x05,
+		FEATURE_MODEL_ID            = 0x06,
+		FEATURE_CCGP_DEVICE         = 0x07,
+		FEATURE_VENDOR_REVISION     = 0x08
+	};
+
+	enum class PROPERTY_DATA_TYPE : uint16_t
+	{
+		REG_SZ                  = 1,
+		REG_EXPAND_SZ           = 2,
+		REG_BINARY              = 3,
+		REG_DWORD_LITTLE_ENDIAN = 4,
+		REG_DWORD_BIG_ENDIAN    = 5,
+		REG_LINK                = 6,
+		REG_MULTI_SZ            = 7
+	};
+
+	explicit MS_OS_20_descriptor_set(const uint8_t vendor_code, const uint32_t windows_version = WINDOWS_VERSION_8_1);
+
+	//starts a new configuration subset, closing any open subsets
+	//windows expects the configuration index here, not bConfigurationValue
+	void add_configuration_subset(const uint8_t config_index);
+
+	//starts a new function subset, closing any open function subset
+	void add_function_subset(const uint8_t first_iface);
+
+	//eg "WINUSB", up to 8 ascii chars each
+	bool add_compatible_id(const char* compatible_id, const char* sub_compatible_id = "");
+
+	//name and string data are ascii, stored as UTF-16LE
+	bool add_registry_property(const PROPERTY_DATA_TYPE type, const char* name, const std::vector<uint8_t>& data);
+	bool add_registry_property(const PROPERTY_DATA_TYPE type, const char* name, const char* str);
+
+	//REG_MULTI_SZ DeviceInterfaceGUIDs, the path WinUSB clients open the device by
+	bool add_device_interface_guid(const char* guid);
+
+	//patch the subset and set lengths, call once after the last feature
+	bool finalize();
+
+	const std::vector<uint8_t>& get_data() const
+	{
+		return m_data;
+	}
+
+	size_t size() const
+	{
+		return m_data.size();
+	}
+
+	uint8_t get_vendor_code() const
+	{
+		return m_vendor_code;
+	}
+
+	//platform capability for the BOS, call after finalize
+	bool make_platform_capability(Platform_capability_descriptor* const out_cap) const;
+
+protected:
+
+	void close_function_subset();
+	void close_configuration_subset();
+
+	void append_u16(const uint16_t val);
+	void append_u32(const uint32_t val);
+	void append_utf16(const char* str);
+	void patch_u16(const size_t offset, const uint16_t val);
+
+	uint8_t m_vendor_code;
+	uint32_t m_windows_version;
+
+	static constexpr size_t NO_SUBSET = SIZE_MAX;
+	size_t m_config_offset;
+	size_t m_function_offset;
+
+	bool m_finalized;
+
+	std::vector<uint8_t> m_data;
+};
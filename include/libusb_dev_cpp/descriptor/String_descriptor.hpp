@@ -73,6 +73,7 @@ public:
 	//build from ascii
 	String_descriptor_n(const char msg[STRLEN])
 	{
+		bLength = 2;
 		for(size_t i = 0; i < STRLEN; i++)
 		{
 			if(msg[i] == 0)
@@ -82,9 +83,8 @@ public:
 			}
 
 			String_descriptor_base<STRLEN>::m_buf[i] = ascii_to_utf16le(msg[i]);
+			bLength = 2+(i+1)*2;
 		}
-
-		bLength = STRLEN+2;
 	}
 
 	typedef std::array<uint8_t, 2 + STRLEN*2> String_descriptor_array;
@@ -104,7 +104,7 @@ public:
 		(*out_array)[0] = bLength;
 		(*out_array)[1] = String_descriptor_base<STRLEN>::bDescriptorType;
 
-		for(size_t i = 0; i < (bLength - 2); i++)
+		for(size_t i = 0; i < ((bLength - 2) / 2); i++)
 		{
 			(*out_array)[2+2*i]   = Byte_util::get_b0(String_descriptor_base<STRLEN>::m_buf[i]);
 			(*out_array)[2+2*i+1] = Byte_util::get_b1(String_descriptor_base<STRLEN>::m_buf[i]);
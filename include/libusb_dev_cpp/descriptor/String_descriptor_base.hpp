@@ -21,18 +21,20 @@ public:
 
 	size_t size() const override;
 
+	//content produced at runtime, kept out of the flat table
+	virtual bool is_dynamic() const
+	{
+		return false;
+	}
+
+	//UTF-8, encoded to UTF-16LE on each serialize
+	//for fixed strings prefer String_descriptor_static, which is encoded at compile time
 	void assign(const char* str)
 	{
 		m_str = str;
 	}
 
 protected:
-	
-	static void ascii_to_utf16le(const uint8_t c, std::array<uint8_t, 2>* const buf)
-	{
-		(*buf)[0] = c;
-		(*buf)[1] = 0;
-	}
 
 	static constexpr uint8_t bDescriptorType = 0x03;
 	static constexpr size_t str_len_max = 126;
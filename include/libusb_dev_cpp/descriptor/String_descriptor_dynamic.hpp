@@ -0,0 +1,70 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/descriptor/String_descriptor_base.hpp"
+
+#include <array>
+#include <functional>
+
+//string whose text comes from a callback the first time the host asks for it, eg a serial number from the chip UID
+//the encoded descriptor is cached in a fixed buffer, so later requests are a copy with no formatting and no heap
+class String_descriptor_dynamic : public String_descriptor_base
+{
+public:
+
+	//write up to maxlen bytes of UTF-8 into buf, return the length used, need not be null terminated
+	typedef std::function<size_t (void*, char* const, const size_t)> Generate_callback;
+
+	String_descriptor_dynamic()
+	{
+		m_generate_callback_ctx = nullptr;
+		m_valid = false;
+		m_cache.fill(0);
+	}
+
+	String_descriptor_dynamic(const Generate_callback& callback, void* ctx)
+	{
+		m_generate_callback_func = callback;
+		m_generate_callback_ctx = ctx;
+		m_valid = false;
+		m_cache.fill(0);
+	}
+
+	void set_generate_callback(const Generate_callback& callback, void* ctx)
+	{
+		m_generate_callback_func = callback;
+		m_generate_callback_ctx = ctx;
+		m_valid = false;
+	}
+
+	//regenerate on the next request
+	void invalidate()
+	{
+		m_valid = false;
+	}
+
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override;
+
+	bool is_dynamic() const override
+	{
+		return true;
+	}
+
+protected:
+
+	void generate() const;
+
+	Generate_callback m_generate_callback_func;
+	void* m_generate_callback_ctx;
+
+	//filled on first use
+	mutable bool m_valid;
+	mutable std::array<uint8_t, 2 + 2 * str_len_max> m_cache;
+};
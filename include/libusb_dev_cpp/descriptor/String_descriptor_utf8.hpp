@@ -0,0 +1,246 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/descriptor/String_descriptor_base.hpp"
+
+#include <array>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Utf8
+{
+	constexpr uint32_t REPLACEMENT_CHAR = 0xFFFD;
+
+	//USB strings hold at most 126 UTF-16 code units
+	constexpr size_t MAX_CODE_UNITS = 126;
+
+	//not constexpr, so a bad or too long literal fails to compile when encoded at compile time
+	//at runtime a bad sequence becomes U+FFFD and a long string is truncated
+	inline uint32_t invalid_sequence()
+	{
+		return REPLACEMENT_CHAR;
+	}
+
+	//decode one code point starting at str[*idx], advances *idx
+	//a null byte is returned as 0 and does not advance
+	template<typename CHAR_T>
+	constexpr uint32_t decode(const CHAR_T* const str, size_t* const idx)
+	{
+		const uint8_t c0 = static_cast<uint8_t>(str[*idx]);
+		if(c0 == 0)
+		{
+			return 0;
+		}
+
+		size_t len = 0;
+		uint32_t cp = 0;
+		uint32_t min = 0;
+		if(c0 < 0x80)
+		{
+			(*idx)++;
+			return c0;
+		}
+		else if((c0 & 0xE0) == 0xC0)
+		{
+			len = 2;
+			cp  = c0 & 0x1F;
+			min = 0x80;
+		}
+		else if((c0 & 0xF0) == 0xE0)
+		{
+			len = 3;
+			cp  = c0 & 0x0F;
+			min = 0x800;
+		}
+		else if((c0 & 0xF8) == 0xF0)
+		{
+			len = 4;
+			cp  = c0 & 0x07;
+			min = 0x10000;
+		}
+		else
+		{
+			(*idx)++;
+			return invalid_sequence();
+		}
+
+		for(size_t i = 1; i < len; i++)
+		{
+			const uint8_t cn = static_cast<uint8_t>(str[*idx + i]);
+			if((cn & 0xC0) != 0x80)
+			{
+				//truncated, resync on the byte that broke the sequence
+				*idx += i;
+				return invalid_sequence();
+			}
+
+			cp = (cp << 6) | (cn & 0x3F);
+		}
+
+		*idx += len;
+
+		//overlong, surrogate, or out of range
+		if((cp < min) || ((cp >= 0xD800) && (cp <= 0xDFFF)) || (cp > 0x10FFFF))
+		{
+			return invalid_sequence();
+		}
+
+		return cp;
+	}
+
+	constexpr size_t utf16_units(const uint32_t cp)
+	{
+		return (cp >= 0x10000) ? 2 : 1;
+	}
+
+	//number of UTF-16 code units for a null terminated UTF-8 string, reading at most max_bytes
+	template<typename CHAR_T>
+	constexpr size_t utf16_len(const CHAR_T* const str, const size_t max_bytes)
+	{
+		size_t len = 0;
+		size_t idx = 0;
+		while(idx < max_bytes)
+		{
+			const uint32_t cp = decode(str, &idx);
+			if(cp == 0)
+			{
+				break;
+			}
+
+			len += utf16_units(cp);
+		}
+
+		return len;
+	}
+
+	//write cp as UTF-16LE at out[0..3], returns the number of bytes written
+	constexpr size_t encode_utf16le(const uint32_t cp, uint8_t* const out)
+	{
+		if(cp < 0x10000)
+		{
+			out[0] = static_cast<uint8_t>(cp & 0xFF);
+			out[1] = static_cast<uint8_t>((cp >> 8) & 0xFF);
+			return 2;
+		}
+
+		const uint32_t v  = cp - 0x10000;
+		const uint32_t hi = 0xD800 | ((v >> 10) & 0x3FF);
+		const uint32_t lo = 0xDC00 | (v & 0x3FF);
+
+		out[0] = static_cast<uint8_t>(hi & 0xFF);
+		out[1] = static_cast<uint8_t>((hi >> 8) & 0xFF);
+		out[2] = static_cast<uint8_t>(lo & 0xFF);
+		out[3] = static_cast<uint8_t>((lo >> 8) & 0xFF);
+		return 4;
+	}
+
+	inline size_t too_long()
+	{
+		return MAX_CODE_UNITS;
+	}
+}
+
+//a complete string descriptor, bLength, bDescriptorType and UTF-16LE text
+//sized for the worst case of one code unit per UTF-8 byte, bLength has the real size
+template<size_t N>
+struct Utf8_string_descriptor_data
+{
+	static constexpr size_t MAX_LEN = 2 + 2 * (N - 1);
+	static_assert(N >= 1, "string literal must be null terminated");
+
+	std::array<uint8_t, MAX_LEN> buf;
+
+	constexpr size_t size() const
+	{
+		return buf[0];
+	}
+
+	const uint8_t* data() const
+	{
+		return buf.data();
+	}
+};
+
+//encode a UTF-8 literal into a string descriptor
+//assign to a static constexpr so the result lives in flash
+//	static constexpr auto product_str = make_utf8_string_descriptor(u8"Capteur de débit µ");
+template<typename CHAR_T, size_t N>
+constexpr Utf8_string_descriptor_data<N> make_utf8_string_descriptor(const CHAR_T (&str)[N])
+{
+	Utf8_string_descriptor_data<N> out {};
+
+	size_t units = Utf8::utf16_len(str, N);
+	if(units > Utf8::MAX_CODE_UNITS)
+	{
+		units = Utf8::too_long();
+	}
+
+	out.buf[0] = static_cast<uint8_t>(2 + 2 * units);
+	out.buf[1] = 0x03;
+
+	size_t out_idx = 2;
+	size_t in_idx = 0;
+	while((in_idx < N) && (out_idx < out.buf[0]))
+	{
+		const uint32_t cp = Utf8::decode(str, &in_idx);
+		if(cp == 0)
+		{
+			break;
+		}
+
+		//a surrogate pair that would run past the limit is dropped
+		if((out_idx + 2 * Utf8::utf16_units(cp)) > out.buf[0])
+		{
+			break;
+		}
+
+		uint8_t tmp[4] = {0, 0, 0, 0};
+		const size_t n = Utf8::encode_utf16le(cp, tmp);
+		for(size_t i = 0; i < n; i++)
+		{
+			out.buf[out_idx + i] = tmp[i];
+		}
+		out_idx += n;
+	}
+
+	out.buf[0] = static_cast<uint8_t>(out_idx);
+
+	return out;
+}
+
+//refers to a pre-encoded descriptor, usually in flash, serialize is a copy
+class String_descriptor_static : public String_descriptor_base
+{
+public:
+
+	String_descriptor_static()
+	{
+		m_buf = nullptr;
+	}
+
+	//only the pointer is kept, desc must outlive this
+	template<size_t N>
+	explicit String_descriptor_static(const Utf8_string_descriptor_data<N>& desc)
+	{
+		m_buf = desc.data();
+	}
+	//a temporary would dangle
+	template<size_t N>
+	explicit String_descriptor_static(const Utf8_string_descriptor_data<N>&& desc) = delete;
+
+	bool serialize(Buffer_adapter_tx* const out_array) const override;
+
+	size_t size() const override
+	{
+		return (m_buf) ? m_buf[0] : 0;
+	}
+
+protected:
+	const uint8_t* m_buf;
+};
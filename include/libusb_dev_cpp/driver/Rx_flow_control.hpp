@@ -0,0 +1,149 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <array>
+#include <functional>
+
+#include <cstddef>
+#include <cstdint>
+
+//per OUT ep flow control, what the driver does when the application falls behind
+//
+//pending is the number of filled buffers handed to the application and not yet released
+//the driver calls the on_* hooks from its isr, or with its isr masked, so the state needs no locking
+//
+//policies, when no free buffer is left for the next packet
+//	NAK         - NAK only this ep until the application releases a buffer, other eps keep running
+//	DROP_OLDEST - take back the oldest buffer still queued for the application and reuse it
+//	              the manager's dequeue must be safe from the isr and a task at once
+//	              EP_buffer_mgr_freertos, _lockfree, _shared and _slab all are
+//	DROP_NEWEST - discard the packet just received and reuse its buffer
+//	BLOCK       - NAK this ep and hold off all OUT traffic until a release, the original behavior
+//
+//with a high watermark set, NAK also holds the ep once pending reaches it, before the pool runs dry,
+//and lets it go once pending falls back to the low watermark
+class Rx_flow_control
+{
+public:
+
+	static constexpr size_t MAX_EP = 8;
+
+	enum class POLICY
+	{
+		NAK,
+		DROP_OLDEST,
+		DROP_NEWEST,
+		BLOCK
+	};
+
+	enum class EVENT
+	{
+		//pending rose to the high watermark
+		HIGH_WATERMARK,
+		//pending fell back to the low watermark after a high
+		LOW_WATERMARK,
+		//no buffer for the next packet
+		UNDERRUN,
+		//a packet was thrown away
+		DROP
+	};
+
+	struct Config
+	{
+		Config()
+		{
+			policy         = POLICY::NAK;
+			high_watermark = 0;
+			low_watermark  = 0;
+		}
+
+		POLICY policy;
+		//0 disables the watermarks
+		size_t high_watermark;
+		size_t low_watermark;
+	};
+
+	//called from the usb isr, keep it short
+	typedef std::function<void (void*, const uint8_t, const EVENT, const size_t)> Event_callback;
+
+	Rx_flow_control();
+
+	//fails if the ep is out of range or low is above high
+	bool set_config(const uint8_t ep_addr, const Config& cfg);
+	const Config& get_config(const uint8_t ep_addr) const
+	{
+		return m_ep[ep_addr].cfg;
+	}
+
+	void set_event_callback(const Event_callback& func, void* ctx)
+	{
+		m_event_callback_func = func;
+		m_event_callback_ctx  = ctx;
+	}
+
+	//counters and hold state back to idle, the config is kept
+	//on bus reset or when the ep is configured
+	void reset(const uint8_t ep_addr);
+	void reset_all();
+
+	//driver side
+
+	//a filled buffer went to the application
+	//returns true if the ep should be held NAKed even though it has a buffer
+	bool on_queued(const uint8_t ep_addr);
+	//no buffer for the next packet, returns the policy to apply
+	POLICY on_underrun(const uint8_t ep_addr);
+	//a packet was discarded, eg DROP_NEWEST, or one arrived with no buffer loaded
+	void on_drop(const uint8_t ep_addr);
+	//DROP_OLDEST took a queued buffer back from the application
+	void on_reclaimed(const uint8_t ep_addr);
+	//the application released a buffer
+	//returns true if a held ep should be re-armed
+	bool on_released(const uint8_t ep_addr);
+
+	bool is_held(const uint8_t ep_addr) const
+	{
+		return m_ep[ep_addr].held;
+	}
+	size_t get_pending(const uint8_t ep_addr) const
+	{
+		return m_ep[ep_addr].pending;
+	}
+	size_t get_drop_count(const uint8_t ep_addr) const
+	{
+		return m_ep[ep_addr].drops;
+	}
+	size_t get_underrun_count(const uint8_t ep_addr) const
+	{
+		return m_ep[ep_addr].underruns;
+	}
+
+protected:
+
+	struct EP_state
+	{
+		Config cfg;
+
+		size_t pending;
+		bool above_high;
+		bool held;
+
+		size_t drops;
+		size_t underruns;
+	};
+
+	void fire(const uint8_t ep_addr, const EVENT event);
+
+	//pending dropped by one, fire LOW_WATERMARK if it crossed
+	void check_low(const uint8_t ep_addr);
+
+	std::array<EP_state, MAX_EP> m_ep;
+
+	Event_callback m_event_callback_func;
+	void* m_event_callback_ctx;
+};
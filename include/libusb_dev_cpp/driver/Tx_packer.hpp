@@ -0,0 +1,261 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/driver/usb_driver_base.hpp"
+
+#include "libusb_dev_cpp/util/EP_buffer_waiter.hpp"
+#include "libusb_dev_cpp/util/Mpsc_record_ring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+//many writers on one IN ep, eg several tasks logging to one bulk pipe
+//
+//writers copy records into a Mpsc_record_ring, no mutex and no driver call on the way in
+//whoever pumps packs the records, in the order they were written, back to back into IN buffers of up to max_len bytes
+//so many small records from different writers go out as a few full packets, and each writer's records keep their order
+//a part filled buffer is only sent when no transfer is on the wire, while one is it keeps filling
+//the host sees a byte stream, a record may be split across packets
+//
+//the packer owns the ep, its EP_TX events must come here, see bind_ep
+template<size_t SLOT_LEN, size_t NUM_SLOT, template<size_t> class WAIT_POLICY = EP_buffer_wait_spin>
+class Tx_packer
+{
+public:
+
+	typedef Mpsc_record_ring<SLOT_LEN, NUM_SLOT> Ring;
+
+	Tx_packer()
+	{
+		m_driver  = nullptr;
+		m_ep      = 0;
+		m_max_len = 0;
+
+		m_cur = nullptr;
+		m_rec_offset = 0;
+
+		m_in_flight.store(0);
+		m_pump_req.store(0);
+
+		m_num_packets = 0;
+		m_num_bytes   = 0;
+		m_num_full.store(0);
+	}
+
+	//max_len is usually the ep's max packet size, it is capped at the tx buffer size
+	bool initialize(usb_driver_base* const driver, const uint8_t ep, const size_t max_len)
+	{
+		if((max_len == 0) || !USB_common::is_in_ep(ep))
+		{
+			return false;
+		}
+
+		m_driver  = driver;
+		m_ep      = ep;
+		m_max_len = max_len;
+
+		return true;
+	}
+
+	//take the ep's tx callback, so USB_core's event loop pumps on EP_TX
+	bool bind_ep()
+	{
+		return m_driver->set_ep_tx_callback(USB_common::get_ep_addr(m_ep), std::bind(&Tx_packer::handle_ep_event, this, std::placeholders::_1, std::placeholders::_2));
+	}
+
+	//any task, false if the ring is full
+	bool poll_write(const uint8_t* const data, const size_t len)
+	{
+		if(!poll_write_isr(data, len))
+		{
+			return false;
+		}
+
+		pump();
+		return true;
+	}
+
+	//any task, block until there is room
+	//false if len is longer than the ring
+	bool wait_write(const uint8_t* const data, const size_t len)
+	{
+		if(len > Ring::MAX_RECORD_LEN)
+		{
+			return false;
+		}
+
+		m_waiter.wait_until(0, [this, data, len](){return m_ring.write(data, len);});
+
+		pump();
+		return true;
+	}
+
+	//from an isr, the record goes out on the next pump
+	bool poll_write_isr(const uint8_t* const data, const size_t len)
+	{
+		if(!m_ring.write(data, len))
+		{
+			m_num_full.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		return true;
+	}
+
+	//any task, move what writers have queued into IN buffers
+	//one caller packs at a time, a call while another is packing asks that one to go around again, so nothing waits on a lock
+	void pump()
+	{
+		if(m_pump_req.fetch_add(1, std::memory_order_acq_rel) != 0)
+		{
+			return;
+		}
+
+		//the requests this pumper has served, a call that came in during pack bumps the count and the cas fails
+		uint32_t seen = 1;
+		for(;;)
+		{
+			pack();
+
+			if(m_pump_req.compare_exchange_strong(seen, 0, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				break;
+			}
+		}
+	}
+
+	//from the usb task, one IN buffer finished
+	void handle_ep_event(const USB_common::USB_EVENTS event, const uint8_t ep)
+	{
+		if(event != USB_common::USB_EVENTS::EP_TX)
+		{
+			return;
+		}
+
+		if(m_in_flight.load(std::memory_order_acquire) != 0)
+		{
+			m_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+		}
+
+		pump();
+	}
+
+	//bus reset or SET_CONFIGURATION 0, after the ep is unconfigured
+	//queued records are kept and go out once the ep is configured again
+	void reset()
+	{
+		m_in_flight.store(0);
+	}
+
+	size_t get_packet_count() const
+	{
+		return m_num_packets;
+	}
+	size_t get_byte_count() const
+	{
+		return m_num_bytes;
+	}
+	//writes refused because the ring was full
+	size_t get_full_count() const
+	{
+		return m_num_full.load(std::memory_order_relaxed);
+	}
+
+protected:
+
+	//only from pump
+	void pack()
+	{
+		const uint8_t ep_addr = USB_common::get_ep_addr(m_ep);
+
+		for(;;)
+		{
+			size_t len = 0;
+			const uint8_t* const rec = m_ring.peek(&len);
+			if(rec == nullptr)
+			{
+				break;
+			}
+
+			if(m_cur == nullptr)
+			{
+				m_cur = m_driver->get_tx_buffer()->poll_allocate_buffer(ep_addr);
+				if(m_cur == nullptr)
+				{
+					//the next EP_TX frees one
+					return;
+				}
+				m_cur->reset();
+			}
+
+			const size_t max_len = std::min(m_max_len, m_cur->max_size());
+			const size_t num = std::min(max_len - m_cur->size(), len - m_rec_offset);
+			m_cur->insert(rec + m_rec_offset, num);
+
+			m_rec_offset += num;
+			if(m_rec_offset == len)
+			{
+				m_ring.pop();
+				m_rec_offset = 0;
+				m_waiter.wake(0);
+			}
+
+			if(m_cur->size() == max_len)
+			{
+				if(!send())
+				{
+					return;
+				}
+			}
+		}
+
+		//nothing left to pack, a short packet only goes if it would not wait behind another
+		if(m_cur && !m_cur->empty() && (m_in_flight.load(std::memory_order_acquire) == 0))
+		{
+			send();
+		}
+	}
+
+	bool send()
+	{
+		const size_t len = m_cur->size();
+
+		m_in_flight.fetch_add(1, std::memory_order_acq_rel);
+		if(!m_driver->enqueue_tx_buffer(m_ep, m_cur))
+		{
+			//try again after the next EP_TX
+			m_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+			return false;
+		}
+
+		m_cur = nullptr;
+		m_num_packets++;
+		m_num_bytes += len;
+
+		return true;
+	}
+
+	usb_driver_base* m_driver;
+	uint8_t m_ep;
+	size_t m_max_len;
+
+	Ring m_ring;
+	EP_buffer_waiter<1, WAIT_POLICY> m_waiter;
+
+	//consumer side, only touched inside pump
+	Buffer_adapter_base* m_cur;
+	size_t m_rec_offset;
+	size_t m_num_packets;
+	size_t m_num_bytes;
+
+	std::atomic<uint32_t> m_in_flight;
+	std::atomic<uint32_t> m_pump_req;
+
+	std::atomic<size_t> m_num_full;
+};
@@ -0,0 +1,187 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/Buffer_adapter.hpp"
+
+#include <atomic>
+#include <functional>
+
+#include <cstddef>
+#include <cstdint>
+
+//completion token for one IN buffer, pass it with usb_driver_base::enqueue_tx_buffer
+//
+//the application owns the token, it must stay alive until it completes
+//the driver fills in the timestamps as the buffer moves
+//	queued   - handed to the driver
+//	started  - loaded into the core's tx fifo
+//	complete - the host took it, XFRC, on bulk and interrupt eps this is the host's ACK
+//	           iso IN has no handshake, this is the (micro)frame it went out in
+//timestamps come from usb_driver_base::set_tx_timestamp_callback, or the frame number
+class Tx_token
+{
+public:
+
+	enum class STATE : uint8_t
+	{
+		IDLE,
+		QUEUED,
+		STARTED,
+		//sent
+		DONE,
+		//not sent, eg bus reset, ep unconfigured or an iso packet that missed its frame
+		ABORTED
+	};
+
+	//called from the usb isr, keep it short
+	typedef std::function<void (void*, Tx_token* const)> Complete_callback;
+
+	Tx_token();
+	virtual ~Tx_token();
+
+	void set_complete_callback(const Complete_callback& func, void* ctx)
+	{
+		m_complete_callback_func = func;
+		m_complete_callback_ctx  = ctx;
+	}
+
+	STATE get_state() const
+	{
+		return m_state.load();
+	}
+
+	bool is_pending() const
+	{
+		const STATE state = get_state();
+		return (state == STATE::QUEUED) || (state == STATE::STARTED);
+	}
+
+	bool is_complete() const
+	{
+		const STATE state = get_state();
+		return (state == STATE::DONE) || (state == STATE::ABORTED);
+	}
+
+	uint8_t get_ep() const
+	{
+		return m_ep;
+	}
+	size_t get_len() const
+	{
+		return m_len;
+	}
+
+	uint32_t get_queued_time() const
+	{
+		return m_queued_time;
+	}
+	uint32_t get_started_time() const
+	{
+		return m_started_time;
+	}
+	uint32_t get_complete_time() const
+	{
+		return m_complete_time;
+	}
+
+	//driver side, with the usb isr masked or from it
+
+	//fails if the token is still pending
+	bool queue(const uint8_t ep, const Buffer_adapter_base* const buf, const uint32_t now);
+	void start(const uint32_t now);
+	void complete(const STATE state, const uint32_t now);
+
+protected:
+
+	friend class Tx_token_queue;
+
+	//runs after the callback, so a waiter sees a finished token
+	virtual void on_complete()
+	{
+
+	}
+
+	std::atomic<STATE> m_state;
+
+	uint8_t m_ep;
+	size_t m_len;
+	const Buffer_adapter_base* m_buf;
+
+	uint32_t m_queued_time;
+	uint32_t m_started_time;
+	uint32_t m_complete_time;
+
+	Tx_token* m_next;
+
+	Complete_callback m_complete_callback_func;
+	void* m_complete_callback_ctx;
+};
+
+//tokens for one IN ep in the order the buffers were queued, an intrusive list so it never allocates
+//buffers queued without a token are not in the list, a token is matched to its buffer by address
+//use with the usb isr masked, or from it
+class Tx_token_queue
+{
+public:
+
+	Tx_token_queue()
+	{
+		m_head = nullptr;
+		m_tail = nullptr;
+	}
+
+	bool empty() const
+	{
+		return m_head == nullptr;
+	}
+
+	void push(Tx_token* const token);
+
+	//buf was loaded into the fifo
+	void on_started(const Buffer_adapter_base* const buf, const uint32_t now);
+	//buf left the ep, state is DONE or ABORTED
+	void on_finished(const Buffer_adapter_base* const buf, const Tx_token::STATE state, const uint32_t now);
+	//everything still queued is dropped
+	void abort_all(const uint32_t now);
+
+protected:
+
+	Tx_token* pop();
+
+	Tx_token* m_head;
+	Tx_token* m_tail;
+};
+
+//a token the application can block on
+//WAIT_POLICY is one of the EP buffer wait policies, eg EP_buffer_wait_freertos or EP_buffer_wait_std
+template<template<size_t> class WAIT_POLICY>
+class Tx_future : public Tx_token
+{
+public:
+
+	//block until the host took the buffer or it was dropped
+	//returns true if it was sent
+	bool wait()
+	{
+		while(!is_complete())
+		{
+			m_wait.wait(0);
+		}
+
+		return get_state() == STATE::DONE;
+	}
+
+protected:
+
+	void on_complete() override
+	{
+		m_wait.notify(0);
+	}
+
+	WAIT_POLICY<1> m_wait;
+};
@@ -37,4 +37,24 @@ public:
 			: "memory"
 		);
 	}
+
+	static inline void wait_for_event()
+	{
+		asm volatile(
+			"wfe\n"
+			: /* no out */
+			: /* no in */
+			: "memory"
+		);
+	}
+	static inline void send_event()
+	{
+		asm volatile(
+			"dsb SY\n"
+			"sev\n"
+			: /* no out */
+			: /* no in */
+			: "memory"
+		);
+	}
 };
@@ -38,9 +38,18 @@ public:
 	int ep_read(const uint8_t ep, uint8_t* const buf, const uint16_t max_len) override;
 
 	uint16_t get_frame_number() override;
+	//the 96 bit device unique ID
+	size_t get_serial_number(uint8_t* const buf, const size_t maxlen) override;
 
 	USB_common::USB_SPEED get_speed() const override;
 
+	bool set_test_mode(const uint8_t selector) override;
+
+	bool remote_wakeup() override;
+	void remote_wakeup_end() override;
+	bool set_lpm_enable(const bool enable) override;
+	bool set_phy_clock_gate(const bool gate) override;
+
 	void poll(const USB_common::Event_callback& func) override;
 
 	const ep_cfg& get_ep0_config() const override;
@@ -62,11 +71,7 @@ public:
 	Buffer_adapter_base* wait_tx_buffer(const uint8_t ep) override;
 	//application give buffer to driver for transmission
 	bool enqueue_tx_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override;
-
-	size_t get_serial_number(uint8_t* const buf, const size_t maxlen)
-	{
-		return 0;
-	}
+	bool enqueue_tx_buffer(const uint8_t ep, Buffer_adapter_base* const buf, Tx_token* const token) override;
 
 protected:
 
@@ -85,10 +90,25 @@ protected:
 
 	STATE m_state;
 
+	//set by the LPM interrupt, cleared on resume or reset
+	volatile bool m_l1_active;
+
 	void set_data0(const uint8_t ep) override;
 
 	bool handle_iepintx(const USB_common::Event_callback& func);
 	bool handle_oepintx(const USB_common::Event_callback& func);
+	bool handle_incomplete_iso_in(const USB_common::Event_callback& func);
+
+	//iso eps only transfer in the (micro)frame matching their even/odd setting
+	//returns the DxEPCTL bit to target the next (micro)frame
+	uint32_t get_next_frame_parity();
+	bool is_iso_in_ep(const uint8_t ep_addr);
+	bool is_iso_out_ep(const uint8_t ep_addr);
+
+	//pop a packet from the rx fifo that has nowhere to go
+	void ep_discard(const uint16_t len);
+	//clear NAK and enable an OUT ep with a buffer loaded
+	void arm_out_ep(const uint8_t ep_addr);
 
 	void flush_rx();
 	void flush_tx(const uint8_t ep);
@@ -97,12 +117,14 @@ protected:
 	void core_reset();
 
 	static bool config_ep_tx_fifo(const uint8_t ep, const size_t len);
+	bool replan_tx_fifo();
 
 	static constexpr size_t MAX_NUM_EP = 8;//ep0 + ep1..ep8
 	static constexpr size_t MAX_RX_PACKET = 512;
 	static constexpr size_t RX_FIFO_SIZE = (5*1+8) + 2*(MAX_RX_PACKET/4+1) + (2*9) + 1;//maybe use 1280?
 	static constexpr size_t MAX_FIFO_LEN_U32 = 1024; //uint32 * 1024, 4096B
 	static constexpr size_t MAX_FIFO_LEN_U8  = 4096; //uint8  * 4096, 4096B
+	static constexpr size_t PARK_FIFO_LEN_U32 = 16; //shared by unconfigured IN eps at the top of fifo ram
 
 	ep_cfg m_ep0_cfg;
 	std::array<ep_cfg, MAX_NUM_EP> m_rx_ep_cfg;
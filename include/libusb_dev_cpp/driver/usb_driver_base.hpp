@@ -10,9 +10,15 @@
 
 #include "libusb_dev_cpp/core/Setup_packet.hpp"
 
+#include "libusb_dev_cpp/driver/Rx_flow_control.hpp"
+#include "libusb_dev_cpp/driver/Tx_token.hpp"
+
 #include "libusb_dev_cpp/util/Buffer_adapter.hpp"
+#include "libusb_dev_cpp/util/Cache_line.hpp"
 #include "libusb_dev_cpp/util/EP_buffer_mgr_base.hpp"
 
+#include <atomic>
+
 #include <cstdint>
 #include <cstddef>
 
@@ -65,21 +71,30 @@ public:
 	};
 
 	static size_t get_max_bulk_ep_size(const USB_SPEED& speed)
+	{
+		return get_max_bulk_ep_size(to_common_speed(speed));
+	}
+
+	//bulk is not allowed on LS
+	static size_t get_max_bulk_ep_size(const USB_common::USB_SPEED& speed)
 	{
 		size_t size = 0;
 		switch(speed)
 		{
-			case USB_SPEED::LS:
+			case USB_common::USB_SPEED::LS:
 			{
-				size = 64;
+				size = 0;
+				break;
 			}
-			case USB_SPEED::FS:
+			case USB_common::USB_SPEED::FS:
 			{
-				size = 64;	
+				size = 64;
+				break;
 			}
-			case USB_SPEED::HS:
+			case USB_common::USB_SPEED::HS:
 			{
 				size = 512;
+				break;
 			}
 			default:
 			{
@@ -88,7 +103,92 @@ public:
 		}
 
 		return size;
-	};
+	}
+
+	static size_t get_max_interrupt_ep_size(const USB_common::USB_SPEED& speed)
+	{
+		size_t size = 0;
+		switch(speed)
+		{
+			case USB_common::USB_SPEED::LS:
+			{
+				size = 8;
+				break;
+			}
+			case USB_common::USB_SPEED::FS:
+			{
+				size = 64;
+				break;
+			}
+			case USB_common::USB_SPEED::HS:
+			{
+				size = 1024;
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+
+		return size;
+	}
+
+	//single transaction per microframe on HS
+	static size_t get_max_iso_ep_size(const USB_common::USB_SPEED& speed)
+	{
+		size_t size = 0;
+		switch(speed)
+		{
+			case USB_common::USB_SPEED::LS:
+			{
+				size = 0;
+				break;
+			}
+			case USB_common::USB_SPEED::FS:
+			{
+				size = 1023;
+				break;
+			}
+			case USB_common::USB_SPEED::HS:
+			{
+				size = 1024;
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+
+		return size;
+	}
+
+	static USB_common::USB_SPEED to_common_speed(const USB_SPEED& speed)
+	{
+		USB_common::USB_SPEED out = USB_common::USB_SPEED::FS;
+		switch(speed)
+		{
+			case USB_SPEED::LS:
+			{
+				out = USB_common::USB_SPEED::LS;
+				break;
+			}
+			case USB_SPEED::HS:
+			{
+				out = USB_common::USB_SPEED::HS;
+				break;
+			}
+			case USB_SPEED::FS:
+			default:
+			{
+				out = USB_common::USB_SPEED::FS;
+				break;
+			}
+		}
+
+		return out;
+	}
 
 	usb_driver_base();
 	virtual ~usb_driver_base() = default;
@@ -117,13 +217,60 @@ public:
 
 	virtual uint16_t get_frame_number() = 0;
 	virtual size_t get_serial_number(uint8_t* const buf, const size_t maxlen) = 0;
+	//get_serial_number as upper case hex text, for a String_descriptor_dynamic callback
+	size_t get_serial_number_string(char* const buf, const size_t maxlen);
 
 	virtual USB_common::USB_SPEED get_speed() const = 0;
 
+	//enter a SET_FEATURE(TEST_MODE) test mode, 1 TEST_J to 5 TEST_FORCE_ENABLE
+	//called after the status stage, only a power cycle leaves it
+	virtual bool set_test_mode(const uint8_t selector)
+	{
+		return false;
+	}
+
+	//start resume signaling to wake the host from suspend or LPM L1, does not block
+	//USB_core calls remote_wakeup_end from the usb task once the signaling has lasted long enough
+	//returns false if the bus is not asleep, or the host did not allow remote wakeup for this L1 entry
+	virtual bool remote_wakeup()
+	{
+		return false;
+	}
+
+	//stop resume signaling, a no-op if the driver or the core already stopped it
+	virtual void remote_wakeup_end()
+	{
+
+	}
+
+	//ack LPM L1 requests, the BOS also needs a USB 2.0 extension descriptor with the LPM bit
+	virtual bool set_lpm_enable(const bool enable)
+	{
+		return false;
+	}
+
+	//stop the PHY and core clocks while suspended, the driver ungates them itself on resume or remote wakeup
+	//returns false if not supported or the bus is not suspended
+	virtual bool set_phy_clock_gate(const bool gate)
+	{
+		return false;
+	}
+
 	bool set_ep_rx_callback(const uint8_t ep, const USB_common::Event_callback& func);
 	bool set_ep_tx_callback(const uint8_t ep, const USB_common::Event_callback& func);
 	bool set_ep_setup_callback(const uint8_t ep, const USB_common::Event_callback& func);
 
+	//an OUT ep other than ep0 posts EP_RX for queued packets only if someone takes them
+	//USB_core enables the OUT eps of each function passed to add_usb_class, a rx callback enables its ep
+	//at most one EP_RX is pending per ep, so the handler must dequeue every buffer queued
+	void set_ep_rx_event_enable(const uint8_t ep_addr, const bool enable);
+
+	//the driver calls this when it queues a packet, true if it should post EP_RX
+	bool claim_ep_rx_event(const uint8_t ep_addr);
+
+	//the core calls this before it handles EP_RX, so a packet queued from then on posts again
+	void clear_ep_rx_event(const uint8_t ep_addr);
+
 	const USB_common::Event_callback& get_event_callback(const uint8_t ep_addr) const
 	{
 		return m_event_callbacks[ep_addr];
@@ -131,17 +278,17 @@ public:
 
 	const USB_common::Event_callback& get_ep_rx_callback(const uint8_t ep_addr) const
 	{
-		return m_ep_rx_callbacks[ep_addr];
+		return m_ep_callbacks[ep_addr].rx;
 	}
 
 	const USB_common::Event_callback& get_ep_tx_callback(const uint8_t ep_addr) const
 	{
-		return m_ep_tx_callbacks[ep_addr];
+		return m_ep_callbacks[ep_addr].tx;
 	}
 
 	const USB_common::Event_callback& get_ep_setup_callback(const uint8_t ep_addr) const
 	{
-		return m_ep_setup_callbacks[ep_addr];
+		return m_ep_callbacks[ep_addr].setup;
 	}
 
 	virtual void poll(const USB_common::Event_callback& func) = 0;
@@ -184,6 +331,12 @@ public:
 		return m_rx_buffer;
 	}
 
+	//what the driver does when an OUT ep runs out of buffers, set per ep before connecting
+	Rx_flow_control* get_rx_flow_control()
+	{
+		return &m_rx_flow;
+	}
+
 	//application waits for a buffer with data
 	//this might be better as a stream thing rather than buffer exchange
 	virtual Buffer_adapter_base* wait_rx_buffer(const uint8_t ep) = 0;
@@ -193,7 +346,23 @@ public:
 	//application wait for usable tx buffer
 	virtual Buffer_adapter_base* wait_tx_buffer(const uint8_t ep) = 0;
 	//application give buffer to driver for transmission
+	//one task per IN ep, the lock free buffer managers take a single producer per ep, use Tx_packer to share an ep
 	virtual bool enqueue_tx_buffer(const uint8_t ep, Buffer_adapter_base* const buf) = 0;
+	//as above, token tracks the buffer until the host takes it, may be nullptr
+	//fails if the token is still pending, or the driver does not support tokens
+	virtual bool enqueue_tx_buffer(const uint8_t ep, Buffer_adapter_base* const buf, Tx_token* const token);
+
+	//free running time base for the Tx_token timestamps, eg a us timer
+	//defaults to the (micro)frame number, set before connecting
+	typedef std::function<uint32_t (void*)> Timestamp_callback;
+	void set_tx_timestamp_callback(const Timestamp_callback& func, void* ctx)
+	{
+		m_tx_timestamp_callback_func = func;
+		m_tx_timestamp_callback_ctx  = ctx;
+	}
+
+	//no IN ep has a buffer loaded, and so none queued behind one
+	virtual bool is_tx_idle();
 
 	virtual bool handle_reset();
 	virtual bool handle_enum_done();
@@ -204,8 +373,34 @@ protected:
 	EP_buffer_mgr_base* m_tx_buffer;
 	EP_buffer_mgr_base* m_rx_buffer;
 
+	Rx_flow_control m_rx_flow;
+
+	uint32_t get_tx_timestamp();
+
+	//drivers call these as IN buffers move, with the usb isr masked or from it
+	//they cost nothing on an ep with no tokens queued
+	void tx_token_started(const uint8_t ep_addr, const Buffer_adapter_base* const buf);
+	void tx_token_finished(const uint8_t ep_addr, const Buffer_adapter_base* const buf, const Tx_token::STATE state);
+	void tx_token_abort(const uint8_t ep_addr);
+
+	//per IN ep
+	std::array<Tx_token_queue, 8> m_tx_tokens;
+
+	Timestamp_callback m_tx_timestamp_callback_func;
+	void* m_tx_timestamp_callback_ctx;
+
+	//the callbacks and rx event flags for one ep sit on their own cache lines,
+	//so the isr claiming an event on one ep does not share a line with a task on another
+	struct alignas(CACHE_LINE_SIZE) EP_callbacks
+	{
+		USB_common::Event_callback rx;
+		USB_common::Event_callback tx;
+		USB_common::Event_callback setup;
+
+		std::atomic<bool> rx_event_enable;
+		std::atomic<bool> rx_event_pending;
+	};
+
 	std::array<USB_common::Event_callback, USB_common::USB_EVENTS_MAX> m_event_callbacks;
-	std::array<USB_common::Event_callback, 8>                          m_ep_rx_callbacks;
-	std::array<USB_common::Event_callback, 8>                          m_ep_tx_callbacks;
-	std::array<USB_common::Event_callback, 8>                          m_ep_setup_callbacks;
+	std::array<EP_callbacks, 8>                                        m_ep_callbacks;
 };
\ No newline at end of file
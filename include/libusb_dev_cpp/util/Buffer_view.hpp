@@ -0,0 +1,157 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <algorithm>
+
+//how insert moves rem_len
+//tx counts up what is left to send, rx counts down what is left to receive
+struct Buffer_view_policy_none
+{
+	static void on_insert(size_t* const rem_len, const size_t num)
+	{
+
+	}
+};
+struct Buffer_view_policy_tx
+{
+	static void on_insert(size_t* const rem_len, const size_t num)
+	{
+		*rem_len += num;
+	}
+};
+struct Buffer_view_policy_rx
+{
+	static void on_insert(size_t* const rem_len, const size_t num)
+	{
+		*rem_len -= num;
+	}
+};
+
+//a view of caller owned memory, pointer, size, max size and a transfer cursor
+//no virtual functions, so insert inlines into descriptor serialize and the ep0 copy loops
+template <typename T, typename POLICY>
+class Buffer_view_T
+{
+public:
+
+	Buffer_view_T()
+	{
+		clear();
+	}
+
+	Buffer_view_T(T* const buf_ptr, const size_t buf_max)
+	{
+		reset(buf_ptr, buf_max);
+	}
+
+	void reset()
+	{
+		m_buf_size  = 0;
+
+		curr_ptr = m_buf_ptr;
+		rem_len  = 0;
+	}
+
+	void reset(T* const buf, const size_t maxlen)
+	{
+		m_buf_ptr  = buf;
+		m_buf_max  = maxlen;
+		m_buf_size = 0;
+
+		curr_ptr = m_buf_ptr;
+		rem_len  = 0;
+	}
+
+	size_t insert(const T& buf)
+	{
+		if(full())
+		{
+			return 0;
+		}
+
+		m_buf_ptr[m_buf_size] = buf;
+		m_buf_size++;
+
+		POLICY::on_insert(&rem_len, 1);
+
+		return 1;
+	}
+
+	size_t insert(const T* buf_ptr, const size_t len)
+	{
+		const size_t num_to_copy = std::min(len, capacity());
+		std::copy_n(buf_ptr, num_to_copy, m_buf_ptr + m_buf_size);
+
+		m_buf_size += num_to_copy;
+
+		POLICY::on_insert(&rem_len, num_to_copy);
+
+		return num_to_copy;
+	}
+
+	T* data()
+	{
+		return m_buf_ptr;
+	}
+	const T* data() const
+	{
+		return m_buf_ptr;
+	}
+
+	bool full() const
+	{
+		return m_buf_size == m_buf_max;
+	}
+	bool empty() const
+	{
+		return m_buf_size == 0;
+	}
+
+	size_t size() const
+	{
+		return m_buf_size;
+	}
+	size_t capacity() const
+	{
+		return m_buf_max - m_buf_size;
+	}
+	size_t max_size() const
+	{
+		return m_buf_max;
+	}
+
+	void resize(const size_t len)
+	{
+		m_buf_size = len;
+	}
+
+	//remaining length
+	size_t rem_len;
+
+	//current position in buffer
+	T* curr_ptr;
+
+protected:
+
+	void clear()
+	{
+		m_buf_ptr  = nullptr;
+		m_buf_max  = 0;
+		m_buf_size = 0;
+
+		curr_ptr = nullptr;
+		rem_len  = 0;
+	}
+
+	T* m_buf_ptr;
+	size_t m_buf_max;
+	size_t m_buf_size;
+};
@@ -0,0 +1,20 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <cstddef>
+
+//data cache line size, for padding state that different cores or an isr and a task write
+//Cortex-M7 has 32 byte lines, hosts are assumed to have 64
+//define LIBUSB_DEV_CPP_CACHE_LINE_SIZE to override
+#if defined(LIBUSB_DEV_CPP_CACHE_LINE_SIZE)
+	constexpr size_t CACHE_LINE_SIZE = LIBUSB_DEV_CPP_CACHE_LINE_SIZE;
+#elif defined(__arm__)
+	constexpr size_t CACHE_LINE_SIZE = 32;
+#else
+	constexpr size_t CACHE_LINE_SIZE = 64;
+#endif
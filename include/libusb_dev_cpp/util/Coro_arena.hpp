@@ -0,0 +1,111 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/Lockfree_index_stack.hpp"
+
+#include <array>
+
+#include <cstddef>
+#include <cstdint>
+
+//fixed size blocks for coroutine frames, so spawning an endpoint state machine never touches the heap
+class Coro_arena_base
+{
+public:
+
+	virtual ~Coro_arena_base()
+	{
+
+	}
+
+	//nullptr if len does not fit a block or the arena is full
+	virtual void* allocate(const size_t len) = 0;
+	virtual void deallocate(void* const ptr) = 0;
+
+	//arena for coroutine frames created from now on, set before spawning
+	static void set_default(Coro_arena_base* const arena)
+	{
+		m_default = arena;
+	}
+	static Coro_arena_base* get_default()
+	{
+		return m_default;
+	}
+
+protected:
+	static Coro_arena_base* m_default;
+};
+
+//NUM_BLOCK blocks of BLOCK_LEN bytes
+//size BLOCK_LEN from the largest frame, eg log get_max_request from a debug build
+template<size_t BLOCK_LEN, size_t NUM_BLOCK>
+class Coro_arena : public Coro_arena_base
+{
+public:
+
+	static constexpr size_t ALIGN = alignof(std::max_align_t);
+	static constexpr size_t STRIDE = (BLOCK_LEN + ALIGN - 1) & ~(ALIGN - 1);
+
+	Coro_arena()
+	{
+		m_free.fill();
+		m_max_request = 0;
+	}
+
+	void* allocate(const size_t len) override
+	{
+		if(len > m_max_request)
+		{
+			m_max_request = len;
+		}
+
+		if(len > BLOCK_LEN)
+		{
+			return nullptr;
+		}
+
+		uint16_t idx = 0;
+		if(!m_free.pop(&idx))
+		{
+			return nullptr;
+		}
+
+		return m_mem.data() + size_t(idx) * STRIDE;
+	}
+
+	void deallocate(void* const ptr) override
+	{
+		const size_t offset = static_cast<uint8_t*>(ptr) - m_mem.data();
+		m_free.push(offset / STRIDE);
+	}
+
+	bool owns(const void* const ptr) const
+	{
+		const uint8_t* const p = static_cast<const uint8_t*>(ptr);
+		return (p >= m_mem.data()) && (p < (m_mem.data() + m_mem.size()));
+	}
+
+	bool full() const
+	{
+		return m_free.empty();
+	}
+
+	//largest frame asked for, including ones that did not fit
+	size_t get_max_request() const
+	{
+		return m_max_request;
+	}
+
+protected:
+
+	alignas(ALIGN) std::array<uint8_t, STRIDE * NUM_BLOCK> m_mem;
+
+	Lockfree_index_stack<NUM_BLOCK> m_free;
+
+	size_t m_max_request;
+};
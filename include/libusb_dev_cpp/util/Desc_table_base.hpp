@@ -53,6 +53,42 @@ public:
 		return it->second;
 	}
 
+	//func(idx, desc) for every entry in index order
+	template <typename F>
+	void for_each(F func) const
+	{
+		for(const auto& entry : m_table)
+		{
+			func(entry.first, Desc_const_ptr(entry.second));
+		}
+	}
+
+	void clear()
+	{
+		m_table.clear();
+	}
+
+	template<typename F>
+	void remove_if(F pred)
+	{
+		for(auto it = m_table.begin(); it != m_table.end(); )
+		{
+			if(pred(it->first, Desc_const_ptr(it->second)))
+			{
+				it = m_table.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	bool empty() const
+	{
+		return m_table.empty();
+	}
+
 private:
 
 	std::map<uint8_t, Desc_ptr> m_table;
@@ -9,11 +9,16 @@
 #include "libusb_dev_cpp/core/usb_common.hpp"
 
 #include "libusb_dev_cpp/descriptor/Device_descriptor.hpp"
+#include "libusb_dev_cpp/descriptor/Device_qualifier_descriptor.hpp"
+#include "libusb_dev_cpp/descriptor/BOS_descriptor.hpp"
+#include "libusb_dev_cpp/descriptor/MS_OS_20_descriptor.hpp"
+#include "libusb_dev_cpp/descriptor/String_descriptor_utf8.hpp"
 
 #include "libusb_dev_cpp/util/Config_desc_table.hpp"
 #include "libusb_dev_cpp/util/Iface_desc_table.hpp"
 #include "libusb_dev_cpp/util/String_desc_table.hpp"
 #include "libusb_dev_cpp/util/Endpoint_desc_table.hpp"
+#include "libusb_dev_cpp/util/Flat_desc_table.hpp"
 
 #include <list>
 
@@ -42,6 +47,17 @@ public:
 		return m_dev_desc;
 	}
 
+	//set for HS capable devices only
+	void set_device_qualifier_descriptor(const Device_qualifier_descriptor& desc)
+	{
+		m_dev_qual_desc = std::make_shared<Device_qualifier_descriptor>(desc);
+	}
+
+	std::shared_ptr<const Device_qualifier_descriptor> get_device_qualifier_descriptor() const
+	{
+		return m_dev_qual_desc;
+	}
+
 	// void set_config_descriptor(const Configuration_descriptor& desc, const uint8_t idx)
 	// {
 	// 	m_config_table.set_config(idx, desc);
@@ -92,16 +108,31 @@ public:
 		return m_endpoint_table.get_config(idx);
 	}
 
+	//the LANGID zero descriptor is generated from the languages registered here, unless one is set explicitly
 	void set_string_descriptor(const String_descriptor_base& desc, const String_descriptor_zero::LANGID lang, const uint8_t idx)
 	{
 		String_desc_table* const string_table = m_string_table.get_table(lang);
 		string_table->set_config(idx, desc);
+		update_lang_zero();
 	}
 	void set_string_descriptor(const String_desc_table::String_desc_ptr& desc, const String_descriptor_zero::LANGID lang, const uint8_t idx)
 	{
 		String_desc_table* const string_table = m_string_table.get_table(lang);
 		string_table->set_config(idx, desc);
+		update_lang_zero();
 	}
+	//compile time encoded, eg from make_utf8_string_descriptor
+	//only the pointer is kept, desc must outlive the table, eg a static constexpr
+	template<size_t N>
+	void set_string_descriptor(const Utf8_string_descriptor_data<N>& desc, const String_descriptor_zero::LANGID lang, const uint8_t idx)
+	{
+		String_desc_table* const string_table = m_string_table.get_table(lang);
+		string_table->set_config(idx, String_descriptor_static(desc));
+		update_lang_zero();
+	}
+	//a temporary would dangle
+	template<size_t N>
+	void set_string_descriptor(const Utf8_string_descriptor_data<N>&& desc, const String_descriptor_zero::LANGID lang, const uint8_t idx) = delete;
 
 	String_desc_table::String_desc_ptr get_string_descriptor(const String_descriptor_zero::LANGID lang, const uint8_t idx)
 	{
@@ -111,24 +142,75 @@ public:
 			return String_desc_table::String_desc_ptr();
 		}
 
-		return string_table->get_config(idx);
+		String_desc_table::String_desc_ptr desc = string_table->get_config(idx);
+		if(!desc && (idx == 0) && (lang == String_descriptor_zero::LANGID::NONE))
+		{
+			desc = m_lang_zero;
+		}
+
+		return desc;
 	}
 
 	String_desc_table::String_desc_const_ptr get_string_descriptor(const String_descriptor_zero::LANGID lang, const uint8_t idx) const
 	{
+		String_desc_table::String_desc_const_ptr desc;
+
 		const String_desc_table* string_table = m_string_table.get_table(lang);
-		if(!string_table)
+		if(string_table)
+		{
+			desc = string_table->get_config(idx);
+		}
+
+		if(!desc && (idx == 0) && (lang == String_descriptor_zero::LANGID::NONE))
 		{
-			return String_desc_table::String_desc_const_ptr();
+			desc = m_lang_zero;
 		}
 		
-		return string_table->get_config(idx);
+		return desc;
+	}
+
+	void set_bos_descriptor(const std::shared_ptr<BOS_descriptor>& desc)
+	{
+		m_bos_desc = desc;
+	}
+
+	std::shared_ptr<const BOS_descriptor> get_bos_descriptor() const
+	{
+		return m_bos_desc;
+	}
+
+	//served by the core on the vendor request named in the set, must be finalized
+	void set_ms_os_20_descriptor_set(const std::shared_ptr<const MS_OS_20_descriptor_set>& desc_set)
+	{
+		m_ms_os_20_desc_set = desc_set;
+	}
+
+	std::shared_ptr<const MS_OS_20_descriptor_set> get_ms_os_20_descriptor_set() const
+	{
+		return m_ms_os_20_desc_set;
 	}
 
 	void add_other_descriptor(std::shared_ptr<Descriptor_base> other_desc)
 	{
 		m_other_desc.push_back(other_desc);
 	}
+
+	//serialize the device, qualifier, configuration, BOS, and string descriptors into the flat table
+	//call once all descriptors are set, the core then serves GET_DESCRIPTOR from it and falls back to the objects on a miss
+	bool build_flat_table();
+
+	//free the per descriptor heap nodes once the flat table is built
+	//the MS OS 2.0 set, dynamic strings, and objects owned by the app are kept
+	void release_object_tables();
+
+	const Flat_desc_table& get_flat_table() const
+	{
+		return m_flat_table;
+	}
+
+	//the configuration with this bConfigurationValue and all its children as sent to the host at speed
+	//from the flat table if it was built, otherwise serialized from the objects
+	bool get_configuration_bytes(const uint8_t bConfigurationValue, const USB_common::USB_SPEED speed, std::vector<uint8_t>* const out) const;
 #if 0
 	bool set_descriptor(const Desc_base_ptr& desc, const USB_common::DESCRIPTOR_TYPE type, const uint8_t idx)
 	{
@@ -249,6 +331,10 @@ public:
 protected:
 	
 	Device_desc_ptr m_dev_desc;
+	std::shared_ptr<Device_qualifier_descriptor> m_dev_qual_desc;
+
+	std::shared_ptr<BOS_descriptor> m_bos_desc;
+	std::shared_ptr<const MS_OS_20_descriptor_set> m_ms_os_20_desc_set;
 
 	Config_desc_table m_config_table;
 	Endpoint_desc_table m_endpoint_table;
@@ -256,4 +342,11 @@ protected:
 	Multilang_string_desc_table m_string_table;
 
 	std::list< std::shared_ptr<Descriptor_base> > m_other_desc;
+
+	Flat_desc_table m_flat_table;
+
+	void update_lang_zero();
+
+	std::vector<String_descriptor_zero::LANGID> m_langids;
+	std::shared_ptr<String_descriptor_zero> m_lang_zero;
 };
\ No newline at end of file
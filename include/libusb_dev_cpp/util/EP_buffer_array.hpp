@@ -15,9 +15,9 @@ class EP_buffer_array : public Buffer_adapter_base
 {
 public:
 
-	EP_buffer_array() : Buffer_adapter_base(m_buf.data(), m_buf.size())
+	EP_buffer_array()
 	{
-
+		reset(m_buf.data(), m_buf.size());
 	}
 
 protected:
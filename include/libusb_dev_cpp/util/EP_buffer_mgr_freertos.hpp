@@ -8,6 +8,7 @@
 
 #include "freertos_cpp_util/object_pool/Object_pool.hpp"
 
+#include "libusb_dev_cpp/util/Cache_line.hpp"
 #include "libusb_dev_cpp/util/EP_buffer_array.hpp"
 #include "libusb_dev_cpp/util/EP_buffer_mgr_base.hpp"
 
@@ -20,9 +21,9 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 	
 	EP_buffer_mgr_freertos()
 	{
-		for(size_t i = 0; i < m_active_buffer.size(); i++)
+		for(size_t i = 0; i < m_ep.size(); i++)
 		{
-			std::atomic_init<Buffer_adapter_base*>(&m_active_buffer[i], nullptr);
+			std::atomic_init<Buffer_adapter_base*>(&m_ep[i].active_buffer, nullptr);
 		}
 	}
 
@@ -39,7 +40,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return false;
 		}
 
-		m_active_buffer[ep] = buf;
+		m_ep[ep].active_buffer = buf;
 		return true;
 	}
 	Buffer_adapter_base* get_buffer(const uint8_t ep) override
@@ -49,7 +50,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return nullptr;
 		}
 
-		return m_active_buffer[ep];
+		return m_ep[ep].active_buffer;
 	}
 	Buffer_adapter_base* poll_allocate_buffer_isr(const uint8_t ep) override
 	{
@@ -59,7 +60,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 		}
 
 		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-		Buffer_adapter_base* buf = m_ep_buffer[ep].try_allocate_isr(&xHigherPriorityTaskWoken);
+		Buffer_adapter_base* buf = m_ep[ep].ep_buffer.try_allocate_isr(&xHigherPriorityTaskWoken);
 
 		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 
@@ -79,7 +80,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return poll_allocate_buffer_isr(ep);
 		}
 
-		return m_ep_buffer[ep].allocate();
+		return m_ep[ep].ep_buffer.allocate();
 	}
 	Buffer_adapter_base* wait_allocate_buffer(const uint8_t ep) override
 	{
@@ -88,7 +89,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return nullptr;
 		}
 
-		return m_ep_buffer[ep].try_allocate_for_ticks(portMAX_DELAY);
+		return m_ep[ep].ep_buffer.try_allocate_for_ticks(portMAX_DELAY);
 	}
 	Buffer_adapter_base* allocate_buffer(const uint8_t ep, const TickType_t xTicksToWait)
 	{
@@ -97,7 +98,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return nullptr;
 		}
 
-		return m_ep_buffer[ep].try_allocate_for_ticks(xTicksToWait);
+		return m_ep[ep].ep_buffer.try_allocate_for_ticks(xTicksToWait);
 	}
 	template< class Rep, class Period >
 	Buffer_adapter_base* allocate_buffer(const uint8_t ep, const std::chrono::duration<Rep,Period>& duration)
@@ -107,7 +108,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return nullptr;
 		}
 
-		return m_ep_buffer[ep].try_allocate_for(duration);
+		return m_ep[ep].ep_buffer.try_allocate_for(duration);
 	}
 
 	bool poll_enqueue_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
@@ -124,7 +125,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return false;	
 		}
 
-		return m_app_buffer[ep].push_back_isr(ptr);
+		return m_ep[ep].app_buffer.push_back_isr(ptr);
 	}
 
 	bool poll_enqueue_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
@@ -148,7 +149,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return false;	
 		}
 
-		return m_app_buffer[ep].push_back(ptr);
+		return m_ep[ep].app_buffer.push_back(ptr);
 	}
 
 	Buffer_adapter_base* poll_dequeue_buffer_isr(const uint8_t ep) override
@@ -159,7 +160,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 		}
 
 		Buffer_adapter_base* buf = nullptr;
-		m_app_buffer[ep].pop_front_isr(&buf);
+		m_ep[ep].app_buffer.pop_front_isr(&buf);
 
 		return buf;
 	}
@@ -186,7 +187,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 		}
 
 		Buffer_adapter_base* buf = nullptr;
-		m_app_buffer[ep].pop_front(&buf, xTicksToWait);
+		m_ep[ep].app_buffer.pop_front(&buf, xTicksToWait);
 
 		return buf;
 	}
@@ -219,7 +220,7 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return;	
 		}
 
-		m_ep_buffer[ep].deallocate(ptr);
+		m_ep[ep].ep_buffer.deallocate(ptr);
 	}
 
 	void release_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
@@ -237,25 +238,27 @@ class EP_buffer_mgr_freertos : public EP_buffer_mgr_base
 			return;	
 		}
 
-		m_ep_buffer[ep].deallocate_isr(ptr);
+		m_ep[ep].ep_buffer.deallocate_isr(ptr);
 	}
 
 	protected:
-		std::array<
-			Object_pool<
-				EP_buffer_array<BUFFER_LEN, BUFFER_ALLIGN>,
-				BUFFER_DEPTH
-				>,
-			NUM_EP> m_ep_buffer;
 
-		std::array<
-			std::atomic<Buffer_adapter_base*>,
-			NUM_EP> m_active_buffer;
+		//everything an ep touches per transfer, on its own cache lines so the isr working one ep
+		//does not evict what a task is using on another
+		struct alignas(CACHE_LINE_SIZE) EP_state
+		{
+			std::atomic<Buffer_adapter_base*> active_buffer;
 
-		std::array<
 			Queue_static_pod<
 				Buffer_adapter_base*,
 				BUFFER_DEPTH
-				>,
-			NUM_EP> m_app_buffer;
+				> app_buffer;
+
+			Object_pool<
+				EP_buffer_array<BUFFER_LEN, BUFFER_ALLIGN>,
+				BUFFER_DEPTH
+				> ep_buffer;
+		};
+
+		std::array<EP_state, NUM_EP> m_ep;
 };
@@ -0,0 +1,231 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/EP_buffer_array.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_base.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_waiter.hpp"
+
+#include "libusb_dev_cpp/util/Cache_line.hpp"
+#include "libusb_dev_cpp/util/Lockfree_index_stack.hpp"
+#include "libusb_dev_cpp/util/Spmc_ring.hpp"
+
+#include <array>
+#include <atomic>
+
+//drop in for EP_buffer_mgr_freertos with no locks and no RTOS calls on the data path
+//
+//per ep the buffers live in a static array, free buffers are tracked by index in a Treiber stack
+//and filled buffers move through an SPMC ring, so alloc / enqueue / dequeue / release are a few atomics
+//and the same code is safe from a task or an isr, there is no xPortIsInsideInterrupt branch
+//
+//the WAIT_POLICY is only called when a task is actually blocked in wait_allocate_buffer or wait_dequeue_buffer
+//see EP_buffer_wait_freertos.hpp for the FreeRTOS policy
+//
+//allocate and release may be called from any number of contexts
+//enqueue is single producer per ep, unlike EP_buffer_mgr_freertos
+//	OUT eps, the driver isr
+//	IN eps, the one task that calls usb_driver_base::enqueue_tx_buffer for that ep, share an ep between tasks with Tx_packer
+//dequeue may be called from several contexts at once, eg the app task and the driver isr under Rx_flow_control DROP_OLDEST
+template<size_t NUM_EP, size_t BUFFER_DEPTH, size_t BUFFER_LEN, size_t BUFFER_ALLIGN, template<size_t> class WAIT_POLICY = EP_buffer_wait_spin>
+class EP_buffer_mgr_lockfree : public EP_buffer_mgr_base
+{
+public:
+
+	typedef EP_buffer_array<BUFFER_LEN, BUFFER_ALLIGN> Buffer_type;
+
+	EP_buffer_mgr_lockfree()
+	{
+		for(size_t i = 0; i < NUM_EP; i++)
+		{
+			std::atomic_init<Buffer_adapter_base*>(&m_ep[i].active_buffer, nullptr);
+			m_ep[i].free.fill();
+		}
+	}
+
+	//both
+	size_t get_num_ep() const override
+	{
+		return NUM_EP;
+	}
+
+	bool set_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return false;
+		}
+
+		m_ep[ep].active_buffer = buf;
+		return true;
+	}
+	Buffer_adapter_base* get_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return m_ep[ep].active_buffer;
+	}
+
+	Buffer_adapter_base* poll_allocate_buffer_isr(const uint8_t ep) override
+	{
+		return poll_allocate_buffer(ep);
+	}
+	Buffer_adapter_base* poll_allocate_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		uint16_t idx = 0;
+		if(!m_ep[ep].free.pop(&idx))
+		{
+			return nullptr;
+		}
+
+		Buffer_type* const buf = &m_storage[ep][idx];
+		buf->reset();
+
+		return buf;
+	}
+	Buffer_adapter_base* wait_allocate_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return m_waiter.wait_until(free_ch(ep), [this, ep](){return poll_allocate_buffer(ep);});
+	}
+
+	bool poll_enqueue_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(!enqueue(ep, buf))
+		{
+			return false;
+		}
+
+		m_waiter.wake_isr(app_ch(ep));
+		return true;
+	}
+	bool poll_enqueue_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(!enqueue(ep, buf))
+		{
+			return false;
+		}
+
+		m_waiter.wake(app_ch(ep));
+		return true;
+	}
+
+	Buffer_adapter_base* poll_dequeue_buffer_isr(const uint8_t ep) override
+	{
+		return poll_dequeue_buffer(ep);
+	}
+	Buffer_adapter_base* poll_dequeue_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		Buffer_adapter_base* buf = nullptr;
+		m_ep[ep].app_buffer.pop(&buf);
+
+		return buf;
+	}
+	Buffer_adapter_base* wait_dequeue_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return m_waiter.wait_until(app_ch(ep), [this, ep](){return poll_dequeue_buffer(ep);});
+	}
+
+	void release_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(release(ep, buf))
+		{
+			m_waiter.wake_isr(free_ch(ep));
+		}
+	}
+	void release_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(release(ep, buf))
+		{
+			m_waiter.wake(free_ch(ep));
+		}
+	}
+
+	WAIT_POLICY<2*NUM_EP>& get_wait_policy()
+	{
+		return m_waiter.get_wait_policy();
+	}
+
+protected:
+
+	static constexpr size_t free_ch(const uint8_t ep)
+	{
+		return ep;
+	}
+	static constexpr size_t app_ch(const uint8_t ep)
+	{
+		return NUM_EP + ep;
+	}
+
+	bool enqueue(const uint8_t ep, Buffer_adapter_base* const buf)
+	{
+		if((ep >= NUM_EP) || (buf == nullptr))
+		{
+			return false;
+		}
+
+		return m_ep[ep].app_buffer.push(buf);
+	}
+
+	bool release(const uint8_t ep, Buffer_adapter_base* const buf)
+	{
+		if((ep >= NUM_EP) || (buf == nullptr))
+		{
+			return false;
+		}
+
+		//map back to the slot, this also rejects a buffer from another ep or manager
+		const Buffer_type* const ptr = static_cast<const Buffer_type*>(buf);
+		const Buffer_type* const base = m_storage[ep].data();
+		if((ptr < base) || (ptr >= (base + BUFFER_DEPTH)))
+		{
+			return false;
+		}
+
+		m_ep[ep].free.push(uint16_t(ptr - base));
+		return true;
+	}
+
+	//everything an ep touches per transfer, on its own cache lines so the isr working one ep
+	//does not evict what a task is using on another
+	struct alignas(CACHE_LINE_SIZE) EP_state
+	{
+		Lockfree_index_stack<BUFFER_DEPTH> free;
+		std::atomic<Buffer_adapter_base*> active_buffer;
+		Spmc_ring<Buffer_adapter_base*, BUFFER_DEPTH> app_buffer;
+	};
+
+	std::array<EP_state, NUM_EP> m_ep;
+
+	std::array<
+		std::array<Buffer_type, BUFFER_DEPTH>,
+		NUM_EP> m_storage;
+
+	EP_buffer_waiter<2*NUM_EP, WAIT_POLICY> m_waiter;
+};
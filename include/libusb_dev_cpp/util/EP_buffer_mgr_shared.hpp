@@ -0,0 +1,402 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/EP_buffer_array.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_base.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_waiter.hpp"
+
+#include "libusb_dev_cpp/util/Cache_line.hpp"
+#include "libusb_dev_cpp/util/Lockfree_index_stack.hpp"
+#include "libusb_dev_cpp/util/Spmc_ring.hpp"
+
+#include <array>
+#include <atomic>
+
+//all eps draw from one pool of POOL_DEPTH buffers instead of NUM_EP x BUFFER_DEPTH
+//
+//each ep has a quota set with set_quota
+//	min - buffers held back for this ep, it can always get this many no matter what the other eps do
+//	max - most buffers this ep may hold, so a bursty ep can not drain what is left for the others
+//the pool minus the sum of the mins is shared, an ep above its min borrows from it and gives back on release
+//the default quota is min 0, max POOL_DEPTH
+//
+//set the quotas before the manager is in use, eg before the driver is initialized
+//threading is the same as EP_buffer_mgr_lockfree
+template<size_t NUM_EP, size_t POOL_DEPTH, size_t BUFFER_LEN, size_t BUFFER_ALLIGN, template<size_t> class WAIT_POLICY = EP_buffer_wait_spin>
+class EP_buffer_mgr_shared : public EP_buffer_mgr_base
+{
+public:
+
+	typedef EP_buffer_array<BUFFER_LEN, BUFFER_ALLIGN> Buffer_type;
+
+	static_assert(NUM_EP < 0xFF, "NUM_EP must leave room for the no owner tag");
+
+	static constexpr uint8_t NO_OWNER = 0xFF;
+
+	EP_buffer_mgr_shared()
+	{
+		for(size_t i = 0; i < NUM_EP; i++)
+		{
+			std::atomic_init<Buffer_adapter_base*>(&m_ep[i].active_buffer, nullptr);
+			std::atomic_init<size_t>(&m_ep[i].used, size_t(0));
+
+			m_min[i] = 0;
+			m_max[i] = POOL_DEPTH;
+		}
+
+		for(size_t i = 0; i < POOL_DEPTH; i++)
+		{
+			std::atomic_init<uint8_t>(&m_owner[i], NO_OWNER);
+		}
+
+		std::atomic_init<size_t>(&m_shared_avail, POOL_DEPTH);
+
+		m_free.fill();
+	}
+
+	//fails if min > max, max > POOL_DEPTH, or the mins of all eps add up to more than the pool
+	bool set_quota(const uint8_t ep, const size_t min, const size_t max)
+	{
+		if((ep >= NUM_EP) || (min > max) || (max > POOL_DEPTH))
+		{
+			return false;
+		}
+
+		size_t total_min = min;
+		for(size_t i = 0; i < NUM_EP; i++)
+		{
+			if(i != ep)
+			{
+				total_min += m_min[i];
+			}
+		}
+
+		if(total_min > POOL_DEPTH)
+		{
+			return false;
+		}
+
+		m_min[ep] = min;
+		m_max[ep] = max;
+
+		m_shared_avail.store(POOL_DEPTH - total_min);
+
+		return true;
+	}
+
+	size_t get_used(const uint8_t ep) const
+	{
+		if(ep >= NUM_EP)
+		{
+			return 0;
+		}
+
+		return m_ep[ep].used.load(std::memory_order_relaxed);
+	}
+	//buffers that any ep above its min could still borrow
+	size_t get_shared_avail() const
+	{
+		return m_shared_avail.load(std::memory_order_relaxed);
+	}
+
+	//both
+	size_t get_num_ep() const override
+	{
+		return NUM_EP;
+	}
+
+	bool set_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return false;
+		}
+
+		m_ep[ep].active_buffer = buf;
+		return true;
+	}
+	Buffer_adapter_base* get_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return m_ep[ep].active_buffer;
+	}
+
+	Buffer_adapter_base* poll_allocate_buffer_isr(const uint8_t ep) override
+	{
+		return poll_allocate_buffer(ep);
+	}
+	Buffer_adapter_base* poll_allocate_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		if(!take_quota(ep))
+		{
+			return nullptr;
+		}
+
+		//the quota guarantees a free slot, a release pushes before it gives back quota
+		uint16_t idx = 0;
+		while(!m_free.pop(&idx))
+		{
+
+		}
+
+		m_owner[idx].store(ep, std::memory_order_relaxed);
+
+		Buffer_type* const buf = &m_storage[idx];
+		buf->reset();
+
+		return buf;
+	}
+	Buffer_adapter_base* wait_allocate_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return m_waiter.wait_until(free_ch(ep), [this, ep](){return poll_allocate_buffer(ep);});
+	}
+
+	bool poll_enqueue_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(!enqueue(ep, buf))
+		{
+			return false;
+		}
+
+		m_waiter.wake_isr(app_ch(ep));
+		return true;
+	}
+	bool poll_enqueue_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(!enqueue(ep, buf))
+		{
+			return false;
+		}
+
+		m_waiter.wake(app_ch(ep));
+		return true;
+	}
+
+	Buffer_adapter_base* poll_dequeue_buffer_isr(const uint8_t ep) override
+	{
+		return poll_dequeue_buffer(ep);
+	}
+	Buffer_adapter_base* poll_dequeue_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		Buffer_adapter_base* buf = nullptr;
+		m_ep[ep].app_buffer.pop(&buf);
+
+		return buf;
+	}
+	Buffer_adapter_base* wait_dequeue_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return m_waiter.wait_until(app_ch(ep), [this, ep](){return poll_dequeue_buffer(ep);});
+	}
+
+	void release_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		const RELEASE_RESULT ret = release(ep, buf);
+		if(ret == RELEASE_RESULT::SHARED)
+		{
+			for(size_t i = 0; i < NUM_EP; i++)
+			{
+				m_waiter.wake_isr(free_ch(i));
+			}
+		}
+		else if(ret == RELEASE_RESULT::RESERVED)
+		{
+			m_waiter.wake_isr(free_ch(ep));
+		}
+	}
+	void release_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		const RELEASE_RESULT ret = release(ep, buf);
+		if(ret == RELEASE_RESULT::SHARED)
+		{
+			wake_all_free();
+		}
+		else if(ret == RELEASE_RESULT::RESERVED)
+		{
+			m_waiter.wake(free_ch(ep));
+		}
+	}
+
+	WAIT_POLICY<2*NUM_EP>& get_wait_policy()
+	{
+		return m_waiter.get_wait_policy();
+	}
+
+protected:
+
+	enum class RELEASE_RESULT
+	{
+		INVALID,
+		RESERVED,
+		SHARED
+	};
+
+	static constexpr size_t free_ch(const size_t ep)
+	{
+		return ep;
+	}
+	static constexpr size_t app_ch(const size_t ep)
+	{
+		return NUM_EP + ep;
+	}
+
+	void wake_all_free()
+	{
+		for(size_t i = 0; i < NUM_EP; i++)
+		{
+			m_waiter.wake(free_ch(i));
+		}
+	}
+
+	//count the buffer against the ep before touching the pool
+	//below min it comes from the ep's reservation, otherwise a shared credit is taken first
+	bool take_quota(const uint8_t ep)
+	{
+		size_t used = m_ep[ep].used.load(std::memory_order_seq_cst);
+		for(;;)
+		{
+			if(used >= m_max[ep])
+			{
+				return false;
+			}
+
+			if(used < m_min[ep])
+			{
+				if(m_ep[ep].used.compare_exchange_weak(used, used + 1, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					return true;
+				}
+				continue;
+			}
+
+			if(!take_shared())
+			{
+				return false;
+			}
+
+			if(m_ep[ep].used.compare_exchange_strong(used, used + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				return true;
+			}
+
+			//a release on this ep raced us, give the credit back and look again
+			//another ep may have seen the pool empty meanwhile and gone to sleep
+			m_shared_avail.fetch_add(1, std::memory_order_seq_cst);
+			wake_all_free();
+		}
+	}
+
+	bool take_shared()
+	{
+		size_t avail = m_shared_avail.load(std::memory_order_seq_cst);
+		do
+		{
+			if(avail == 0)
+			{
+				return false;
+			}
+		} while(!m_shared_avail.compare_exchange_weak(avail, avail - 1, std::memory_order_acquire, std::memory_order_relaxed));
+
+		return true;
+	}
+
+	bool enqueue(const uint8_t ep, Buffer_adapter_base* const buf)
+	{
+		if((ep >= NUM_EP) || (buf == nullptr))
+		{
+			return false;
+		}
+
+		return m_ep[ep].app_buffer.push(buf);
+	}
+
+	RELEASE_RESULT release(const uint8_t ep, Buffer_adapter_base* const buf)
+	{
+		if((ep >= NUM_EP) || (buf == nullptr))
+		{
+			return RELEASE_RESULT::INVALID;
+		}
+
+		const Buffer_type* const ptr = static_cast<const Buffer_type*>(buf);
+		const Buffer_type* const base = m_storage.data();
+		if((ptr < base) || (ptr >= (base + POOL_DEPTH)))
+		{
+			return RELEASE_RESULT::INVALID;
+		}
+
+		//rejects a buffer held by another ep and a double release
+		const uint16_t idx = uint16_t(ptr - base);
+		uint8_t owner = ep;
+		if(!m_owner[idx].compare_exchange_strong(owner, NO_OWNER, std::memory_order_relaxed))
+		{
+			return RELEASE_RESULT::INVALID;
+		}
+
+		//slot first, then quota, so a successful take_quota always finds a slot
+		m_free.push(idx);
+
+		const size_t used = m_ep[ep].used.fetch_sub(1, std::memory_order_seq_cst);
+		if(used > m_min[ep])
+		{
+			m_shared_avail.fetch_add(1, std::memory_order_seq_cst);
+			return RELEASE_RESULT::SHARED;
+		}
+
+		return RELEASE_RESULT::RESERVED;
+	}
+
+	std::array<Buffer_type, POOL_DEPTH> m_storage;
+
+	Lockfree_index_stack<POOL_DEPTH> m_free;
+
+	std::array<
+		std::atomic<uint8_t>,
+		POOL_DEPTH> m_owner;
+
+	//per ep runtime state, each on its own cache lines
+	struct alignas(CACHE_LINE_SIZE) EP_state
+	{
+		std::atomic<size_t> used;
+		std::atomic<Buffer_adapter_base*> active_buffer;
+		Spmc_ring<Buffer_adapter_base*, POOL_DEPTH> app_buffer;
+	};
+
+	std::array<EP_state, NUM_EP> m_ep;
+
+	//written by every borrow from any ep
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_shared_avail;
+
+	//config, only written by set_quota
+	std::array<size_t, NUM_EP> m_min;
+	std::array<size_t, NUM_EP> m_max;
+
+	EP_buffer_waiter<2*NUM_EP, WAIT_POLICY> m_waiter;
+};
@@ -0,0 +1,413 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/EP_buffer_array.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_base.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_waiter.hpp"
+
+#include "libusb_dev_cpp/util/Cache_line.hpp"
+#include "libusb_dev_cpp/util/Lockfree_index_stack.hpp"
+#include "libusb_dev_cpp/util/Spmc_ring.hpp"
+
+#include <array>
+#include <atomic>
+#include <tuple>
+
+//one size class, COUNT buffers of LEN bytes
+template<size_t LEN, size_t COUNT>
+struct Slab_class
+{
+	static constexpr size_t BUFFER_LEN   = LEN;
+	static constexpr size_t BUFFER_COUNT = COUNT;
+};
+
+class Slab_base
+{
+public:
+
+	virtual ~Slab_base()
+	{
+
+	}
+
+	virtual size_t get_buffer_len() const = 0;
+
+	virtual Buffer_adapter_base* allocate() = 0;
+	//false if buf is not from this slab
+	virtual bool release(Buffer_adapter_base* const buf) = 0;
+};
+
+template<size_t LEN, size_t COUNT, size_t ALLIGN>
+class Slab : public Slab_base
+{
+public:
+
+	typedef EP_buffer_array<LEN, ALLIGN> Buffer_type;
+
+	Slab()
+	{
+		m_free.fill();
+	}
+
+	size_t get_buffer_len() const override
+	{
+		return LEN;
+	}
+
+	Buffer_adapter_base* allocate() override
+	{
+		uint16_t idx = 0;
+		if(!m_free.pop(&idx))
+		{
+			return nullptr;
+		}
+
+		Buffer_type* const buf = &m_storage[idx];
+		buf->reset();
+
+		return buf;
+	}
+
+	bool release(Buffer_adapter_base* const buf) override
+	{
+		//compare addresses of the adapters, only a buffer from this slab is downcast
+		const Buffer_adapter_base* const first = &m_storage.front();
+		const Buffer_adapter_base* const last  = &m_storage.back();
+		if((buf < first) || (buf > last))
+		{
+			return false;
+		}
+
+		const Buffer_type* const ptr = static_cast<const Buffer_type*>(buf);
+		m_free.push(uint16_t(ptr - m_storage.data()));
+		return true;
+	}
+
+protected:
+	std::array<Buffer_type, COUNT> m_storage;
+	Lockfree_index_stack<COUNT> m_free;
+};
+
+//buffers in several size classes, eg 64 / 512 / 4096 / 16384, all aligned to BUFFER_ALLIGN
+//list the classes smallest first
+//	EP_buffer_mgr_slab<4, 32, EP_buffer_wait_spin, Slab_class<64, 16>, Slab_class<512, 8>, Slab_class<4096, 2>>
+//
+//each ep has a default buffer length, set with set_ep_buffer_len, used by the EP_buffer_mgr_base api
+//poll_allocate_buffer / wait_allocate_buffer with a length pick per request
+//a request takes the smallest class that fits, and spills to the next larger one when that class is empty
+//
+//threading is the same as EP_buffer_mgr_lockfree
+template<size_t NUM_EP, size_t BUFFER_ALLIGN, template<size_t> class WAIT_POLICY, typename... CLASSES>
+class EP_buffer_mgr_slab : public EP_buffer_mgr_base
+{
+public:
+
+	static constexpr size_t NUM_CLASS = sizeof...(CLASSES);
+
+	static_assert(NUM_CLASS > 0, "at least one size class is needed");
+
+	//an ep can hold every buffer
+	static constexpr size_t TOTAL_BUFFERS = []()
+	{
+		size_t n = 0;
+		for(const size_t c : {CLASSES::BUFFER_COUNT...})
+		{
+			n += c;
+		}
+		return n;
+	}();
+
+	static_assert([]()
+	{
+		size_t prev = 0;
+		for(const size_t len : {CLASSES::BUFFER_LEN...})
+		{
+			if(len <= prev)
+			{
+				return false;
+			}
+			prev = len;
+		}
+		return true;
+	}(), "size classes must be listed smallest first");
+
+	EP_buffer_mgr_slab()
+	{
+		m_slab_ptr = std::apply([](auto&... slab){return std::array<Slab_base*, NUM_CLASS>{{&slab...}};}, m_slabs);
+
+		for(size_t i = 0; i < NUM_EP; i++)
+		{
+			std::atomic_init<Buffer_adapter_base*>(&m_ep[i].active_buffer, nullptr);
+			m_ep_class[i] = 0;
+		}
+	}
+
+	//default length for allocations on this ep, fails if no class is large enough
+	bool set_ep_buffer_len(const uint8_t ep, const size_t len)
+	{
+		if(ep >= NUM_EP)
+		{
+			return false;
+		}
+
+		const size_t cls = get_class(len);
+		if(cls >= NUM_CLASS)
+		{
+			return false;
+		}
+
+		m_ep_class[ep] = cls;
+		return true;
+	}
+
+	//smallest class length that holds len, or 0 if none
+	size_t get_class_len(const size_t len) const
+	{
+		const size_t cls = get_class(len);
+		if(cls >= NUM_CLASS)
+		{
+			return 0;
+		}
+
+		return m_slab_ptr[cls]->get_buffer_len();
+	}
+
+	//both
+	size_t get_num_ep() const override
+	{
+		return NUM_EP;
+	}
+
+	bool set_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return false;
+		}
+
+		m_ep[ep].active_buffer = buf;
+		return true;
+	}
+	Buffer_adapter_base* get_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return m_ep[ep].active_buffer;
+	}
+
+	Buffer_adapter_base* poll_allocate_buffer_isr(const uint8_t ep) override
+	{
+		return poll_allocate_buffer(ep);
+	}
+	Buffer_adapter_base* poll_allocate_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return allocate_from(m_ep_class[ep]);
+	}
+	Buffer_adapter_base* poll_allocate_buffer(const uint8_t ep, const size_t len)
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return allocate_from(get_class(len));
+	}
+	Buffer_adapter_base* wait_allocate_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		const size_t cls = m_ep_class[ep];
+		return m_waiter.wait_until(free_ch(cls), [this, cls](){return allocate_from(cls);});
+	}
+	Buffer_adapter_base* wait_allocate_buffer(const uint8_t ep, const size_t len)
+	{
+		const size_t cls = get_class(len);
+		if((ep >= NUM_EP) || (cls >= NUM_CLASS))
+		{
+			return nullptr;
+		}
+
+		return m_waiter.wait_until(free_ch(cls), [this, cls](){return allocate_from(cls);});
+	}
+
+	bool poll_enqueue_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(!enqueue(ep, buf))
+		{
+			return false;
+		}
+
+		m_waiter.wake_isr(app_ch(ep));
+		return true;
+	}
+	bool poll_enqueue_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		if(!enqueue(ep, buf))
+		{
+			return false;
+		}
+
+		m_waiter.wake(app_ch(ep));
+		return true;
+	}
+
+	Buffer_adapter_base* poll_dequeue_buffer_isr(const uint8_t ep) override
+	{
+		return poll_dequeue_buffer(ep);
+	}
+	Buffer_adapter_base* poll_dequeue_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		Buffer_adapter_base* buf = nullptr;
+		m_ep[ep].app_buffer.pop(&buf);
+
+		return buf;
+	}
+	Buffer_adapter_base* wait_dequeue_buffer(const uint8_t ep) override
+	{
+		if(ep >= NUM_EP)
+		{
+			return nullptr;
+		}
+
+		return m_waiter.wait_until(app_ch(ep), [this, ep](){return poll_dequeue_buffer(ep);});
+	}
+
+	void release_buffer_isr(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		const size_t cls = release(ep, buf);
+		if(cls >= NUM_CLASS)
+		{
+			return;
+		}
+
+		//a waiter on a smaller class may spill into this one
+		for(size_t i = 0; i <= cls; i++)
+		{
+			m_waiter.wake_isr(free_ch(i));
+		}
+	}
+	void release_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		const size_t cls = release(ep, buf);
+		if(cls >= NUM_CLASS)
+		{
+			return;
+		}
+
+		for(size_t i = 0; i <= cls; i++)
+		{
+			m_waiter.wake(free_ch(i));
+		}
+	}
+
+	WAIT_POLICY<NUM_CLASS + NUM_EP>& get_wait_policy()
+	{
+		return m_waiter.get_wait_policy();
+	}
+
+protected:
+
+	static constexpr size_t free_ch(const size_t cls)
+	{
+		return cls;
+	}
+	static constexpr size_t app_ch(const size_t ep)
+	{
+		return NUM_CLASS + ep;
+	}
+
+	//NUM_CLASS if len is too large
+	size_t get_class(const size_t len) const
+	{
+		for(size_t i = 0; i < NUM_CLASS; i++)
+		{
+			if(m_slab_ptr[i]->get_buffer_len() >= len)
+			{
+				return i;
+			}
+		}
+
+		return NUM_CLASS;
+	}
+
+	Buffer_adapter_base* allocate_from(const size_t cls)
+	{
+		for(size_t i = cls; i < NUM_CLASS; i++)
+		{
+			Buffer_adapter_base* const buf = m_slab_ptr[i]->allocate();
+			if(buf)
+			{
+				return buf;
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool enqueue(const uint8_t ep, Buffer_adapter_base* const buf)
+	{
+		if((ep >= NUM_EP) || (buf == nullptr))
+		{
+			return false;
+		}
+
+		return m_ep[ep].app_buffer.push(buf);
+	}
+
+	//returns the class the buffer went back to, or NUM_CLASS if it is not ours
+	size_t release(const uint8_t ep, Buffer_adapter_base* const buf)
+	{
+		if((ep >= NUM_EP) || (buf == nullptr))
+		{
+			return NUM_CLASS;
+		}
+
+		for(size_t i = 0; i < NUM_CLASS; i++)
+		{
+			if(m_slab_ptr[i]->release(buf))
+			{
+				return i;
+			}
+		}
+
+		return NUM_CLASS;
+	}
+
+	std::tuple<Slab<CLASSES::BUFFER_LEN, CLASSES::BUFFER_COUNT, BUFFER_ALLIGN>...> m_slabs;
+	std::array<Slab_base*, NUM_CLASS> m_slab_ptr;
+
+	//per ep runtime state, each on its own cache lines
+	struct alignas(CACHE_LINE_SIZE) EP_state
+	{
+		std::atomic<Buffer_adapter_base*> active_buffer;
+		Spmc_ring<Buffer_adapter_base*, TOTAL_BUFFERS> app_buffer;
+	};
+
+	std::array<EP_state, NUM_EP> m_ep;
+
+	//config
+	std::array<size_t, NUM_EP> m_ep_class;
+
+	EP_buffer_waiter<NUM_CLASS + NUM_EP, WAIT_POLICY> m_waiter;
+};
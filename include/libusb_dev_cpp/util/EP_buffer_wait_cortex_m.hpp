@@ -0,0 +1,38 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/driver/cpu/Cortex_m7.hpp"
+
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include <cstddef>
+
+//wait policy for a bare metal main loop with no RTOS
+//the core sleeps in WFE until an event, the usb isr sends one when it frees or fills a buffer
+//any other interrupt is a spurious wakeup and the manager checks again
+template<size_t NUM_CH>
+class EP_buffer_wait_cortex_m
+{
+public:
+	void wait(const size_t ch)
+	{
+		Cortex_m7::wait_for_event();
+	}
+	void notify(const size_t ch)
+	{
+		Cortex_m7::send_event();
+	}
+	void notify_isr(const size_t ch)
+	{
+		Cortex_m7::send_event();
+	}
+};
+
+//the lock free manager for bare metal
+template<size_t NUM_EP, size_t BUFFER_DEPTH, size_t BUFFER_LEN, size_t BUFFER_ALLIGN>
+using EP_buffer_mgr_bare_metal = EP_buffer_mgr_lockfree<NUM_EP, BUFFER_DEPTH, BUFFER_LEN, BUFFER_ALLIGN, EP_buffer_wait_cortex_m>;
@@ -0,0 +1,64 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include <array>
+
+//wait policy for EP_buffer_mgr_lockfree, one binary semaphore per channel
+//a stale give only causes a spurious wakeup, the manager checks again
+template<size_t NUM_CH>
+class EP_buffer_wait_freertos
+{
+public:
+
+	EP_buffer_wait_freertos()
+	{
+		for(size_t i = 0; i < NUM_CH; i++)
+		{
+			m_sema[i] = xSemaphoreCreateBinaryStatic(&m_sema_buf[i]);
+		}
+	}
+
+	~EP_buffer_wait_freertos()
+	{
+		for(size_t i = 0; i < NUM_CH; i++)
+		{
+			vSemaphoreDelete(m_sema[i]);
+		}
+	}
+
+	void wait(const size_t ch)
+	{
+		xSemaphoreTake(m_sema[ch], portMAX_DELAY);
+	}
+
+	void notify(const size_t ch)
+	{
+		//the driver may reach this from its isr through the non isr api
+		if(xPortIsInsideInterrupt() == pdTRUE)
+		{
+			notify_isr(ch);
+			return;
+		}
+
+		xSemaphoreGive(m_sema[ch]);
+	}
+
+	void notify_isr(const size_t ch)
+	{
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+		xSemaphoreGiveFromISR(m_sema[ch], &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+
+protected:
+	std::array<StaticSemaphore_t, NUM_CH> m_sema_buf;
+	std::array<SemaphoreHandle_t, NUM_CH> m_sema;
+};
@@ -0,0 +1,57 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+
+//wait policy on std::mutex and std::condition_variable, for running the buffer path on a host
+//each channel behaves as a binary semaphore, a notify with no waiter is kept for the next wait
+template<size_t NUM_CH>
+class EP_buffer_wait_std
+{
+public:
+
+	EP_buffer_wait_std()
+	{
+		m_pending.fill(false);
+	}
+
+	void wait(const size_t ch)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex[ch]);
+		m_cv[ch].wait(lock, [this, ch](){return m_pending[ch];});
+		m_pending[ch] = false;
+	}
+
+	void notify(const size_t ch)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex[ch]);
+			m_pending[ch] = true;
+		}
+		m_cv[ch].notify_one();
+	}
+
+	//no isr on a host, a signal handler must not call this
+	void notify_isr(const size_t ch)
+	{
+		notify(ch);
+	}
+
+protected:
+	std::array<std::mutex, NUM_CH> m_mutex;
+	std::array<std::condition_variable, NUM_CH> m_cv;
+	std::array<bool, NUM_CH> m_pending;
+};
+
+//the lock free manager with blocking waits on std threads
+template<size_t NUM_EP, size_t BUFFER_DEPTH, size_t BUFFER_LEN, size_t BUFFER_ALLIGN>
+using EP_buffer_mgr_std = EP_buffer_mgr_lockfree<NUM_EP, BUFFER_DEPTH, BUFFER_LEN, BUFFER_ALLIGN, EP_buffer_wait_std>;
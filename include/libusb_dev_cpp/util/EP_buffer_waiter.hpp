@@ -0,0 +1,109 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/Buffer_adapter.hpp"
+
+#include <array>
+#include <atomic>
+
+//wait policy with no scheduler, a blocked wait just polls again
+//the policy is templated on the number of wait channels and provides
+//	void wait(const size_t ch)       - block until notify or a spurious wakeup
+//	void notify(const size_t ch)     - from a task, or from an isr if the port can not tell
+//	void notify_isr(const size_t ch) - from an isr
+template<size_t NUM_CH>
+class EP_buffer_wait_spin
+{
+public:
+	void wait(const size_t ch)
+	{
+
+	}
+	void notify(const size_t ch)
+	{
+
+	}
+	void notify_isr(const size_t ch)
+	{
+
+	}
+};
+
+//blocking on top of a lock free container
+//the WAIT_POLICY is only called when a task is actually blocked, so the fast path never touches the RTOS
+//the container's publish and check must be seq_cst, see Lockfree_index_stack and Spmc_ring
+template<size_t NUM_CH, template<size_t> class WAIT_POLICY>
+class EP_buffer_waiter
+{
+public:
+
+	EP_buffer_waiter()
+	{
+		for(size_t i = 0; i < NUM_CH; i++)
+		{
+			std::atomic_init<uint32_t>(&m_waiters[i], 0U);
+		}
+	}
+
+	//a waiter registers then checks again, a producer publishes then checks for waiters
+	//all four are seq_cst so at least one side sees the other and a wakeup is never lost
+	//try_func returns a buffer pointer or a bool, and is retried until it is non null or true
+	template<typename FUNC>
+	auto wait_until(const size_t ch, const FUNC& try_func) -> decltype(try_func())
+	{
+		auto buf = try_func();
+		while(!buf)
+		{
+			m_waiters[ch].fetch_add(1, std::memory_order_seq_cst);
+
+			buf = try_func();
+			if(!buf)
+			{
+				m_wait.wait(ch);
+				buf = try_func();
+			}
+
+			//the policy may fold several notifies into one, eg a binary semaphore
+			//so pass the wakeup on to the next waiter to check again
+			if((m_waiters[ch].fetch_sub(1, std::memory_order_seq_cst) > 1) && buf)
+			{
+				m_wait.notify(ch);
+			}
+		}
+
+		return buf;
+	}
+
+	void wake(const size_t ch)
+	{
+		if(m_waiters[ch].load(std::memory_order_seq_cst) != 0)
+		{
+			m_wait.notify(ch);
+		}
+	}
+	void wake_isr(const size_t ch)
+	{
+		if(m_waiters[ch].load(std::memory_order_seq_cst) != 0)
+		{
+			m_wait.notify_isr(ch);
+		}
+	}
+
+	WAIT_POLICY<NUM_CH>& get_wait_policy()
+	{
+		return m_wait;
+	}
+
+protected:
+
+	std::array<
+		std::atomic<uint32_t>,
+		NUM_CH> m_waiters;
+
+	WAIT_POLICY<NUM_CH> m_wait;
+};
@@ -0,0 +1,105 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+//pre-serialized descriptors in one contiguous arena with a sorted index
+//
+//add every descriptor, then finalize once
+//after that lookups are a binary search over a small array and a pointer into the arena, no heap and no refcounts
+//
+//entries are keyed on descriptor type, index, and a 16 bit qualifier
+//the qualifier is the LANGID for strings, the USB_common::USB_SPEED for configurations, and 0 otherwise
+class Flat_desc_table
+{
+public:
+
+	Flat_desc_table()
+	{
+		m_finalized = false;
+	}
+
+	//copies len bytes into the arena, fails after finalize or on a duplicate key
+	bool add(const uint8_t type, const uint8_t idx, const uint16_t qual, const uint8_t* const data, const size_t len);
+
+	//sort the index and release slack
+	void finalize();
+
+	//drop everything, the table can be rebuilt
+	void clear();
+
+	bool is_finalized() const
+	{
+		return m_finalized;
+	}
+
+	//pointer into the arena, valid until clear
+	bool find(const uint8_t type, const uint8_t idx, const uint16_t qual, const uint8_t** const out_ptr, size_t* const out_len) const;
+
+	//func(idx, qual, ptr, len) for every entry of this type, in idx then qual order
+	template <typename F>
+	void for_each(const uint8_t type, F func) const
+	{
+		if(!m_finalized)
+		{
+			return;
+		}
+
+		auto it = std::lower_bound(m_index.begin(), m_index.end(), make_key(type, 0, 0), [](const Entry& e, const uint32_t k){return e.key < k;});
+		for( ; (it != m_index.end()) && (get_type(it->key) == type); ++it)
+		{
+			func(get_idx(it->key), get_qual(it->key), m_arena.data() + it->offset, size_t(it->len));
+		}
+	}
+
+	size_t get_num_entries() const
+	{
+		return m_index.size();
+	}
+
+	//heap bytes held by the arena and index
+	size_t get_heap_size() const
+	{
+		return m_arena.capacity() + m_index.capacity() * sizeof(Entry);
+	}
+
+protected:
+
+	struct Entry
+	{
+		uint32_t key;
+		uint16_t offset;
+		uint16_t len;
+	};
+
+	static constexpr uint32_t make_key(const uint8_t type, const uint8_t idx, const uint16_t qual)
+	{
+		return (uint32_t(type) << 24) | (uint32_t(idx) << 16) | uint32_t(qual);
+	}
+	static constexpr uint8_t get_type(const uint32_t key)
+	{
+		return uint8_t(key >> 24);
+	}
+	static constexpr uint8_t get_idx(const uint32_t key)
+	{
+		return uint8_t(key >> 16);
+	}
+	static constexpr uint16_t get_qual(const uint32_t key)
+	{
+		return uint16_t(key);
+	}
+
+	std::vector<uint8_t> m_arena;
+	std::vector<Entry> m_index;
+
+	bool m_finalized;
+};
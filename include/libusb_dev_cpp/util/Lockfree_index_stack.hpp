@@ -0,0 +1,104 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstdint>
+#include <cstddef>
+
+//lock free LIFO of indices 0 .. LEN-1, a Treiber stack
+//the head packs a 16 bit modification tag over the 16 bit top index so a pop that races a pop/push pair of the same index fails its CAS instead of linking a stale next (ABA)
+//one 32 bit CAS per op, so it is lock free on any core with 32 bit atomics, eg LDREX/STREX on Cortex-M
+//safe from any number of tasks and ISRs
+//push and the first load in pop are seq_cst so a caller can pair them with its own seq_cst flag, eg a waiter count, without a fence
+template<size_t LEN>
+class Lockfree_index_stack
+{
+public:
+
+	static_assert(LEN < 0xFFFF, "LEN must fit in 16 bits with a nil value");
+
+	static constexpr uint16_t NIL = 0xFFFF;
+
+	Lockfree_index_stack()
+	{
+		m_head.store(pack(0, NIL));
+		for(std::atomic<uint16_t>& next : m_next)
+		{
+			next.store(NIL);
+		}
+	}
+
+	//not thread safe, push every index
+	void fill()
+	{
+		for(size_t i = 0; i < LEN; i++)
+		{
+			m_next[i].store((i + 1) < LEN ? uint16_t(i + 1) : NIL, std::memory_order_relaxed);
+		}
+		m_head.store(pack(0, (LEN > 0) ? 0 : NIL), std::memory_order_release);
+	}
+
+	void push(const uint16_t idx)
+	{
+		uint32_t old_head = m_head.load(std::memory_order_relaxed);
+		uint32_t new_head = 0;
+		do
+		{
+			m_next[idx].store(get_idx(old_head), std::memory_order_relaxed);
+			new_head = pack(get_tag(old_head) + 1, idx);
+		} while(!m_head.compare_exchange_weak(old_head, new_head, std::memory_order_seq_cst, std::memory_order_relaxed));
+	}
+
+	bool pop(uint16_t* const out_idx)
+	{
+		uint32_t old_head = m_head.load(std::memory_order_seq_cst);
+		for(;;)
+		{
+			const uint16_t top = get_idx(old_head);
+			if(top == NIL)
+			{
+				return false;
+			}
+
+			//may be stale if top was taken meanwhile, the tag makes the CAS fail then
+			const uint16_t next = m_next[top].load(std::memory_order_relaxed);
+			const uint32_t new_head = pack(get_tag(old_head) + 1, next);
+
+			if(m_head.compare_exchange_weak(old_head, new_head, std::memory_order_acquire, std::memory_order_acquire))
+			{
+				*out_idx = top;
+				return true;
+			}
+		}
+	}
+
+	bool empty() const
+	{
+		return get_idx(m_head.load(std::memory_order_relaxed)) == NIL;
+	}
+
+protected:
+
+	static constexpr uint32_t pack(const uint32_t tag, const uint16_t idx)
+	{
+		return ((tag & 0xFFFFU) << 16) | uint32_t(idx);
+	}
+	static constexpr uint16_t get_idx(const uint32_t head)
+	{
+		return uint16_t(head & 0xFFFFU);
+	}
+	static constexpr uint32_t get_tag(const uint32_t head)
+	{
+		return head >> 16;
+	}
+
+	std::atomic<uint32_t> m_head;
+	std::array<std::atomic<uint16_t>, LEN> m_next;
+};
@@ -0,0 +1,148 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/Cache_line.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include <cstdint>
+#include <cstddef>
+
+//multi producer single consumer ring of byte records, lock free for producers and wait free for the consumer
+//a record is split over as many SLOT_LEN slots as it needs, all claimed with one CAS, so records from several producers never interleave
+//each slot carries a sequence number, as in Vyukov's bounded queue, so a producer still copying does not block the others from claiming
+//records come out in the order they were claimed, so each producer's own records keep their order
+//producers may be tasks or ISRs, the consumer is one context at a time
+//freeing a slot and the producer's check are seq_cst so a caller can pair them with its own seq_cst flag, eg a waiter count, without a fence
+template<size_t SLOT_LEN, size_t NUM_SLOT>
+class Mpsc_record_ring
+{
+public:
+
+	//round up so the free running positions wrap cleanly
+	static constexpr size_t CAPACITY = []()
+	{
+		size_t n = 1;
+		while(n < NUM_SLOT)
+		{
+			n <<= 1;
+		}
+		return n;
+	}();
+
+	//largest record that can ever fit
+	static constexpr size_t MAX_RECORD_LEN = CAPACITY * SLOT_LEN;
+
+	Mpsc_record_ring()
+	{
+		for(size_t i = 0; i < CAPACITY; i++)
+		{
+			m_slots[i].seq.store(i, std::memory_order_relaxed);
+			m_slots[i].len = 0;
+		}
+
+		m_enqueue.store(0);
+		m_dequeue = 0;
+	}
+
+	//producer, false if there is no room now
+	bool write(const uint8_t* const data, const size_t len)
+	{
+		const size_t num = std::max<size_t>(1, (len + SLOT_LEN - 1) / SLOT_LEN);
+		if(num > CAPACITY)
+		{
+			return false;
+		}
+
+		//the consumer frees slots in order, so if the last slot is free for this lap the ones before it are too
+		size_t pos = m_enqueue.load(std::memory_order_relaxed);
+		for(;;)
+		{
+			const size_t last = pos + num - 1;
+			const size_t seq = m_slots[last & (CAPACITY - 1)].seq.load(std::memory_order_seq_cst);
+			const intptr_t diff = intptr_t(seq) - intptr_t(last);
+
+			if(diff == 0)
+			{
+				if(m_enqueue.compare_exchange_weak(pos, pos + num, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				//still holds a record from the last lap
+				return false;
+			}
+			else
+			{
+				pos = m_enqueue.load(std::memory_order_relaxed);
+			}
+		}
+
+		size_t offset = 0;
+		for(size_t i = 0; i < num; i++)
+		{
+			Slot& slot = m_slots[(pos + i) & (CAPACITY - 1)];
+
+			const size_t chunk = std::min(SLOT_LEN, len - offset);
+			std::copy_n(data + offset, chunk, slot.data.begin());
+			slot.len = chunk;
+			offset += chunk;
+
+			slot.seq.store(pos + i + 1, std::memory_order_release);
+		}
+
+		return true;
+	}
+
+	//consumer, the oldest filled slot or nullptr
+	//a record split over several slots comes out as several chunks, each valid until pop
+	const uint8_t* peek(size_t* const out_len)
+	{
+		Slot& slot = m_slots[m_dequeue & (CAPACITY - 1)];
+		if(slot.seq.load(std::memory_order_acquire) != (m_dequeue + 1))
+		{
+			return nullptr;
+		}
+
+		*out_len = slot.len;
+		return slot.data.data();
+	}
+
+	//consumer, free the slot from peek
+	void pop()
+	{
+		Slot& slot = m_slots[m_dequeue & (CAPACITY - 1)];
+		slot.seq.store(m_dequeue + CAPACITY, std::memory_order_seq_cst);
+		m_dequeue++;
+	}
+
+	//consumer
+	bool empty()
+	{
+		size_t len = 0;
+		return peek(&len) == nullptr;
+	}
+
+protected:
+
+	struct Slot
+	{
+		std::atomic<size_t> seq;
+		size_t len;
+		std::array<uint8_t, SLOT_LEN> data;
+	};
+
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_enqueue;
+	alignas(CACHE_LINE_SIZE) size_t m_dequeue;
+
+	std::array<Slot, CAPACITY> m_slots;
+};
@@ -0,0 +1,136 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include <cstdint>
+#include <cstddef>
+
+//single producer single consumer ring for streaming samples between the usb task and an audio dma isr
+//the reader never stalls, a short read is padded with silence and counted as an underrun
+template<typename T, size_t LEN>
+class Sample_fifo
+{
+public:
+
+	static_assert((LEN & (LEN - 1)) == 0, "LEN must be a power of 2");
+
+	Sample_fifo()
+	{
+		clear();
+	}
+
+	//not thread safe
+	void clear()
+	{
+		m_head.store(0);
+		m_tail.store(0);
+		m_overrun.store(0);
+		m_underrun.store(0);
+	}
+
+	size_t size() const
+	{
+		return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const
+	{
+		return LEN - size();
+	}
+
+	constexpr static size_t max_size()
+	{
+		return LEN;
+	}
+
+	//producer
+	//returns number written, samples that do not fit are dropped and counted as overrun
+	size_t write(const T* const buf, const size_t len)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		const size_t tail = m_tail.load(std::memory_order_acquire);
+
+		const size_t num_to_write = std::min(len, LEN - (head - tail));
+
+		const size_t idx = head & (LEN - 1);
+		const size_t first = std::min(num_to_write, LEN - idx);
+		std::copy_n(buf, first, m_buf.data() + idx);
+		std::copy_n(buf + first, num_to_write - first, m_buf.data());
+
+		m_head.store(head + num_to_write, std::memory_order_release);
+
+		if(num_to_write != len)
+		{
+			m_overrun.fetch_add(len - num_to_write, std::memory_order_relaxed);
+		}
+
+		return num_to_write;
+	}
+
+	//consumer
+	//always fills len, returns number of real samples
+	size_t read(T* const buf, const size_t len)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		const size_t head = m_head.load(std::memory_order_acquire);
+
+		const size_t num_to_read = std::min(len, head - tail);
+
+		const size_t idx = tail & (LEN - 1);
+		const size_t first = std::min(num_to_read, LEN - idx);
+		std::copy_n(m_buf.data() + idx, first, buf);
+		std::copy_n(m_buf.data(), num_to_read - first, buf + first);
+
+		m_tail.store(tail + num_to_read, std::memory_order_release);
+
+		if(num_to_read != len)
+		{
+			std::fill_n(buf + num_to_read, len - num_to_read, T());
+			m_underrun.fetch_add(len - num_to_read, std::memory_order_relaxed);
+		}
+
+		return num_to_read;
+	}
+
+	//consumer, drop samples without copying
+	size_t discard(const size_t len)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		const size_t head = m_head.load(std::memory_order_acquire);
+
+		const size_t num_to_drop = std::min(len, head - tail);
+
+		m_tail.store(tail + num_to_drop, std::memory_order_release);
+
+		return num_to_drop;
+	}
+
+	size_t get_overrun_count() const
+	{
+		return m_overrun.load(std::memory_order_relaxed);
+	}
+
+	size_t get_underrun_count() const
+	{
+		return m_underrun.load(std::memory_order_relaxed);
+	}
+
+protected:
+
+	//free running counters, only wrapped when indexing
+	std::atomic<size_t> m_head;
+	std::atomic<size_t> m_tail;
+
+	std::atomic<size_t> m_overrun;
+	std::atomic<size_t> m_underrun;
+
+	std::array<T, LEN> m_buf;
+};
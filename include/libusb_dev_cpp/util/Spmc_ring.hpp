@@ -0,0 +1,98 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#pragma once
+
+#include "libusb_dev_cpp/util/Cache_line.hpp"
+
+#include <array>
+#include <atomic>
+
+#include <cstdint>
+#include <cstddef>
+
+//single producer multi consumer ring of at least LEN elements, wait free to push and lock free to pop
+//the producer may be a task or an ISR, but only one at a time
+//any number of tasks and ISRs may pop, eg an app task and the driver isr reclaiming the oldest buffer
+//T must be trivially copyable, the slots are atomics so a pop that loses a race reads a stale value and retries
+//publishing and the consumer's check are seq_cst so a caller can pair them with its own seq_cst flag, eg a waiter count, without a fence
+template<typename T, size_t LEN>
+class Spmc_ring
+{
+public:
+
+	//round up so the free running indices wrap cleanly
+	static constexpr size_t CAPACITY = []()
+	{
+		size_t n = 1;
+		while(n < LEN)
+		{
+			n <<= 1;
+		}
+		return n;
+	}();
+
+	Spmc_ring()
+	{
+		m_head.store(0);
+		m_tail.store(0);
+	}
+
+	//producer
+	bool push(const T& val)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if((tail - m_head.load(std::memory_order_acquire)) == CAPACITY)
+		{
+			return false;
+		}
+
+		m_buf[tail & (CAPACITY - 1)].store(val, std::memory_order_relaxed);
+		m_tail.store(tail + 1, std::memory_order_seq_cst);
+
+		return true;
+	}
+
+	//consumers
+	bool pop(T* const val)
+	{
+		//acquire, so the tail seen below is at least the one the consumer that moved head saw
+		size_t head = m_head.load(std::memory_order_acquire);
+		for(;;)
+		{
+			if(head == m_tail.load(std::memory_order_seq_cst))
+			{
+				return false;
+			}
+
+			//the slot is not reused until head moves past it, so if the cas wins this is the value pushed
+			const T out = m_buf[head & (CAPACITY - 1)].load(std::memory_order_relaxed);
+			if(m_head.compare_exchange_weak(head, head + 1, std::memory_order_release, std::memory_order_acquire))
+			{
+				*val = out;
+				return true;
+			}
+		}
+	}
+
+	//either side, a snapshot
+	size_t size() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+protected:
+
+	std::array<std::atomic<T>, CAPACITY> m_buf;
+
+	//the consumers write head and the producer writes tail, keep them on their own lines
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail;
+};
@@ -10,6 +10,8 @@
 
 #include "libusb_dev_cpp/util/Desc_table_base.hpp"
 
+#include <vector>
+
 class String_desc_table : public Desc_table_base<String_descriptor_base>
 {
 public:
@@ -26,5 +28,8 @@ public:
 	String_desc_table* get_table(const String_descriptor_zero::LANGID lang);
 	const String_desc_table* get_table(const String_descriptor_zero::LANGID lang) const;
 
+	//every language with a table, in LANGID order, LANGID::NONE is skipped
+	std::vector<String_descriptor_zero::LANGID> get_langids() const;
+
 	std::map<String_descriptor_zero::LANGID, String_desc_table> m_table;
 };
\ No newline at end of file
@@ -36,7 +36,7 @@ bool CDC::LINE_CODING::serialize(Buffer_adapter_tx* const out_array) const
 	return true;
 }
 
-bool CDC::LINE_CODING::deserialize(const Buffer_adapter_base* buf)
+bool CDC::LINE_CODING::deserialize(const Buffer_adapter_rx* buf)
 {
 	// freertos_util::logging::Logger* const logger = freertos_util::logging::Global_logger::get();
 
@@ -0,0 +1,46 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/class/hid/hid_desc.hpp"
+
+#include "common_util/Byte_util.hpp"
+
+namespace HID
+{
+
+bool HID_descriptor::serialize(HID_descriptor_array* const out_array) const
+{
+	(*out_array)[0] = bLength;
+	(*out_array)[1] = bDescriptorType;
+	(*out_array)[2] = Byte_util::get_b0(bcdHID);
+	(*out_array)[3] = Byte_util::get_b1(bcdHID);
+	(*out_array)[4] = bCountryCode;
+	(*out_array)[5] = bNumDescriptors;
+	(*out_array)[6] = bReportDescriptorType;
+	(*out_array)[7] = Byte_util::get_b0(wDescriptorLength);
+	(*out_array)[8] = Byte_util::get_b1(wDescriptorLength);
+
+	return true;
+}
+bool HID_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	HID_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+}
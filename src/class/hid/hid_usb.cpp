@@ -0,0 +1,418 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/class/hid/hid_usb.hpp"
+
+#include "common_util/Byte_util.hpp"
+
+#include "freertos_cpp_util/logging/Global_logger.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+using freertos_util::logging::Global_logger;
+using freertos_util::logging::LOG_LEVEL;
+
+HID_class::HID_class()
+{
+	m_driver = nullptr;
+	m_iface = 0;
+	m_in_ep = 0;
+	m_in_ep_size = 0;
+	m_configured = false;
+
+	m_report_desc = nullptr;
+	m_report_desc_len = 0;
+
+	m_protocol = HID::PROTOCOL::REPORT;
+	m_idle_rate = 0;
+
+	m_get_report_callback_func = nullptr;
+	m_get_report_callback_ctx = nullptr;
+
+	m_set_report_callback_func = nullptr;
+	m_set_report_callback_ctx = nullptr;
+
+	m_in_busy = false;
+	m_in_frame = 0;
+
+	m_pending_valid = false;
+	m_pending_frame = 0;
+	m_pending_len = 0;
+
+	m_last_len = 0;
+
+	reset_latency_stats();
+}
+HID_class::~HID_class()
+{
+
+}
+
+bool HID_class::initialize(usb_driver_base* const driver, const uint8_t iface, const uint8_t in_ep)
+{
+	if(!USB_common::is_in_ep(in_ep))
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "HID_class", "initialize: ep 0x%02X is not an IN ep", in_ep);
+		return false;
+	}
+
+	m_driver = driver;
+	m_iface = iface;
+	m_in_ep = in_ep;
+
+	m_driver->set_ep_tx_callback(USB_common::get_ep_addr(m_in_ep), std::bind(&HID_class::handle_in_complete, this, std::placeholders::_1, std::placeholders::_2));
+
+	return true;
+}
+
+bool HID_class::configure(const size_t in_ep_size)
+{
+	if(!m_driver)
+	{
+		return false;
+	}
+
+	if(in_ep_size > MAX_REPORT_SIZE)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "HID_class", "configure: ep size %u too large", in_ep_size);
+		return false;
+	}
+
+	usb_driver_base::ep_cfg ep;
+	ep.num  = m_in_ep;
+	ep.size = in_ep_size;
+	ep.type = usb_driver_base::EP_TYPE::INTERRUPT;
+
+	if(!m_driver->ep_config(ep))
+	{
+		return false;
+	}
+
+	std::lock_guard<Mutex_static> lock(m_mutex);
+
+	m_in_ep_size = in_ep_size;
+	m_in_busy = false;
+	m_pending_valid = false;
+	m_protocol = HID::PROTOCOL::REPORT;
+	m_configured = true;
+
+	return true;
+}
+
+void HID_class::unconfigure()
+{
+	if(!m_driver)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<Mutex_static> lock(m_mutex);
+
+		m_configured = false;
+		m_in_busy = false;
+		m_pending_valid = false;
+	}
+
+	m_driver->ep_unconfig(m_in_ep);
+}
+
+void HID_class::set_report_descriptor(const uint8_t* const desc, const size_t len)
+{
+	m_report_desc = desc;
+	m_report_desc_len = len;
+
+	m_hid_desc.wDescriptorLength = len;
+}
+
+bool HID_class::send_report(const uint8_t* const report, const size_t len)
+{
+	//not initialized
+	if(!m_driver)
+	{
+		return false;
+	}
+
+	if(len > MAX_REPORT_SIZE)
+	{
+		return false;
+	}
+
+	const uint16_t frame = m_driver->get_frame_number();
+
+	std::lock_guard<Mutex_static> lock(m_mutex);
+
+	if(!m_configured)
+	{
+		return false;
+	}
+
+	if(len > m_in_ep_size)
+	{
+		return false;
+	}
+
+	std::copy_n(report, len, m_last.data());
+	m_last_len = len;
+
+	if(!m_in_busy)
+	{
+		return load_report(report, len, frame);
+	}
+
+	//ep has a report in the fifo, replace whatever was waiting behind it
+	if(m_pending_valid)
+	{
+		m_stats.dropped++;
+	}
+	else
+	{
+		m_pending_frame = frame;
+	}
+
+	std::copy_n(report, len, m_pending.data());
+	m_pending_len = len;
+	m_pending_valid = true;
+
+	return true;
+}
+
+bool HID_class::load_report(const uint8_t* const report, const size_t len, const uint16_t frame)
+{
+	Buffer_adapter_base* const buf = m_driver->get_tx_buffer()->poll_allocate_buffer(USB_common::get_ep_addr(m_in_ep));
+	if(!buf)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "HID_class", "load_report: no tx buffer");
+		return false;
+	}
+
+	buf->reset();
+	buf->insert(report, len);
+
+	if(!m_driver->enqueue_tx_buffer(m_in_ep, buf))
+	{
+		m_driver->get_tx_buffer()->release_buffer(USB_common::get_ep_addr(m_in_ep), buf);
+		return false;
+	}
+
+	m_in_busy = true;
+	m_in_frame = frame;
+
+	return true;
+}
+
+void HID_class::handle_in_complete(const USB_common::USB_EVENTS event, const uint8_t ep)
+{
+	const uint16_t frame = m_driver->get_frame_number();
+
+	std::lock_guard<Mutex_static> lock(m_mutex);
+
+	if(!m_in_busy)
+	{
+		return;
+	}
+
+	const uint16_t delta = get_frame_delta(m_in_frame, frame);
+	m_stats.count++;
+	m_stats.sum += delta;
+	m_stats.min = std::min(m_stats.min, delta);
+	m_stats.max = std::max(m_stats.max, delta);
+
+	m_in_busy = false;
+
+	if(m_pending_valid && m_configured)
+	{
+		m_pending_valid = false;
+		load_report(m_pending.data(), m_pending_len, m_pending_frame);
+	}
+}
+
+uint16_t HID_class::get_frame_delta(const uint16_t start, const uint16_t end) const
+{
+	//HS counts 14 bit microframes, FS and LS count 11 bit frames
+	const uint16_t mask = (m_driver->get_speed() == USB_common::USB_SPEED::HS) ? 0x3FFF : 0x07FF;
+
+	return (end - start) & mask;
+}
+
+HID_class::Latency_stats HID_class::get_latency_stats()
+{
+	std::lock_guard<Mutex_static> lock(m_mutex);
+
+	return m_stats;
+}
+
+void HID_class::reset_latency_stats()
+{
+	std::lock_guard<Mutex_static> lock(m_mutex);
+
+	m_stats.count = 0;
+	m_stats.sum = 0;
+	m_stats.min = std::numeric_limits<uint16_t>::max();
+	m_stats.max = 0;
+	m_stats.dropped = 0;
+}
+
+USB_common::USB_RESP HID_class::handle_class_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+{
+	if(req->wIndex != m_iface)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
+
+	buf_to_host->reset();
+
+	switch(static_cast<HID::HID_REQUESTS>(req->bRequest))
+	{
+		case HID::HID_REQUESTS::GET_REPORT:
+		{
+			const HID::REPORT_TYPE type = static_cast<HID::REPORT_TYPE>(Byte_util::get_b1(req->wValue));
+			const uint8_t report_id = Byte_util::get_b0(req->wValue);
+
+			if(m_get_report_callback_func)
+			{
+				if(m_get_report_callback_func(m_get_report_callback_ctx, type, report_id, buf_to_host))
+				{
+					r = USB_common::USB_RESP::ACK;
+				}
+			}
+			else if(type == HID::REPORT_TYPE::INPUT)
+			{
+				std::lock_guard<Mutex_static> lock(m_mutex);
+
+				buf_to_host->insert(m_last.data(), m_last_len);
+				r = USB_common::USB_RESP::ACK;
+			}
+			break;
+		}
+		case HID::HID_REQUESTS::SET_REPORT:
+		{
+			const HID::REPORT_TYPE type = static_cast<HID::REPORT_TYPE>(Byte_util::get_b1(req->wValue));
+			const uint8_t report_id = Byte_util::get_b0(req->wValue);
+
+			if(m_set_report_callback_func)
+			{
+				if(m_set_report_callback_func(m_set_report_callback_ctx, type, report_id, buf_from_host))
+				{
+					r = USB_common::USB_RESP::ACK;
+				}
+			}
+			break;
+		}
+		case HID::HID_REQUESTS::GET_IDLE:
+		{
+			//one rate for all reports, per report id rates are not kept
+			if(Byte_util::get_b0(req->wValue) != 0)
+			{
+				break;
+			}
+
+			buf_to_host->insert(m_idle_rate);
+			r = USB_common::USB_RESP::ACK;
+			break;
+		}
+		case HID::HID_REQUESTS::SET_IDLE:
+		{
+			//only the rate for all reports, report id 0, is accepted
+			//it is stored for GET_IDLE and not enforced, reports are sent on change by send_report
+			if(Byte_util::get_b0(req->wValue) != 0)
+			{
+				Global_logger::get()->log(LOG_LEVEL::WARN, "HID_class", "handle_class_request: SET_IDLE for report id %d not supported", int(Byte_util::get_b0(req->wValue)));
+				break;
+			}
+
+			m_idle_rate = Byte_util::get_b1(req->wValue);
+			r = USB_common::USB_RESP::ACK;
+			break;
+		}
+		case HID::HID_REQUESTS::GET_PROTOCOL:
+		{
+			buf_to_host->insert(static_cast<uint8_t>(m_protocol));
+			r = USB_common::USB_RESP::ACK;
+			break;
+		}
+		case HID::HID_REQUESTS::SET_PROTOCOL:
+		{
+			switch(static_cast<HID::PROTOCOL>(Byte_util::get_b0(req->wValue)))
+			{
+				case HID::PROTOCOL::BOOT:
+				case HID::PROTOCOL::REPORT:
+				{
+					m_protocol = static_cast<HID::PROTOCOL>(Byte_util::get_b0(req->wValue));
+					r = USB_common::USB_RESP::ACK;
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+			break;
+		}
+		default:
+		{
+			Global_logger::get()->log(LOG_LEVEL::INFO, "HID_class", "handle_class_request: unknown, %d", int(req->bRequest));
+			break;
+		}
+	}
+
+	return r;
+}
+
+USB_common::USB_RESP HID_class::handle_std_iface_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+{
+	if(req->wIndex != m_iface)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	if(static_cast<Setup_packet::INTERFACE_REQUEST>(req->bRequest) != Setup_packet::INTERFACE_REQUEST::GET_DESCRIPTOR)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
+
+	buf_to_host->reset();
+
+	switch(static_cast<HID::DESCRIPTOR_TYPE>(Byte_util::get_b1(req->wValue)))
+	{
+		case HID::DESCRIPTOR_TYPE::HID:
+		{
+			if(m_hid_desc.serialize(buf_to_host))
+			{
+				r = USB_common::USB_RESP::ACK;
+			}
+			break;
+		}
+		case HID::DESCRIPTOR_TYPE::REPORT:
+		{
+			if(m_report_desc == nullptr)
+			{
+				break;
+			}
+
+			if(buf_to_host->insert(m_report_desc, m_report_desc_len) != m_report_desc_len)
+			{
+				Global_logger::get()->log(LOG_LEVEL::ERROR, "HID_class", "handle_std_iface_request: report descriptor does not fit ep0 buffer");
+				break;
+			}
+
+			r = USB_common::USB_RESP::ACK;
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	return r;
+}
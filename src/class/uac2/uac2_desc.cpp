@@ -0,0 +1,270 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/class/uac2/uac2_desc.hpp"
+
+#include "common_util/Byte_util.hpp"
+
+namespace UAC2
+{
+
+bool AC_header_descriptor::serialize(AC_header_descriptor_array* const out_array) const
+{
+	(*out_array)[0] = bLength;
+	(*out_array)[1] = bDescriptorType;
+	(*out_array)[2] = bDescriptorSubtype;
+	(*out_array)[3] = Byte_util::get_b0(bcdADC);
+	(*out_array)[4] = Byte_util::get_b1(bcdADC);
+	(*out_array)[5] = bCategory;
+	(*out_array)[6] = Byte_util::get_b0(wTotalLength);
+	(*out_array)[7] = Byte_util::get_b1(wTotalLength);
+	(*out_array)[8] = bmControls;
+
+	return true;
+}
+bool AC_header_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	AC_header_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+bool Clock_source_descriptor::serialize(Clock_source_descriptor_array* const out_array) const
+{
+	(*out_array)[0] = bLength;
+	(*out_array)[1] = bDescriptorType;
+	(*out_array)[2] = bDescriptorSubtype;
+	(*out_array)[3] = bClockID;
+	(*out_array)[4] = bmAttributes;
+	(*out_array)[5] = bmControls;
+	(*out_array)[6] = bAssocTerminal;
+	(*out_array)[7] = iClockSource;
+
+	return true;
+}
+bool Clock_source_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	Clock_source_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+bool Clock_selector_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	out_array->insert(static_cast<uint8_t>(size()));
+	out_array->insert(bDescriptorType);
+	out_array->insert(bDescriptorSubtype);
+	out_array->insert(bClockID);
+	out_array->insert(static_cast<uint8_t>(baCSourceID.size()));
+	out_array->insert(baCSourceID.data(), baCSourceID.size());
+	out_array->insert(bmControls);
+	out_array->insert(iClockSelector);
+
+	return true;
+}
+
+bool Input_terminal_descriptor::serialize(Input_terminal_descriptor_array* const out_array) const
+{
+	(*out_array)[0]  = bLength;
+	(*out_array)[1]  = bDescriptorType;
+	(*out_array)[2]  = bDescriptorSubtype;
+	(*out_array)[3]  = bTerminalID;
+	(*out_array)[4]  = Byte_util::get_b0(wTerminalType);
+	(*out_array)[5]  = Byte_util::get_b1(wTerminalType);
+	(*out_array)[6]  = bAssocTerminal;
+	(*out_array)[7]  = bCSourceID;
+	(*out_array)[8]  = bNrChannels;
+	(*out_array)[9]  = Byte_util::get_b0(bmChannelConfig);
+	(*out_array)[10] = Byte_util::get_b1(bmChannelConfig);
+	(*out_array)[11] = Byte_util::get_b2(bmChannelConfig);
+	(*out_array)[12] = Byte_util::get_b3(bmChannelConfig);
+	(*out_array)[13] = iChannelNames;
+	(*out_array)[14] = Byte_util::get_b0(bmControls);
+	(*out_array)[15] = Byte_util::get_b1(bmControls);
+	(*out_array)[16] = iTerminal;
+
+	return true;
+}
+bool Input_terminal_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	Input_terminal_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+bool Output_terminal_descriptor::serialize(Output_terminal_descriptor_array* const out_array) const
+{
+	(*out_array)[0]  = bLength;
+	(*out_array)[1]  = bDescriptorType;
+	(*out_array)[2]  = bDescriptorSubtype;
+	(*out_array)[3]  = bTerminalID;
+	(*out_array)[4]  = Byte_util::get_b0(wTerminalType);
+	(*out_array)[5]  = Byte_util::get_b1(wTerminalType);
+	(*out_array)[6]  = bAssocTerminal;
+	(*out_array)[7]  = bSourceID;
+	(*out_array)[8]  = bCSourceID;
+	(*out_array)[9]  = Byte_util::get_b0(bmControls);
+	(*out_array)[10] = Byte_util::get_b1(bmControls);
+	(*out_array)[11] = iTerminal;
+
+	return true;
+}
+bool Output_terminal_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	Output_terminal_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+bool AS_general_descriptor::serialize(AS_general_descriptor_array* const out_array) const
+{
+	(*out_array)[0]  = bLength;
+	(*out_array)[1]  = bDescriptorType;
+	(*out_array)[2]  = bDescriptorSubtype;
+	(*out_array)[3]  = bTerminalLink;
+	(*out_array)[4]  = bmControls;
+	(*out_array)[5]  = bFormatType;
+	(*out_array)[6]  = Byte_util::get_b0(bmFormats);
+	(*out_array)[7]  = Byte_util::get_b1(bmFormats);
+	(*out_array)[8]  = Byte_util::get_b2(bmFormats);
+	(*out_array)[9]  = Byte_util::get_b3(bmFormats);
+	(*out_array)[10] = bNrChannels;
+	(*out_array)[11] = Byte_util::get_b0(bmChannelConfig);
+	(*out_array)[12] = Byte_util::get_b1(bmChannelConfig);
+	(*out_array)[13] = Byte_util::get_b2(bmChannelConfig);
+	(*out_array)[14] = Byte_util::get_b3(bmChannelConfig);
+	(*out_array)[15] = iChannelNames;
+
+	return true;
+}
+bool AS_general_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	AS_general_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+bool Format_type_I_descriptor::serialize(Format_type_I_descriptor_array* const out_array) const
+{
+	(*out_array)[0] = bLength;
+	(*out_array)[1] = bDescriptorType;
+	(*out_array)[2] = bDescriptorSubtype;
+	(*out_array)[3] = bFormatType;
+	(*out_array)[4] = bSubslotSize;
+	(*out_array)[5] = bBitResolution;
+
+	return true;
+}
+bool Format_type_I_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	Format_type_I_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+bool AS_iso_endpoint_descriptor::serialize(AS_iso_endpoint_descriptor_array* const out_array) const
+{
+	(*out_array)[0] = bLength;
+	(*out_array)[1] = bDescriptorType;
+	(*out_array)[2] = bDescriptorSubtype;
+	(*out_array)[3] = bmAttributes;
+	(*out_array)[4] = bmControls;
+	(*out_array)[5] = bLockDelayUnits;
+	(*out_array)[6] = Byte_util::get_b0(wLockDelay);
+	(*out_array)[7] = Byte_util::get_b1(wLockDelay);
+
+	return true;
+}
+bool AS_iso_endpoint_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	AS_iso_endpoint_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+}
@@ -0,0 +1,93 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/class/uac2/uac2_feedback.hpp"
+
+#include "common_util/Byte_util.hpp"
+
+#include <algorithm>
+
+UAC2_feedback::UAC2_feedback()
+{
+	m_speed = USB_common::USB_SPEED::FS;
+
+	m_nominal  = 0;
+	m_measured = 0;
+	m_feedback = 0;
+
+	m_window = 1;
+	m_acc_frames = 0;
+	m_acc_samples = 0;
+
+	m_target_level = 0;
+	m_trim_shift = 10;
+}
+
+void UAC2_feedback::set_rate(const uint32_t sample_rate, const USB_common::USB_SPEED speed)
+{
+	m_speed = speed;
+
+	const uint64_t frames_per_sec = (m_speed == USB_common::USB_SPEED::HS) ? 8000 : 1000;
+
+	m_nominal = static_cast<uint32_t>((uint64_t(sample_rate) << 16) / frames_per_sec);
+
+	reset();
+}
+
+void UAC2_feedback::reset()
+{
+	m_measured = m_nominal;
+	m_feedback = m_nominal;
+
+	m_acc_frames = 0;
+	m_acc_samples = 0;
+}
+
+void UAC2_feedback::update(const uint32_t frames, const uint32_t samples, const size_t fifo_level)
+{
+	m_acc_frames  += frames;
+	m_acc_samples += samples;
+
+	if(m_acc_frames >= m_window)
+	{
+		m_measured = static_cast<uint32_t>((uint64_t(m_acc_samples) << 16) / m_acc_frames);
+
+		m_acc_frames = 0;
+		m_acc_samples = 0;
+	}
+
+	//ask for more when below target, less when above
+	const int64_t level_err = int64_t(m_target_level) - int64_t(fifo_level);
+	const int64_t trim = (level_err * 65536) / (int64_t(1) << m_trim_shift);
+
+	//keep within ~0.4% of nominal, hosts may ignore anything wilder
+	const int64_t max_dev = m_nominal >> 8;
+	const int64_t fb = std::clamp<int64_t>(int64_t(m_measured) + trim, int64_t(m_nominal) - max_dev, int64_t(m_nominal) + max_dev);
+
+	m_feedback = static_cast<uint32_t>(fb);
+}
+
+size_t UAC2_feedback::serialize(Feedback_array* const out_array) const
+{
+	if(m_speed == USB_common::USB_SPEED::HS)
+	{
+		(*out_array)[0] = Byte_util::get_b0(m_feedback);
+		(*out_array)[1] = Byte_util::get_b1(m_feedback);
+		(*out_array)[2] = Byte_util::get_b2(m_feedback);
+		(*out_array)[3] = Byte_util::get_b3(m_feedback);
+
+		return 4;
+	}
+
+	const uint32_t fb_10_14 = m_feedback >> 2;
+
+	(*out_array)[0] = Byte_util::get_b0(fb_10_14);
+	(*out_array)[1] = Byte_util::get_b1(fb_10_14);
+	(*out_array)[2] = Byte_util::get_b2(fb_10_14);
+	(*out_array)[3] = 0;
+
+	return 3;
+}
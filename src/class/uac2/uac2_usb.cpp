@@ -0,0 +1,409 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/class/uac2/uac2_usb.hpp"
+
+#include "common_util/Byte_util.hpp"
+
+#include "freertos_cpp_util/logging/Global_logger.hpp"
+
+#include <algorithm>
+
+using freertos_util::logging::Global_logger;
+using freertos_util::logging::LOG_LEVEL;
+
+UAC2_class::UAC2_class()
+{
+	m_driver = nullptr;
+	m_ac_iface = 0;
+	m_clock_id = 0;
+	m_out_ep = 0;
+	m_fb_ep = 0;
+
+	m_clock_selector_id = 0;
+	m_clock_selector_pins = 0;
+	m_clock_selector_pin = 0;
+
+	m_sample_rate = 48000;
+	m_frame_size = 0;
+
+	m_sample_clock_callback_func = nullptr;
+	m_sample_clock_callback_ctx = nullptr;
+
+	m_sample_rate_callback_func = nullptr;
+	m_sample_rate_callback_ctx = nullptr;
+
+	m_streaming = false;
+	m_fb_busy = false;
+
+	m_last_frame = 0;
+	m_last_sample_clock = 0;
+
+	m_dropped_packets = 0;
+}
+UAC2_class::~UAC2_class()
+{
+
+}
+
+bool UAC2_class::initialize(usb_driver_base* const driver, const uint8_t ac_iface, const uint8_t clock_id, const uint8_t out_ep, const uint8_t fb_ep)
+{
+	if(USB_common::is_in_ep(out_ep) || !USB_common::is_in_ep(fb_ep))
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "UAC2_class", "initialize: bad ep direction");
+		return false;
+	}
+
+	m_driver = driver;
+	m_ac_iface = ac_iface;
+	m_clock_id = clock_id;
+	m_out_ep = out_ep;
+	m_fb_ep = fb_ep;
+
+	m_driver->set_ep_tx_callback(USB_common::get_ep_addr(m_fb_ep), std::bind(&UAC2_class::handle_fb_complete, this, std::placeholders::_1, std::placeholders::_2));
+
+	return true;
+}
+
+void UAC2_class::set_sample_rates(const std::vector<uint32_t>& rates)
+{
+	m_sample_rates = rates;
+
+	if(!m_sample_rates.empty())
+	{
+		m_sample_rate = m_sample_rates.front();
+	}
+}
+
+bool UAC2_class::start_streaming(const size_t out_ep_size)
+{
+	if(m_frame_size == 0)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "UAC2_class", "start_streaming: format not set");
+		return false;
+	}
+
+	const USB_common::USB_SPEED speed = m_driver->get_speed();
+
+	usb_driver_base::ep_cfg ep;
+	ep.num  = m_out_ep;
+	ep.size = out_ep_size;
+	ep.type = usb_driver_base::EP_TYPE::ISOCHRONUS;
+	if(!m_driver->ep_config(ep))
+	{
+		return false;
+	}
+
+	ep.num  = m_fb_ep;
+	ep.size = 4;
+	ep.type = usb_driver_base::EP_TYPE::ISOCHRONUS;
+	if(!m_driver->ep_config(ep))
+	{
+		m_driver->ep_unconfig(m_out_ep);
+		return false;
+	}
+
+	m_fifo.clear();
+	m_dropped_packets = 0;
+
+	m_feedback.set_rate(m_sample_rate, speed);
+	m_feedback.set_window((speed == USB_common::USB_SPEED::HS) ? 1024 : 128);
+	m_feedback.set_target_level((FIFO_SIZE / m_frame_size) / 2, 10);
+
+	m_last_frame = m_driver->get_frame_number();
+	if(m_sample_clock_callback_func)
+	{
+		m_last_sample_clock = m_sample_clock_callback_func(m_sample_clock_callback_ctx);
+	}
+
+	m_streaming = true;
+
+	m_fb_busy = false;
+	load_feedback();
+
+	return true;
+}
+
+void UAC2_class::stop_streaming()
+{
+	m_streaming = false;
+
+	m_driver->ep_unconfig(m_out_ep);
+	m_driver->ep_unconfig(m_fb_ep);
+
+	m_fb_busy = false;
+}
+
+void UAC2_class::process()
+{
+	const uint8_t ep_addr = USB_common::get_ep_addr(m_out_ep);
+
+	for(;;)
+	{
+		Buffer_adapter_base* const buf = m_driver->get_rx_buffer()->poll_dequeue_buffer(ep_addr);
+		if(!buf)
+		{
+			break;
+		}
+
+		//only whole packets go in so the fifo always holds whole audio frames
+		if(m_streaming && ((buf->size() % m_frame_size) == 0) && (m_fifo.capacity() >= buf->size()))
+		{
+			m_fifo.write(buf->data(), buf->size());
+		}
+		else
+		{
+			m_dropped_packets++;
+		}
+
+		m_driver->release_rx_buffer(m_out_ep, buf);
+	}
+}
+
+void UAC2_class::update_feedback()
+{
+	if(!m_streaming)
+	{
+		return;
+	}
+
+	if(!m_sample_clock_callback_func)
+	{
+		return;
+	}
+
+	//HS counts 14 bit microframes, FS counts 11 bit frames
+	const uint16_t mask = (m_driver->get_speed() == USB_common::USB_SPEED::HS) ? 0x3FFF : 0x07FF;
+
+	const uint16_t frame = m_driver->get_frame_number();
+	const uint32_t sample_clock = m_sample_clock_callback_func(m_sample_clock_callback_ctx);
+
+	const uint16_t frames  = (frame - m_last_frame) & mask;
+	const uint32_t samples = sample_clock - m_last_sample_clock;
+
+	if(frames == 0)
+	{
+		return;
+	}
+
+	m_last_frame = frame;
+	m_last_sample_clock = sample_clock;
+
+	m_feedback.update(frames, samples, get_fifo_level());
+
+	if(!m_fb_busy)
+	{
+		load_feedback();
+	}
+}
+
+size_t UAC2_class::read_frames(uint8_t* const buf, const size_t num_frames)
+{
+	if(m_frame_size == 0)
+	{
+		return 0;
+	}
+
+	const size_t len = num_frames * m_frame_size;
+
+	if(!m_streaming)
+	{
+		std::fill_n(buf, len, 0);
+		return 0;
+	}
+
+	return m_fifo.read(buf, len) / m_frame_size;
+}
+
+bool UAC2_class::load_feedback()
+{
+	Buffer_adapter_base* const buf = m_driver->get_tx_buffer()->poll_allocate_buffer(USB_common::get_ep_addr(m_fb_ep));
+	if(!buf)
+	{
+		return false;
+	}
+
+	UAC2_feedback::Feedback_array fb;
+	const size_t fb_len = m_feedback.serialize(&fb);
+
+	buf->reset();
+	buf->insert(fb.data(), fb_len);
+
+	m_fb_busy = true;
+	if(!m_driver->enqueue_tx_buffer(m_fb_ep, buf))
+	{
+		m_fb_busy = false;
+		m_driver->get_tx_buffer()->release_buffer(USB_common::get_ep_addr(m_fb_ep), buf);
+		return false;
+	}
+
+	return true;
+}
+
+void UAC2_class::handle_fb_complete(const USB_common::USB_EVENTS event, const uint8_t ep)
+{
+	m_fb_busy = false;
+
+	//keep the newest value loaded for the next poll
+	if(m_streaming)
+	{
+		load_feedback();
+	}
+}
+
+USB_common::USB_RESP UAC2_class::handle_class_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+{
+	//AC requests address an entity in wIndex high byte, interface in the low byte
+	const uint8_t entity_id = Byte_util::get_b1(req->wIndex);
+	const uint8_t iface = Byte_util::get_b0(req->wIndex);
+
+	if(iface != m_ac_iface)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	buf_to_host->reset();
+
+	if(entity_id == m_clock_id)
+	{
+		return handle_clock_source_request(req, buf_from_host, buf_to_host);
+	}
+	else if((m_clock_selector_pins != 0) && (entity_id == m_clock_selector_id))
+	{
+		return handle_clock_selector_request(req, buf_from_host, buf_to_host);
+	}
+
+	Global_logger::get()->log(LOG_LEVEL::INFO, "UAC2_class", "handle_class_request: unknown entity %d", int(entity_id));
+
+	return USB_common::USB_RESP::FAIL;
+}
+
+USB_common::USB_RESP UAC2_class::handle_clock_source_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+{
+	Request_type req_type;
+	req->get_request_type(&req_type);
+
+	const UAC2::CS_CONTROL_SELECTOR cs = static_cast<UAC2::CS_CONTROL_SELECTOR>(Byte_util::get_b1(req->wValue));
+	const UAC2::UAC2_REQUESTS request = static_cast<UAC2::UAC2_REQUESTS>(req->bRequest);
+
+	USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
+
+	switch(cs)
+	{
+		case UAC2::CS_CONTROL_SELECTOR::SAM_FREQ_CONTROL:
+		{
+			if(request == UAC2::UAC2_REQUESTS::CUR)
+			{
+				if(req_type.data_dir == Request_type::DATA_DIR::DEV_TO_HOST)
+				{
+					const std::array<uint8_t, 4> cur = {
+						Byte_util::get_b0(m_sample_rate),
+						Byte_util::get_b1(m_sample_rate),
+						Byte_util::get_b2(m_sample_rate),
+						Byte_util::get_b3(m_sample_rate)
+					};
+					buf_to_host->insert(cur.data(), cur.size());
+					r = USB_common::USB_RESP::ACK;
+				}
+				else
+				{
+					if(buf_from_host->size() != 4)
+					{
+						break;
+					}
+
+					const uint8_t* const data = buf_from_host->data();
+					const uint32_t rate = Byte_util::make_u32(data[3], data[2], data[1], data[0]);
+
+					if(std::find(m_sample_rates.begin(), m_sample_rates.end(), rate) == m_sample_rates.end())
+					{
+						break;
+					}
+
+					if(m_sample_rate_callback_func && !m_sample_rate_callback_func(m_sample_rate_callback_ctx, rate))
+					{
+						break;
+					}
+
+					m_sample_rate = rate;
+					m_feedback.set_rate(m_sample_rate, m_driver->get_speed());
+
+					r = USB_common::USB_RESP::ACK;
+				}
+			}
+			else if((request == UAC2::UAC2_REQUESTS::RANGE) && (req_type.data_dir == Request_type::DATA_DIR::DEV_TO_HOST))
+			{
+				//wNumSubRanges then {dMIN, dMAX, dRES} per discrete rate
+				const uint16_t num = m_sample_rates.size();
+				buf_to_host->insert(Byte_util::get_b0(num));
+				buf_to_host->insert(Byte_util::get_b1(num));
+
+				for(const uint32_t rate : m_sample_rates)
+				{
+					const std::array<uint8_t, 12> range = {
+						Byte_util::get_b0(rate), Byte_util::get_b1(rate), Byte_util::get_b2(rate), Byte_util::get_b3(rate),
+						Byte_util::get_b0(rate), Byte_util::get_b1(rate), Byte_util::get_b2(rate), Byte_util::get_b3(rate),
+						0, 0, 0, 0
+					};
+					buf_to_host->insert(range.data(), range.size());
+				}
+
+				r = USB_common::USB_RESP::ACK;
+			}
+			break;
+		}
+		case UAC2::CS_CONTROL_SELECTOR::CLOCK_VALID_CONTROL:
+		{
+			if((request == UAC2::UAC2_REQUESTS::CUR) && (req_type.data_dir == Request_type::DATA_DIR::DEV_TO_HOST))
+			{
+				buf_to_host->insert(uint8_t(1));
+				r = USB_common::USB_RESP::ACK;
+			}
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	return r;
+}
+
+USB_common::USB_RESP UAC2_class::handle_clock_selector_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+{
+	Request_type req_type;
+	req->get_request_type(&req_type);
+
+	const UAC2::CX_CONTROL_SELECTOR cx = static_cast<UAC2::CX_CONTROL_SELECTOR>(Byte_util::get_b1(req->wValue));
+	const UAC2::UAC2_REQUESTS request = static_cast<UAC2::UAC2_REQUESTS>(req->bRequest);
+
+	if((cx != UAC2::CX_CONTROL_SELECTOR::CLOCK_SELECTOR_CONTROL) || (request != UAC2::UAC2_REQUESTS::CUR))
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	if(req_type.data_dir == Request_type::DATA_DIR::DEV_TO_HOST)
+	{
+		buf_to_host->insert(m_clock_selector_pin);
+		return USB_common::USB_RESP::ACK;
+	}
+
+	if(buf_from_host->size() != 1)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	const uint8_t pin = buf_from_host->data()[0];
+	if((pin == 0) || (pin > m_clock_selector_pins))
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	m_clock_selector_pin = pin;
+
+	return USB_common::USB_RESP::ACK;
+}
@@ -9,3 +9,28 @@ USB_class::~USB_class()
 {
 	
 }
+
+USB_common::USB_RESP USB_class::handle_std_iface_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+{
+	return USB_common::USB_RESP::FAIL;
+}
+
+USB_common::USB_RESP USB_class::handle_vendor_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+{
+	return USB_common::USB_RESP::FAIL;
+}
+
+void USB_class::handle_ep_event(const USB_common::USB_EVENTS event, const uint8_t ep)
+{
+
+}
+
+bool USB_class::set_configuration(const uint8_t bConfigurationValue)
+{
+	return true;
+}
+
+bool USB_class::set_interface(const uint8_t iface, const uint8_t alt)
+{
+	return true;
+}
@@ -37,23 +37,3 @@ bool Notification_packet::deserialize(const Notification_packet_array& in_array)
 
 	return true;
 }
-
-bool Notification_packet::serialize(Buffer_adapter_base* const out_array) const
-{
-	size_t len = 0;
-
-	len += out_array->insert(bmRequestType);
-
-	len += out_array->insert(bNotification);
-
-	len += out_array->insert(Byte_util::get_b0(wValue));
-	len += out_array->insert(Byte_util::get_b1(wValue));
-
-	len += out_array->insert(Byte_util::get_b0(wIndex));
-	len += out_array->insert(Byte_util::get_b1(wIndex));
-
-	len += out_array->insert(Byte_util::get_b0(wLength));
-	len += out_array->insert(Byte_util::get_b1(wLength));
-
-	return len == std::tuple_size< Notification_packet_array >::value;
-}
\ No newline at end of file
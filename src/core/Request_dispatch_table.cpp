@@ -0,0 +1,98 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/core/Request_dispatch_table.hpp"
+
+Request_dispatch_table::Request_dispatch_table()
+{
+	for(Handler_entry& entry : m_std_handlers)
+	{
+		entry.func = nullptr;
+		entry.ctx = nullptr;
+	}
+}
+
+bool Request_dispatch_table::register_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest, const Request_handler& handler, void* ctx)
+{
+	if(!handler)
+	{
+		return false;
+	}
+
+	const uint8_t type_val = static_cast<uint8_t>(type);
+	const uint8_t recipient_val = static_cast<uint8_t>(recipient);
+
+	Handler_entry entry;
+	entry.func = handler;
+	entry.ctx = ctx;
+
+	if(is_std_slot(type_val, recipient_val, bRequest))
+	{
+		m_std_handlers[recipient_val * NUM_STD_REQUESTS + bRequest] = entry;
+	}
+	else
+	{
+		m_handlers[make_key(type_val, recipient_val, bRequest)] = entry;
+	}
+
+	return true;
+}
+
+void Request_dispatch_table::unregister_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest)
+{
+	const uint8_t type_val = static_cast<uint8_t>(type);
+	const uint8_t recipient_val = static_cast<uint8_t>(recipient);
+
+	if(is_std_slot(type_val, recipient_val, bRequest))
+	{
+		Handler_entry& entry = m_std_handlers[recipient_val * NUM_STD_REQUESTS + bRequest];
+		entry.func = nullptr;
+		entry.ctx = nullptr;
+	}
+	else
+	{
+		m_handlers.erase(make_key(type_val, recipient_val, bRequest));
+	}
+}
+
+const Request_dispatch_table::Handler_entry* Request_dispatch_table::find(const uint8_t bmRequestType, const uint8_t bRequest) const
+{
+	const uint8_t type = get_type(bmRequestType);
+	const uint8_t recipient = get_recipient(bmRequestType);
+
+	if(is_std_slot(type, recipient, bRequest))
+	{
+		const Handler_entry& entry = m_std_handlers[recipient * NUM_STD_REQUESTS + bRequest];
+		return (entry.func) ? &entry : nullptr;
+	}
+
+	//reserved recipients are never registered
+	if((recipient >= NUM_STD_RECIPIENTS) || m_handlers.empty())
+	{
+		return nullptr;
+	}
+
+	auto it = m_handlers.find(make_key(type, recipient, bRequest));
+	if(it == m_handlers.end())
+	{
+		return nullptr;
+	}
+
+	return &(it->second);
+}
+
+bool Request_dispatch_table::dispatch(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host, USB_common::USB_RESP* const out_resp) const
+{
+	const Handler_entry* const entry = find(req->bmRequestType, req->bRequest);
+	if(!entry)
+	{
+		return false;
+	}
+
+	*out_resp = entry->func(entry->ctx, req, buf_from_host, buf_to_host);
+
+	return true;
+}
@@ -10,6 +10,7 @@
 
 #include "libusb_dev_cpp/descriptor/Device_descriptor.hpp"
 #include "libusb_dev_cpp/descriptor/Configuration_descriptor.hpp"
+#include "libusb_dev_cpp/descriptor/Endpoint_descriptor.hpp"
 
 #include "common_util/Byte_util.hpp"
 
@@ -25,6 +26,41 @@ USB_core::USB_core()
 	m_driver = nullptr;
 	m_usb_class = nullptr;
 	m_desc_table = nullptr;
+
+	m_remote_wakeup_enabled = false;
+	m_iface_alt.fill(0);
+
+	m_control_state = USB_CONTROL_STATE::IDLE;
+	m_deferred.waiting = false;
+	m_deferred.done = false;
+	m_deferred.resp = USB_common::USB_RESP::FAIL;
+	m_deferred.start = 0;
+	m_setup_id = 0;
+	m_deferred_timeout = std::chrono::milliseconds(500);
+
+	m_stream = nullptr;
+	m_stream_offset = 0;
+	m_stream_rem = 0;
+
+	m_timestamp_callback_ctx = nullptr;
+	m_timestamp_callback_func = nullptr;
+
+	m_clock_gating = false;
+	m_suspend_callback_ctx = nullptr;
+	m_suspend_callback_func = nullptr;
+	m_resume_callback_ctx = nullptr;
+	m_resume_callback_func = nullptr;
+
+	m_num_queued_events = 0;
+
+	m_link_state = LINK_STATE::L0;
+	m_wake_pending = false;
+	m_wake_start = 0;
+	m_wake_signaling = false;
+	m_wake_signal_start = 0;
+	reset_power_stats();
+
+	register_std_requests();
 }
 
 USB_core::~USB_core()
@@ -36,6 +72,9 @@ bool USB_core::initialize(usb_driver_base* const driver, const uint8_t ep0size,
 {
 	m_address = 0;
 	m_configuration = 0;
+	m_speed = USB_common::USB_SPEED::FS;
+
+	m_iface_alt.fill(0);
 
 	m_driver = driver;
 
@@ -53,8 +92,32 @@ bool USB_core::initialize(usb_driver_base* const driver, const uint8_t ep0size,
 	m_reset_callback_ctx = nullptr;
 	m_reset_callback_func = nullptr;
 
+	m_timestamp_callback_ctx = nullptr;
+	m_timestamp_callback_func = nullptr;
+
+	m_clock_gating = false;
+	m_suspend_callback_ctx = nullptr;
+	m_suspend_callback_func = nullptr;
+	m_resume_callback_ctx = nullptr;
+	m_resume_callback_func = nullptr;
+
+	{
+		std::lock_guard<Mutex_static> lock(m_power_mutex);
+		m_remote_wakeup_enabled = false;
+		m_link_state = LINK_STATE::L0;
+		m_wake_pending = false;
+		m_wake_signaling = false;
+	}
+	reset_power_stats();
+
 	m_usb_core_handle_event = std::bind(&USB_core::handle_event, this, std::placeholders::_1, std::placeholders::_2);
 
+	//functions added before the driver was known
+	for(const Function_entry& f : m_functions)
+	{
+		enable_ep_rx_events(f.ep_mask);
+	}
+
 	return true;
 }
 
@@ -63,6 +126,150 @@ void USB_core::set_usb_class(USB_class* const usb_class)
 	m_usb_class = usb_class;
 }
 
+bool USB_core::add_usb_class(USB_class* const usb_class, const uint8_t first_iface, const uint8_t num_iface, const uint32_t ep_mask)
+{
+	if(!usb_class)
+	{
+		return false;
+	}
+
+	//interfaces and eps belong to exactly one function
+	for(const Function_entry& f : m_functions)
+	{
+		const bool iface_overlap = (first_iface < (f.first_iface + f.num_iface)) && (f.first_iface < (first_iface + num_iface));
+		if(iface_overlap || ((f.ep_mask & ep_mask) != 0))
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core", "add_usb_class: overlaps an existing function");
+			return false;
+		}
+	}
+
+	Function_entry entry;
+	entry.usb_class   = usb_class;
+	entry.first_iface = first_iface;
+	entry.num_iface   = num_iface;
+	entry.ep_mask     = ep_mask;
+
+	m_functions.push_back(entry);
+
+	if(m_driver)
+	{
+		enable_ep_rx_events(ep_mask);
+	}
+
+	return true;
+}
+
+void USB_core::enable_ep_rx_events(const uint32_t ep_mask)
+{
+	//OUT eps 1..15, ep0 always posts
+	for(uint8_t ep_addr = 1; ep_addr < 16; ep_addr++)
+	{
+		if((ep_mask & get_ep_mask(ep_addr)) != 0)
+		{
+			m_driver->set_ep_rx_event_enable(ep_addr, true);
+		}
+	}
+}
+
+USB_class* USB_core::get_class_for_iface(const uint8_t iface)
+{
+	for(const Function_entry& f : m_functions)
+	{
+		if((iface >= f.first_iface) && (iface < (f.first_iface + f.num_iface)))
+		{
+			return f.usb_class;
+		}
+	}
+
+	return m_usb_class;
+}
+
+USB_class* USB_core::get_class_for_ep(const uint8_t ep)
+{
+	const uint32_t mask = get_ep_mask(ep);
+
+	for(const Function_entry& f : m_functions)
+	{
+		if((f.ep_mask & mask) != 0)
+		{
+			return f.usb_class;
+		}
+	}
+
+	return m_usb_class;
+}
+
+USB_class* USB_core::get_class_for_request(Setup_packet* const req)
+{
+	Request_type request_type;
+	if(!req->get_request_type(&request_type))
+	{
+		return m_usb_class;
+	}
+
+	USB_class* usb_class = m_usb_class;
+	switch(request_type.recipient)
+	{
+		case Request_type::RECIPIENT::INTERFACE:
+		{
+			usb_class = get_class_for_iface(Byte_util::get_b0(req->wIndex));
+			break;
+		}
+		case Request_type::RECIPIENT::ENDPOINT:
+		{
+			usb_class = get_class_for_ep(Byte_util::get_b0(req->wIndex));
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	return usb_class;
+}
+
+void USB_core::handle_ep_event(const USB_common::USB_EVENTS event, const uint8_t ep)
+{
+	//one EP_RX is pending per ep, the handler drains every buffer queued before and during this
+	if((event == USB_common::USB_EVENTS::EP_RX) && (USB_common::get_ep_addr(ep) != 0))
+	{
+		m_driver->clear_ep_rx_event(USB_common::get_ep_addr(ep));
+	}
+
+	//ep0 and eps with a driver callback bound keep the direct path
+	USB_common::Event_callback func = nullptr;
+	if(event == USB_common::USB_EVENTS::EP_RX)
+	{
+		func = m_driver->get_ep_rx_callback(USB_common::get_ep_addr(ep));
+	}
+	else
+	{
+		func = m_driver->get_ep_tx_callback(USB_common::get_ep_addr(ep));
+	}
+
+	if(func)
+	{
+		func(event, ep);
+		return;
+	}
+
+	if(USB_common::get_ep_addr(ep) == 0)
+	{
+		return;
+	}
+
+	//OUT events may arrive without the direction bit
+	const uint8_t dir_ep = (event == USB_common::USB_EVENTS::EP_TX) ? (0x80 | ep) : USB_common::get_ep_addr(ep);
+
+	USB_class* const usb_class = get_class_for_ep(dir_ep);
+	if(usb_class)
+	{
+		usb_class->handle_ep_event(event, dir_ep);
+	}
+}
+
 void USB_core::set_descriptor_table(Descriptor_table* const desc_table)
 {
 	m_desc_table = desc_table;
@@ -104,6 +311,23 @@ bool USB_core::handle_reset()
 
 	m_setup_complete_callback = nullptr;
 
+	//drop any pending request
+	m_control_state = USB_CONTROL_STATE::IDLE;
+	m_stream = nullptr;
+	{
+		std::lock_guard<Mutex_static> lock(m_deferred_mutex);
+		m_setup_id++;
+		m_deferred.waiting = false;
+		m_deferred.done = false;
+	}
+
+	{
+		std::lock_guard<Mutex_static> lock(m_power_mutex);
+		m_remote_wakeup_enabled = false;
+	}
+	m_iface_alt.fill(0);
+	m_alt_settings.clear();
+
 	usb_driver_base::ep_cfg ep0;
 	ep0.num = 0;
 	ep0.size = 8;
@@ -120,6 +344,9 @@ bool USB_core::handle_reset()
 
 bool USB_core::handle_enum_done()
 {
+	//descriptors and ep sizes follow the negotiated speed
+	m_speed = m_driver->get_speed();
+
 	usb_driver_base::ep_cfg ep0;
 	ep0.num = 0;
 	if(m_driver->get_speed() == USB_common::USB_SPEED::LS)
@@ -142,6 +369,12 @@ bool USB_core::handle_enum_done()
 
 bool USB_core::handle_sof()
 {
+	//bus traffic, in case the resume event was missed
+	if(m_link_state != LINK_STATE::L0)
+	{
+		handle_resume();
+	}
+
 	if(m_sof_callback_func)
 	{
 		m_sof_callback_func(m_sof_callback_ctx);
@@ -150,6 +383,245 @@ bool USB_core::handle_sof()
 	return true;
 }
 
+bool USB_core::handle_suspend(const LINK_STATE state)
+{
+	const uint32_t start = get_timestamp();
+
+	set_link_state(state);
+
+	if(m_suspend_callback_func)
+	{
+		m_suspend_callback_func(m_suspend_callback_ctx, state);
+	}
+
+	//L1 has to resume in tens of us, only gate the clocks in L2
+	if(m_clock_gating && (state == LINK_STATE::L2))
+	{
+		m_driver->set_phy_clock_gate(true);
+	}
+
+	const uint32_t latency = get_timestamp() - start;
+	{
+		std::lock_guard<Mutex_static> lock(m_power_mutex);
+		m_power_stats.max_suspend_latency = std::max(m_power_stats.max_suspend_latency, latency);
+	}
+
+	return true;
+}
+
+bool USB_core::handle_resume()
+{
+	if(m_link_state == LINK_STATE::L0)
+	{
+		return true;
+	}
+
+	const uint32_t start = get_timestamp();
+
+	//the driver already ungated on the wakeup interrupt, make sure for the other paths
+	if(m_clock_gating)
+	{
+		m_driver->set_phy_clock_gate(false);
+	}
+
+	set_link_state(LINK_STATE::L0);
+
+	if(m_resume_callback_func)
+	{
+		m_resume_callback_func(m_resume_callback_ctx);
+	}
+
+	const uint32_t latency = get_timestamp() - start;
+	{
+		std::lock_guard<Mutex_static> lock(m_power_mutex);
+		m_power_stats.max_resume_latency = std::max(m_power_stats.max_resume_latency, latency);
+	}
+
+	return true;
+}
+
+bool USB_core::is_safe_to_sleep()
+{
+	if(get_link_state() == LINK_STATE::L0)
+	{
+		return false;
+	}
+
+	if(m_num_queued_events != 0)
+	{
+		return false;
+	}
+
+	if(m_control_state != USB_CONTROL_STATE::IDLE)
+	{
+		return false;
+	}
+
+	return m_driver->is_tx_idle();
+}
+
+void USB_core::set_link_state(const LINK_STATE state)
+{
+	std::lock_guard<Mutex_static> lock(m_power_mutex);
+
+	if(state == m_link_state)
+	{
+		return;
+	}
+
+	const uint32_t now = get_timestamp();
+
+	m_power_stats.residency[size_t(m_link_state)] += uint32_t(now - m_link_state_start);
+	m_power_stats.entries[size_t(state)]++;
+
+	m_link_state = state;
+	m_link_state_start = now;
+
+	if((state == LINK_STATE::L0) && m_wake_pending)
+	{
+		m_wake_pending = false;
+
+		const uint32_t latency = now - m_wake_start;
+		m_power_stats.last_wake_latency = latency;
+		m_power_stats.max_wake_latency = std::max(m_power_stats.max_wake_latency, latency);
+	}
+}
+
+uint32_t USB_core::get_timestamp() const
+{
+	if(m_timestamp_callback_func)
+	{
+		return m_timestamp_callback_func(m_timestamp_callback_ctx);
+	}
+
+	return xTaskGetTickCount();
+}
+
+bool USB_core::request_remote_wakeup()
+{
+	{
+		std::lock_guard<Mutex_static> lock(m_power_mutex);
+
+		if(m_link_state == LINK_STATE::L0)
+		{
+			return false;
+		}
+
+		if((m_link_state == LINK_STATE::L2) && !m_remote_wakeup_enabled)
+		{
+			return false;
+		}
+
+		m_wake_pending = true;
+		m_wake_start = get_timestamp();
+	}
+
+	//starts the resume signaling, the usb task ends it
+	const bool ret = m_driver->remote_wakeup();
+
+	{
+		std::lock_guard<Mutex_static> lock(m_power_mutex);
+
+		if(ret)
+		{
+			m_power_stats.remote_wakeups++;
+			m_wake_signaling = true;
+			m_wake_signal_start = xTaskGetTickCount();
+		}
+		else
+		{
+			m_wake_pending = false;
+		}
+	}
+
+	//the usb task may be blocked on an idle bus
+	if(ret)
+	{
+		handle_event(USB_common::USB_EVENTS::REMOTE_WAKEUP, 0x00);
+	}
+
+	return ret;
+}
+
+bool USB_core::is_remote_wakeup_enabled()
+{
+	std::lock_guard<Mutex_static> lock(m_power_mutex);
+	return m_remote_wakeup_enabled;
+}
+
+TickType_t USB_core::get_remote_wakeup_wait()
+{
+	std::lock_guard<Mutex_static> lock(m_power_mutex);
+
+	if(!m_wake_signaling)
+	{
+		return portMAX_DELAY;
+	}
+
+	const TickType_t elapsed = xTaskGetTickCount() - m_wake_signal_start;
+	const TickType_t timeout = pdMS_TO_TICKS(REMOTE_WAKEUP_SIGNAL_MS);
+	if(elapsed >= timeout)
+	{
+		return 0;
+	}
+
+	return timeout - elapsed;
+}
+
+void USB_core::check_remote_wakeup_end()
+{
+	{
+		std::lock_guard<Mutex_static> lock(m_power_mutex);
+
+		if(!m_wake_signaling)
+		{
+			return;
+		}
+
+		const TickType_t elapsed = xTaskGetTickCount() - m_wake_signal_start;
+		if(elapsed < pdMS_TO_TICKS(REMOTE_WAKEUP_SIGNAL_MS))
+		{
+			return;
+		}
+
+		m_wake_signaling = false;
+	}
+
+	m_driver->remote_wakeup_end();
+}
+
+USB_core::LINK_STATE USB_core::get_link_state()
+{
+	std::lock_guard<Mutex_static> lock(m_power_mutex);
+
+	return m_link_state;
+}
+
+USB_core::Power_stats USB_core::get_power_stats()
+{
+	std::lock_guard<Mutex_static> lock(m_power_mutex);
+
+	Power_stats stats = m_power_stats;
+	stats.residency[size_t(m_link_state)] += uint32_t(get_timestamp() - m_link_state_start);
+
+	return stats;
+}
+
+void USB_core::reset_power_stats()
+{
+	std::lock_guard<Mutex_static> lock(m_power_mutex);
+
+	m_power_stats.residency.fill(0);
+	m_power_stats.entries.fill(0);
+	m_power_stats.remote_wakeups = 0;
+	m_power_stats.last_wake_latency = 0;
+	m_power_stats.max_wake_latency = 0;
+	m_power_stats.max_suspend_latency = 0;
+	m_power_stats.max_resume_latency = 0;
+
+	m_link_state_start = get_timestamp();
+}
+
 bool USB_core::wait_event_loop()
 {
 	bool ret = poll_event_loop(true);
@@ -170,10 +642,26 @@ bool USB_core::poll_event_loop(const bool wait)
 {
 	usb_core_event core_evt;
 
-	if(!m_event_queue.pop_front_wait(&core_evt, wait))
+	//a pending request times out and remote wakeup signaling ends on an idle bus too, so do not block past either deadline
+	const TickType_t deadline_wait = std::min(get_deferred_wait(), get_remote_wakeup_wait());
+
+	bool got_event = false;
+	if(wait && (deadline_wait != portMAX_DELAY))
+	{
+		got_event = m_event_queue.pop_front(&core_evt, deadline_wait);
+	}
+	else
+	{
+		got_event = m_event_queue.pop_front_wait(&core_evt, wait);
+	}
+
+	if(!got_event)
 	{
+		check_remote_wakeup_end();
+		check_deferred_timeout();
 		return false;
 	}
+	m_num_queued_events--;
 
 	const uint8_t ep_addr = USB_common::get_ep_addr(core_evt.ep);
 
@@ -185,6 +673,7 @@ bool USB_core::poll_event_loop(const bool wait)
 		{
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "USB_EVENTS::RESET");
 
+			handle_resume();
 			ret = handle_reset();
 			break;
 		}
@@ -199,22 +688,14 @@ bool USB_core::poll_event_loop(const bool wait)
 		{
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::TRACE, "USB_core", "USB_EVENTS::EP_RX");
 
-			func = m_driver->get_ep_rx_callback(ep_addr);
-			if(func)
-			{
-				func(core_evt.event, core_evt.ep);
-			}
+			handle_ep_event(core_evt.event, core_evt.ep);
 			break;
 		}
 		case USB_common::USB_EVENTS::EP_TX:
 		{
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::TRACE, "USB_core", "USB_EVENTS::EP_TX");
 
-			func = m_driver->get_ep_tx_callback(ep_addr);
-			if(func)
-			{
-				func(core_evt.event, core_evt.ep);
-			}
+			handle_ep_event(core_evt.event, core_evt.ep);
 			break;
 		}
 		case USB_common::USB_EVENTS::CTRL_SETUP_PHASE_DONE:
@@ -246,6 +727,21 @@ bool USB_core::poll_event_loop(const bool wait)
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "USB_EVENTS::SUSPEND");
 
 			//we are suspended
+			ret = handle_suspend(LINK_STATE::L2);
+			break;
+		}
+		case USB_common::USB_EVENTS::L1_SLEEP:
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "USB_EVENTS::L1_SLEEP");
+
+			ret = handle_suspend(LINK_STATE::L1);
+			break;
+		}
+		case USB_common::USB_EVENTS::WAKEUP:
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "USB_EVENTS::WAKEUP");
+
+			ret = handle_resume();
 			break;
 		}
 		case USB_common::USB_EVENTS::SOF:
@@ -255,6 +751,22 @@ bool USB_core::poll_event_loop(const bool wait)
 			ret = handle_sof();
 			break;
 		}
+		case USB_common::USB_EVENTS::CTRL_DEFERRED_DONE:
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "USB_EVENTS::CTRL_DEFERRED_DONE");
+
+			handle_deferred_done();
+			ret = true;
+			break;
+		}
+		case USB_common::USB_EVENTS::REMOTE_WAKEUP:
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "USB_EVENTS::REMOTE_WAKEUP");
+
+			//only here to recompute the wait, check_remote_wakeup_end does the work
+			ret = true;
+			break;
+		}
 		case USB_common::USB_EVENTS::NONE:
 		{
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::WARN, "USB_core", "USB_EVENTS::NONE");
@@ -269,13 +781,20 @@ bool USB_core::poll_event_loop(const bool wait)
 		}
 	}
 
-	func = m_driver->get_event_callback(ep_addr);//todo use the get addr helper func
-	if(func)
+	//events the core posts to itself are not the driver's
+	if((core_evt.event != USB_common::USB_EVENTS::CTRL_DEFERRED_DONE) && (core_evt.event != USB_common::USB_EVENTS::REMOTE_WAKEUP))
 	{
-		func(core_evt.event, core_evt.ep);
-		ret = true;
+		func = m_driver->get_event_callback(ep_addr);//todo use the get addr helper func
+		if(func)
+		{
+			func(core_evt.event, core_evt.ep);
+			ret = true;
+		}
 	}
 
+	check_remote_wakeup_end();
+	check_deferred_timeout();
+
 	return ret;
 }
 
@@ -287,6 +806,8 @@ bool USB_core::handle_event(const USB_common::USB_EVENTS evt, const uint8_t ep)
 
 	bool ret = false;
 
+	m_num_queued_events++;
+
 	//verify if this is really an interrupt
 	//in some cases eg the USB library will have a code path that is optionally polled or ISR
 	if(xPortIsInsideInterrupt() == pdFALSE)
@@ -300,6 +821,7 @@ bool USB_core::handle_event(const USB_common::USB_EVENTS evt, const uint8_t ep)
 
 	if(!ret)
 	{
+		m_num_queued_events--;
 		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core", "handle_event queue push failed, ep: %d, event: %d", ep, evt);
 	}
 
@@ -316,6 +838,15 @@ bool USB_core::handle_ep0_setup(const USB_common::USB_EVENTS event, const uint8_
 	//init
 	m_control_state = USB_CONTROL_STATE::IDLE;
 	m_setup_complete_callback = nullptr;
+	m_stream = nullptr;
+
+	//a new setup packet replaces any request still pending, the host gave up on it
+	{
+		std::lock_guard<Mutex_static> lock(m_deferred_mutex);
+		m_setup_id++;
+		m_deferred.waiting = false;
+		m_deferred.done = false;
+	}
 
 	//force read & process
 	handle_ep0_rx(event, ep);
@@ -366,6 +897,8 @@ bool USB_core::handle_ep0_rx(const USB_common::USB_EVENTS event, const uint8_t e
 				m_setup_packet.wLength
 				);
 
+			const Stream_entry* const stream = find_stream_request(m_setup_packet);
+
 			//check if we need to read data from the host
 			if((req_type.data_dir == Request_type::DATA_DIR::HOST_TO_DEV))
 			{
@@ -376,6 +909,17 @@ bool USB_core::handle_ep0_rx(const USB_common::USB_EVENTS event, const uint8_t e
 					break;
 				}
 
+				//streamed, no size limit
+				if(stream && stream->rx_func)
+				{
+					m_stream = stream;
+					m_stream_offset = 0;
+					m_stream_rem = m_setup_packet.wLength;
+
+					m_control_state = USB_CONTROL_STATE::RXDATA;
+					return true;
+				}
+
 				//setup read
 				if(m_setup_packet.wLength > m_rx_buffer.max_size())
 				{
@@ -396,9 +940,22 @@ bool USB_core::handle_ep0_rx(const USB_common::USB_EVENTS event, const uint8_t e
 				//processing will continue on the next read event
 				return true;
 			}
-			else
+			else if(stream && stream->tx_func && (m_setup_packet.wLength > 0))
 			{
-				///Nothing to do
+				//the tx buffer holds one packet at a time
+				if(m_tx_buffer.max_size() < m_driver->get_ep0_config().size)
+				{
+					stall_control_ep(ep);
+					return true;
+				}
+
+				m_stream = stream;
+				m_stream_offset = 0;
+				m_stream_rem = m_setup_packet.wLength;
+
+				m_control_state = USB_CONTROL_STATE::TXDATA;
+				handle_ep0_tx(event, ep | 0x80);
+				return true;
 			}
 
 			//DEV_TO_HOST, we can process and respond instead
@@ -408,6 +965,11 @@ bool USB_core::handle_ep0_rx(const USB_common::USB_EVENTS event, const uint8_t e
 		{
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "handle_ep0_rx USB_CONTROL_STATE::RXDATA");
 
+			if(m_stream)
+			{
+				return handle_ep0_rx_stream(event, ep);
+			}
+
 			EP_buffer_mgr_base* ep0_buf_mgr = m_driver->get_ep0_buffer();
 
 			Buffer_adapter_base* ep0_buf = ep0_buf_mgr->poll_dequeue_buffer(0);
@@ -485,7 +1047,30 @@ bool USB_core::handle_ep0_rx(const USB_common::USB_EVENTS event, const uint8_t e
 		return false;
 	}
 
-	switch(process_request(&m_setup_packet))
+	const USB_common::USB_RESP resp = process_request(&m_setup_packet);
+	if(resp == USB_common::USB_RESP::PENDING)
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "handle_ep0_rx process_request - PENDING");
+
+		start_deferred_request();
+		return true;
+	}
+
+	send_control_response(resp, event, ep);
+	
+	return true;
+}
+
+void USB_core::send_control_response(const USB_common::USB_RESP resp, const USB_common::USB_EVENTS event, const uint8_t ep)
+{
+	Request_type req_type;
+	if(!m_setup_packet.get_request_type(&req_type))
+	{
+		stall_control_ep(ep);
+		return;
+	}
+
+	switch(resp)
 	{
 		case USB_common::USB_RESP::ACK:
 		{
@@ -542,9 +1127,219 @@ bool USB_core::handle_ep0_rx(const USB_common::USB_EVENTS event, const uint8_t e
 			break;
 		}
 	}
-	
+}
+
+bool USB_core::handle_ep0_rx_stream(const USB_common::USB_EVENTS event, const uint8_t ep)
+{
+	EP_buffer_mgr_base* ep0_buf_mgr = m_driver->get_ep0_buffer();
+
+	Buffer_adapter_base* ep0_buf = ep0_buf_mgr->poll_dequeue_buffer(0);
+	if(!ep0_buf)
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core", "handle_ep0_rx_stream ep0 did not have buffer");
+		return true;
+	}
+
+	const size_t len = ep0_buf->size();
+
+	bool ok = len <= m_stream_rem;
+	if(ok)
+	{
+		ok = m_stream->rx_func(m_stream->ctx, &m_setup_packet, m_stream_offset, ep0_buf->data(), len);
+	}
+
+	ep0_buf_mgr->release_buffer(0, ep0_buf);
+	ep0_buf = nullptr;
+
+	if(!ok)
+	{
+		stall_control_ep(ep);
+		return true;
+	}
+
+	m_stream_offset += len;
+	m_stream_rem    -= len;
+
+	if(m_stream_rem > 0)
+	{
+		//keep reading
+		return true;
+	}
+
+	m_stream = nullptr;
+
+	//all data consumed, zlp status
+	send_control_response(USB_common::USB_RESP::ACK, event, ep);
+
+	return true;
+}
+
+void USB_core::handle_ep0_tx_stream(const uint8_t ep)
+{
+	const size_t ep0size = m_driver->get_ep0_config().size;
+	const size_t max_len = std::min(m_stream_rem, ep0size);
+
+	const int len = m_stream->tx_func(m_stream->ctx, &m_setup_packet, m_stream_offset, m_tx_buffer.data(), max_len);
+	if((len < 0) || (size_t(len) > max_len))
+	{
+		stall_control_ep(ep);
+		return;
+	}
+
+	if(m_driver->ep_write(ep | 0x80, m_tx_buffer.data(), len) < 0)
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_ep0_tx_stream", "ep_write error");
+	}
+
+	m_stream_offset += len;
+	m_stream_rem    -= len;
+
+	//a short packet or all of wLength ends the data stage, no zlp needed either way
+	if((size_t(len) < ep0size) || (m_stream_rem == 0))
+	{
+		m_stream = nullptr;
+		m_control_state = USB_CONTROL_STATE::TXCOMP;
+	}
+}
+
+bool USB_core::complete_deferred_request(const uint32_t setup_id, const USB_common::USB_RESP resp, const uint8_t* const data, const size_t len)
+{
+	if(resp == USB_common::USB_RESP::PENDING)
+	{
+		return false;
+	}
+
+	bool post_event = false;
+	{
+		std::lock_guard<Mutex_static> lock(m_deferred_mutex);
+
+		if((setup_id != m_setup_id) || m_deferred.done)
+		{
+			return false;
+		}
+
+		//the event loop leaves the tx buffer alone until the request is done
+		if((resp == USB_common::USB_RESP::ACK) && data)
+		{
+			m_tx_buffer.reset();
+			m_tx_buffer.insert(data, len);
+		}
+
+		m_deferred.resp = resp;
+		m_deferred.done = true;
+
+		//if the handler has not returned yet start_deferred_request picks this up
+		post_event = m_deferred.waiting;
+	}
+
+	if(post_event)
+	{
+		return handle_event(USB_common::USB_EVENTS::CTRL_DEFERRED_DONE, 0x00);
+	}
+
 	return true;
 }
+
+void USB_core::start_deferred_request()
+{
+	bool done = false;
+	{
+		std::lock_guard<Mutex_static> lock(m_deferred_mutex);
+
+		m_deferred.waiting = true;
+		m_deferred.start = xTaskGetTickCount();
+
+		done = m_deferred.done;
+	}
+
+	//nothing is loaded in the ep0 fifo so the host is NAKed
+	m_control_state = USB_CONTROL_STATE::DEFERRED;
+
+	if(done)
+	{
+		handle_deferred_done();
+	}
+}
+
+void USB_core::handle_deferred_done()
+{
+	USB_common::USB_RESP resp = USB_common::USB_RESP::FAIL;
+	{
+		std::lock_guard<Mutex_static> lock(m_deferred_mutex);
+
+		//stale event for a request that timed out or was replaced
+		if(!m_deferred.waiting || !m_deferred.done)
+		{
+			return;
+		}
+
+		m_deferred.waiting = false;
+		resp = m_deferred.resp;
+	}
+
+	if(m_control_state != USB_CONTROL_STATE::DEFERRED)
+	{
+		return;
+	}
+
+	send_control_response(resp, USB_common::USB_EVENTS::CTRL_DEFERRED_DONE, 0x00);
+}
+
+TickType_t USB_core::get_deferred_wait()
+{
+	if(m_control_state != USB_CONTROL_STATE::DEFERRED)
+	{
+		return portMAX_DELAY;
+	}
+
+	std::lock_guard<Mutex_static> lock(m_deferred_mutex);
+
+	if(!m_deferred.waiting || m_deferred.done)
+	{
+		return portMAX_DELAY;
+	}
+
+	const TickType_t elapsed = xTaskGetTickCount() - m_deferred.start;
+	const TickType_t timeout = pdMS_TO_TICKS(m_deferred_timeout.count());
+	if(elapsed >= timeout)
+	{
+		return 0;
+	}
+
+	return timeout - elapsed;
+}
+
+void USB_core::check_deferred_timeout()
+{
+	if(m_control_state != USB_CONTROL_STATE::DEFERRED)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<Mutex_static> lock(m_deferred_mutex);
+
+		if(!m_deferred.waiting || m_deferred.done)
+		{
+			return;
+		}
+
+		const TickType_t elapsed = xTaskGetTickCount() - m_deferred.start;
+		if(elapsed < pdMS_TO_TICKS(m_deferred_timeout.count()))
+		{
+			return;
+		}
+
+		//a late complete_deferred_request is refused
+		m_setup_id++;
+		m_deferred.waiting = false;
+	}
+
+	Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::WARN, "USB_core", "deferred request 0x%02X timed out", m_setup_packet.bRequest);
+
+	stall_control_ep(0x00);
+}
+
 bool USB_core::handle_ep0_tx(const USB_common::USB_EVENTS event, const uint8_t ep)
 {
 	switch(m_control_state)
@@ -553,6 +1348,12 @@ bool USB_core::handle_ep0_tx(const USB_common::USB_EVENTS event, const uint8_t e
 		{
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core", "USB_CONTROL_STATE::TXDATA");
 
+			if(m_stream)
+			{
+				handle_ep0_tx_stream(ep);
+				break;
+			}
+
 			const size_t ep0size = m_driver->get_ep0_config().size;
 			const size_t num_to_write = std::min(m_tx_buffer.rem_len, ep0size);
 
@@ -629,6 +1430,12 @@ USB_common::USB_RESP USB_core::process_request(Setup_packet* const req)
 {
 	USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
 
+	//standard requests and any app registered handler, indexed straight from the setup packet
+	if(m_request_table.dispatch(req, &m_rx_buffer, &m_tx_buffer, &r))
+	{
+		return r;
+	}
+
 	Request_type request_type;
 	if(!req->get_request_type(&request_type))
 	{
@@ -643,19 +1450,16 @@ USB_common::USB_RESP USB_core::process_request(Setup_packet* const req)
 			{
 				case Request_type::RECIPIENT::DEVICE:
 				{
-					Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::process_request", "STANDARD DEVICE request");
 					r = handle_std_device_request(req);
 					break;
 				}
 				case Request_type::RECIPIENT::INTERFACE:
 				{
-					Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::process_request", "STANDARD INTERFACE request");
 					r = handle_std_iface_request(req);
 					break;
 				}
 				case Request_type::RECIPIENT::ENDPOINT:
 				{
-					Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::process_request", "STANDARD ENDPOINT request");
 					r = handle_std_ep_request(req);
 					break;
 				}
@@ -671,9 +1475,10 @@ USB_common::USB_RESP USB_core::process_request(Setup_packet* const req)
 		case Request_type::TYPE::CLASS:
 		{
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::process_request", "CLASS request, m_rx_buffer has %u", m_rx_buffer.size());
-			if(m_usb_class)
+			USB_class* const usb_class = get_class_for_request(req);
+			if(usb_class)
 			{
-				r = m_usb_class->handle_class_request(req, &m_rx_buffer, &m_tx_buffer);
+				r = usb_class->handle_class_request(req, &m_rx_buffer, &m_tx_buffer);
 				Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::process_request", "CLASS request, m_tx_buffer has %u", m_tx_buffer.size());
 				Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::process_request", "CLASS request, m_tx_buffer rem_len %u", m_tx_buffer.rem_len);
 			}
@@ -686,7 +1491,35 @@ USB_common::USB_RESP USB_core::process_request(Setup_packet* const req)
 		case Request_type::TYPE::VENDOR:
 		{
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::process_request", "VENDOR request");
-			r = USB_common::USB_RESP::FAIL;
+
+			if(handle_ms_os_20_request(req, &r))
+			{
+				break;
+			}
+
+			USB_class* const usb_class = get_class_for_request(req);
+			if(usb_class)
+			{
+				r = usb_class->handle_vendor_request(req, &m_rx_buffer, &m_tx_buffer);
+			}
+			
+			//device recipient vendor requests carry no routing info, offer them to each function in turn
+			if((r == USB_common::USB_RESP::FAIL) && (request_type.recipient == Request_type::RECIPIENT::DEVICE))
+			{
+				for(const Function_entry& f : m_functions)
+				{
+					if(f.usb_class == usb_class)
+					{
+						continue;
+					}
+
+					r = f.usb_class->handle_vendor_request(req, &m_rx_buffer, &m_tx_buffer);
+					if(r != USB_common::USB_RESP::FAIL)
+					{
+						break;
+					}
+				}
+			}
 			break;
 		}
 		case Request_type::TYPE::RESERVED:
@@ -707,358 +1540,657 @@ USB_common::USB_RESP USB_core::process_request(Setup_packet* const req)
 	return r;
 }
 
+void USB_core::register_std_requests()
+{
+	register_std_request(Request_type::RECIPIENT::DEVICE, uint8_t(Setup_packet::DEVICE_REQUEST::GET_STATUS),        &USB_core::handle_get_status_device);
+	register_std_request(Request_type::RECIPIENT::DEVICE, uint8_t(Setup_packet::DEVICE_REQUEST::CLEAR_FEATURE),     &USB_core::handle_clear_feature_device);
+	register_std_request(Request_type::RECIPIENT::DEVICE, uint8_t(Setup_packet::DEVICE_REQUEST::SET_FEATURE),       &USB_core::handle_set_feature_device);
+	register_std_request(Request_type::RECIPIENT::DEVICE, uint8_t(Setup_packet::DEVICE_REQUEST::SET_ADDRESS),       &USB_core::handle_set_address);
+	register_std_request(Request_type::RECIPIENT::DEVICE, uint8_t(Setup_packet::DEVICE_REQUEST::GET_DESCRIPTOR),    &USB_core::handle_get_descriptor);
+	register_std_request(Request_type::RECIPIENT::DEVICE, uint8_t(Setup_packet::DEVICE_REQUEST::GET_CONFIGURATION), &USB_core::handle_get_configuration);
+	register_std_request(Request_type::RECIPIENT::DEVICE, uint8_t(Setup_packet::DEVICE_REQUEST::SET_CONFIGURATION), &USB_core::handle_set_configuration);
+
+	register_std_request(Request_type::RECIPIENT::INTERFACE, uint8_t(Setup_packet::INTERFACE_REQUEST::GET_STATUS),    &USB_core::handle_get_status_iface);
+	register_std_request(Request_type::RECIPIENT::INTERFACE, uint8_t(Setup_packet::INTERFACE_REQUEST::GET_INTERFACE), &USB_core::handle_get_interface);
+	register_std_request(Request_type::RECIPIENT::INTERFACE, uint8_t(Setup_packet::INTERFACE_REQUEST::SET_INTERFACE), &USB_core::handle_set_interface);
+
+	register_std_request(Request_type::RECIPIENT::ENDPOINT, uint8_t(Setup_packet::ENDPOINT_REQUEST::GET_STATUS),    &USB_core::handle_get_status_ep);
+	register_std_request(Request_type::RECIPIENT::ENDPOINT, uint8_t(Setup_packet::ENDPOINT_REQUEST::CLEAR_FEATURE), &USB_core::handle_clear_feature_ep);
+	register_std_request(Request_type::RECIPIENT::ENDPOINT, uint8_t(Setup_packet::ENDPOINT_REQUEST::SET_FEATURE),   &USB_core::handle_set_feature_ep);
+	register_std_request(Request_type::RECIPIENT::ENDPOINT, uint8_t(Setup_packet::ENDPOINT_REQUEST::SYNC_FRAME),    &USB_core::handle_sync_frame);
+}
+
+void USB_core::register_std_request(const Request_type::RECIPIENT recipient, const uint8_t bRequest, const Std_request_handler handler)
+{
+	m_request_table.register_request(Request_type::TYPE::STANDARD, recipient, bRequest,
+		[this, handler](void* ctx, Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+		{
+			return (this->*handler)(req);
+		},
+		nullptr
+	);
+}
+
 USB_common::USB_RESP USB_core::handle_std_device_request(Setup_packet* const req)
+{
+	//SET_DESCRIPTOR and anything unknown
+	Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_std_device_request", "Unknown request %d", req->bRequest);
+	return USB_common::USB_RESP::FAIL;
+}
+USB_common::USB_RESP USB_core::handle_std_iface_request(Setup_packet* const req)
 {
 	USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
 
-	switch(static_cast<Setup_packet::DEVICE_REQUEST>(req->bRequest))
+	//class specific descriptors and features
+	USB_class* const usb_class = get_class_for_iface(Byte_util::get_b0(req->wIndex));
+	if(usb_class)
 	{
-		case Setup_packet::DEVICE_REQUEST::GET_STATUS:
-		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "GET_STATUS");
-			m_tx_buffer.reset();
-			m_tx_buffer.insert(0);
-			m_tx_buffer.insert(0);
+		r = usb_class->handle_std_iface_request(req, &m_rx_buffer, &m_tx_buffer);
+	}
 
-			// if(selfpowered)
-			// {
-			// 	m_tx_buffer.buf_ptr[0] |= (1U << 0);
-			// }
+	if(r == USB_common::USB_RESP::FAIL)
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_std_iface_request", "Unknown request %d", req->bRequest);
+	}
 
-			// if(remote_wakeup)
-			// {
-			// 	m_tx_buffer.buf_ptr[0] |= (1U << 1);
-			// }
+	return r;
+}
+USB_common::USB_RESP USB_core::handle_std_ep_request(Setup_packet* const req)
+{
+	Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_std_ep_request", "Unknown request %d", req->bRequest);
+	return USB_common::USB_RESP::FAIL;
+}
 
-			r = USB_common::USB_RESP::ACK;
-			break;
+USB_common::USB_RESP USB_core::handle_get_status_device(Setup_packet* const req)
+{
+	uint8_t status = 0;
+
+	// if(selfpowered)
+	// {
+	// 	status |= (1U << 0);
+	// }
+
+	if(is_remote_wakeup_enabled())
+	{
+		status |= (1U << 1);
+	}
+
+	m_tx_buffer.reset();
+	m_tx_buffer.insert(status);
+	m_tx_buffer.insert(0);
+
+	return USB_common::USB_RESP::ACK;
+}
+USB_common::USB_RESP USB_core::handle_clear_feature_device(Setup_packet* const req)
+{
+	//TEST_MODE can not be cleared, only a power cycle leaves it
+	switch(static_cast<Setup_packet::FEATURE_SELECTOR>(req->wValue))
+	{
+		case Setup_packet::FEATURE_SELECTOR::DEVICE_REMOTE_WAKEUP:
+		{
+			std::lock_guard<Mutex_static> lock(m_power_mutex);
+			m_remote_wakeup_enabled = false;
+			return USB_common::USB_RESP::ACK;
 		}
-		case Setup_packet::DEVICE_REQUEST::CLEAR_FEATURE:
+		default:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "CLEAR_FEATURE");
 			break;
 		}
-		case Setup_packet::DEVICE_REQUEST::SET_FEATURE:
+	}
+
+	return USB_common::USB_RESP::FAIL;
+}
+USB_common::USB_RESP USB_core::handle_set_feature_device(Setup_packet* const req)
+{
+	switch(static_cast<Setup_packet::FEATURE_SELECTOR>(req->wValue))
+	{
+		case Setup_packet::FEATURE_SELECTOR::DEVICE_REMOTE_WAKEUP:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "SET_FEATURE");
-			break;
+			std::lock_guard<Mutex_static> lock(m_power_mutex);
+			m_remote_wakeup_enabled = true;
+			return USB_common::USB_RESP::ACK;
 		}
-		case Setup_packet::DEVICE_REQUEST::SET_ADDRESS:
+		case Setup_packet::FEATURE_SELECTOR::TEST_MODE:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "SET_ADDRESS");
-
-			if((req->wIndex != 0) || (req->wLength != 0))
+			//selector in the high byte of wIndex, low byte is 0
+			const uint8_t selector = Byte_util::get_b1(req->wIndex);
+			if((Byte_util::get_b0(req->wIndex) != 0) || (selector < uint8_t(Setup_packet::TEST_MODE_SELECTOR::TEST_J)) || (selector > uint8_t(Setup_packet::TEST_MODE_SELECTOR::TEST_FORCE_ENABLE)))
 			{
-				Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_std_device_request", "SET_ADDRESS packet invalid");
-				r = USB_common::USB_RESP::FAIL;
-				break;
+				return USB_common::USB_RESP::FAIL;
 			}
 
-			if(req->wValue > 127)
-			{
-				Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_std_device_request", "SET_ADDRESS address invalid");
-				r = USB_common::USB_RESP::FAIL;
-				break;
-			}
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::INFO, "USB_core::handle_set_feature_device", "TEST_MODE %d", selector);
 
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::TRACE, "USB_core::handle_std_device_request", "Queue SET_ADDRESS to %d", req->wValue);
-			
-			// m_address = req->wValue;
-			// m_setup_complete_callback = std::bind(&USB_core::set_address, this, req->wValue);
-			set_address(req->wValue);
-			r = USB_common::USB_RESP::ACK;
-			break;
+			//entered after the status stage
+			m_setup_complete_callback = [this, selector]()
+			{
+				m_driver->set_test_mode(selector);
+			};
+			return USB_common::USB_RESP::ACK;
 		}
-		// handled by child class
-		case Setup_packet::DEVICE_REQUEST::GET_DESCRIPTOR:
+		default:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "GET_DESCRIPTOR");
-
-			const USB_common::DESCRIPTOR_TYPE desc_type = static_cast<USB_common::DESCRIPTOR_TYPE>(Byte_util::get_b1(req->wValue));
-			const uint8_t desc_index = Byte_util::get_b0(req->wValue);
-
-			switch(desc_type)
-			{
-				case USB_common::DESCRIPTOR_TYPE::DEVICE:
-				{
-					Descriptor_table::Device_desc_const_ptr dev_desc = m_desc_table->get_device_descriptor(desc_index);
-					if(!dev_desc)
-					{
-						r = USB_common::USB_RESP::FAIL;
-						break;
-					}
-
-					Device_descriptor::Device_descriptor_array desc_arr;
-					if(!dev_desc->serialize(&desc_arr))
-					{
-						r = USB_common::USB_RESP::FAIL;
-						break;
-					}
-
-					m_tx_buffer.reset();
-
-					//truncate if needed
-					m_tx_buffer.insert(desc_arr.data(), std::min<size_t>(req->wLength, desc_arr.size()));
-
-					r = USB_common::USB_RESP::ACK;
-					break;
-				}
-				case USB_common::DESCRIPTOR_TYPE::CONFIGURATION:
-				{
-					Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "GET_DESCRIPTOR - CONFIGURATION");
-
-					Config_desc_table::Config_desc_const_ptr config_desc = m_desc_table->get_config_descriptor(desc_index);
-					if(!config_desc)
-					{
-						r = USB_common::USB_RESP::FAIL;
-						break;
-					}
+			break;
+		}
+	}
 
-					m_tx_buffer.reset();
+	return USB_common::USB_RESP::FAIL;
+}
+USB_common::USB_RESP USB_core::handle_set_address(Setup_packet* const req)
+{
+	if((req->wIndex != 0) || (req->wLength != 0))
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_set_address", "SET_ADDRESS packet invalid");
+		return USB_common::USB_RESP::FAIL;
+	}
 
-					if(!config_desc->serialize(&m_tx_buffer))
-					{
-						r = USB_common::USB_RESP::FAIL;
-						break;
-					}
+	if(req->wValue > 127)
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_set_address", "SET_ADDRESS address invalid");
+		return USB_common::USB_RESP::FAIL;
+	}
 
-					for(size_t i = 0; i < config_desc->size(); i++)
-					{
-						Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "CONFIGURATION - 0x%02X", m_tx_buffer.data()[i]);
-					}
+	// m_address = req->wValue;
+	// m_setup_complete_callback = std::bind(&USB_core::set_address, this, req->wValue);
+	set_address(req->wValue);
 
-					//send iface and ep descriptors if asked for more
-					if(req->wLength > config_desc->bLength)
-					{					
-						Descriptor_base const * desc_node = config_desc->get_desc_list().front<Descriptor_base>();
+	return USB_common::USB_RESP::ACK;
+}
+USB_common::USB_RESP USB_core::handle_get_descriptor(Setup_packet* const req)
+{
+	USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
 
-						while(desc_node)
-						{
-							Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "CONFIGURATION - node");
+	if(handle_get_descriptor_flat(req, &r))
+	{
+		return r;
+	}
 
-							if(m_tx_buffer.size() == req->wLength)
-							{
-								break;
-							}
+	const USB_common::DESCRIPTOR_TYPE desc_type = static_cast<USB_common::DESCRIPTOR_TYPE>(Byte_util::get_b1(req->wValue));
+	const uint8_t desc_index = Byte_util::get_b0(req->wValue);
 
-							if(!desc_node->serialize(&m_tx_buffer))
-							{
-								r = USB_common::USB_RESP::FAIL;
-								break;
-							}
+	switch(desc_type)
+	{
+		case USB_common::DESCRIPTOR_TYPE::DEVICE:
+		{
+			Descriptor_table::Device_desc_const_ptr dev_desc = m_desc_table->get_device_descriptor(desc_index);
+			if(!dev_desc)
+			{
+				r = USB_common::USB_RESP::FAIL;
+				break;
+			}
 
-							desc_node = desc_node->next<Descriptor_base>();
-						}
-					}
+			Device_descriptor::Device_descriptor_array desc_arr;
+			if(!dev_desc->serialize(&desc_arr))
+			{
+				r = USB_common::USB_RESP::FAIL;
+				break;
+			}
 
-					r = USB_common::USB_RESP::ACK;
-					break;
-				}
-				case USB_common::DESCRIPTOR_TYPE::STRING:
-				{
-					Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "GET_DESCRIPTOR - STRING");
+			m_tx_buffer.reset();
 
-					String_descriptor_zero::LANGID lang_idx = static_cast<String_descriptor_zero::LANGID>(req->wIndex);
+			//truncate if needed
+			m_tx_buffer.insert(desc_arr.data(), std::min<size_t>(req->wLength, desc_arr.size()));
 
-					String_desc_table::String_desc_const_ptr string_desc = m_desc_table->get_string_descriptor(lang_idx, desc_index);
-					if(!string_desc)
-					{
-						r = USB_common::USB_RESP::FAIL;
-						break;
-					}
+			r = USB_common::USB_RESP::ACK;
+			break;
+		}
+		case USB_common::DESCRIPTOR_TYPE::CONFIGURATION:
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_get_descriptor", "GET_DESCRIPTOR - CONFIGURATION");
 
-					m_tx_buffer.reset();
-					if(!string_desc->serialize(&m_tx_buffer))
-					{
-						r = USB_common::USB_RESP::FAIL;
-						break;
-					}
+			r = serialize_configuration(desc_index, m_speed, USB_common::DESCRIPTOR_TYPE::CONFIGURATION, req->wLength);
+			break;
+		}
+		case USB_common::DESCRIPTOR_TYPE::DEVICE_QUALIFIER:
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_get_descriptor", "GET_DESCRIPTOR - DEVICE_QUALIFIER");
 
-					r = USB_common::USB_RESP::ACK;
-					break;
-				}
-				// case USB_common::DESCRIPTOR_TYPE::INTERFACE:
-				// case USB_common::DESCRIPTOR_TYPE::ENDPOINT:
-				default:
-				{
-					Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_std_device_request", "GET_DESCRIPTOR - invalid type");
+			//FS only devices stall this
+			std::shared_ptr<const Device_qualifier_descriptor> dev_qual_desc = m_desc_table->get_device_qualifier_descriptor();
+			if(!dev_qual_desc)
+			{
+				r = USB_common::USB_RESP::FAIL;
+				break;
+			}
 
-					r = USB_common::USB_RESP::NAK;
-					break;
-				}
+			m_tx_buffer.reset();
+			if(!dev_qual_desc->serialize(&m_tx_buffer))
+			{
+				r = USB_common::USB_RESP::FAIL;
+				break;
 			}
 
+			r = USB_common::USB_RESP::ACK;
 			break;
 		}
-		case Setup_packet::DEVICE_REQUEST::SET_DESCRIPTOR:
+		case USB_common::DESCRIPTOR_TYPE::OTHER_SPEED_CONFIGURATION:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "SET_DESCRIPTOR");
-			r = USB_common::USB_RESP::FAIL;
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_get_descriptor", "GET_DESCRIPTOR - OTHER_SPEED_CONFIGURATION");
+
+			if(!m_desc_table->get_device_qualifier_descriptor())
+			{
+				r = USB_common::USB_RESP::FAIL;
+				break;
+			}
+
+			const USB_common::USB_SPEED other_speed = (m_speed == USB_common::USB_SPEED::HS) ? USB_common::USB_SPEED::FS : USB_common::USB_SPEED::HS;
+
+			r = serialize_configuration(desc_index, other_speed, USB_common::DESCRIPTOR_TYPE::OTHER_SPEED_CONFIGURATION, req->wLength);
 			break;
 		}
-		case Setup_packet::DEVICE_REQUEST::GET_CONFIGURATION:
+		case USB_common::DESCRIPTOR_TYPE::STRING:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "GET_CONFIGURATION");
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_get_descriptor", "GET_DESCRIPTOR - STRING");
+
+			String_descriptor_zero::LANGID lang_idx = static_cast<String_descriptor_zero::LANGID>(req->wIndex);
 
-			if(
-				(req->wValue  != 0) ||
-				(req->wIndex  != 0) ||
-				(req->wLength != 1)
-				)
+			String_desc_table::String_desc_const_ptr string_desc = m_desc_table->get_string_descriptor(lang_idx, desc_index);
+			if(!string_desc)
 			{
 				r = USB_common::USB_RESP::FAIL;
 				break;
 			}
 
-			uint8_t temp = 0;
-			if(!get_configuration(&temp))
+			m_tx_buffer.reset();
+			if(!string_desc->serialize(&m_tx_buffer))
 			{
 				r = USB_common::USB_RESP::FAIL;
 				break;
 			}
 
-			m_tx_buffer.insert(&temp, 1);
 			r = USB_common::USB_RESP::ACK;
 			break;
 		}
-		case Setup_packet::DEVICE_REQUEST::SET_CONFIGURATION:
+		case USB_common::DESCRIPTOR_TYPE::BOS:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "SET_CONFIGURATION");
-			if(
-				(Byte_util::get_b1(req->wValue) != 0) ||
-				(req->wIndex  != 0)                   ||
-				(req->wLength != 0)
-				)
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_get_descriptor", "GET_DESCRIPTOR - BOS");
+
+			std::shared_ptr<const BOS_descriptor> bos_desc = m_desc_table->get_bos_descriptor();
+			if(!bos_desc)
 			{
 				r = USB_common::USB_RESP::FAIL;
 				break;
 			}
 
-			const uint8_t bConfigurationValue = Byte_util::get_b0(req->wValue);
-			if(!set_configuration(bConfigurationValue))
+			m_tx_buffer.reset();
+
+			if(!bos_desc->serialize(&m_tx_buffer))
 			{
-				r = USB_common::USB_RESP::FAIL;		
+				r = USB_common::USB_RESP::FAIL;
+				break;
 			}
-			else
+
+			r = USB_common::USB_RESP::ACK;
+
+			//device capabilities follow if asked for more
+			Descriptor_base const * desc_node = bos_desc->get_desc_list().front<Descriptor_base>();
+			while(desc_node && (m_tx_buffer.size() < req->wLength))
 			{
-				r = USB_common::USB_RESP::ACK;
+				if(!desc_node->serialize(&m_tx_buffer))
+				{
+					r = USB_common::USB_RESP::FAIL;
+					break;
+				}
+
+				desc_node = desc_node->next<Descriptor_base>();
 			}
-			
 			break;
 		}
+		// case USB_common::DESCRIPTOR_TYPE::INTERFACE:
+		// case USB_common::DESCRIPTOR_TYPE::ENDPOINT:
 		default:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_std_device_request", "Unknown request");
-			r = USB_common::USB_RESP::FAIL;
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_get_descriptor", "GET_DESCRIPTOR - invalid type");
+
+			r = USB_common::USB_RESP::NAK;
 			break;
 		}
 	}
+
 	return r;
 }
-USB_common::USB_RESP USB_core::handle_std_iface_request(Setup_packet* const req)
+USB_common::USB_RESP USB_core::handle_get_configuration(Setup_packet* const req)
 {
-	USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
+	if(
+		(req->wValue  != 0) ||
+		(req->wIndex  != 0) ||
+		(req->wLength != 1)
+		)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
 
-	switch(static_cast<Setup_packet::INTERFACE_REQUEST>(req->bRequest))
+	uint8_t temp = 0;
+	if(!get_configuration(&temp))
 	{
-		case Setup_packet::INTERFACE_REQUEST::GET_STATUS:
-		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_device_request", "GET_STATUS");
+		return USB_common::USB_RESP::FAIL;
+	}
 
-			m_tx_buffer.reset();
+	m_tx_buffer.reset();
+	m_tx_buffer.insert(&temp, 1);
+
+	return USB_common::USB_RESP::ACK;
+}
+USB_common::USB_RESP USB_core::handle_set_configuration(Setup_packet* const req)
+{
+	if(
+		(Byte_util::get_b1(req->wValue) != 0) ||
+		(req->wIndex  != 0)                   ||
+		(req->wLength != 0)
+		)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
 
-			std::array<uint8_t, 2> status;
-			status.fill(0);
+	const uint8_t bConfigurationValue = Byte_util::get_b0(req->wValue);
+	if(!set_configuration(bConfigurationValue))
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
 
-			m_tx_buffer.insert(status.data(), status.size());
+	return USB_common::USB_RESP::ACK;
+}
 
-			r = USB_common::USB_RESP::ACK;
-			break;
+USB_common::USB_RESP USB_core::handle_get_status_iface(Setup_packet* const req)
+{
+	m_tx_buffer.reset();
+	m_tx_buffer.insert(0);
+	m_tx_buffer.insert(0);
+
+	return USB_common::USB_RESP::ACK;
+}
+USB_common::USB_RESP USB_core::handle_get_interface(Setup_packet* const req)
+{
+	const uint8_t iface = Byte_util::get_b0(req->wIndex);
+	if((m_configuration == 0) || (iface >= m_iface_alt.size()) || (req->wValue != 0) || (req->wLength != 1))
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	m_tx_buffer.reset();
+	m_tx_buffer.insert(m_iface_alt[iface]);
+
+	return USB_common::USB_RESP::ACK;
+}
+USB_common::USB_RESP USB_core::handle_set_interface(Setup_packet* const req)
+{
+	const uint8_t iface = Byte_util::get_b0(req->wIndex);
+	const uint8_t alt = Byte_util::get_b0(req->wValue);
+	if((m_configuration == 0) || (iface >= m_iface_alt.size()) || (req->wLength != 0))
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	const uint8_t prev_alt = m_iface_alt[iface];
+
+	//an interface with no alt settings in the descriptors only has alt 0
+	const bool has_alt = has_alt_settings(iface);
+	if(has_alt)
+	{
+		if(!find_alt_setting(iface, alt))
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_set_interface", "iface %d has no alt %d", iface, alt);
+			return USB_common::USB_RESP::FAIL;
 		}
-		default:
+
+		if(!switch_alt_setting(iface, prev_alt, alt))
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_std_iface_request", "Unknown request");
+			switch_alt_setting(iface, alt, prev_alt);
+			return USB_common::USB_RESP::FAIL;
+		}
+	}
+	else if(alt != 0)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
 
-			r = USB_common::USB_RESP::FAIL;
-			break;
+	USB_class* const usb_class = get_class_for_iface(iface);
+	if(usb_class && !usb_class->set_interface(iface, alt))
+	{
+		if(has_alt)
+		{
+			switch_alt_setting(iface, alt, prev_alt);
 		}
+		return USB_common::USB_RESP::FAIL;
 	}
-	return r;
+
+	m_iface_alt[iface] = alt;
+
+	return USB_common::USB_RESP::ACK;
 }
-USB_common::USB_RESP USB_core::handle_std_ep_request(Setup_packet* const req)
+
+USB_common::USB_RESP USB_core::handle_get_status_ep(Setup_packet* const req)
 {
-	USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
+	const uint8_t endpoint_idx = Byte_util::get_b0(req->wIndex);
 
-	const Setup_packet::FEATURE_SELECTOR feature = static_cast<Setup_packet::FEATURE_SELECTOR>(req->wValue);
-	if(feature != Setup_packet::FEATURE_SELECTOR::ENDPOINT_HALT)
+	m_tx_buffer.reset();
+	
+	if(m_driver->ep_is_stalled(endpoint_idx))
+	{			
+		m_tx_buffer.insert((1U << 0));
+	}
+	else
 	{
-		return r;
+		m_tx_buffer.insert(0);
 	}
 
-	const uint8_t endpoint_idx = Byte_util::get_b0(req->wIndex);
+	m_tx_buffer.insert(0);
+
+	return USB_common::USB_RESP::ACK;
+}
+USB_common::USB_RESP USB_core::handle_clear_feature_ep(Setup_packet* const req)
+{
+	if(static_cast<Setup_packet::FEATURE_SELECTOR>(req->wValue) != Setup_packet::FEATURE_SELECTOR::ENDPOINT_HALT)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	m_driver->ep_unstall(Byte_util::get_b0(req->wIndex));
+
+	return USB_common::USB_RESP::ACK;
+}
+USB_common::USB_RESP USB_core::handle_set_feature_ep(Setup_packet* const req)
+{
+	if(static_cast<Setup_packet::FEATURE_SELECTOR>(req->wValue) != Setup_packet::FEATURE_SELECTOR::ENDPOINT_HALT)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	m_driver->ep_stall(Byte_util::get_b0(req->wIndex));
+
+	return USB_common::USB_RESP::ACK;
+}
+USB_common::USB_RESP USB_core::handle_sync_frame(Setup_packet* const req)
+{
+	//only meaningful for iso eps, report the current frame number
+	if((m_configuration == 0) || (req->wValue != 0) || (req->wLength != 2) || (USB_common::get_ep_addr(Byte_util::get_b0(req->wIndex)) == 0))
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	const uint16_t frame = m_driver->get_frame_number();
+
+	m_tx_buffer.reset();
+	m_tx_buffer.insert(Byte_util::get_b0(frame));
+	m_tx_buffer.insert(Byte_util::get_b1(frame));
+
+	return USB_common::USB_RESP::ACK;
+}
+
+bool USB_core::handle_get_descriptor_flat(Setup_packet* const req, USB_common::USB_RESP* const out_resp)
+{
+	const Flat_desc_table& flat_table = m_desc_table->get_flat_table();
+	if(!flat_table.is_finalized())
+	{
+		return false;
+	}
 
-	switch(static_cast<Setup_packet::ENDPOINT_REQUEST>(req->bRequest))
+	const USB_common::DESCRIPTOR_TYPE desc_type = static_cast<USB_common::DESCRIPTOR_TYPE>(Byte_util::get_b1(req->wValue));
+	const uint8_t desc_index = Byte_util::get_b0(req->wValue);
+
+	uint8_t type = static_cast<uint8_t>(desc_type);
+	uint16_t qual = 0;
+	switch(desc_type)
 	{
-		case Setup_packet::ENDPOINT_REQUEST::SET_FEATURE:
+		case USB_common::DESCRIPTOR_TYPE::CONFIGURATION:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_ep_request", "SET_FEATURE");
-			m_driver->ep_stall(endpoint_idx);
-			r = USB_common::USB_RESP::ACK;
+			qual = static_cast<uint16_t>(m_speed);
 			break;
 		}
-		case Setup_packet::ENDPOINT_REQUEST::CLEAR_FEATURE:
+		case USB_common::DESCRIPTOR_TYPE::OTHER_SPEED_CONFIGURATION:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_ep_request", "CLEAR_FEATURE");
-			if(req->wValue == 0x00)
+			//only a HS capable device has an other speed
+			const uint8_t* qual_ptr = nullptr;
+			size_t qual_len = 0;
+			if(!flat_table.find(static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::DEVICE_QUALIFIER), 0, 0, &qual_ptr, &qual_len))
 			{
-				m_driver->ep_unstall(endpoint_idx);
-				r = USB_common::USB_RESP::ACK;
-			}
-			else
-			{
-				r = USB_common::USB_RESP::NAK;
+				return false;
 			}
+
+			type = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CONFIGURATION);
+			qual = static_cast<uint16_t>((m_speed == USB_common::USB_SPEED::HS) ? USB_common::USB_SPEED::FS : USB_common::USB_SPEED::HS);
 			break;
 		}
-		case Setup_packet::ENDPOINT_REQUEST::GET_STATUS:
+		case USB_common::DESCRIPTOR_TYPE::STRING:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_ep_request", "GET_STATUS");
-			m_tx_buffer.reset();
-			
-			if(m_driver->ep_is_stalled(endpoint_idx))
-			{			
-				m_tx_buffer.insert((1U << 0));
-			}
-			else
-			{
-				m_tx_buffer.insert(0);
-			}
-
-			m_tx_buffer.insert(0);
-
-			r = USB_common::USB_RESP::ACK;
+			qual = req->wIndex;
 			break;
 		}
 		default:
 		{
-			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_std_ep_request", "Unknown request %d", req->bRequest);
-			r = USB_common::USB_RESP::FAIL;
 			break;
 		}
 	}
-	return r;
+
+	const uint8_t* desc_ptr = nullptr;
+	size_t desc_len = 0;
+	if(!flat_table.find(type, desc_index, qual, &desc_ptr, &desc_len))
+	{
+		//configurations without speed dependent fields are only stored for FS
+		if((type != static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CONFIGURATION)) || !flat_table.find(type, desc_index, static_cast<uint16_t>(USB_common::USB_SPEED::FS), &desc_ptr, &desc_len))
+		{
+			return false;
+		}
+	}
+
+	const size_t len = std::min<size_t>(req->wLength, desc_len);
+
+	m_tx_buffer.reset();
+	if(m_tx_buffer.capacity() < len)
+	{
+		*out_resp = USB_common::USB_RESP::FAIL;
+		return true;
+	}
+
+	m_tx_buffer.insert(desc_ptr, len);
+
+	if((desc_type == USB_common::DESCRIPTOR_TYPE::OTHER_SPEED_CONFIGURATION) && (len > 1))
+	{
+		m_tx_buffer.data()[1] = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::OTHER_SPEED_CONFIGURATION);
+	}
+
+	*out_resp = USB_common::USB_RESP::ACK;
+	return true;
+}
+
+USB_common::USB_RESP USB_core::serialize_configuration(const uint8_t desc_index, const USB_common::USB_SPEED speed, const USB_common::DESCRIPTOR_TYPE desc_type, const uint16_t wLength)
+{
+	Config_desc_table::Config_desc_const_ptr config_desc = m_desc_table->get_config_descriptor(desc_index);
+	if(!config_desc)
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	m_tx_buffer.reset();
+
+	if(!config_desc->serialize(&m_tx_buffer))
+	{
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	//other speed config is the same layout with a different type
+	m_tx_buffer.data()[1] = static_cast<uint8_t>(desc_type);
+
+	for(size_t i = 0; i < config_desc->size(); i++)
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::serialize_configuration", "CONFIGURATION - 0x%02X", m_tx_buffer.data()[i]);
+	}
+
+	//send iface and ep descriptors if asked for more
+	if(wLength > config_desc->bLength)
+	{
+		Descriptor_base const * desc_node = config_desc->get_desc_list().front<Descriptor_base>();
+
+		while(desc_node)
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::serialize_configuration", "CONFIGURATION - node");
+
+			if(m_tx_buffer.size() >= wLength)
+			{
+				break;
+			}
+
+			if(!desc_node->serialize_for_speed(&m_tx_buffer, speed))
+			{
+				return USB_common::USB_RESP::FAIL;
+			}
+
+			desc_node = desc_node->next<Descriptor_base>();
+		}
+	}
+
+	return USB_common::USB_RESP::ACK;
+}
+
+bool USB_core::handle_ms_os_20_request(Setup_packet* const req, USB_common::USB_RESP* const out_resp)
+{
+	if(!m_desc_table)
+	{
+		return false;
+	}
+
+	std::shared_ptr<const MS_OS_20_descriptor_set> desc_set = m_desc_table->get_ms_os_20_descriptor_set();
+	if(!desc_set)
+	{
+		return false;
+	}
+
+	if((req->bRequest != desc_set->get_vendor_code()) || (req->wIndex != MS_OS_20_descriptor_set::MS_OS_20_DESCRIPTOR_INDEX))
+	{
+		return false;
+	}
+
+	Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::DEBUG, "USB_core::handle_ms_os_20_request", "MS OS 2.0 descriptor set");
+
+	m_tx_buffer.reset();
+
+	const std::vector<uint8_t>& data = desc_set->get_data();
+	if(m_tx_buffer.capacity() < std::min<size_t>(req->wLength, data.size()))
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::handle_ms_os_20_request", "m_tx_buffer too small, need %u", data.size());
+		*out_resp = USB_common::USB_RESP::FAIL;
+		return true;
+	}
+
+	m_tx_buffer.insert(data.data(), std::min<size_t>(req->wLength, data.size()));
+
+	*out_resp = USB_common::USB_RESP::ACK;
+	return true;
 }
 
 bool USB_core::set_configuration(const uint8_t bConfigurationValue)
 {
 	bool ret = false;
 
+	//every interface starts at alt 0 after SET_CONFIGURATION
+	m_iface_alt.fill(0);
+
 	if(m_set_config_callback_func)
 	{
 		if(m_set_config_callback_func(m_set_config_callback_ctx, bConfigurationValue))
 		{
 			m_configuration = bConfigurationValue;
-			ret = true;
+			ret = notify_functions_configuration(m_configuration);
 
 			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::INFO, "USB_core::set_configuration", "Config set to %d ok", m_configuration);
 		}
@@ -1069,7 +2201,7 @@ bool USB_core::set_configuration(const uint8_t bConfigurationValue)
 			if(m_set_config_callback_func(m_set_config_callback_ctx, 0))
 			{
 				m_configuration = 0;
-				ret = true;
+				notify_functions_configuration(m_configuration);
 
 				Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::set_configuration", "Config set to %d ok", m_configuration);
 			}
@@ -1081,6 +2213,12 @@ bool USB_core::set_configuration(const uint8_t bConfigurationValue)
 			ret = false;
 		}
 	}
+	else if(!m_functions.empty())
+	{
+		//composite device with the functions configuring their own eps
+		m_configuration = bConfigurationValue;
+		ret = notify_functions_configuration(m_configuration);
+	}
 	else
 	{
 		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::FATAL, "USB_core::set_configuration", "No set configuration handler registered, can't configure");
@@ -1089,6 +2227,153 @@ bool USB_core::set_configuration(const uint8_t bConfigurationValue)
 
 	return ret;
 }
+bool USB_core::notify_functions_configuration(const uint8_t bConfigurationValue)
+{
+	bool ret = true;
+
+	load_alt_settings(bConfigurationValue);
+
+	for(const Function_entry& f : m_functions)
+	{
+		if(!f.usb_class->set_configuration(bConfigurationValue))
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::set_configuration", "Function on iface %d rejected config %d", f.first_iface, bConfigurationValue);
+			ret = false;
+		}
+	}
+
+	return ret;
+}
+bool USB_core::load_alt_settings(const uint8_t bConfigurationValue)
+{
+	m_alt_settings.clear();
+
+	if(!m_desc_table || (bConfigurationValue == 0))
+	{
+		return true;
+	}
+
+	std::vector<uint8_t> config;
+	if(!m_desc_table->get_configuration_bytes(bConfigurationValue, m_speed, &config))
+	{
+		Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::WARN, "USB_core::load_alt_settings", "no descriptor for config %d", bConfigurationValue);
+		return false;
+	}
+
+	//walk the descriptors, eps belong to the last interface seen
+	Alt_setting* current = nullptr;
+	size_t i = 0;
+	while((i + 2) <= config.size())
+	{
+		const uint8_t bLength = config[i + 0];
+		const uint8_t bDescriptorType = config[i + 1];
+		if((bLength < 2) || ((i + bLength) > config.size()))
+		{
+			break;
+		}
+
+		if((bDescriptorType == static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::INTERFACE)) && (bLength >= 4))
+		{
+			Alt_setting setting;
+			setting.iface = config[i + 2];
+			setting.alt   = config[i + 3];
+			m_alt_settings.push_back(setting);
+			current = &m_alt_settings.back();
+		}
+		else if((bDescriptorType == static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::ENDPOINT)) && (bLength >= 7) && current)
+		{
+			usb_driver_base::ep_cfg ep;
+			ep.num  = config[i + 2];
+			ep.size = Byte_util::make_u16(config[i + 5], config[i + 4]) & 0x07FFU;
+
+			switch(static_cast<Endpoint_descriptor::ATTRIBUTE_TRANSFER>(config[i + 3] & 0x03))
+			{
+				case Endpoint_descriptor::ATTRIBUTE_TRANSFER::ISOCHRONOUS:
+				{
+					ep.type = usb_driver_base::EP_TYPE::ISOCHRONUS;
+					break;
+				}
+				case Endpoint_descriptor::ATTRIBUTE_TRANSFER::BULK:
+				{
+					ep.type = usb_driver_base::EP_TYPE::BULK;
+					break;
+				}
+				case Endpoint_descriptor::ATTRIBUTE_TRANSFER::INTERRUPT:
+				{
+					ep.type = usb_driver_base::EP_TYPE::INTERRUPT;
+					break;
+				}
+				case Endpoint_descriptor::ATTRIBUTE_TRANSFER::CONTROL:
+				default:
+				{
+					ep.type = usb_driver_base::EP_TYPE::CONTROL;
+					break;
+				}
+			}
+
+			current->eps.push_back(ep);
+		}
+
+		i += bLength;
+	}
+
+	return true;
+}
+
+const USB_core::Alt_setting* USB_core::find_alt_setting(const uint8_t iface, const uint8_t alt) const
+{
+	for(const Alt_setting& setting : m_alt_settings)
+	{
+		if((setting.iface == iface) && (setting.alt == alt))
+		{
+			return &setting;
+		}
+	}
+
+	return nullptr;
+}
+
+bool USB_core::has_alt_settings(const uint8_t iface) const
+{
+	for(const Alt_setting& setting : m_alt_settings)
+	{
+		if((setting.iface == iface) && (setting.alt != 0))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool USB_core::switch_alt_setting(const uint8_t iface, const uint8_t from_alt, const uint8_t to_alt)
+{
+	//free the old eps first so their fifo space can be reused
+	const Alt_setting* const from = find_alt_setting(iface, from_alt);
+	if(from)
+	{
+		for(const usb_driver_base::ep_cfg& ep : from->eps)
+		{
+			m_driver->ep_unconfig(ep.num);
+		}
+	}
+
+	const Alt_setting* const to = find_alt_setting(iface, to_alt);
+	if(to)
+	{
+		for(const usb_driver_base::ep_cfg& ep : to->eps)
+		{
+			if(!m_driver->ep_config(ep))
+			{
+				Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "USB_core::switch_alt_setting", "iface %d alt %d ep 0x%02X config failed", iface, to_alt, ep.num);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 bool USB_core::get_configuration(uint8_t* const bConfigurationValue)
 {
 	*bConfigurationValue = m_configuration;
@@ -1100,10 +2385,52 @@ void USB_core::handle_ctrl_req_complete()
 	
 }
 
+bool USB_core::register_stream_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest, const Ctrl_stream_rx_callback& rx_callback, const Ctrl_stream_tx_callback& tx_callback, void* ctx)
+{
+	if(!rx_callback && !tx_callback)
+	{
+		return false;
+	}
+
+	Stream_entry entry;
+	entry.rx_func = rx_callback;
+	entry.tx_func = tx_callback;
+	entry.ctx = ctx;
+
+	m_stream_handlers[make_stream_key(static_cast<uint8_t>(type), static_cast<uint8_t>(recipient), bRequest)] = entry;
+
+	return true;
+}
+
+void USB_core::unregister_stream_request(const Request_type::TYPE type, const Request_type::RECIPIENT recipient, const uint8_t bRequest)
+{
+	m_stream_handlers.erase(make_stream_key(static_cast<uint8_t>(type), static_cast<uint8_t>(recipient), bRequest));
+}
+
+const USB_core::Stream_entry* USB_core::find_stream_request(const Setup_packet& req) const
+{
+	if(m_stream_handlers.empty())
+	{
+		return nullptr;
+	}
+
+	const uint8_t type = (req.bmRequestType >> 5) & 0x03;
+	const uint8_t recipient = req.bmRequestType & 0x1F;
+
+	auto it = m_stream_handlers.find(make_stream_key(type, recipient, req.bRequest));
+	if(it == m_stream_handlers.end())
+	{
+		return nullptr;
+	}
+
+	return &(it->second);
+}
+
 void USB_core::stall_control_ep(const uint8_t ep)
 {
 	m_driver->ep_stall(ep & 0x7F);
 	m_driver->ep_stall(ep | 0x80);
 
 	m_control_state = USB_CONTROL_STATE::IDLE;
+	m_stream = nullptr;
 }
\ No newline at end of file
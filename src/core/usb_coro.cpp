@@ -0,0 +1,435 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/core/usb_coro.hpp"
+
+#if defined(__cpp_impl_coroutine)
+
+#include "freertos_cpp_util/logging/Global_logger.hpp"
+
+#include <algorithm>
+
+using freertos_util::logging::Global_logger;
+using freertos_util::logging::LOG_LEVEL;
+
+namespace
+{
+	//the frame remembers its arena, so the default can change while coroutines run
+	struct alignas(std::max_align_t) Frame_header
+	{
+		Coro_arena_base* arena;
+	};
+}
+
+void* Usb_coro_task::promise_type::operator new(const size_t len) noexcept
+{
+	Coro_arena_base* const arena = Coro_arena_base::get_default();
+	if(arena == nullptr)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "Usb_coro_task", "no arena");
+		return nullptr;
+	}
+
+	void* const mem = arena->allocate(sizeof(Frame_header) + len);
+	if(mem == nullptr)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "Usb_coro_task", "arena full or frame too big, %u bytes", unsigned(sizeof(Frame_header) + len));
+		return nullptr;
+	}
+
+	Frame_header* const header = static_cast<Frame_header*>(mem);
+	header->arena = arena;
+
+	return header + 1;
+}
+
+void Usb_coro_task::promise_type::operator delete(void* const ptr) noexcept
+{
+	if(ptr == nullptr)
+	{
+		return;
+	}
+
+	Frame_header* const header = static_cast<Frame_header*>(ptr) - 1;
+	header->arena->deallocate(header);
+}
+
+bool Usb_coro_ep::Read_awaitable::await_ready()
+{
+	if(m_ep_addr >= Usb_coro_executor::MAX_EP)
+	{
+		return true;
+	}
+
+	m_buf = m_exec->m_driver->get_rx_buffer()->poll_dequeue_buffer(m_ep_addr);
+
+	return m_buf != nullptr;
+}
+
+bool Usb_coro_ep::Read_awaitable::await_suspend(std::coroutine_handle<> handle)
+{
+	Usb_coro_executor::Rx_waiter& waiter = m_exec->m_rx_waiters[m_ep_addr];
+	if(waiter.handle)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "Usb_coro_ep", "ep 0x%02X already has a reader", m_ep_addr);
+		return false;
+	}
+
+	waiter.handle  = handle;
+	waiter.out_buf = &m_buf;
+
+	return true;
+}
+
+bool Usb_coro_ep::Alloc_awaitable::await_ready()
+{
+	if(m_ep_addr >= Usb_coro_executor::MAX_EP)
+	{
+		return true;
+	}
+
+	m_buf = m_exec->m_driver->get_tx_buffer()->poll_allocate_buffer(m_ep_addr);
+	if(m_buf)
+	{
+		m_buf->reset();
+	}
+
+	return m_buf != nullptr;
+}
+
+bool Usb_coro_ep::Alloc_awaitable::await_suspend(std::coroutine_handle<> handle)
+{
+	Usb_coro_executor::Tx_waiter& waiter = m_exec->m_tx_waiters[m_ep_addr];
+	if(waiter.handle)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "Usb_coro_ep", "ep 0x%02X already has a writer", m_ep_addr);
+		return false;
+	}
+
+	waiter.handle  = handle;
+	waiter.out_buf = &m_buf;
+	waiter.token   = nullptr;
+
+	return true;
+}
+
+bool Usb_coro_ep::Write_awaitable::await_ready()
+{
+	if(m_ep_addr >= Usb_coro_executor::MAX_EP)
+	{
+		return true;
+	}
+
+	//check before queueing, once queued the token must not leave this frame until it completes
+	if(m_exec->m_tx_waiters[m_ep_addr].handle)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "Usb_coro_ep", "ep 0x%02X already has a writer", m_ep_addr);
+		return true;
+	}
+
+	m_queued = m_exec->m_driver->enqueue_tx_buffer(0x80 | m_ep_addr, m_buf, &m_token);
+	if(!m_queued)
+	{
+		return true;
+	}
+
+	return m_token.is_complete();
+}
+
+bool Usb_coro_ep::Write_awaitable::await_suspend(std::coroutine_handle<> handle)
+{
+	Usb_coro_executor::Tx_waiter& waiter = m_exec->m_tx_waiters[m_ep_addr];
+
+	waiter.handle  = handle;
+	waiter.out_buf = nullptr;
+	waiter.token   = &m_token;
+
+	return true;
+}
+
+void Usb_coro_ep::release(Buffer_adapter_base* const buf)
+{
+	m_exec->m_driver->release_rx_buffer(m_ep, buf);
+}
+
+Usb_coro_executor::Usb_coro_executor()
+{
+	m_driver = nullptr;
+
+	for(Rx_waiter& w : m_rx_waiters)
+	{
+		w.handle  = nullptr;
+		w.out_buf = nullptr;
+	}
+	for(Tx_waiter& w : m_tx_waiters)
+	{
+		w.handle  = nullptr;
+		w.out_buf = nullptr;
+		w.token   = nullptr;
+	}
+}
+
+bool Usb_coro_executor::initialize(usb_driver_base* const driver)
+{
+	m_driver = driver;
+
+	return true;
+}
+
+bool Usb_coro_executor::bind_ep(const uint8_t ep)
+{
+	const uint8_t ep_addr = USB_common::get_ep_addr(ep);
+	if((ep_addr == 0) || (ep_addr >= MAX_EP))
+	{
+		return false;
+	}
+
+	USB_common::Event_callback func = std::bind(&Usb_coro_executor::handle_ep_event, this, std::placeholders::_1, std::placeholders::_2);
+
+	if(USB_common::is_in_ep(ep))
+	{
+		return m_driver->set_ep_tx_callback(ep_addr, func);
+	}
+
+	return m_driver->set_ep_rx_callback(ep_addr, func);
+}
+
+void Usb_coro_executor::handle_ep_event(const USB_common::USB_EVENTS event, const uint8_t ep)
+{
+	const uint8_t ep_addr = USB_common::get_ep_addr(ep);
+	if(ep_addr >= MAX_EP)
+	{
+		return;
+	}
+
+	switch(event)
+	{
+		case USB_common::USB_EVENTS::EP_RX:
+		{
+			Rx_waiter& waiter = m_rx_waiters[ep_addr];
+			if(!waiter.handle)
+			{
+				break;
+			}
+
+			Buffer_adapter_base* const buf = m_driver->get_rx_buffer()->poll_dequeue_buffer(ep_addr);
+			if(buf == nullptr)
+			{
+				break;
+			}
+
+			//clear the slot first, the coroutine may read again before resume returns
+			std::coroutine_handle<> handle = waiter.handle;
+			*waiter.out_buf = buf;
+			waiter.handle = nullptr;
+
+			handle.resume();
+			break;
+		}
+		case USB_common::USB_EVENTS::EP_TX:
+		{
+			Tx_waiter& waiter = m_tx_waiters[ep_addr];
+			if(!waiter.handle)
+			{
+				break;
+			}
+
+			if(waiter.out_buf)
+			{
+				Buffer_adapter_base* const buf = m_driver->get_tx_buffer()->poll_allocate_buffer(ep_addr);
+				if(buf == nullptr)
+				{
+					break;
+				}
+
+				buf->reset();
+				*waiter.out_buf = buf;
+			}
+			else if(!waiter.token->is_complete())
+			{
+				//a buffer queued ahead of ours went out
+				break;
+			}
+
+			std::coroutine_handle<> handle = waiter.handle;
+			waiter.handle = nullptr;
+
+			handle.resume();
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+}
+
+void Usb_coro_executor::cancel_all()
+{
+	for(Rx_waiter& waiter : m_rx_waiters)
+	{
+		if(waiter.handle)
+		{
+			std::coroutine_handle<> handle = waiter.handle;
+			*waiter.out_buf = nullptr;
+			waiter.handle = nullptr;
+
+			handle.resume();
+		}
+	}
+
+	for(Tx_waiter& waiter : m_tx_waiters)
+	{
+		if(!waiter.handle)
+		{
+			continue;
+		}
+
+		//a write still owned by the driver must keep its frame
+		if(waiter.token && !waiter.token->is_complete())
+		{
+			continue;
+		}
+
+		std::coroutine_handle<> handle = waiter.handle;
+		if(waiter.out_buf)
+		{
+			*waiter.out_buf = nullptr;
+		}
+		waiter.handle = nullptr;
+
+		handle.resume();
+	}
+}
+
+size_t Usb_coro_executor::get_num_waiting() const
+{
+	const size_t num_rx = std::count_if(m_rx_waiters.begin(), m_rx_waiters.end(), [](const Rx_waiter& w){return bool(w.handle);});
+	const size_t num_tx = std::count_if(m_tx_waiters.begin(), m_tx_waiters.end(), [](const Tx_waiter& w){return bool(w.handle);});
+
+	return num_rx + num_tx;
+}
+
+bool Usb_coro_control::Setup_awaitable::await_ready()
+{
+	if(m_ctrl->m_req_ready)
+	{
+		m_ctrl->m_req_ready  = false;
+		m_ctrl->m_req_active = true;
+		m_req = &m_ctrl->m_req;
+		return true;
+	}
+
+	return false;
+}
+
+bool Usb_coro_control::Setup_awaitable::await_suspend(std::coroutine_handle<> handle)
+{
+	if(m_ctrl->m_waiter)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "Usb_coro_control", "next_setup already has a waiter");
+		return false;
+	}
+
+	m_ctrl->m_waiter     = handle;
+	m_ctrl->m_waiter_out = &m_req;
+
+	return true;
+}
+
+Usb_coro_control::Usb_coro_control()
+{
+	m_core = nullptr;
+
+	m_req.setup_id = 0;
+	m_req.len = 0;
+	m_req_ready  = false;
+	m_req_active = false;
+
+	m_waiter     = nullptr;
+	m_waiter_out = nullptr;
+}
+
+bool Usb_coro_control::initialize(USB_core* const core)
+{
+	m_core = core;
+
+	return true;
+}
+
+USB_common::USB_RESP Usb_coro_control::handle_request(void* ctx, Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+{
+	return static_cast<Usb_coro_control*>(ctx)->handle_request(req, buf_from_host);
+}
+
+USB_common::USB_RESP Usb_coro_control::handle_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host)
+{
+	//HOST_TO_DEV data is copied into the request
+	const bool host_to_dev = (req->bmRequestType & 0x80) == 0;
+	if(host_to_dev && (req->wLength > MAX_DATA_LEN))
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "Usb_coro_control", "handle_request: wLength %u too long", unsigned(req->wLength));
+		return USB_common::USB_RESP::FAIL;
+	}
+
+	//a new setup packet replaces any request still open, the host has given up on it
+	m_req.setup_id = m_core->get_setup_id();
+	m_req.setup    = *req;
+	m_req.len      = 0;
+	if(host_to_dev && buf_from_host)
+	{
+		m_req.len = std::min(buf_from_host->size(), m_req.data.size());
+		std::copy_n(buf_from_host->data(), m_req.len, m_req.data.begin());
+	}
+
+	if(m_waiter)
+	{
+		std::coroutine_handle<> handle = m_waiter;
+		*m_waiter_out = &m_req;
+		m_waiter = nullptr;
+		m_req_ready  = false;
+		m_req_active = true;
+
+		//USB_core allows complete_deferred_request before the handler returns PENDING
+		handle.resume();
+	}
+	else
+	{
+		m_req_ready  = true;
+		m_req_active = false;
+	}
+
+	return USB_common::USB_RESP::PENDING;
+}
+
+bool Usb_coro_control::complete(const USB_common::USB_RESP resp, const uint8_t* const data, const size_t len)
+{
+	if(!m_req_active)
+	{
+		return false;
+	}
+
+	m_req_active = false;
+
+	return m_core->complete_deferred_request(m_req.setup_id, resp, data, len);
+}
+
+void Usb_coro_control::cancel()
+{
+	m_req_ready  = false;
+	m_req_active = false;
+
+	if(m_waiter)
+	{
+		std::coroutine_handle<> handle = m_waiter;
+		*m_waiter_out = nullptr;
+		m_waiter = nullptr;
+
+		handle.resume();
+	}
+}
+
+#endif
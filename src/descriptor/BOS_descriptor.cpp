@@ -0,0 +1,116 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/descriptor/BOS_descriptor.hpp"
+
+#include "common_util/Byte_util.hpp"
+
+bool BOS_descriptor::serialize(BOS_descriptor_array* const out_array) const
+{
+	const size_t total_size = get_total_size();
+	const size_t num_caps   = get_num_caps();
+
+	if((total_size > 0xFFFFU) || (num_caps > 0xFFU))
+	{
+		return false;
+	}
+
+	(*out_array)[0] = bLength;
+	(*out_array)[1] = bDescriptorType;
+	(*out_array)[2] = Byte_util::get_b0(total_size);
+	(*out_array)[3] = Byte_util::get_b1(total_size);
+	(*out_array)[4] = static_cast<uint8_t>(num_caps);
+
+	return true;
+}
+bool BOS_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	BOS_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+
+bool USB20_extension_descriptor::serialize(USB20_extension_descriptor_array* const out_array) const
+{
+	(*out_array)[0] = bLength;
+	(*out_array)[1] = bDescriptorType;
+	(*out_array)[2] = bDevCapabilityType;
+	(*out_array)[3] = Byte_util::get_b0(bmAttributes);
+	(*out_array)[4] = Byte_util::get_b1(bmAttributes);
+	(*out_array)[5] = Byte_util::get_b2(bmAttributes);
+	(*out_array)[6] = Byte_util::get_b3(bmAttributes);
+
+	return true;
+}
+bool USB20_extension_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	USB20_extension_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
+bool USB20_extension_descriptor::deserialize(const USB20_extension_descriptor_array& array)
+{
+	if(bLength != array[0])
+	{
+		return false;
+	}
+	if(bDescriptorType != array[1])
+	{
+		return false;
+	}
+	if(bDevCapabilityType != array[2])
+	{
+		return false;
+	}
+
+	bmAttributes = Byte_util::make_u32(array[6], array[5], array[4], array[3]);
+
+	return true;
+}
+
+bool Platform_capability_descriptor::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(size() > 0xFFU)
+	{
+		return false;
+	}
+
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	out_array->insert(static_cast<uint8_t>(size()));
+	out_array->insert(bDescriptorType);
+	out_array->insert(bDevCapabilityType);
+	out_array->insert(0);
+	out_array->insert(PlatformCapabilityUUID.data(), PlatformCapabilityUUID.size());
+	out_array->insert(CapabilityData.data(), CapabilityData.size());
+
+	return true;
+}
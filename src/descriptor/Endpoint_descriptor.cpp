@@ -37,6 +37,28 @@ bool Endpoint_descriptor::serialize(Buffer_adapter_tx* const out_array) const
 
 	return true;
 }
+bool Endpoint_descriptor::serialize_for_speed(Buffer_adapter_tx* const out_array, const USB_common::USB_SPEED speed) const
+{
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	Endpoint_descriptor_array temp;
+	if(!serialize(&temp))
+	{
+		return false;
+	}
+
+	const uint16_t max_packet_size = get_wMaxPacketSize(speed);
+	temp[4] = Byte_util::get_b0(max_packet_size);
+	temp[5] = Byte_util::get_b1(max_packet_size);
+	temp[6] = get_bInterval(speed);
+
+	out_array->insert(temp.data(), temp.size());
+
+	return true;
+}
 bool Endpoint_descriptor::deserialize(const Endpoint_descriptor_array& array)
 {
 	if(bLength != array[0])
@@ -0,0 +1,219 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/descriptor/MS_OS_20_descriptor.hpp"
+
+#include "common_util/Byte_util.hpp"
+
+#include <cstring>
+
+MS_OS_20_descriptor_set::MS_OS_20_descriptor_set(const uint8_t vendor_code, const uint32_t windows_version)
+{
+	m_vendor_code     = vendor_code;
+	m_windows_version = windows_version;
+
+	m_config_offset   = NO_SUBSET;
+	m_function_offset = NO_SUBSET;
+
+	m_finalized = false;
+
+	//set header, wTotalLength is patched by finalize
+	append_u16(10);
+	append_u16(static_cast<uint16_t>(DESCRIPTOR_TYPE::SET_HEADER_DESCRIPTOR));
+	append_u32(m_windows_version);
+	append_u16(0);
+}
+
+void MS_OS_20_descriptor_set::add_configuration_subset(const uint8_t config_index)
+{
+	close_function_subset();
+	close_configuration_subset();
+
+	m_config_offset = m_data.size();
+
+	append_u16(8);
+	append_u16(static_cast<uint16_t>(DESCRIPTOR_TYPE::SUBSET_HEADER_CONFIGURATION));
+	m_data.push_back(config_index);
+	m_data.push_back(0);
+	append_u16(0);
+}
+
+void MS_OS_20_descriptor_set::add_function_subset(const uint8_t first_iface)
+{
+	close_function_subset();
+
+	m_function_offset = m_data.size();
+
+	append_u16(8);
+	append_u16(static_cast<uint16_t>(DESCRIPTOR_TYPE::SUBSET_HEADER_FUNCTION));
+	m_data.push_back(first_iface);
+	m_data.push_back(0);
+	append_u16(0);
+}
+
+bool MS_OS_20_descriptor_set::add_compatible_id(const char* compatible_id, const char* sub_compatible_id)
+{
+	const size_t id_len     = strlen(compatible_id);
+	const size_t sub_id_len = strlen(sub_compatible_id);
+
+	if((id_len > 8) || (sub_id_len > 8))
+	{
+		return false;
+	}
+
+	append_u16(20);
+	append_u16(static_cast<uint16_t>(DESCRIPTOR_TYPE::FEATURE_COMPATBLE_ID));
+
+	//both fields are null padded to 8 bytes
+	const size_t id_offset = m_data.size();
+	m_data.resize(m_data.size() + 16, 0);
+	memcpy(m_data.data() + id_offset, compatible_id, id_len);
+	memcpy(m_data.data() + id_offset + 8, sub_compatible_id, sub_id_len);
+
+	return true;
+}
+
+bool MS_OS_20_descriptor_set::add_registry_property(const PROPERTY_DATA_TYPE type, const char* name, const std::vector<uint8_t>& data)
+{
+	//UTF-16LE with null terminator
+	const size_t name_len = (strlen(name) + 1) * 2;
+	const size_t total_len = 10 + name_len + data.size();
+
+	if(total_len > 0xFFFFU)
+	{
+		return false;
+	}
+
+	append_u16(static_cast<uint16_t>(total_len));
+	append_u16(static_cast<uint16_t>(DESCRIPTOR_TYPE::FEATURE_REG_PROPERTY));
+	append_u16(static_cast<uint16_t>(type));
+	append_u16(static_cast<uint16_t>(name_len));
+	append_utf16(name);
+	append_u16(static_cast<uint16_t>(data.size()));
+	m_data.insert(m_data.end(), data.begin(), data.end());
+
+	return true;
+}
+
+bool MS_OS_20_descriptor_set::add_registry_property(const PROPERTY_DATA_TYPE type, const char* name, const char* str)
+{
+	std::vector<uint8_t> data;
+	data.reserve((strlen(str) + 2) * 2);
+
+	for(const char* c = str; *c != '\0'; c++)
+	{
+		data.push_back(static_cast<uint8_t>(*c));
+		data.push_back(0);
+	}
+
+	//string terminator
+	data.push_back(0);
+	data.push_back(0);
+
+	//list terminator
+	if(type == PROPERTY_DATA_TYPE::REG_MULTI_SZ)
+	{
+		data.push_back(0);
+		data.push_back(0);
+	}
+
+	return add_registry_property(type, name, data);
+}
+
+bool MS_OS_20_descriptor_set::add_device_interface_guid(const char* guid)
+{
+	return add_registry_property(PROPERTY_DATA_TYPE::REG_MULTI_SZ, "DeviceInterfaceGUIDs", guid);
+}
+
+bool MS_OS_20_descriptor_set::finalize()
+{
+	close_function_subset();
+	close_configuration_subset();
+
+	if(m_data.size() > 0xFFFFU)
+	{
+		return false;
+	}
+
+	patch_u16(8, static_cast<uint16_t>(m_data.size()));
+
+	m_finalized = true;
+
+	return true;
+}
+
+bool MS_OS_20_descriptor_set::make_platform_capability(Platform_capability_descriptor* const out_cap) const
+{
+	if(!m_finalized)
+	{
+		return false;
+	}
+
+	out_cap->PlatformCapabilityUUID = PLATFORM_UUID;
+
+	out_cap->CapabilityData.clear();
+	out_cap->CapabilityData.push_back(Byte_util::get_b0(m_windows_version));
+	out_cap->CapabilityData.push_back(Byte_util::get_b1(m_windows_version));
+	out_cap->CapabilityData.push_back(Byte_util::get_b2(m_windows_version));
+	out_cap->CapabilityData.push_back(Byte_util::get_b3(m_windows_version));
+	out_cap->CapabilityData.push_back(Byte_util::get_b0(m_data.size()));
+	out_cap->CapabilityData.push_back(Byte_util::get_b1(m_data.size()));
+	out_cap->CapabilityData.push_back(m_vendor_code);
+	//bAltEnumCode, no alternate enumeration
+	out_cap->CapabilityData.push_back(0);
+
+	return true;
+}
+
+void MS_OS_20_descriptor_set::close_function_subset()
+{
+	if(m_function_offset != NO_SUBSET)
+	{
+		patch_u16(m_function_offset + 6, static_cast<uint16_t>(m_data.size() - m_function_offset));
+		m_function_offset = NO_SUBSET;
+	}
+}
+
+void MS_OS_20_descriptor_set::close_configuration_subset()
+{
+	if(m_config_offset != NO_SUBSET)
+	{
+		patch_u16(m_config_offset + 6, static_cast<uint16_t>(m_data.size() - m_config_offset));
+		m_config_offset = NO_SUBSET;
+	}
+}
+
+void MS_OS_20_descriptor_set::append_u16(const uint16_t val)
+{
+	m_data.push_back(Byte_util::get_b0(val));
+	m_data.push_back(Byte_util::get_b1(val));
+}
+
+void MS_OS_20_descriptor_set::append_u32(const uint32_t val)
+{
+	m_data.push_back(Byte_util::get_b0(val));
+	m_data.push_back(Byte_util::get_b1(val));
+	m_data.push_back(Byte_util::get_b2(val));
+	m_data.push_back(Byte_util::get_b3(val));
+}
+
+void MS_OS_20_descriptor_set::append_utf16(const char* str)
+{
+	for(const char* c = str; *c != '\0'; c++)
+	{
+		m_data.push_back(static_cast<uint8_t>(*c));
+		m_data.push_back(0);
+	}
+
+	m_data.push_back(0);
+	m_data.push_back(0);
+}
+
+void MS_OS_20_descriptor_set::patch_u16(const size_t offset, const uint16_t val)
+{
+	m_data[offset + 0] = Byte_util::get_b0(val);
+	m_data[offset + 1] = Byte_util::get_b1(val);
+}
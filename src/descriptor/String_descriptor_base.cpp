@@ -5,6 +5,7 @@
 */
 
 #include "libusb_dev_cpp/descriptor/String_descriptor_base.hpp"
+#include "libusb_dev_cpp/descriptor/String_descriptor_utf8.hpp"
 
 #include "common_util/Byte_util.hpp"
 
@@ -19,22 +20,28 @@ bool String_descriptor_base::serialize(Buffer_adapter_tx* const out_array) const
 	out_array->insert(len);
 	out_array->insert(bDescriptorType);
 	
-	std::array<uint8_t, 2> m_char;
+	//m_str is UTF-8, characters outside the BMP become surrogate pairs
+	std::array<uint8_t, 4> m_char;
 	if(m_str)
 	{
-		for(size_t i = 0; i < str_len_max; i++)
+		size_t out_len = 2;
+		size_t idx = 0;
+		while(idx < (str_len_max * 4))
 		{
-			const char c = m_str[i];
-			if(c)
+			const uint32_t cp = Utf8::decode(m_str, &idx);
+			if(cp == 0)
 			{
-				ascii_to_utf16le(c, &m_char);
-
-				out_array->insert(m_char.data(), m_char.size());
+				break;
 			}
-			else
+
+			const size_t n = Utf8::encode_utf16le(cp, m_char.data());
+			if((out_len + n) > len)
 			{
 				break;
 			}
+
+			out_array->insert(m_char.data(), n);
+			out_len += n;
 		}
 	}
 
@@ -42,21 +49,11 @@ bool String_descriptor_base::serialize(Buffer_adapter_tx* const out_array) const
 }
 
 size_t String_descriptor_base::size() const
-{;
+{
 	size_t len = 1+1;
 	if(m_str)
 	{
-		for(size_t i = 0; i < str_len_max; i++)
-		{
-			if(m_str[i])
-			{
-				len += 2;
-			}
-			else
-			{
-				break;
-			}
-		}
+		len += 2U * Utf8::utf16_len(m_str, str_len_max * 4);
 	}
 	return std::min<size_t>(len, 254U);
 }
@@ -70,7 +67,7 @@ bool String_descriptor_zero::serialize(Buffer_adapter_tx* const out_array) const
 	out_array->insert(bDescriptorType);
 
 	std::array<uint8_t, 2> u16;
-	for(size_t i = 0; i < len; i++)
+	for(size_t i = 0; i < m_size; i++)
 	{
 		u16[0] = Byte_util::get_b0(static_cast<uint16_t>(m_lang[i]));
 		u16[1] = Byte_util::get_b1(static_cast<uint16_t>(m_lang[i]));
@@ -0,0 +1,73 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/descriptor/String_descriptor_dynamic.hpp"
+#include "libusb_dev_cpp/descriptor/String_descriptor_utf8.hpp"
+
+#include <algorithm>
+
+bool String_descriptor_dynamic::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(!m_valid)
+	{
+		generate();
+	}
+
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	out_array->insert(m_cache.data(), m_cache[0]);
+
+	return true;
+}
+
+size_t String_descriptor_dynamic::size() const
+{
+	if(!m_valid)
+	{
+		generate();
+	}
+
+	return m_cache[0];
+}
+
+void String_descriptor_dynamic::generate() const
+{
+	//UTF-8 text can be up to 4 bytes per code point, the encoder truncates to what fits
+	std::array<char, str_len_max * 4 + 1> text;
+
+	size_t text_len = 0;
+	if(m_generate_callback_func)
+	{
+		text_len = std::min(m_generate_callback_func(m_generate_callback_ctx, text.data(), text.size() - 1), text.size() - 1);
+	}
+	text[text_len] = '\0';
+
+	size_t out_idx = 2;
+	size_t in_idx = 0;
+	while(in_idx < text_len)
+	{
+		const uint32_t cp = Utf8::decode(text.data(), &in_idx);
+		if(cp == 0)
+		{
+			break;
+		}
+
+		if((out_idx + 2 * Utf8::utf16_units(cp)) > m_cache.size())
+		{
+			break;
+		}
+
+		out_idx += Utf8::encode_utf16le(cp, m_cache.data() + out_idx);
+	}
+
+	m_cache[0] = static_cast<uint8_t>(out_idx);
+	m_cache[1] = bDescriptorType;
+
+	m_valid = true;
+}
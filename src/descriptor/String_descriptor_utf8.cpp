@@ -0,0 +1,24 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/descriptor/String_descriptor_utf8.hpp"
+
+bool String_descriptor_static::serialize(Buffer_adapter_tx* const out_array) const
+{
+	if(!m_buf)
+	{
+		return false;
+	}
+
+	if(out_array->capacity() < size())
+	{
+		return false;
+	}
+
+	out_array->insert(m_buf, size());
+
+	return true;
+}
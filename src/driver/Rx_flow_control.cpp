@@ -0,0 +1,177 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/driver/Rx_flow_control.hpp"
+
+Rx_flow_control::Rx_flow_control()
+{
+	for(EP_state& ep : m_ep)
+	{
+		ep.cfg = Config();
+	}
+
+	reset_all();
+
+	m_event_callback_func = nullptr;
+	m_event_callback_ctx  = nullptr;
+}
+
+bool Rx_flow_control::set_config(const uint8_t ep_addr, const Config& cfg)
+{
+	if(ep_addr >= MAX_EP)
+	{
+		return false;
+	}
+
+	if(cfg.low_watermark > cfg.high_watermark)
+	{
+		return false;
+	}
+
+	m_ep[ep_addr].cfg = cfg;
+
+	return true;
+}
+
+void Rx_flow_control::reset(const uint8_t ep_addr)
+{
+	if(ep_addr >= MAX_EP)
+	{
+		return;
+	}
+
+	EP_state& ep = m_ep[ep_addr];
+
+	ep.pending    = 0;
+	ep.above_high = false;
+	ep.held       = false;
+	ep.drops      = 0;
+	ep.underruns  = 0;
+}
+
+void Rx_flow_control::reset_all()
+{
+	for(size_t i = 0; i < MAX_EP; i++)
+	{
+		reset(i);
+	}
+}
+
+bool Rx_flow_control::on_queued(const uint8_t ep_addr)
+{
+	if(ep_addr >= MAX_EP)
+	{
+		return false;
+	}
+
+	EP_state& ep = m_ep[ep_addr];
+
+	ep.pending++;
+
+	if((ep.cfg.high_watermark == 0) || (ep.pending < ep.cfg.high_watermark))
+	{
+		return false;
+	}
+
+	if(!ep.above_high)
+	{
+		ep.above_high = true;
+		fire(ep_addr, EVENT::HIGH_WATERMARK);
+	}
+
+	if(ep.cfg.policy == POLICY::NAK)
+	{
+		ep.held = true;
+	}
+
+	return ep.held;
+}
+
+Rx_flow_control::POLICY Rx_flow_control::on_underrun(const uint8_t ep_addr)
+{
+	if(ep_addr >= MAX_EP)
+	{
+		return POLICY::BLOCK;
+	}
+
+	EP_state& ep = m_ep[ep_addr];
+
+	ep.underruns++;
+	fire(ep_addr, EVENT::UNDERRUN);
+
+	return ep.cfg.policy;
+}
+
+void Rx_flow_control::on_drop(const uint8_t ep_addr)
+{
+	if(ep_addr >= MAX_EP)
+	{
+		return;
+	}
+
+	m_ep[ep_addr].drops++;
+	fire(ep_addr, EVENT::DROP);
+}
+
+void Rx_flow_control::on_reclaimed(const uint8_t ep_addr)
+{
+	if(ep_addr >= MAX_EP)
+	{
+		return;
+	}
+
+	if(m_ep[ep_addr].pending > 0)
+	{
+		m_ep[ep_addr].pending--;
+	}
+
+	on_drop(ep_addr);
+	check_low(ep_addr);
+}
+
+bool Rx_flow_control::on_released(const uint8_t ep_addr)
+{
+	if(ep_addr >= MAX_EP)
+	{
+		return false;
+	}
+
+	EP_state& ep = m_ep[ep_addr];
+
+	if(ep.pending > 0)
+	{
+		ep.pending--;
+	}
+
+	check_low(ep_addr);
+
+	if(ep.held && !ep.above_high)
+	{
+		ep.held = false;
+		return true;
+	}
+
+	return false;
+}
+
+void Rx_flow_control::fire(const uint8_t ep_addr, const EVENT event)
+{
+	if(m_event_callback_func)
+	{
+		m_event_callback_func(m_event_callback_ctx, ep_addr, event, m_ep[ep_addr].pending);
+	}
+}
+
+void Rx_flow_control::check_low(const uint8_t ep_addr)
+{
+	EP_state& ep = m_ep[ep_addr];
+
+	if(ep.above_high && (ep.pending <= ep.cfg.low_watermark))
+	{
+		ep.above_high = false;
+		fire(ep_addr, EVENT::LOW_WATERMARK);
+	}
+}
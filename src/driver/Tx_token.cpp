@@ -0,0 +1,130 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/driver/Tx_token.hpp"
+
+Tx_token::Tx_token() : m_state(STATE::IDLE)
+{
+	m_ep  = 0;
+	m_len = 0;
+	m_buf = nullptr;
+
+	m_queued_time   = 0;
+	m_started_time  = 0;
+	m_complete_time = 0;
+
+	m_next = nullptr;
+
+	m_complete_callback_func = nullptr;
+	m_complete_callback_ctx  = nullptr;
+}
+
+Tx_token::~Tx_token()
+{
+
+}
+
+bool Tx_token::queue(const uint8_t ep, const Buffer_adapter_base* const buf, const uint32_t now)
+{
+	if(is_pending())
+	{
+		return false;
+	}
+
+	m_ep  = ep;
+	m_len = buf->size();
+	m_buf = buf;
+
+	m_queued_time   = now;
+	m_started_time  = 0;
+	m_complete_time = 0;
+
+	m_next = nullptr;
+
+	m_state.store(STATE::QUEUED);
+
+	return true;
+}
+
+void Tx_token::start(const uint32_t now)
+{
+	m_started_time = now;
+	m_state.store(STATE::STARTED);
+}
+
+void Tx_token::complete(const STATE state, const uint32_t now)
+{
+	m_complete_time = now;
+	m_buf  = nullptr;
+	m_next = nullptr;
+
+	m_state.store(state);
+
+	if(m_complete_callback_func)
+	{
+		m_complete_callback_func(m_complete_callback_ctx, this);
+	}
+
+	on_complete();
+}
+
+void Tx_token_queue::push(Tx_token* const token)
+{
+	token->m_next = nullptr;
+
+	if(m_tail)
+	{
+		m_tail->m_next = token;
+	}
+	else
+	{
+		m_head = token;
+	}
+
+	m_tail = token;
+}
+
+Tx_token* Tx_token_queue::pop()
+{
+	Tx_token* const token = m_head;
+	if(token)
+	{
+		m_head = token->m_next;
+		if(m_head == nullptr)
+		{
+			m_tail = nullptr;
+		}
+	}
+
+	return token;
+}
+
+void Tx_token_queue::on_started(const Buffer_adapter_base* const buf, const uint32_t now)
+{
+	//buffers go out in order, so only the head can match
+	if(m_head && (m_head->m_buf == buf))
+	{
+		m_head->start(now);
+	}
+}
+
+void Tx_token_queue::on_finished(const Buffer_adapter_base* const buf, const Tx_token::STATE state, const uint32_t now)
+{
+	if(m_head && (m_head->m_buf == buf))
+	{
+		pop()->complete(state, now);
+	}
+}
+
+void Tx_token_queue::abort_all(const uint32_t now)
+{
+	Tx_token* token = pop();
+	while(token)
+	{
+		token->complete(Tx_token::STATE::ABORTED, now);
+		token = pop();
+	}
+}
@@ -872,7 +872,21 @@ uint16_t stm32_h7xx_otghs::get_frame_number()
 }
 size_t stm32_h7xx_otghs::get_serial_number(uint8_t* const buf, const size_t maxlen)
 {
-	return 0;
+	//UID_BASE holds 3 words, copy them out LSB first
+	const volatile uint32_t* const uid = reinterpret_cast<const volatile uint32_t*>(UID_BASE);
+
+	size_t len = 0;
+	for(size_t i = 0; i < 3; i++)
+	{
+		const uint32_t word = uid[i];
+		for(size_t j = 0; (j < 4) && (len < maxlen); j++)
+		{
+			buf[len] = static_cast<uint8_t>((word >> (8 * j)) & 0xFF);
+			len++;
+		}
+	}
+
+	return len;
 }
 
 USB_common::USB_SPEED stm32_h7xx_otghs::get_speed() const
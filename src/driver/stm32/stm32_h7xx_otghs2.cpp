@@ -15,6 +15,7 @@
 
 #include "freertos_cpp_util/logging/Global_logger.hpp"
 
+#include <algorithm>
 #include <cinttypes>
 
 using freertos_util::logging::Global_logger;
@@ -168,9 +169,114 @@ bool stm32_h7xx_otghs2::config_ep_tx_fifo(const uint8_t ep, const size_t len)
 	return true;
 }
 
+//place the fifo of every configured IN ep after the ep0 fifo, first fit in ep order, so an ep only takes space while configured
+//an ep that is enabled or has a buffer loaded keeps its fifo, moving it would lose the packet in flight
+//an idle ep may move, its fifo is empty
+//unconfigured eps share one parked block at the top of fifo ram that no configured ep uses, the core does not read the fifo of an inactive ep
+//call with the usb isr masked, so an ep can not go busy while the plan is made
+bool stm32_h7xx_otghs2::replan_tx_fifo()
+{
+	const uint32_t DIEPTXF0_HNPTXFSIZ = OTG->DIEPTXF0_HNPTXFSIZ;
+
+	//in 32bit words
+	const uint32_t first_fsa = _FLD2VAL(USB_OTG_TX0FSA, DIEPTXF0_HNPTXFSIZ) + _FLD2VAL(USB_OTG_TX0FD, DIEPTXF0_HNPTXFSIZ);
+	const uint32_t park_fsa  = MAX_FIFO_LEN_U32 - PARK_FIFO_LEN_U32;
+
+	std::array<uint32_t, MAX_NUM_EP> fsa;
+	std::array<uint32_t, MAX_NUM_EP> len32;
+	std::array<bool, MAX_NUM_EP> placed;
+
+	//busy eps are fixed where they are
+	for(size_t i = 1; i <= MAX_NUM_EP; i++)
+	{
+		const ep_cfg& cfg = m_tx_ep_cfg[i-1];
+
+		fsa[i-1]    = park_fsa;
+		len32[i-1]  = PARK_FIFO_LEN_U32;
+		placed[i-1] = false;
+
+		if(cfg.type == EP_TYPE::UNCONF)
+		{
+			continue;
+		}
+
+		len32[i-1] = (std::max<size_t>(cfg.size, 64) + 3U) / 4U;
+
+		const bool busy = ((get_ep_in(i)->DIEPCTL & USB_OTG_DIEPCTL_EPENA) != 0) || (m_tx_buffer && m_tx_buffer->get_buffer(i));
+		if(busy)
+		{
+			const uint32_t DIEPTXF = OTG->DIEPTXF[i-1];
+			const uint32_t i_fsa = _FLD2VAL(USB_OTG_DIEPTXF_INEPTXSA, DIEPTXF);
+			const uint32_t i_fd  = _FLD2VAL(USB_OTG_DIEPTXF_INEPTXFD, DIEPTXF);
+
+			if(i_fd < len32[i-1])
+			{
+				Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "stm32_h7xx_otghs2::replan_tx_fifo", "ep %d is busy and its fifo is %d words, wanted %d", i, i_fd, len32[i-1]);
+				return false;
+			}
+
+			fsa[i-1]    = i_fsa;
+			len32[i-1]  = i_fd;
+			placed[i-1] = true;
+		}
+	}
+
+	//idle eps take the first gap that fits
+	for(size_t i = 1; i <= MAX_NUM_EP; i++)
+	{
+		if((m_tx_ep_cfg[i-1].type == EP_TYPE::UNCONF) || placed[i-1])
+		{
+			continue;
+		}
+
+		uint32_t i_fsa = first_fsa;
+		bool overlap = true;
+		while(overlap)
+		{
+			overlap = false;
+			for(size_t j = 1; j <= MAX_NUM_EP; j++)
+			{
+				if(placed[j-1] && (i_fsa < (fsa[j-1] + len32[j-1])) && (fsa[j-1] < (i_fsa + len32[i-1])))
+				{
+					i_fsa = fsa[j-1] + len32[j-1];
+					overlap = true;
+				}
+			}
+		}
+
+		if((i_fsa + len32[i-1]) > park_fsa)
+		{
+			Global_logger::get()->log(freertos_util::logging::LOG_LEVEL::ERROR, "stm32_h7xx_otghs2::replan_tx_fifo", "ep %d does not fit, %d words", i, len32[i-1]);
+			return false;
+		}
+
+		fsa[i-1]    = i_fsa;
+		placed[i-1] = true;
+	}
+
+	//nothing was written until the whole plan fit
+	for(size_t i = 1; i <= MAX_NUM_EP; i++)
+	{
+		const uint32_t DIEPTXF = _VAL2FLD(USB_OTG_DIEPTXF_INEPTXFD, len32[i-1]) | _VAL2FLD(USB_OTG_DIEPTXF_INEPTXSA, fsa[i-1]);
+		if(OTG->DIEPTXF[i-1] != DIEPTXF)
+		{
+			OTG->DIEPTXF[i-1] = DIEPTXF;
+
+			//only idle eps move, this just resets the fifo pointers
+			if(m_tx_ep_cfg[i-1].type != EP_TYPE::UNCONF)
+			{
+				flush_tx(i);
+			}
+		}
+	}
+
+	return true;
+}
+
 stm32_h7xx_otghs2::stm32_h7xx_otghs2()
 {
 	m_state = STATE::UNKNOWN;
+	m_l1_active = false;
 
 	m_tx_buffer = nullptr;
 	m_rx_buffer = nullptr;
@@ -357,6 +463,7 @@ bool stm32_h7xx_otghs2::enable()
 					USB_OTG_GINTMSK_USBRST   |
     				USB_OTG_GINTMSK_USBSUSPM |
 					USB_OTG_GINTMSK_ESUSPM   |
+					USB_OTG_GINTMSK_WUIM     |
     				USB_OTG_GINTMSK_SOFM     |
 					USB_OTG_GINTMSK_OTGINT   |
 					USB_OTG_GINTMSK_MMISM
@@ -489,12 +596,26 @@ bool stm32_h7xx_otghs2::ep_config(const ep_cfg& ep)
 			// _VAL2FLD(USB_OTG_DIEPCTL_MPSIZ, mpsize); | //hardcoded to match control in 0
 			;
 	}
+	else if(ep_addr > MAX_NUM_EP)
+	{
+		return false;
+	}
 	else if(USB_common::is_in_ep(ep.num))
 	{
 		volatile USB_OTG_INEndpointTypeDef* const ep_in = get_ep_in(ep_addr);
 
-		if(!config_ep_tx_fifo(ep_addr, ep.size))
+		if(ep.type == usb_driver_base::EP_TYPE::UNCONF)
+		{
+			return false;
+		}
+
+		Scoped_ISR_Mask otg_mask(OTG_HS_IRQn);
+
+		m_tx_ep_cfg[ep_addr - 1] = ep;
+		if(!replan_tx_fifo())
 		{
+			m_tx_ep_cfg[ep_addr - 1].type = EP_TYPE::UNCONF;
+			replan_tx_fifo();
 			return false;
 		}
 
@@ -541,6 +662,11 @@ bool stm32_h7xx_otghs2::ep_config(const ep_cfg& ep)
 		
 		//enable tx interrupt
 		OTGD->DAINTMSK |= _VAL2FLD(USB_OTG_DAINTMSK_IEPM, 0x0001 << ep_addr);
+
+		if(ep.type == usb_driver_base::EP_TYPE::ISOCHRONUS)
+		{
+			Register_util::set_bits(&OTG->GINTMSK, USB_OTG_GINTMSK_IISOIXFRM);
+		}
 	}
 	else
 	{
@@ -587,6 +713,10 @@ bool stm32_h7xx_otghs2::ep_config(const ep_cfg& ep)
 		}
 
 		// OTGD->DAINTMSK |= _VAL2FLD(USB_OTG_DAINTMSK_OEPM, 0x0001 << ep_addr);
+
+		m_rx_ep_cfg[ep_addr - 1] = ep;
+
+		m_rx_flow.reset(ep_addr);
 	}
 
 	return true;
@@ -594,59 +724,108 @@ bool stm32_h7xx_otghs2::ep_config(const ep_cfg& ep)
 bool stm32_h7xx_otghs2::ep_unconfig(const uint8_t ep)
 {
 	const uint8_t ep_addr = USB_common::get_ep_addr(ep);
+	if(ep_addr > MAX_NUM_EP)
+	{
+		return false;
+	}
 
-	volatile USB_OTG_INEndpointTypeDef*  const ep_in  = get_ep_in(ep_addr);
-	volatile USB_OTG_OUTEndpointTypeDef* const ep_out = get_ep_out(ep_addr);
-	
-	OTGD->DAINTMSK &= ~(0x00010001 << ep_addr);
-
-	Register_util::clear_bits(&ep_in->DIEPCTL, USB_OTG_DIEPCTL_USBAEP);
-	flush_tx(ep_addr);
+	//ep0 is both directions, otherwise only the half named by ep, its partner may belong to another interface
+	const bool unconfig_in  = (ep_addr == 0) || USB_common::is_in_ep(ep);
+	const bool unconfig_out = (ep_addr == 0) || !USB_common::is_in_ep(ep);
 
-	if(ep_addr != 0)
+	if(unconfig_in)
 	{
-		if(ep_in->DIEPCTL & USB_OTG_DIEPCTL_EPENA)
+		volatile USB_OTG_INEndpointTypeDef* const ep_in = get_ep_in(ep_addr);
+
+		Scoped_ISR_Mask otg_mask(OTG_HS_IRQn);
+
+		OTGD->DAINTMSK &= ~(0x00000001 << ep_addr);
+
+		//stop the packet in flight before its fifo is flushed and given back
+		if(ep_addr != 0)
 		{
-			Register_util::set_bits(&ep_in->DIEPCTL, USB_OTG_DIEPCTL_EPDIS);
+			if(ep_in->DIEPCTL & USB_OTG_DIEPCTL_EPENA)
+			{
+				Register_util::set_bits(&ep_in->DIEPCTL, USB_OTG_DIEPCTL_SNAK | USB_OTG_DIEPCTL_EPDIS);
+				Register_util::wait_until_set(&ep_in->DIEPINT, USB_OTG_DIEPINT_EPDISD);
+			}
 		}
-	}
 
-	ep_in->DIEPINT = 
-		(1U << 13) | 
-		(1U << 11) | 
-		(1U <<  8) | 
-		(1U <<  7) | 
-		(1U <<  6) | 
-		(1U <<  5) | 
-		(1U <<  4) | 
-		(1U <<  3) | 
-		(1U <<  2) | 
-		(1U <<  1) | 
-		(1U <<  0);
+		Register_util::clear_bits(&ep_in->DIEPCTL, USB_OTG_DIEPCTL_USBAEP);
+		flush_tx(ep_addr);
 
-	if(ep_addr != 0)
-	{
-		OTG->DIEPTXF[ep_addr-1] = _VAL2FLD(USB_OTG_DIEPTXF_INEPTXFD, 0x0200) | _VAL2FLD(USB_OTG_DIEPTXF_INEPTXSA, 0x0200+0x0200*ep_addr);
+		//the loaded buffer is not coming back through XFRC, and nothing queued behind it may go out once the ep is configured again
+		if((ep_addr != 0) && m_tx_buffer)
+		{
+			Buffer_adapter_base* const curr_tx_buf = m_tx_buffer->get_buffer(ep_addr);
+			if(curr_tx_buf)
+			{
+				m_tx_buffer->set_buffer(ep_addr, nullptr);
+				m_tx_buffer->release_buffer(ep_addr, curr_tx_buf);
+			}
+
+			for(Buffer_adapter_base* buf = m_tx_buffer->poll_dequeue_buffer(ep_addr); buf != nullptr; buf = m_tx_buffer->poll_dequeue_buffer(ep_addr))
+			{
+				m_tx_buffer->release_buffer(ep_addr, buf);
+			}
+		}
+
+		//nothing queued will be sent now
+		tx_token_abort(ep_addr);
+
+		ep_in->DIEPINT = 
+			(1U << 13) | 
+			(1U << 11) | 
+			(1U <<  8) | 
+			(1U <<  7) | 
+			(1U <<  6) | 
+			(1U <<  5) | 
+			(1U <<  4) | 
+			(1U <<  3) | 
+			(1U <<  2) | 
+			(1U <<  1) | 
+			(1U <<  0);
+
+		if(ep_addr != 0)
+		{
+			//give the fifo space back
+			m_tx_ep_cfg[ep_addr - 1].size = 0;
+			m_tx_ep_cfg[ep_addr - 1].type = EP_TYPE::UNCONF;
+			replan_tx_fifo();
+		}
 	}
 
-	Register_util::clear_bits(&ep_out->DOEPCTL, USB_OTG_DOEPCTL_USBAEP);
-	if(ep_out->DOEPCTL & USB_OTG_DOEPCTL_EPENA)
+	if(unconfig_out)
 	{
-		Register_util::set_bits(&ep_out->DOEPCTL, USB_OTG_DOEPCTL_EPDIS);
+		volatile USB_OTG_OUTEndpointTypeDef* const ep_out = get_ep_out(ep_addr);
+
+		OTGD->DAINTMSK &= ~(0x00010000 << ep_addr);
+
+		Register_util::clear_bits(&ep_out->DOEPCTL, USB_OTG_DOEPCTL_USBAEP);
+		if(ep_out->DOEPCTL & USB_OTG_DOEPCTL_EPENA)
+		{
+			Register_util::set_bits(&ep_out->DOEPCTL, USB_OTG_DOEPCTL_EPDIS);
+		}
+		ep_out->DOEPINT = 
+			(1U << 14) | 
+			(1U << 13) | 
+			(1U << 12) | 
+			(1U <<  8) | 
+			(1U <<  7) | 
+			(1U <<  6) | 
+			(1U <<  5) | 
+			(1U <<  4) | 
+			(1U <<  3) | 
+			(1U <<  2) | 
+			(1U <<  1) | 
+			(1U <<  0);
+
+		if(ep_addr != 0)
+		{
+			m_rx_ep_cfg[ep_addr - 1].size = 0;
+			m_rx_ep_cfg[ep_addr - 1].type = EP_TYPE::UNCONF;
+		}
 	}
-	ep_out->DOEPINT = 
-		(1U << 14) | 
-		(1U << 13) | 
-		(1U << 12) | 
-		(1U <<  8) | 
-		(1U <<  7) | 
-		(1U <<  6) | 
-		(1U <<  5) | 
-		(1U <<  4) | 
-		(1U <<  3) | 
-		(1U <<  2) | 
-		(1U <<  1) | 
-		(1U <<  0);
 
 	return true;
 }
@@ -787,16 +966,32 @@ int stm32_h7xx_otghs2::ep_write(const uint8_t ep, const uint8_t* buf, const uint
 			return -1;
 		}
 
-		Register_util::mask_set_bits(
-							&epin->DIEPTSIZ,
-							USB_OTG_DIEPTSIZ_MULCNT | USB_OTG_DIEPTSIZ_PKTCNT | USB_OTG_DIEPTSIZ_XFRSIZ,
-							_VAL2FLD(USB_OTG_DIEPTSIZ_MULCNT, 0) | _VAL2FLD(USB_OTG_DIEPTSIZ_PKTCNT, 1) | _VAL2FLD(USB_OTG_DIEPTSIZ_XFRSIZ, len)
-						);
-		
-		Register_util::mask_set_bits(
-			&epin->DIEPCTL,
-			USB_OTG_DIEPCTL_STALL | USB_OTG_DIEPCTL_SD0PID_SEVNFRM,
-			USB_OTG_DIEPCTL_CNAK  | USB_OTG_DIEPCTL_EPENA);
+		if(is_iso_in_ep(ep_addr))
+		{
+			Register_util::mask_set_bits(
+								&epin->DIEPTSIZ,
+								USB_OTG_DIEPTSIZ_MULCNT | USB_OTG_DIEPTSIZ_PKTCNT | USB_OTG_DIEPTSIZ_XFRSIZ,
+								_VAL2FLD(USB_OTG_DIEPTSIZ_MULCNT, 1) | _VAL2FLD(USB_OTG_DIEPTSIZ_PKTCNT, 1) | _VAL2FLD(USB_OTG_DIEPTSIZ_XFRSIZ, len)
+							);
+
+			Register_util::mask_set_bits(
+				&epin->DIEPCTL,
+				USB_OTG_DIEPCTL_STALL | USB_OTG_DIEPCTL_SD0PID_SEVNFRM | USB_OTG_DIEPCTL_SODDFRM,
+				USB_OTG_DIEPCTL_CNAK  | USB_OTG_DIEPCTL_EPENA | get_next_frame_parity());
+		}
+		else
+		{
+			Register_util::mask_set_bits(
+								&epin->DIEPTSIZ,
+								USB_OTG_DIEPTSIZ_MULCNT | USB_OTG_DIEPTSIZ_PKTCNT | USB_OTG_DIEPTSIZ_XFRSIZ,
+								_VAL2FLD(USB_OTG_DIEPTSIZ_MULCNT, 0) | _VAL2FLD(USB_OTG_DIEPTSIZ_PKTCNT, 1) | _VAL2FLD(USB_OTG_DIEPTSIZ_XFRSIZ, len)
+							);
+			
+			Register_util::mask_set_bits(
+				&epin->DIEPCTL,
+				USB_OTG_DIEPCTL_STALL | USB_OTG_DIEPCTL_SD0PID_SEVNFRM,
+				USB_OTG_DIEPCTL_CNAK  | USB_OTG_DIEPCTL_EPENA);
+		}
 	}
 
 	volatile uint32_t* const fifo = get_ep_fifo(ep_addr);
@@ -857,6 +1052,25 @@ int stm32_h7xx_otghs2::ep_write(const uint8_t ep, const uint8_t* buf, const uint
 
 	return len;
 }
+void stm32_h7xx_otghs2::ep_discard(const uint16_t len)
+{
+	for(size_t i = 0; i < len; i += 4)
+	{
+		volatile uint32_t temp = *get_ep_fifo(0);
+		(void)temp;
+	}
+}
+void stm32_h7xx_otghs2::arm_out_ep(const uint8_t ep_addr)
+{
+	if(is_iso_out_ep(ep_addr))
+	{
+		get_ep_out(ep_addr)->DOEPCTL |= (USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_EPENA | get_next_frame_parity());
+	}
+	else
+	{
+		get_ep_out(ep_addr)->DOEPCTL |= (USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_EPENA);
+	}
+}
 int stm32_h7xx_otghs2::ep_read(const uint8_t ep, uint8_t* const buf, const uint16_t max_len)
 {
 	//no data
@@ -921,6 +1135,24 @@ uint16_t stm32_h7xx_otghs2::get_frame_number()
 {
 	return _FLD2VAL(USB_OTG_DSTS_FNSOF, OTGD->DSTS);
 }
+size_t stm32_h7xx_otghs2::get_serial_number(uint8_t* const buf, const size_t maxlen)
+{
+	//UID_BASE holds 3 words, copy them out LSB first
+	const volatile uint32_t* const uid = reinterpret_cast<const volatile uint32_t*>(UID_BASE);
+
+	size_t len = 0;
+	for(size_t i = 0; i < 3; i++)
+	{
+		const uint32_t word = uid[i];
+		for(size_t j = 0; (j < 4) && (len < maxlen); j++)
+		{
+			buf[len] = static_cast<uint8_t>((word >> (8 * j)) & 0xFF);
+			len++;
+		}
+	}
+
+	return len;
+}
 
 USB_common::USB_SPEED stm32_h7xx_otghs2::get_speed() const
 {
@@ -943,6 +1175,87 @@ USB_common::USB_SPEED stm32_h7xx_otghs2::get_speed() const
 	}
 }
 
+bool stm32_h7xx_otghs2::set_test_mode(const uint8_t selector)
+{
+	if((selector < 1) || (selector > 5))
+	{
+		return false;
+	}
+
+	OTGD->DCTL = (OTGD->DCTL & ~USB_OTG_DCTL_TCTL) | _VAL2FLD(USB_OTG_DCTL_TCTL, selector);
+
+	return true;
+}
+
+bool stm32_h7xx_otghs2::remote_wakeup()
+{
+	if(m_l1_active)
+	{
+		//the host says in the LPM token if we may wake it
+		if((OTG->GLPMCFG & USB_OTG_GLPMCFG_REMWAKE) == 0)
+		{
+			return false;
+		}
+
+		//the core times the L1 resume itself, RWUSIG is cleared on WKUINT
+		Register_util::set_bits(&OTGD->DCTL, USB_OTG_DCTL_RWUSIG);
+		return true;
+	}
+
+	if((OTGD->DSTS & USB_OTG_DSTS_SUSPSTS) == 0)
+	{
+		return false;
+	}
+
+	//the core needs its clock to signal
+	Register_util::clear_bits(OTGPCTL, USB_OTG_PCGCCTL_STOPCLK | USB_OTG_PCGCCTL_GATECLK);
+
+	//resume signaling for 1-15 ms, USB_core calls remote_wakeup_end
+	Register_util::set_bits(&OTGD->DCTL, USB_OTG_DCTL_RWUSIG);
+
+	return true;
+}
+
+void stm32_h7xx_otghs2::remote_wakeup_end()
+{
+	Register_util::clear_bits(&OTGD->DCTL, USB_OTG_DCTL_RWUSIG);
+}
+
+bool stm32_h7xx_otghs2::set_phy_clock_gate(const bool gate)
+{
+	if(gate)
+	{
+		if((OTGD->DSTS & USB_OTG_DSTS_SUSPSTS) == 0)
+		{
+			return false;
+		}
+
+		Register_util::set_bits(OTGPCTL, USB_OTG_PCGCCTL_STOPCLK | USB_OTG_PCGCCTL_GATECLK);
+	}
+	else
+	{
+		Register_util::clear_bits(OTGPCTL, USB_OTG_PCGCCTL_STOPCLK | USB_OTG_PCGCCTL_GATECLK);
+	}
+
+	return true;
+}
+
+bool stm32_h7xx_otghs2::set_lpm_enable(const bool enable)
+{
+	if(enable)
+	{
+		Register_util::set_bits(&OTG->GLPMCFG, USB_OTG_GLPMCFG_LPMEN | USB_OTG_GLPMCFG_LPMACK | USB_OTG_GLPMCFG_ENBESL);
+		Register_util::set_bits(&OTG->GINTMSK, USB_OTG_GINTMSK_LPMINTM);
+	}
+	else
+	{
+		Register_util::clear_bits(&OTG->GINTMSK, USB_OTG_GINTMSK_LPMINTM);
+		Register_util::clear_bits(&OTG->GLPMCFG, USB_OTG_GLPMCFG_LPMEN | USB_OTG_GLPMCFG_LPMACK | USB_OTG_GLPMCFG_ENBESL);
+	}
+
+	return true;
+}
+
 void stm32_h7xx_otghs2::poll(const USB_common::Event_callback& func)
 {
 	const uint32_t GINTSTS = OTG->GINTSTS;
@@ -1009,6 +1322,7 @@ void stm32_h7xx_otghs2::poll(const USB_common::Event_callback& func)
 
 		OTG->GINTSTS = USB_OTG_GINTSTS_USBRST;
 
+		m_l1_active = false;
 		handle_reset_done();
 
 		USB_common::USB_EVENTS event = USB_common::USB_EVENTS::RESET;
@@ -1051,9 +1365,38 @@ void stm32_h7xx_otghs2::poll(const USB_common::Event_callback& func)
 
 			OTG->GINTSTS = USB_OTG_GINTSTS_USBSUSP;
 
+			//L2 from here on, even if we were in L1
+			m_l1_active = false;
+
 			USB_common::USB_EVENTS event = USB_common::USB_EVENTS::SUSPEND;
 			func(event, 0);
 		}
+		if(GINTSTS & USB_OTG_GINTSTS_LPMINT)
+		{
+			logger->log(freertos_util::logging::LOG_LEVEL::INFO, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_LPMINT");
+
+			OTG->GINTSTS = USB_OTG_GINTSTS_LPMINT;
+
+			//suspend is only ever reported by USBSUSP
+			m_l1_active = true;
+
+			USB_common::USB_EVENTS event = USB_common::USB_EVENTS::L1_SLEEP;
+			func(event, 0);
+		}
+		if(GINTSTS & USB_OTG_GINTSTS_WKUINT)
+		{
+			logger->log(freertos_util::logging::LOG_LEVEL::INFO, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_WKUINT");
+
+			//clocks back on before anything else, then end our resume signaling, if any
+			Register_util::clear_bits(OTGPCTL, USB_OTG_PCGCCTL_STOPCLK | USB_OTG_PCGCCTL_GATECLK);
+			Register_util::clear_bits(&OTGD->DCTL, USB_OTG_DCTL_RWUSIG);
+			m_l1_active = false;
+
+			OTG->GINTSTS = USB_OTG_GINTSTS_WKUINT;
+
+			USB_common::USB_EVENTS event = USB_common::USB_EVENTS::WAKEUP;
+			func(event, 0);
+		}
 
 		//check for io
 
@@ -1067,6 +1410,18 @@ void stm32_h7xx_otghs2::poll(const USB_common::Event_callback& func)
 			}
 		}
 		
+		if(GINTSTS & USB_OTG_GINTSTS_IISOIXFR)
+		{
+			logger->log(freertos_util::logging::LOG_LEVEL::TRACE, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_IISOIXFR");
+
+			OTG->GINTSTS = USB_OTG_GINTSTS_IISOIXFR;
+
+			if(!handle_incomplete_iso_in(func))
+			{
+				logger->log(freertos_util::logging::LOG_LEVEL::ERROR, "stm32_h7xx_otghs2", "handle_incomplete_iso_in had an error");
+			}
+		}
+
 		if(GINTSTS & USB_OTG_GINTSTS_OEPINT)
 		{
 			logger->log(freertos_util::logging::LOG_LEVEL::TRACE, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_OEPINT");
@@ -1117,47 +1472,128 @@ void stm32_h7xx_otghs2::poll(const USB_common::Event_callback& func)
 						{
 							//get active buffer
 							Buffer_adapter_base* curr_buf = m_rx_buffer->get_buffer(ep_num);
+							if(curr_buf == nullptr)
+							{
+								//the ep is NAKed with no buffer, but a packet was already in flight
+								logger->log(freertos_util::logging::LOG_LEVEL::WARN, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL no rx buffer, drop");
+								ep_discard(BCNT);
+								m_rx_flow.on_drop(ep_num);
+								break;
+							}
 
 							//read data from core's fifo into buffer
 							curr_buf->reset();
 							curr_buf->resize(BCNT);
 							ep_read(ep_num, curr_buf->data(), BCNT);
 
-							//enqueue buffer so the application thread can be notified and read it
-							if(m_rx_buffer->poll_enqueue_buffer(ep_num, curr_buf))
+							for(size_t i = 0; i < BCNT; i++)
 							{
-								logger->log(freertos_util::logging::LOG_LEVEL::TRACE, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL PKTSTS 2 rx buffer poll_enqueue_buffer ok");
+								logger->log(freertos_util::logging::LOG_LEVEL::TRACE, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL %02X ", curr_buf->data()[i]);
 							}
-							else
+
+							//get the next buffer first, so the flow control policy can decide what happens to this one
+							Buffer_adapter_base* new_buf = m_rx_buffer->poll_allocate_buffer(ep_num);
+							bool enqueue = true;
+							bool hold    = false;
+							Rx_flow_control::POLICY policy = Rx_flow_control::POLICY::NAK;
+							if(new_buf == nullptr)
 							{
-								logger->log(freertos_util::logging::LOG_LEVEL::ERROR, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL PKTSTS 2 rx buffer poll_enqueue_buffer fail");
+								//OUT buffer underrun
+								logger->log(freertos_util::logging::LOG_LEVEL::TRACE, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL rx buffer underrun");
+
+								policy = m_rx_flow.on_underrun(ep_num);
+								switch(policy)
+								{
+									case Rx_flow_control::POLICY::DROP_OLDEST:
+									{
+										//take back the oldest packet the app has not read yet
+										new_buf = m_rx_buffer->poll_dequeue_buffer_isr(ep_num);
+										if(new_buf)
+										{
+											m_rx_flow.on_reclaimed(ep_num);
+										}
+										else
+										{
+											//everything is held by the app, nothing to reclaim
+											new_buf = curr_buf;
+											enqueue = false;
+											m_rx_flow.on_drop(ep_num);
+										}
+										break;
+									}
+									case Rx_flow_control::POLICY::DROP_NEWEST:
+									{
+										new_buf = curr_buf;
+										enqueue = false;
+										m_rx_flow.on_drop(ep_num);
+										break;
+									}
+									case Rx_flow_control::POLICY::NAK:
+									case Rx_flow_control::POLICY::BLOCK:
+									default:
+									{
+										//we will need to cnak and epena when the app frees a buffer
+										break;
+									}
+								}
 							}
 
-							for(size_t i = 0; i < BCNT; i++)
+							//enqueue buffer so the application thread can be notified and read it
+							if(enqueue)
 							{
-								logger->log(freertos_util::logging::LOG_LEVEL::TRACE, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL %02X ", curr_buf->data()[i]);
+								if(m_rx_buffer->poll_enqueue_buffer(ep_num, curr_buf))
+								{
+									logger->log(freertos_util::logging::LOG_LEVEL::TRACE, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL PKTSTS 2 rx buffer poll_enqueue_buffer ok");
+
+									hold = m_rx_flow.on_queued(ep_num);
+
+									//lets the core route the packet to the function owning this ep
+									//only if a function or callback takes it, and once until the core handles it
+									if(claim_ep_rx_event(ep_num))
+									{
+										func(USB_common::USB_EVENTS::EP_RX, ep_num);
+									}
+								}
+								else
+								{
+									logger->log(freertos_util::logging::LOG_LEVEL::ERROR, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL PKTSTS 2 rx buffer poll_enqueue_buffer fail");
+
+									//keep the buffer rather than lose it
+									m_rx_flow.on_drop(ep_num);
+									if(new_buf)
+									{
+										m_rx_buffer->release_buffer_isr(ep_num, new_buf);
+									}
+									new_buf = curr_buf;
+								}
 							}
 
-							//try to get a new buffer
-							Buffer_adapter_base* new_buf = m_rx_buffer->poll_allocate_buffer(ep_num);
 							//update the active buffer
 							if(new_buf)
 							{
 								new_buf->reset();
 								m_rx_buffer->set_buffer(ep_num, new_buf);
-								get_ep_out(ep_num)->DOEPCTL |= (USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_EPENA);
+								if(hold)
+								{
+									//app is behind, NAK this ep only until it catches up
+									get_ep_out(ep_num)->DOEPCTL |= (USB_OTG_DOEPCTL_SNAK);
+								}
+								else
+								{
+									arm_out_ep(ep_num);
+								}
 							}
 							else
 							{
-								//OUT buffer underrun
-								//we will need to cnak and epena when the app frees a buffer
-								logger->log(freertos_util::logging::LOG_LEVEL::TRACE, "stm32_h7xx_otghs2", "USB_OTG_GINTSTS_RXFLVL rx buffer underrun");
-								
 								m_rx_buffer->set_buffer(ep_num, nullptr);
 								get_ep_out(ep_num)->DOEPCTL |= (USB_OTG_DOEPCTL_SNAK);
 
-								//if no curr_buf, mask USB_OTG_GINTSTS_RXFLVL
-								Register_util::clear_bits(&OTG->GINTMSK, USB_OTG_GINTSTS_RXFLVL);
+								if(policy == Rx_flow_control::POLICY::BLOCK)
+								{
+									//if no curr_buf, mask USB_OTG_GINTSTS_RXFLVL
+									//this holds off every OUT ep, and ep0, until the app frees a buffer
+									Register_util::clear_bits(&OTG->GINTMSK, USB_OTG_GINTSTS_RXFLVL);
+								}
 							}
 						}
 						else
@@ -1298,22 +1734,24 @@ const usb_driver_base::ep_cfg& stm32_h7xx_otghs2::get_ep0_config() const
 }
 bool stm32_h7xx_otghs2::get_rx_ep_config(const uint8_t addr, ep_cfg* const out_ep)
 {
-	if(addr > MAX_NUM_EP)
+	const uint8_t ep_addr = USB_common::get_ep_addr(addr);
+	if((ep_addr == 0) || (ep_addr > MAX_NUM_EP))
 	{
 		return false;
 	}
 
-	*out_ep = m_tx_ep_cfg[addr - 1];
+	*out_ep = m_rx_ep_cfg[ep_addr - 1];
 	return true;
 }
 bool stm32_h7xx_otghs2::get_tx_ep_config(const uint8_t addr, ep_cfg* const out_ep)
 {
-	if(addr > MAX_NUM_EP)
+	const uint8_t ep_addr = USB_common::get_ep_addr(addr);
+	if((ep_addr == 0) || (ep_addr > MAX_NUM_EP))
 	{
 		return false;
 	}
 	
-	*out_ep = m_tx_ep_cfg[addr - 1];
+	*out_ep = m_tx_ep_cfg[ep_addr - 1];
 	return true;
 }
 
@@ -1334,23 +1772,34 @@ void stm32_h7xx_otghs2::release_rx_buffer(const uint8_t ep_num, Buffer_adapter_b
 
 	m_rx_buffer->release_buffer(ep_addr, buf);
 
-	//TODO: we may need to mask usb isr here
-	//it might be safe for now, since we only do this if the ep has no loaded OUT buffer
-	//which means that NAK is set
+	const bool resume = m_rx_flow.on_released(ep_addr);
+
+	//the ep has no loaded OUT buffer, or is held by the flow control watermark
+	//either way NAK is set
 	if(m_rx_buffer->get_buffer(ep_addr) == nullptr)
 	{
 		//clear a OUT nak, since we have a new buffer to read to
 
 		Buffer_adapter_base* act_buf = m_rx_buffer->poll_allocate_buffer(ep_addr);
-		
+		if(act_buf == nullptr)
+		{
+			//another ep took it
+			return;
+		}
+
+		act_buf->reset();
 		m_rx_buffer->set_buffer(ep_addr, act_buf);
 
 		//clear the NAK, enable EP
-		get_ep_out(ep_num)->DOEPCTL |= (USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_EPENA);
+		arm_out_ep(ep_addr);
 
 		//enable the RXFLVL ISR
 		Register_util::set_bits(&OTG->GINTMSK, USB_OTG_GINTSTS_RXFLVL);
 	}
+	else if(resume)
+	{
+		arm_out_ep(ep_addr);
+	}
 }
 
 //application wait for usable tx buffer
@@ -1362,22 +1811,29 @@ Buffer_adapter_base* stm32_h7xx_otghs2::wait_tx_buffer(const uint8_t ep_num)
 }
 //application give buffer to driver for transmission
 bool stm32_h7xx_otghs2::enqueue_tx_buffer(const uint8_t ep_num, Buffer_adapter_base* const buf)
+{
+	return enqueue_tx_buffer(ep_num, buf, nullptr);
+}
+bool stm32_h7xx_otghs2::enqueue_tx_buffer(const uint8_t ep_num, Buffer_adapter_base* const buf, Tx_token* const token)
 {
 	const uint8_t ep_addr = USB_common::get_ep_addr(ep_num);
 
+	if(token)
+	{
+		if((ep_addr >= m_tx_tokens.size()) || token->is_pending())
+		{
+			return false;
+		}
+	}
+
 	Scoped_ISR_Mask otg_mask(OTG_HS_IRQn);
 
 	//TODO: we may need to mask usb isr here
 	//it might be safe for now, since we only do this if the ep has no loaded IN buffer
 	//which means that NAK is set
 
-	if(m_tx_buffer->get_buffer(ep_addr) == nullptr)
-	{
-		m_tx_buffer->set_buffer(ep_addr, buf);
-
-		ep_write(ep_num, buf->data(), buf->size());
-	}
-	else
+	const bool load = (m_tx_buffer->get_buffer(ep_addr) == nullptr);
+	if(!load)
 	{
 		if(!m_tx_buffer->poll_enqueue_buffer(ep_addr, buf))
 		{
@@ -1386,6 +1842,21 @@ bool stm32_h7xx_otghs2::enqueue_tx_buffer(const uint8_t ep_num, Buffer_adapter_b
 		}
 	}
 
+	//queue the token before the fifo is loaded, the isr is masked so XFRC can not beat it
+	if(token)
+	{
+		token->queue(ep_addr, buf, get_tx_timestamp());
+		m_tx_tokens[ep_addr].push(token);
+	}
+
+	if(load)
+	{
+		m_tx_buffer->set_buffer(ep_addr, buf);
+
+		tx_token_started(ep_addr, buf);
+		ep_write(ep_num, buf->data(), buf->size());
+	}
+
 	return true;
 }
 
@@ -1398,7 +1869,6 @@ bool stm32_h7xx_otghs2::handle_iepintx(const USB_common::Event_callback& func)
 		return true;
 	}
 
-	USB_common::USB_EVENTS event = USB_common::USB_EVENTS::NONE;
 	const uint8_t ep_num = __builtin_ctz(IEPINT);
 
 	volatile USB_OTG_INEndpointTypeDef* epin = get_ep_in(ep_num);
@@ -1472,6 +1942,7 @@ bool stm32_h7xx_otghs2::handle_iepintx(const USB_common::Event_callback& func)
 			Buffer_adapter_base* const curr_tx_buf = m_tx_buffer->get_buffer(ep_num);
 			if(curr_tx_buf)
 			{
+				tx_token_finished(ep_num, curr_tx_buf, Tx_token::STATE::DONE);
 				m_tx_buffer->release_buffer(ep_num, curr_tx_buf);
 			}
 		}
@@ -1481,6 +1952,7 @@ bool stm32_h7xx_otghs2::handle_iepintx(const USB_common::Event_callback& func)
 		if(new_tx_buf)
 		{
 			m_tx_buffer->set_buffer(ep_num, new_tx_buf);
+			tx_token_started(ep_num, new_tx_buf);
 			ep_write(0x80 | ep_num, new_tx_buf->data(), new_tx_buf->size());
 		}
 		else
@@ -1489,10 +1961,8 @@ bool stm32_h7xx_otghs2::handle_iepintx(const USB_common::Event_callback& func)
 			get_ep_in(ep_num)->DIEPCTL |= (USB_OTG_DOEPCTL_SNAK);
 		}
 
-		if(ep_num == 0)
-		{
-			func(USB_common::USB_EVENTS::EP_TX, 0x80 | ep_num);
-		}
+		//class drivers use EP_TX to reload IN eps, eg HID keeps the next report loaded
+		func(USB_common::USB_EVENTS::EP_TX, 0x80 | ep_num);
 	}
 	else
 	{
@@ -1503,6 +1973,70 @@ bool stm32_h7xx_otghs2::handle_iepintx(const USB_common::Event_callback& func)
 	return true;
 }
 
+//the host skipped an iso IN ep in the last (micro)frame, so the loaded packet now has the wrong parity
+//drop it and report it as sent so the class loads fresh data for the next one
+bool stm32_h7xx_otghs2::handle_incomplete_iso_in(const USB_common::Event_callback& func)
+{
+	for(uint8_t ep_num = 1; ep_num <= MAX_NUM_EP; ep_num++)
+	{
+		if(!is_iso_in_ep(ep_num))
+		{
+			continue;
+		}
+
+		volatile USB_OTG_INEndpointTypeDef* const epin = get_ep_in(ep_num);
+		if((epin->DIEPCTL & USB_OTG_DIEPCTL_EPENA) == 0)
+		{
+			continue;
+		}
+
+		Register_util::set_bits(&epin->DIEPCTL, USB_OTG_DIEPCTL_SNAK | USB_OTG_DIEPCTL_EPDIS);
+		Register_util::wait_until_set(&epin->DIEPINT, USB_OTG_DIEPINT_EPDISD);
+		epin->DIEPINT = USB_OTG_DIEPINT_EPDISD;
+
+		flush_tx(ep_num);
+
+		Buffer_adapter_base* const curr_tx_buf = m_tx_buffer->get_buffer(ep_num);
+		if(curr_tx_buf)
+		{
+			tx_token_finished(ep_num, curr_tx_buf, Tx_token::STATE::ABORTED);
+			m_tx_buffer->release_buffer(ep_num, curr_tx_buf);
+		}
+
+		Buffer_adapter_base* const new_tx_buf = m_tx_buffer->poll_dequeue_buffer(ep_num);
+		if(new_tx_buf)
+		{
+			m_tx_buffer->set_buffer(ep_num, new_tx_buf);
+			tx_token_started(ep_num, new_tx_buf);
+			ep_write(0x80 | ep_num, new_tx_buf->data(), new_tx_buf->size());
+		}
+		else
+		{
+			m_tx_buffer->set_buffer(ep_num, nullptr);
+		}
+
+		func(USB_common::USB_EVENTS::EP_TX, 0x80 | ep_num);
+	}
+
+	return true;
+}
+
+uint32_t stm32_h7xx_otghs2::get_next_frame_parity()
+{
+	//DIEPCTL and DOEPCTL share bit positions
+	return (get_frame_number() & 0x01) ? USB_OTG_DIEPCTL_SD0PID_SEVNFRM : USB_OTG_DIEPCTL_SODDFRM;
+}
+
+bool stm32_h7xx_otghs2::is_iso_in_ep(const uint8_t ep_addr)
+{
+	return _FLD2VAL(USB_OTG_DIEPCTL_EPTYP, get_ep_in(ep_addr)->DIEPCTL) == 0x01;
+}
+
+bool stm32_h7xx_otghs2::is_iso_out_ep(const uint8_t ep_addr)
+{
+	return _FLD2VAL(USB_OTG_DOEPCTL_EPTYP, get_ep_out(ep_addr)->DOEPCTL) == 0x01;
+}
+
 bool stm32_h7xx_otghs2::handle_oepintx(const USB_common::Event_callback& func)
 {
 	const uint32_t OEPINT = _FLD2VAL(USB_OTG_DAINT_OEPINT, OTGD->DAINT);
@@ -1512,7 +2046,6 @@ bool stm32_h7xx_otghs2::handle_oepintx(const USB_common::Event_callback& func)
 		return true;
 	}
 
-	USB_common::USB_EVENTS event = USB_common::USB_EVENTS::NONE;
 	const uint8_t ep_num = __builtin_ctz(OEPINT);
 
 	volatile USB_OTG_OUTEndpointTypeDef* epout = get_ep_out(ep_num);
@@ -1622,11 +2155,14 @@ bool stm32_h7xx_otghs2::handle_reset_done()
 	for(uint8_t i = 0; i <= MAX_NUM_EP; i++)
 	{
 		ep_unconfig(i);
+		ep_unconfig(0x80 | i);
 	}
 
 	flush_rx();
 	flush_all_tx();
 
+	m_rx_flow.reset_all();
+
 	Register_util::set_bits(&OTG->GINTMSK, USB_OTG_GINTMSK_OEPINT | USB_OTG_GINTMSK_IEPINT);
 	OTGD->DAINTMSK = _VAL2FLD(USB_OTG_DAINTMSK_IEPM, 0x0001) | _VAL2FLD(USB_OTG_DAINTMSK_OEPM, 0x0001);
 	OTGD->DOEPMSK  = USB_OTG_DOEPMSK_STUPM | USB_OTG_DOEPINT_OTEPSPR | USB_OTG_DOEPINT_STUP | USB_OTG_DOEPMSK_XFRCM;
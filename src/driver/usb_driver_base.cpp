@@ -6,31 +6,122 @@
 
 #include "libusb_dev_cpp/driver/usb_driver_base.hpp"
 
+#include <algorithm>
+#include <array>
+
 usb_driver_base::usb_driver_base()
 {
 	m_event_callbacks.fill(nullptr);
-	m_ep_rx_callbacks.fill(nullptr);
-	m_ep_tx_callbacks.fill(nullptr);
-	m_ep_setup_callbacks.fill(nullptr);
+	for(EP_callbacks& cb : m_ep_callbacks)
+	{
+		cb.rx    = nullptr;
+		cb.tx    = nullptr;
+		cb.setup = nullptr;
+
+		cb.rx_event_enable  = false;
+		cb.rx_event_pending = false;
+	}
+
+	m_ep0_buffer = nullptr;
+	m_tx_buffer = nullptr;
+	m_rx_buffer = nullptr;
+
+	m_tx_timestamp_callback_func = nullptr;
+	m_tx_timestamp_callback_ctx  = nullptr;
 }
 
 bool usb_driver_base::set_ep_rx_callback(const uint8_t ep_addr, const USB_common::Event_callback& func)
 {
-	m_ep_rx_callbacks[ep_addr] = func;
+	m_ep_callbacks[ep_addr].rx = func;
+
+	if(ep_addr != 0)
+	{
+		set_ep_rx_event_enable(ep_addr, bool(func));
+	}
 
 	return true;
 }
 
 bool usb_driver_base::set_ep_tx_callback(const uint8_t ep_addr, const USB_common::Event_callback& func)
 {
-	m_ep_tx_callbacks[ep_addr] = func;
+	m_ep_callbacks[ep_addr].tx = func;
 
 	return true;
 }
 
 bool usb_driver_base::set_ep_setup_callback(const uint8_t ep_addr, const USB_common::Event_callback& func)
 {
-	m_ep_setup_callbacks[ep_addr] = func;
+	m_ep_callbacks[ep_addr].setup = func;
+
+	return true;
+}
+
+void usb_driver_base::set_ep_rx_event_enable(const uint8_t ep_addr, const bool enable)
+{
+	if(ep_addr >= m_ep_callbacks.size())
+	{
+		return;
+	}
+
+	m_ep_callbacks[ep_addr].rx_event_enable.store(enable);
+}
+
+bool usb_driver_base::claim_ep_rx_event(const uint8_t ep_addr)
+{
+	if(ep_addr >= m_ep_callbacks.size())
+	{
+		return false;
+	}
+
+	EP_callbacks& cb = m_ep_callbacks[ep_addr];
+	if(!cb.rx_event_enable.load())
+	{
+		return false;
+	}
+
+	return !cb.rx_event_pending.exchange(true);
+}
+
+void usb_driver_base::clear_ep_rx_event(const uint8_t ep_addr)
+{
+	if(ep_addr >= m_ep_callbacks.size())
+	{
+		return;
+	}
+
+	m_ep_callbacks[ep_addr].rx_event_pending.store(false);
+}
+
+size_t usb_driver_base::get_serial_number_string(char* const buf, const size_t maxlen)
+{
+	static constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+
+	std::array<uint8_t, 32> sn;
+	const size_t sn_len = get_serial_number(sn.data(), std::min(sn.size(), maxlen / 2));
+
+	for(size_t i = 0; i < sn_len; i++)
+	{
+		buf[2*i + 0] = HEX_DIGITS[(sn[i] >> 4) & 0x0F];
+		buf[2*i + 1] = HEX_DIGITS[sn[i] & 0x0F];
+	}
+
+	return 2 * sn_len;
+}
+
+bool usb_driver_base::is_tx_idle()
+{
+	if(m_tx_buffer == nullptr)
+	{
+		return true;
+	}
+
+	for(size_t i = 0; i < m_tx_buffer->get_num_ep(); i++)
+	{
+		if(m_tx_buffer->get_buffer(i) != nullptr)
+		{
+			return false;
+		}
+	}
 
 	return true;
 }
@@ -44,3 +135,53 @@ bool usb_driver_base::handle_enum_done()
 {
 	return true;
 }
+
+bool usb_driver_base::enqueue_tx_buffer(const uint8_t ep, Buffer_adapter_base* const buf, Tx_token* const token)
+{
+	if(token)
+	{
+		return false;
+	}
+
+	return enqueue_tx_buffer(ep, buf);
+}
+
+uint32_t usb_driver_base::get_tx_timestamp()
+{
+	if(m_tx_timestamp_callback_func)
+	{
+		return m_tx_timestamp_callback_func(m_tx_timestamp_callback_ctx);
+	}
+
+	return get_frame_number();
+}
+
+void usb_driver_base::tx_token_started(const uint8_t ep_addr, const Buffer_adapter_base* const buf)
+{
+	if((ep_addr >= m_tx_tokens.size()) || m_tx_tokens[ep_addr].empty())
+	{
+		return;
+	}
+
+	m_tx_tokens[ep_addr].on_started(buf, get_tx_timestamp());
+}
+
+void usb_driver_base::tx_token_finished(const uint8_t ep_addr, const Buffer_adapter_base* const buf, const Tx_token::STATE state)
+{
+	if((ep_addr >= m_tx_tokens.size()) || m_tx_tokens[ep_addr].empty())
+	{
+		return;
+	}
+
+	m_tx_tokens[ep_addr].on_finished(buf, state, get_tx_timestamp());
+}
+
+void usb_driver_base::tx_token_abort(const uint8_t ep_addr)
+{
+	if((ep_addr >= m_tx_tokens.size()) || m_tx_tokens[ep_addr].empty())
+	{
+		return;
+	}
+
+	m_tx_tokens[ep_addr].abort_all(get_tx_timestamp());
+}
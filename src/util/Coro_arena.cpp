@@ -0,0 +1,9 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/util/Coro_arena.hpp"
+
+Coro_arena_base* Coro_arena_base::m_default = nullptr;
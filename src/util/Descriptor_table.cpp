@@ -5,3 +5,246 @@
 */
 
 #include "libusb_dev_cpp/util/Descriptor_table.hpp"
+
+#include "freertos_cpp_util/logging/Global_logger.hpp"
+
+#include <vector>
+
+using freertos_util::logging::Global_logger;
+using freertos_util::logging::LOG_LEVEL;
+
+namespace
+{
+	//serialize a descriptor and, for configurations and BOS, its children
+	bool serialize_tree(const Descriptor_base& desc, const Intrusive_list* const children, const size_t total_size, const USB_common::USB_SPEED speed, std::vector<uint8_t>* const out)
+	{
+		out->resize(total_size);
+
+		Buffer_adapter_tx buf;
+		buf.reset(out->data(), out->size());
+
+		if(!desc.serialize(&buf))
+		{
+			return false;
+		}
+
+		if(children)
+		{
+			Descriptor_base const * desc_node = children->front<Descriptor_base>();
+			while(desc_node)
+			{
+				if(!desc_node->serialize_for_speed(&buf, speed))
+				{
+					return false;
+				}
+
+				desc_node = desc_node->next<Descriptor_base>();
+			}
+		}
+
+		out->resize(buf.size());
+
+		return true;
+	}
+}
+
+bool Descriptor_table::build_flat_table()
+{
+	m_flat_table.clear();
+
+	std::vector<uint8_t> scratch;
+	bool ret = true;
+
+	if(m_dev_desc)
+	{
+		ret = ret && serialize_tree(*m_dev_desc, nullptr, m_dev_desc->size(), USB_common::USB_SPEED::FS, &scratch);
+		ret = ret && m_flat_table.add(static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::DEVICE), 0, 0, scratch.data(), scratch.size());
+	}
+
+	if(m_dev_qual_desc)
+	{
+		ret = ret && serialize_tree(*m_dev_qual_desc, nullptr, m_dev_qual_desc->size(), USB_common::USB_SPEED::FS, &scratch);
+		ret = ret && m_flat_table.add(static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::DEVICE_QUALIFIER), 0, 0, scratch.data(), scratch.size());
+	}
+
+	if(m_bos_desc)
+	{
+		ret = ret && serialize_tree(*m_bos_desc, &m_bos_desc->get_desc_list(), m_bos_desc->get_total_size(), USB_common::USB_SPEED::FS, &scratch);
+		ret = ret && m_flat_table.add(static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::BOS), 0, 0, scratch.data(), scratch.size());
+	}
+
+	//FS is always stored, HS only if the ep sizes differ, lookups for HS fall back to FS
+	m_config_table.for_each(
+		[this, &scratch, &ret](const uint8_t idx, const Config_desc_table::Config_desc_const_ptr& desc)
+		{
+			const uint8_t type = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CONFIGURATION);
+
+			ret = ret && serialize_tree(*desc, &desc->get_desc_list(), desc->get_total_size(), USB_common::USB_SPEED::FS, &scratch);
+			ret = ret && m_flat_table.add(type, idx, static_cast<uint16_t>(USB_common::USB_SPEED::FS), scratch.data(), scratch.size());
+
+			std::vector<uint8_t> hs_scratch;
+			ret = ret && serialize_tree(*desc, &desc->get_desc_list(), desc->get_total_size(), USB_common::USB_SPEED::HS, &hs_scratch);
+			if(ret && (hs_scratch != scratch))
+			{
+				ret = m_flat_table.add(type, idx, static_cast<uint16_t>(USB_common::USB_SPEED::HS), hs_scratch.data(), hs_scratch.size());
+			}
+		}
+	);
+
+	for(const auto& lang_table : m_string_table.m_table)
+	{
+		const uint16_t lang = static_cast<uint16_t>(lang_table.first);
+
+		lang_table.second.for_each(
+			[this, &scratch, &ret, lang](const uint8_t idx, const String_desc_table::String_desc_const_ptr& desc)
+			{
+				//generated on first request, the core falls back to the object
+				if(desc->is_dynamic())
+				{
+					return;
+				}
+
+				ret = ret && serialize_tree(*desc, nullptr, desc->size(), USB_common::USB_SPEED::FS, &scratch);
+				ret = ret && m_flat_table.add(static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::STRING), idx, lang, scratch.data(), scratch.size());
+			}
+		);
+	}
+
+	//generated LANGID list, unless the app set its own string zero
+	if(m_lang_zero)
+	{
+		const String_desc_table* const none_table = m_string_table.get_table(String_descriptor_zero::LANGID::NONE);
+		if(!none_table || !none_table->get_config(0))
+		{
+			ret = ret && serialize_tree(*m_lang_zero, nullptr, m_lang_zero->size(), USB_common::USB_SPEED::FS, &scratch);
+			ret = ret && m_flat_table.add(static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::STRING), 0, 0, scratch.data(), scratch.size());
+		}
+	}
+
+	if(!ret)
+	{
+		Global_logger::get()->log(LOG_LEVEL::ERROR, "Descriptor_table", "build_flat_table failed");
+		m_flat_table.clear();
+		return false;
+	}
+
+	m_flat_table.finalize();
+
+	Global_logger::get()->log(LOG_LEVEL::INFO, "Descriptor_table", "build_flat_table %u entries, %u bytes", m_flat_table.get_num_entries(), m_flat_table.get_heap_size());
+
+	return true;
+}
+
+bool Descriptor_table::get_configuration_bytes(const uint8_t bConfigurationValue, const USB_common::USB_SPEED speed, std::vector<uint8_t>* const out) const
+{
+	//configurations are stored by index, bConfigurationValue is at offset 5
+	constexpr size_t CONFIG_VALUE_OFFSET = 5;
+
+	const uint8_t type = static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::CONFIGURATION);
+
+	bool found = false;
+	m_flat_table.for_each(type,
+		[this, bConfigurationValue, speed, type, out, &found](const uint8_t idx, const uint16_t qual, const uint8_t* const ptr, const size_t len)
+		{
+			if(found)
+			{
+				return;
+			}
+
+			//HS is only stored when it differs from FS, the FS entry stands in for it
+			if(qual != static_cast<uint16_t>(speed))
+			{
+				if(qual != static_cast<uint16_t>(USB_common::USB_SPEED::FS))
+				{
+					return;
+				}
+
+				const uint8_t* speed_ptr = nullptr;
+				size_t speed_len = 0;
+				if(m_flat_table.find(type, idx, static_cast<uint16_t>(speed), &speed_ptr, &speed_len))
+				{
+					return;
+				}
+			}
+
+			if((len > CONFIG_VALUE_OFFSET) && (ptr[CONFIG_VALUE_OFFSET] == bConfigurationValue))
+			{
+				out->assign(ptr, ptr + len);
+				found = true;
+			}
+		}
+	);
+
+	if(found)
+	{
+		return true;
+	}
+
+	bool ret = false;
+	m_config_table.for_each(
+		[bConfigurationValue, speed, out, &found, &ret](const uint8_t idx, const Config_desc_table::Config_desc_const_ptr& desc)
+		{
+			if(found || (desc->bConfigurationValue != bConfigurationValue))
+			{
+				return;
+			}
+
+			found = true;
+			ret = serialize_tree(*desc, &desc->get_desc_list(), desc->get_total_size(), speed, out);
+		}
+	);
+
+	return ret;
+}
+
+void Descriptor_table::release_object_tables()
+{
+	m_dev_desc.reset();
+	m_dev_qual_desc.reset();
+	m_bos_desc.reset();
+
+	m_config_table.clear();
+	m_endpoint_table.clear();
+	m_iface_table.clear();
+	//dynamic strings are not in the flat table, keep them
+	for(auto it = m_string_table.m_table.begin(); it != m_string_table.m_table.end(); )
+	{
+		it->second.remove_if(
+			[](const uint8_t idx, const String_desc_table::String_desc_const_ptr& desc)
+			{
+				return !desc->is_dynamic();
+			}
+		);
+
+		if(it->second.empty())
+		{
+			it = m_string_table.m_table.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	m_lang_zero.reset();
+	m_langids.clear();
+
+	m_other_desc.clear();
+}
+
+void Descriptor_table::update_lang_zero()
+{
+	std::vector<String_descriptor_zero::LANGID> langids = m_string_table.get_langids();
+	if(langids.empty() || (langids == m_langids))
+	{
+		return;
+	}
+
+	m_langids.swap(langids);
+
+	if(!m_lang_zero)
+	{
+		m_lang_zero = std::make_shared<String_descriptor_zero>();
+	}
+
+	m_lang_zero->assign(m_langids.data(), m_langids.size());
+}
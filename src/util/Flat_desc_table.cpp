@@ -0,0 +1,80 @@
+/**
+ * @author Jacob Schloss <jacob.schloss@suburbanembedded.com>
+ * @copyright Copyright (c) 2020 Suburban Embedded. All rights reserved.
+ * @license Licensed under the 3-Clause BSD license. See LICENSE for details
+*/
+
+#include "libusb_dev_cpp/util/Flat_desc_table.hpp"
+
+#include <algorithm>
+
+bool Flat_desc_table::add(const uint8_t type, const uint8_t idx, const uint16_t qual, const uint8_t* const data, const size_t len)
+{
+	if(m_finalized)
+	{
+		return false;
+	}
+
+	//offsets and lengths are 16 bit, same limit as wTotalLength
+	if((m_arena.size() + len) > 0xFFFFU)
+	{
+		return false;
+	}
+
+	const uint32_t key = make_key(type, idx, qual);
+
+	auto it = std::find_if(m_index.begin(), m_index.end(), [key](const Entry& e){return e.key == key;});
+	if(it != m_index.end())
+	{
+		return false;
+	}
+
+	Entry entry;
+	entry.key    = key;
+	entry.offset = static_cast<uint16_t>(m_arena.size());
+	entry.len    = static_cast<uint16_t>(len);
+
+	m_arena.insert(m_arena.end(), data, data + len);
+	m_index.push_back(entry);
+
+	return true;
+}
+
+void Flat_desc_table::finalize()
+{
+	std::sort(m_index.begin(), m_index.end(), [](const Entry& a, const Entry& b){return a.key < b.key;});
+
+	m_arena.shrink_to_fit();
+	m_index.shrink_to_fit();
+
+	m_finalized = true;
+}
+
+void Flat_desc_table::clear()
+{
+	std::vector<uint8_t>().swap(m_arena);
+	std::vector<Entry>().swap(m_index);
+
+	m_finalized = false;
+}
+
+bool Flat_desc_table::find(const uint8_t type, const uint8_t idx, const uint16_t qual, const uint8_t** const out_ptr, size_t* const out_len) const
+{
+	if(!m_finalized)
+	{
+		return false;
+	}
+
+	const uint32_t key = make_key(type, idx, qual);
+
+	auto it = std::lower_bound(m_index.begin(), m_index.end(), key, [](const Entry& e, const uint32_t k){return e.key < k;});
+	if((it == m_index.end()) || (it->key != key))
+	{
+		return false;
+	}
+
+	*out_ptr = m_arena.data() + it->offset;
+	*out_len = it->len;
+
+	return true;
+}
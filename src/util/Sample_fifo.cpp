@@ -0,0 +1 @@
+#include "libusb_dev_cpp/util/Sample_fifo.hpp"
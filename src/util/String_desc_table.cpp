@@ -23,3 +23,19 @@ const String_desc_table* Multilang_string_desc_table::get_table(const String_des
 
 	return &(it->second);
 }
+
+std::vector<String_descriptor_zero::LANGID> Multilang_string_desc_table::get_langids() const
+{
+	std::vector<String_descriptor_zero::LANGID> langids;
+	langids.reserve(m_table.size());
+
+	for(const auto& entry : m_table)
+	{
+		if(entry.first != String_descriptor_zero::LANGID::NONE)
+		{
+			langids.push_back(entry.first);
+		}
+	}
+
+	return langids;
+}
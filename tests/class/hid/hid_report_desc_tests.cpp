@@ -0,0 +1,63 @@
+#include "libusb_dev_cpp/class/hid/hid_report_desc.hpp"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+	using namespace HID::Report;
+
+	TEST(hid_report_desc, boot_mouse)
+	{
+		typedef Report_descriptor<
+			Usage_page<USAGE_PAGE::GENERIC_DESKTOP>,
+			Usage<0x02>,
+			Collection<COLLECTION::APPLICATION>,
+				Usage<0x01>,
+				Collection<COLLECTION::PHYSICAL>,
+					Usage_page<USAGE_PAGE::BUTTON>,
+					Usage_minimum<1>,
+					Usage_maximum<3>,
+					Logical_minimum<0>,
+					Logical_maximum<1>,
+					Report_count<3>,
+					Report_size<1>,
+					Input<MAIN_FLAGS::DATA | MAIN_FLAGS::VARIABLE | MAIN_FLAGS::ABSOLUTE>,
+					Report_count<1>,
+					Report_size<5>,
+					Input<MAIN_FLAGS::CONSTANT>,
+					Usage_page<USAGE_PAGE::GENERIC_DESKTOP>,
+					Usage<0x30>,
+					Usage<0x31>,
+					Logical_minimum<-127>,
+					Logical_maximum<127>,
+					Report_size<8>,
+					Report_count<2>,
+					Input<MAIN_FLAGS::DATA | MAIN_FLAGS::VARIABLE | MAIN_FLAGS::RELATIVE>,
+				End_collection,
+			End_collection
+			> Mouse_report_desc;
+
+		const std::array<uint8_t, 50> expected = {
+			0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01,
+			0xA1, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x03,
+			0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01,
+			0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+			0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x81,
+			0x25, 0x7F, 0x75, 0x08, 0x95, 0x02, 0x81, 0x06,
+			0xC0, 0xC0
+		};
+
+		static_assert(Mouse_report_desc::size == 50);
+		EXPECT_EQ(expected, Mouse_report_desc::data);
+	}
+
+	TEST(hid_report_desc, item_sizes)
+	{
+		EXPECT_EQ(Usage_page<USAGE_PAGE::VENDOR>::size, 3U);
+		EXPECT_EQ(Logical_maximum<255>::size, 3U);
+		EXPECT_EQ(Logical_minimum<-32768>::size, 3U);
+		EXPECT_EQ(Logical_maximum<70000>::size, 5U);
+		EXPECT_EQ(Logical_maximum<70000>::prefix, 0x27);
+		EXPECT_EQ(End_collection::size, 1U);
+	}
+}
@@ -0,0 +1,215 @@
+#include "libusb_dev_cpp/class/hid/hid_usb.hpp"
+
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include "../../driver/Fake_driver.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+
+namespace
+{
+	typedef EP_buffer_mgr_lockfree<2, 2, 64, 4> Buffer_mgr;
+
+	class HID_class_test : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			tx_mgr = std::make_unique<Buffer_mgr>();
+			driver.set_tx_buffer(tx_mgr.get());
+
+			rx.reset(rx_mem.data(), rx_mem.size());
+			tx.reset(tx_mem.data(), tx_mem.size());
+
+			ASSERT_TRUE(hid.initialize(&driver, 2, 0x81));
+		}
+
+		USB_common::USB_RESP request(const uint8_t bmRequestType, const HID::HID_REQUESTS bRequest, const uint16_t wValue, const uint16_t wLength)
+		{
+			Setup_packet req;
+			req.bmRequestType = bmRequestType;
+			req.bRequest = uint8_t(bRequest);
+			req.wValue = wValue;
+			req.wIndex = 2;
+			req.wLength = wLength;
+
+			return hid.handle_class_request(&req, &rx, &tx);
+		}
+
+		std::vector<uint8_t> sent(const size_t idx)
+		{
+			Buffer_adapter_base* const buf = driver.m_sent[1][idx];
+			return std::vector<uint8_t>(buf->data(), buf->data() + buf->size());
+		}
+
+		std::unique_ptr<Buffer_mgr> tx_mgr;
+		Fake_driver driver;
+		HID_class hid;
+
+		std::array<uint8_t, 64> rx_mem;
+		std::array<uint8_t, 64> tx_mem;
+		Buffer_adapter_rx rx;
+		Buffer_adapter_tx tx;
+	};
+
+	TEST(HID_class, not_initialized)
+	{
+		HID_class hid;
+
+		const uint8_t report[] = {1, 2, 3};
+		EXPECT_FALSE(hid.send_report(report, sizeof(report)));
+		EXPECT_FALSE(hid.configure(8));
+		hid.unconfigure();
+	}
+
+	TEST_F(HID_class_test, get_report)
+	{
+		ASSERT_TRUE(hid.configure(8));
+
+		const uint8_t report[] = {0x11, 0x22, 0x33};
+		ASSERT_TRUE(hid.send_report(report, sizeof(report)));
+
+		//no callback, the last input report
+		EXPECT_EQ(request(0xA1, HID::HID_REQUESTS::GET_REPORT, 0x0100, 8), USB_common::USB_RESP::ACK);
+		ASSERT_EQ(tx.size(), 3U);
+		EXPECT_EQ(tx.data()[2], 0x33);
+
+		EXPECT_EQ(request(0xA1, HID::HID_REQUESTS::GET_REPORT, 0x0300, 8), USB_common::USB_RESP::FAIL);
+
+		HID::REPORT_TYPE got_type = HID::REPORT_TYPE::INPUT;
+		uint8_t got_id = 0;
+		hid.set_get_report_callback(
+			[&got_type, &got_id](void* ctx, const HID::REPORT_TYPE type, const uint8_t id, Buffer_adapter_tx* const buf)
+			{
+				got_type = type;
+				got_id = id;
+				buf->insert(uint8_t(0xFE));
+				return id != 0x07;
+			},
+			nullptr
+		);
+
+		EXPECT_EQ(request(0xA1, HID::HID_REQUESTS::GET_REPORT, 0x0305, 8), USB_common::USB_RESP::ACK);
+		EXPECT_EQ(got_type, HID::REPORT_TYPE::FEATURE);
+		EXPECT_EQ(got_id, 5);
+		ASSERT_EQ(tx.size(), 1U);
+		EXPECT_EQ(tx.data()[0], 0xFE);
+
+		EXPECT_EQ(request(0xA1, HID::HID_REQUESTS::GET_REPORT, 0x0307, 8), USB_common::USB_RESP::FAIL);
+
+		//another interface
+		Setup_packet req;
+		req.bmRequestType = 0xA1;
+		req.bRequest = uint8_t(HID::HID_REQUESTS::GET_REPORT);
+		req.wValue = 0x0100;
+		req.wIndex = 3;
+		req.wLength = 8;
+		EXPECT_EQ(hid.handle_class_request(&req, &rx, &tx), USB_common::USB_RESP::FAIL);
+	}
+
+	TEST_F(HID_class_test, set_report)
+	{
+		EXPECT_EQ(request(0x21, HID::HID_REQUESTS::SET_REPORT, 0x0200, 1), USB_common::USB_RESP::FAIL);
+
+		std::vector<uint8_t> got;
+		hid.set_set_report_callback(
+			[&got](void* ctx, const HID::REPORT_TYPE type, const uint8_t id, const Buffer_adapter_rx* const buf)
+			{
+				got.assign(buf->data(), buf->data() + buf->size());
+				return type == HID::REPORT_TYPE::OUTPUT;
+			},
+			nullptr
+		);
+
+		const uint8_t leds = 0x05;
+		rx.insert(leds);
+		EXPECT_EQ(request(0x21, HID::HID_REQUESTS::SET_REPORT, 0x0200, 1), USB_common::USB_RESP::ACK);
+		ASSERT_EQ(got.size(), 1U);
+		EXPECT_EQ(got[0], leds);
+
+		EXPECT_EQ(request(0x21, HID::HID_REQUESTS::SET_REPORT, 0x0300, 1), USB_common::USB_RESP::FAIL);
+	}
+
+	TEST_F(HID_class_test, idle_and_protocol)
+	{
+		EXPECT_EQ(hid.get_idle_rate(), 0);
+		EXPECT_EQ(request(0x21, HID::HID_REQUESTS::SET_IDLE, 0x7D00, 0), USB_common::USB_RESP::ACK);
+		EXPECT_EQ(hid.get_idle_rate(), 0x7D);
+
+		EXPECT_EQ(request(0xA1, HID::HID_REQUESTS::GET_IDLE, 0, 1), USB_common::USB_RESP::ACK);
+		ASSERT_EQ(tx.size(), 1U);
+		EXPECT_EQ(tx.data()[0], 0x7D);
+
+		//per report id rates are stalled and leave the global rate alone
+		EXPECT_EQ(request(0x21, HID::HID_REQUESTS::SET_IDLE, 0x1003, 0), USB_common::USB_RESP::FAIL);
+		EXPECT_EQ(hid.get_idle_rate(), 0x7D);
+		EXPECT_EQ(request(0xA1, HID::HID_REQUESTS::GET_IDLE, 0x0003, 1), USB_common::USB_RESP::FAIL);
+
+		EXPECT_EQ(hid.get_protocol(), HID::PROTOCOL::REPORT);
+		EXPECT_EQ(request(0x21, HID::HID_REQUESTS::SET_PROTOCOL, 0x0000, 0), USB_common::USB_RESP::ACK);
+		EXPECT_EQ(hid.get_protocol(), HID::PROTOCOL::BOOT);
+
+		EXPECT_EQ(request(0xA1, HID::HID_REQUESTS::GET_PROTOCOL, 0, 1), USB_common::USB_RESP::ACK);
+		ASSERT_EQ(tx.size(), 1U);
+		EXPECT_EQ(tx.data()[0], 0x00);
+
+		EXPECT_EQ(request(0x21, HID::HID_REQUESTS::SET_PROTOCOL, 0x0002, 0), USB_common::USB_RESP::FAIL);
+		EXPECT_EQ(hid.get_protocol(), HID::PROTOCOL::BOOT);
+
+		//back to report protocol on configure
+		ASSERT_TRUE(hid.configure(8));
+		EXPECT_EQ(hid.get_protocol(), HID::PROTOCOL::REPORT);
+	}
+
+	TEST_F(HID_class_test, pending_slot)
+	{
+		const uint8_t a[] = {0xA0, 0xA1};
+		const uint8_t b[] = {0xB0, 0xB1};
+		const uint8_t c[] = {0xC0, 0xC1, 0xC2};
+		const uint8_t too_long[9] = {};
+
+		//not configured
+		EXPECT_FALSE(hid.send_report(a, sizeof(a)));
+		ASSERT_TRUE(hid.configure(8));
+
+		ASSERT_TRUE(hid.send_report(a, sizeof(a)));
+		ASSERT_EQ(driver.get_sent_count(1), 1U);
+
+		//a is in flight, b waits and c replaces it
+		ASSERT_TRUE(hid.send_report(b, sizeof(b)));
+		ASSERT_TRUE(hid.send_report(c, sizeof(c)));
+		EXPECT_EQ(driver.get_sent_count(1), 1U);
+		EXPECT_EQ(hid.get_latency_stats().dropped, 1U);
+
+		//longer than the ep, refused and c is kept
+		EXPECT_FALSE(hid.send_report(too_long, sizeof(too_long)));
+
+		ASSERT_TRUE(driver.complete_tx(1));
+		ASSERT_EQ(driver.get_sent_count(1), 1U);
+		EXPECT_EQ(sent(0), std::vector<uint8_t>(c, c + sizeof(c)));
+
+		ASSERT_TRUE(driver.complete_tx(1));
+		EXPECT_EQ(driver.get_sent_count(1), 0U);
+		EXPECT_EQ(hid.get_latency_stats().count, 2U);
+
+		ASSERT_EQ(driver.m_acked[1].size(), 5U);
+		EXPECT_EQ(driver.m_acked[1][0], 0xA0);
+		EXPECT_EQ(driver.m_acked[1][2], 0xC0);
+
+		//unconfigured while a report is in flight, the ep gives it back, the pending one is dropped and new ones refused
+		ASSERT_TRUE(hid.send_report(a, sizeof(a)));
+		ASSERT_TRUE(hid.send_report(b, sizeof(b)));
+		hid.unconfigure();
+		EXPECT_FALSE(hid.send_report(c, sizeof(c)));
+		EXPECT_EQ(driver.get_sent_count(1), 0U);
+		EXPECT_FALSE(driver.complete_tx(1));
+		EXPECT_EQ(driver.m_acked[1].size(), 5U);
+
+		//both tx buffers are free again
+		EXPECT_NE(tx_mgr->poll_allocate_buffer(1), nullptr);
+		EXPECT_NE(tx_mgr->poll_allocate_buffer(1), nullptr);
+	}
+}
@@ -0,0 +1,158 @@
+#include "libusb_dev_cpp/class/uac2/uac2_feedback.hpp"
+
+#include "libusb_dev_cpp/util/Sample_fifo.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	struct Drift_result
+	{
+		int64_t min_level;
+		int64_t max_level;
+		int64_t final_level;
+		size_t underrun;
+		size_t overrun;
+	};
+
+	//host sends what the feedback asks for, the device consumes at its local clock
+	//ppm is how much faster the device sample clock is than the host SOF clock
+	Drift_result simulate(const USB_common::USB_SPEED speed, const uint32_t rate, const double ppm, const uint64_t num_frames)
+	{
+		constexpr size_t FIFO_LEN = 4096;
+		constexpr size_t TARGET = FIFO_LEN / 2;
+
+		UAC2_feedback fb;
+		fb.set_rate(rate, speed);
+		fb.set_window((speed == USB_common::USB_SPEED::HS) ? 1024 : 128);
+		fb.set_target_level(TARGET, 10);
+
+		Sample_fifo<int32_t, FIFO_LEN> fifo;
+		std::vector<int32_t> pkt(FIFO_LEN);
+		{
+			std::vector<int32_t> pre(TARGET, 0);
+			fifo.write(pre.data(), pre.size());
+		}
+
+		const uint32_t fb_period = (speed == USB_common::USB_SPEED::HS) ? 8 : 1;
+		const double frames_per_sec = (speed == USB_common::USB_SPEED::HS) ? 8000.0 : 1000.0;
+		const uint64_t local_step = static_cast<uint64_t>((double(rate) * (1.0 + ppm * 1e-6) / frames_per_sec) * 65536.0 * 65536.0);
+
+		uint64_t host_acc  = 0;
+		uint64_t local_acc = 0;
+		uint32_t host_fb = fb.get_feedback();
+
+		Drift_result res;
+		res.min_level = TARGET;
+		res.max_level = TARGET;
+
+		for(uint64_t i = 0; i < num_frames; i++)
+		{
+			//host polls the feedback ep every fb_period frames
+			if((i % fb_period) == 0)
+			{
+				host_fb = fb.get_feedback();
+			}
+
+			host_acc += host_fb;
+			const size_t to_send = host_acc >> 16;
+			host_acc &= 0xFFFF;
+			fifo.write(pkt.data(), to_send);
+
+			local_acc += local_step;
+			const uint32_t consumed = local_acc >> 32;
+			local_acc &= 0xFFFFFFFFULL;
+			fifo.read(pkt.data(), consumed);
+
+			fb.update(1, consumed, fifo.size());
+
+			res.min_level = std::min<int64_t>(res.min_level, fifo.size());
+			res.max_level = std::max<int64_t>(res.max_level, fifo.size());
+		}
+
+		res.final_level = fifo.size();
+		res.underrun = fifo.get_underrun_count();
+		res.overrun = fifo.get_overrun_count();
+
+		return res;
+	}
+
+	TEST(uac2_feedback, nominal)
+	{
+		UAC2_feedback fb;
+
+		fb.set_rate(48000, USB_common::USB_SPEED::FS);
+		EXPECT_EQ(fb.get_nominal(), 48U << 16);
+
+		UAC2_feedback::Feedback_array arr;
+		EXPECT_EQ(fb.serialize(&arr), 3U);
+		EXPECT_EQ(arr[0], 0x00);
+		EXPECT_EQ(arr[1], 0x00);
+		EXPECT_EQ(arr[2], 0x0C);
+
+		fb.set_rate(44100, USB_common::USB_SPEED::HS);
+		EXPECT_EQ(fb.serialize(&arr), 4U);
+		EXPECT_EQ(fb.get_nominal(), (44100ULL << 16) / 8000);
+	}
+
+	//one hour of FS frames
+	TEST(uac2_feedback, fs_drift_1h)
+	{
+		for(const double ppm : {-250.0, -50.0, 0.0, 50.0, 250.0})
+		{
+			const Drift_result res = simulate(USB_common::USB_SPEED::FS, 48000, ppm, 1000ULL * 3600ULL);
+
+			EXPECT_EQ(res.underrun, 0U) << ppm;
+			EXPECT_EQ(res.overrun, 0U) << ppm;
+			EXPECT_GT(res.min_level, 2048 - 256) << ppm;
+			EXPECT_LT(res.max_level, 2048 + 256) << ppm;
+			EXPECT_NEAR(res.final_level, 2048, 64) << ppm;
+		}
+	}
+
+	//ten minutes of HS microframes
+	TEST(uac2_feedback, hs_drift_10m)
+	{
+		for(const double ppm : {-250.0, 0.0, 250.0})
+		{
+			const Drift_result res = simulate(USB_common::USB_SPEED::HS, 44100, ppm, 8000ULL * 600ULL);
+
+			EXPECT_EQ(res.underrun, 0U) << ppm;
+			EXPECT_EQ(res.overrun, 0U) << ppm;
+			EXPECT_GT(res.min_level, 2048 - 256) << ppm;
+			EXPECT_LT(res.max_level, 2048 + 256) << ppm;
+			EXPECT_NEAR(res.final_level, 2048, 64) << ppm;
+		}
+	}
+
+	TEST(Sample_fifo, wrap_and_pad)
+	{
+		Sample_fifo<uint8_t, 8> fifo;
+		std::array<uint8_t, 6> in = {1, 2, 3, 4, 5, 6};
+		std::array<uint8_t, 6> out;
+
+		EXPECT_EQ(fifo.write(in.data(), 6), 6U);
+		EXPECT_EQ(fifo.read(out.data(), 4), 4U);
+		EXPECT_EQ(fifo.write(in.data(), 6), 6U);
+		EXPECT_EQ(fifo.size(), 8U);
+		EXPECT_EQ(fifo.write(in.data(), 1), 0U);
+		EXPECT_EQ(fifo.get_overrun_count(), 1U);
+
+		EXPECT_EQ(fifo.read(out.data(), 2), 2U);
+		EXPECT_EQ(out[0], 5);
+		EXPECT_EQ(out[1], 6);
+
+		EXPECT_EQ(fifo.read(out.data(), 6), 6U);
+		EXPECT_EQ(out[0], 1);
+		EXPECT_EQ(out[5], 6);
+
+		out.fill(0xFF);
+		EXPECT_EQ(fifo.read(out.data(), 2), 0U);
+		EXPECT_EQ(out[0], 0);
+		EXPECT_EQ(out[1], 0);
+		EXPECT_EQ(fifo.get_underrun_count(), 2U);
+	}
+}
@@ -0,0 +1,90 @@
+#include "libusb_dev_cpp/core/Request_dispatch_table.hpp"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+	USB_common::USB_RESP count_request(void* ctx, Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+	{
+		int* const count = static_cast<int*>(ctx);
+		(*count)++;
+		return USB_common::USB_RESP::ACK;
+	}
+
+	Setup_packet make_req(const uint8_t bmRequestType, const uint8_t bRequest)
+	{
+		Setup_packet req;
+		req.bmRequestType = bmRequestType;
+		req.bRequest = bRequest;
+		req.wValue = 0;
+		req.wIndex = 0;
+		req.wLength = 0;
+		return req;
+	}
+
+	TEST(Request_dispatch_table, standard)
+	{
+		Request_dispatch_table table;
+
+		int count = 0;
+		ASSERT_TRUE(table.register_request(Request_type::TYPE::STANDARD, Request_type::RECIPIENT::ENDPOINT, uint8_t(Setup_packet::ENDPOINT_REQUEST::SYNC_FRAME), &count_request, &count));
+
+		//IN, standard, endpoint
+		Setup_packet req = make_req(0x82, 0x0C);
+		USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
+		ASSERT_TRUE(table.dispatch(&req, nullptr, nullptr, &r));
+		EXPECT_EQ(r, USB_common::USB_RESP::ACK);
+		EXPECT_EQ(count, 1);
+
+		//same bRequest on the interface is a different slot
+		req = make_req(0x81, 0x0C);
+		r = USB_common::USB_RESP::FAIL;
+		EXPECT_FALSE(table.dispatch(&req, nullptr, nullptr, &r));
+		EXPECT_EQ(r, USB_common::USB_RESP::FAIL);
+		EXPECT_EQ(count, 1);
+
+		table.unregister_request(Request_type::TYPE::STANDARD, Request_type::RECIPIENT::ENDPOINT, uint8_t(Setup_packet::ENDPOINT_REQUEST::SYNC_FRAME));
+		EXPECT_FALSE(table.has_handler(0x82, 0x0C));
+	}
+
+	TEST(Request_dispatch_table, class_vendor)
+	{
+		Request_dispatch_table table;
+
+		int class_count = 0;
+		int vendor_count = 0;
+		ASSERT_TRUE(table.register_request(Request_type::TYPE::CLASS, Request_type::RECIPIENT::INTERFACE, 0x20, &count_request, &class_count));
+		ASSERT_TRUE(table.register_request(Request_type::TYPE::VENDOR, Request_type::RECIPIENT::DEVICE, 0x20, &count_request, &vendor_count));
+
+		EXPECT_TRUE(table.has_handler(0x21, 0x20));
+		EXPECT_TRUE(table.has_handler(0xC0, 0x20));
+		EXPECT_FALSE(table.has_handler(0x40, 0x21));
+		EXPECT_FALSE(table.has_handler(0x01, 0x20));
+
+		//reserved recipient
+		EXPECT_FALSE(table.has_handler(0x24, 0x20));
+
+		Setup_packet req = make_req(0x21, 0x20);
+		USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
+		ASSERT_TRUE(table.dispatch(&req, nullptr, nullptr, &r));
+		EXPECT_EQ(class_count, 1);
+		EXPECT_EQ(vendor_count, 0);
+	}
+
+	TEST(Request_dispatch_table, replace)
+	{
+		Request_dispatch_table table;
+
+		int first = 0;
+		int second = 0;
+		ASSERT_TRUE(table.register_request(Request_type::TYPE::STANDARD, Request_type::RECIPIENT::DEVICE, 0x00, &count_request, &first));
+		ASSERT_TRUE(table.register_request(Request_type::TYPE::STANDARD, Request_type::RECIPIENT::DEVICE, 0x00, &count_request, &second));
+		EXPECT_FALSE(table.register_request(Request_type::TYPE::STANDARD, Request_type::RECIPIENT::DEVICE, 0x01, nullptr, nullptr));
+
+		Setup_packet req = make_req(0x80, 0x00);
+		USB_common::USB_RESP r = USB_common::USB_RESP::FAIL;
+		ASSERT_TRUE(table.dispatch(&req, nullptr, nullptr, &r));
+		EXPECT_EQ(first, 0);
+		EXPECT_EQ(second, 1);
+	}
+}
@@ -0,0 +1,552 @@
+#include "libusb_dev_cpp/core/usb_core.hpp"
+#include "libusb_dev_cpp/class/usb_class.hpp"
+
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include "../driver/Fake_driver.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	typedef EP_buffer_mgr_lockfree<4, 4, 64, 4> Buffer_mgr;
+
+	//records what the core routed to it
+	class Fake_function : public USB_class
+	{
+	public:
+		Fake_function(usb_driver_base* const driver, const uint8_t id) : m_driver(driver), m_id(id)
+		{
+
+		}
+
+		USB_common::USB_RESP handle_class_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host) override
+		{
+			m_class_requests.push_back(req->bRequest);
+			if(req->wLength > 0)
+			{
+				buf_to_host->insert(m_id);
+			}
+			return USB_common::USB_RESP::ACK;
+		}
+
+		USB_common::USB_RESP handle_vendor_request(Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host) override
+		{
+			m_vendor_requests.push_back(req->bRequest);
+			return m_vendor_ok ? USB_common::USB_RESP::ACK : USB_common::USB_RESP::FAIL;
+		}
+
+		void handle_ep_event(const USB_common::USB_EVENTS event, const uint8_t ep) override
+		{
+			m_ep_events.emplace_back(event, ep);
+
+			//one event per ep, drain all of it
+			if(event == USB_common::USB_EVENTS::EP_RX)
+			{
+				EP_buffer_mgr_base* const mgr = m_driver->get_rx_buffer();
+				while(Buffer_adapter_base* const buf = mgr->poll_dequeue_buffer(ep))
+				{
+					m_rx.push_back(buf->data()[0]);
+					mgr->release_buffer(ep, buf);
+				}
+			}
+		}
+
+		usb_driver_base* m_driver;
+		uint8_t m_id;
+		bool m_vendor_ok = false;
+
+		std::vector<uint8_t> m_class_requests;
+		std::vector<uint8_t> m_vendor_requests;
+		std::vector<std::pair<USB_common::USB_EVENTS, uint8_t>> m_ep_events;
+		std::vector<uint8_t> m_rx;
+	};
+
+	class USB_core_test : public ::testing::Test
+	{
+	protected:
+		USB_core_test() : fn_a(&driver, 0xA0), fn_b(&driver, 0xB0)
+		{
+
+		}
+
+		void SetUp() override
+		{
+			ep0_mgr = std::make_unique<Buffer_mgr>();
+			rx_mgr = std::make_unique<Buffer_mgr>();
+			tx_mgr = std::make_unique<Buffer_mgr>();
+			driver.set_ep0_buffer(ep0_mgr.get());
+			driver.set_rx_buffer(rx_mgr.get());
+			driver.set_tx_buffer(tx_mgr.get());
+
+			ASSERT_TRUE(core.initialize(&driver, 64, Buffer_adapter_tx(tx_mem.data(), tx_mem.size()), Buffer_adapter_rx(rx_mem.data(), rx_mem.size())));
+			core.poll_driver();
+
+			//a: ifaces 0-1 and ep 1, b: iface 2 and ep 2
+			ASSERT_TRUE(core.add_usb_class(&fn_a, 0, 2, USB_core::get_ep_mask(0x01) | USB_core::get_ep_mask(0x81)));
+			ASSERT_TRUE(core.add_usb_class(&fn_b, 2, 1, USB_core::get_ep_mask(0x02) | USB_core::get_ep_mask(0x82)));
+
+			driver.post(USB_common::USB_EVENTS::RESET, 0);
+			driver.post(USB_common::USB_EVENTS::ENUM_DONE, 0);
+			run();
+		}
+
+		//vendor device request 0x30 answers later
+		void register_deferred()
+		{
+			ASSERT_TRUE(core.register_request(Request_type::TYPE::VENDOR, Request_type::RECIPIENT::DEVICE, 0x30,
+				[this](void* ctx, Setup_packet* const req, Buffer_adapter_rx* const buf_from_host, Buffer_adapter_tx* const buf_to_host)
+				{
+					setup_ids.push_back(core.get_setup_id());
+					return USB_common::USB_RESP::PENDING;
+				},
+				nullptr
+			));
+		}
+
+		//vendor device request 0x40 streams its data stage through stream_in / stream_out
+		//a callback fails at fail_offset
+		void register_stream()
+		{
+			ASSERT_TRUE(core.register_stream_request(Request_type::TYPE::VENDOR, Request_type::RECIPIENT::DEVICE, 0x40,
+				[this](void* ctx, Setup_packet* const req, const size_t offset, const uint8_t* const buf, const size_t len)
+				{
+					if(offset != stream_out.size())
+					{
+						return false;
+					}
+					if((offset <= fail_offset) && (fail_offset < (offset + len)))
+					{
+						return false;
+					}
+					stream_out.insert(stream_out.end(), buf, buf + len);
+					return true;
+				},
+				[this](void* ctx, Setup_packet* const req, const size_t offset, uint8_t* const buf, const size_t max_len)
+				{
+					if((offset <= fail_offset) && (fail_offset < (offset + max_len)))
+					{
+						return -1;
+					}
+					const size_t len = std::min(max_len, stream_in.size() - offset);
+					std::copy_n(stream_in.begin() + offset, len, buf);
+					return int(len);
+				},
+				nullptr
+			));
+		}
+
+		//host ACKed the ep0 IN packet
+		void ack_in()
+		{
+			driver.post(USB_common::USB_EVENTS::EP_TX, 0x80);
+			run();
+		}
+
+		void run()
+		{
+			for(size_t i = 0; i < 64; i++)
+			{
+				core.poll_event_loop();
+			}
+		}
+
+		Fake_driver driver;
+		std::unique_ptr<Buffer_mgr> ep0_mgr;
+		std::unique_ptr<Buffer_mgr> rx_mgr;
+		std::unique_ptr<Buffer_mgr> tx_mgr;
+
+		std::array<uint8_t, 256> tx_mem;
+		std::array<uint8_t, 256> rx_mem;
+
+		USB_core core;
+		Fake_function fn_a;
+		Fake_function fn_b;
+
+		std::vector<uint32_t> setup_ids;
+
+		std::vector<uint8_t> stream_in;
+		std::vector<uint8_t> stream_out;
+		size_t fail_offset = SIZE_MAX;
+	};
+
+	std::vector<uint8_t> make_data(const size_t len)
+	{
+		std::vector<uint8_t> data(len);
+		for(size_t i = 0; i < len; i++)
+		{
+			data[i] = uint8_t(i * 7);
+		}
+		return data;
+	}
+
+	TEST_F(USB_core_test, overlap)
+	{
+		Fake_function fn_c(&driver, 0xC0);
+		EXPECT_FALSE(core.add_usb_class(&fn_c, 1, 1, 0));
+		EXPECT_FALSE(core.add_usb_class(&fn_c, 3, 1, USB_core::get_ep_mask(0x82)));
+		EXPECT_FALSE(core.add_usb_class(nullptr, 3, 1, 0));
+
+		EXPECT_EQ(core.get_class_for_iface(1), &fn_a);
+		EXPECT_EQ(core.get_class_for_iface(2), &fn_b);
+		EXPECT_EQ(core.get_class_for_ep(0x81), &fn_a);
+		EXPECT_EQ(core.get_class_for_ep(0x02), &fn_b);
+		EXPECT_EQ(core.get_class_for_ep(0x83), nullptr);
+	}
+
+	TEST_F(USB_core_test, class_request_by_iface)
+	{
+		//host to device, interface 1
+		ASSERT_TRUE(driver.setup(0x21, 0x0A, 0, 1, 0));
+		run();
+		EXPECT_EQ(fn_a.m_class_requests, std::vector<uint8_t>({0x0A}));
+		EXPECT_TRUE(fn_b.m_class_requests.empty());
+
+		//device to host, interface 2, the answer comes from b
+		driver.m_ep0_in.clear();
+		ASSERT_TRUE(driver.setup(0xA1, 0x01, 0, 2, 1));
+		run();
+		EXPECT_EQ(fn_b.m_class_requests, std::vector<uint8_t>({0x01}));
+		ASSERT_EQ(driver.m_ep0_in.size(), 1U);
+		EXPECT_EQ(driver.m_ep0_in[0], std::vector<uint8_t>({0xB0}));
+		EXPECT_EQ(fn_a.m_class_requests.size(), 1U);
+	}
+
+	TEST_F(USB_core_test, class_request_by_ep)
+	{
+		ASSERT_TRUE(driver.setup(0x22, 0x01, 0, 0x82, 0));
+		run();
+		EXPECT_EQ(fn_b.m_class_requests, std::vector<uint8_t>({0x01}));
+
+		ASSERT_TRUE(driver.setup(0x22, 0x02, 0, 0x01, 0));
+		run();
+		EXPECT_EQ(fn_a.m_class_requests, std::vector<uint8_t>({0x02}));
+		EXPECT_EQ(fn_b.m_class_requests.size(), 1U);
+	}
+
+	TEST_F(USB_core_test, vendor_request)
+	{
+		//interface recipient goes to the owner only
+		fn_b.m_vendor_ok = true;
+		ASSERT_TRUE(driver.setup(0x41, 0x10, 0, 2, 0));
+		run();
+		EXPECT_TRUE(fn_a.m_vendor_requests.empty());
+		EXPECT_EQ(fn_b.m_vendor_requests, std::vector<uint8_t>({0x10}));
+
+		//device recipient is offered to each function until one takes it
+		driver.m_ep0_in.clear();
+		ASSERT_TRUE(driver.setup(0x40, 0x11, 0, 0, 0));
+		run();
+		EXPECT_EQ(fn_a.m_vendor_requests, std::vector<uint8_t>({0x11}));
+		EXPECT_EQ(fn_b.m_vendor_requests, std::vector<uint8_t>({0x10, 0x11}));
+		ASSERT_EQ(driver.m_ep0_in.size(), 1U);
+		EXPECT_TRUE(driver.m_ep0_in[0].empty());
+
+		//nobody takes it
+		fn_b.m_vendor_ok = false;
+		driver.m_ep0_in.clear();
+		ASSERT_TRUE(driver.setup(0x40, 0x12, 0, 0, 0));
+		run();
+		EXPECT_EQ(fn_a.m_vendor_requests.size(), 2U);
+		EXPECT_EQ(fn_b.m_vendor_requests.size(), 3U);
+		EXPECT_TRUE(driver.m_ep0_in.empty());
+	}
+
+	TEST_F(USB_core_test, ep_event_by_ep)
+	{
+		driver.post(USB_common::USB_EVENTS::EP_TX, 0x82);
+		driver.post(USB_common::USB_EVENTS::EP_TX, 0x81);
+		ASSERT_TRUE(driver.receive_posted(1, 0x55));
+		run();
+
+		ASSERT_EQ(fn_a.m_ep_events.size(), 2U);
+		EXPECT_EQ(fn_a.m_ep_events[0], std::make_pair(USB_common::USB_EVENTS::EP_TX, uint8_t(0x81)));
+		EXPECT_EQ(fn_a.m_ep_events[1], std::make_pair(USB_common::USB_EVENTS::EP_RX, uint8_t(0x01)));
+		EXPECT_EQ(fn_a.m_rx, std::vector<uint8_t>({0x55}));
+
+		ASSERT_EQ(fn_b.m_ep_events.size(), 1U);
+		EXPECT_EQ(fn_b.m_ep_events[0], std::make_pair(USB_common::USB_EVENTS::EP_TX, uint8_t(0x82)));
+	}
+
+	TEST_F(USB_core_test, ep_rx_coalesced)
+	{
+		//a burst before the core runs is one event
+		ASSERT_TRUE(driver.receive_posted(2, 1));
+		ASSERT_TRUE(driver.receive_posted(2, 2));
+		ASSERT_TRUE(driver.receive_posted(2, 3));
+		run();
+
+		ASSERT_EQ(fn_b.m_ep_events.size(), 1U);
+		EXPECT_EQ(fn_b.m_rx, std::vector<uint8_t>({1, 2, 3}));
+
+		//handled, so the next packet posts again
+		ASSERT_TRUE(driver.receive_posted(2, 4));
+		run();
+		EXPECT_EQ(fn_b.m_ep_events.size(), 2U);
+		EXPECT_EQ(fn_b.m_rx, std::vector<uint8_t>({1, 2, 3, 4}));
+	}
+
+	TEST_F(USB_core_test, ep_rx_unowned)
+	{
+		//no function or callback, the packet waits for a blocking reader and posts nothing
+		ASSERT_TRUE(driver.receive_posted(3, 7));
+		run();
+		EXPECT_TRUE(fn_a.m_ep_events.empty());
+		EXPECT_TRUE(fn_b.m_ep_events.empty());
+
+		Buffer_adapter_base* const buf = rx_mgr->poll_dequeue_buffer(3);
+		ASSERT_NE(buf, nullptr);
+		rx_mgr->release_buffer(3, buf);
+
+		//a rx callback opts the ep in
+		size_t count = 0;
+		driver.set_ep_rx_callback(3, [&count](const USB_common::USB_EVENTS event, const uint8_t ep)
+			{
+				count++;
+			}
+		);
+		ASSERT_TRUE(driver.receive_posted(3, 8));
+		run();
+		EXPECT_EQ(count, 1U);
+		EXPECT_TRUE(fn_a.m_ep_events.empty());
+		EXPECT_TRUE(fn_b.m_ep_events.empty());
+	}
+
+	TEST_F(USB_core_test, deferred_complete)
+	{
+		register_deferred();
+
+		ASSERT_TRUE(driver.setup(0xC0, 0x30, 0, 0, 4));
+		run();
+		ASSERT_EQ(setup_ids.size(), 1U);
+
+		//ep0 NAKs until the answer comes
+		EXPECT_TRUE(driver.m_ep0_in.empty());
+		EXPECT_TRUE(driver.m_stalls.empty());
+
+		const std::array<uint8_t, 3> data = {1, 2, 3};
+		EXPECT_TRUE(core.complete_deferred_request(setup_ids[0], USB_common::USB_RESP::ACK, data.data(), data.size()));
+		run();
+		ASSERT_EQ(driver.m_ep0_in.size(), 1U);
+		EXPECT_EQ(driver.m_ep0_in[0], std::vector<uint8_t>(data.begin(), data.end()));
+
+		//only once
+		EXPECT_FALSE(core.complete_deferred_request(setup_ids[0], USB_common::USB_RESP::ACK, data.data(), data.size()));
+		EXPECT_FALSE(core.complete_deferred_request(setup_ids[0], USB_common::USB_RESP::PENDING, nullptr, 0));
+	}
+
+	TEST_F(USB_core_test, deferred_stale_id)
+	{
+		register_deferred();
+
+		ASSERT_TRUE(driver.setup(0x40, 0x30, 0, 0, 0));
+		run();
+
+		//the host gave up and sent a new request
+		ASSERT_TRUE(driver.setup(0x40, 0x30, 1, 0, 0));
+		run();
+		ASSERT_EQ(setup_ids.size(), 2U);
+		EXPECT_NE(setup_ids[0], setup_ids[1]);
+
+		EXPECT_FALSE(core.complete_deferred_request(setup_ids[0], USB_common::USB_RESP::ACK, nullptr, 0));
+		run();
+		EXPECT_TRUE(driver.m_ep0_in.empty());
+
+		EXPECT_TRUE(core.complete_deferred_request(setup_ids[1], USB_common::USB_RESP::ACK, nullptr, 0));
+		run();
+		ASSERT_EQ(driver.m_ep0_in.size(), 1U);
+		EXPECT_TRUE(driver.m_ep0_in[0].empty());
+	}
+
+	TEST_F(USB_core_test, deferred_timeout)
+	{
+		register_deferred();
+		core.set_deferred_timeout(std::chrono::milliseconds(20));
+
+		ASSERT_TRUE(driver.setup(0xC0, 0x30, 0, 0, 4));
+		run();
+		ASSERT_EQ(setup_ids.size(), 1U);
+		EXPECT_TRUE(driver.m_stalls.empty());
+
+		//no bus traffic, the wait for the next event ends at the deadline
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		while(driver.m_stalls.empty() && ((std::chrono::steady_clock::now() - start) < std::chrono::seconds(2)))
+		{
+			EXPECT_FALSE(core.poll_event_loop(true));
+		}
+
+		EXPECT_EQ(driver.m_stalls, std::vector<uint8_t>({0x00, 0x80}));
+		EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+
+		//too late
+		const std::array<uint8_t, 1> data = {1};
+		EXPECT_FALSE(core.complete_deferred_request(setup_ids[0], USB_common::USB_RESP::ACK, data.data(), data.size()));
+		run();
+		EXPECT_TRUE(driver.m_ep0_in.empty());
+	}
+
+	TEST_F(USB_core_test, stream_out_above_ep0_buffer)
+	{
+		register_stream();
+
+		//more than the 256 byte control rx buffer
+		const std::vector<uint8_t> data = make_data(300);
+		ASSERT_TRUE(driver.setup(0x40, 0x40, 0, 0, data.size()));
+		run();
+
+		for(size_t i = 0; i < data.size(); i += 64)
+		{
+			EXPECT_TRUE(driver.m_ep0_in.empty());
+			ASSERT_TRUE(driver.receive_ep0(data.data() + i, std::min<size_t>(64, data.size() - i)));
+			run();
+		}
+
+		EXPECT_EQ(stream_out, data);
+		EXPECT_TRUE(driver.m_stalls.empty());
+
+		//zlp status
+		ASSERT_EQ(driver.m_ep0_in.size(), 1U);
+		EXPECT_TRUE(driver.m_ep0_in[0].empty());
+	}
+
+	TEST_F(USB_core_test, stream_in_short_packet)
+	{
+		register_stream();
+
+		//the device has less than the host asked for, the short last packet ends the data stage
+		stream_in = make_data(150);
+		ASSERT_TRUE(driver.setup(0xC0, 0x40, 0, 0, 300));
+		run();
+		ack_in();
+		ack_in();
+		ack_in();
+
+		ASSERT_EQ(driver.m_ep0_in.size(), 3U);
+		EXPECT_EQ(driver.m_ep0_in[0].size(), 64U);
+		EXPECT_EQ(driver.m_ep0_in[1].size(), 64U);
+		EXPECT_EQ(driver.m_ep0_in[2].size(), 22U);
+
+		std::vector<uint8_t> got;
+		for(const std::vector<uint8_t>& pkt : driver.m_ep0_in)
+		{
+			got.insert(got.end(), pkt.begin(), pkt.end());
+		}
+		EXPECT_EQ(got, stream_in);
+		EXPECT_TRUE(driver.m_stalls.empty());
+	}
+
+	TEST_F(USB_core_test, stream_in_zlp)
+	{
+		register_stream();
+
+		//a multiple of max packet size and less than wLength needs a zlp
+		stream_in = make_data(128);
+		ASSERT_TRUE(driver.setup(0xC0, 0x40, 0, 0, 300));
+		run();
+		ack_in();
+		ack_in();
+		ack_in();
+
+		ASSERT_EQ(driver.m_ep0_in.size(), 3U);
+		EXPECT_EQ(driver.m_ep0_in[0].size(), 64U);
+		EXPECT_EQ(driver.m_ep0_in[1].size(), 64U);
+		EXPECT_TRUE(driver.m_ep0_in[2].empty());
+
+		//exactly wLength does not
+		driver.m_ep0_in.clear();
+		ASSERT_TRUE(driver.setup(0xC0, 0x40, 0, 0, 128));
+		run();
+		ack_in();
+		ack_in();
+		ack_in();
+
+		ASSERT_EQ(driver.m_ep0_in.size(), 2U);
+		EXPECT_EQ(driver.m_ep0_in[0].size(), 64U);
+		EXPECT_EQ(driver.m_ep0_in[1].size(), 64U);
+		EXPECT_TRUE(driver.m_stalls.empty());
+	}
+
+	TEST_F(USB_core_test, stream_fail)
+	{
+		register_stream();
+
+		//OUT, the second packet is refused
+		fail_offset = 100;
+		const std::vector<uint8_t> data = make_data(200);
+		ASSERT_TRUE(driver.setup(0x40, 0x40, 0, 0, data.size()));
+		run();
+		ASSERT_TRUE(driver.receive_ep0(data.data(), 64));
+		run();
+		EXPECT_TRUE(driver.m_stalls.empty());
+		ASSERT_TRUE(driver.receive_ep0(data.data() + 64, 64));
+		run();
+
+		EXPECT_EQ(driver.m_stalls, std::vector<uint8_t>({0x00, 0x80}));
+		EXPECT_EQ(stream_out.size(), 64U);
+		EXPECT_TRUE(driver.m_ep0_in.empty());
+
+		//IN, the second packet fails
+		driver.m_stalls.clear();
+		stream_in = make_data(200);
+		ASSERT_TRUE(driver.setup(0xC0, 0x40, 0, 0, 200));
+		run();
+		ack_in();
+
+		EXPECT_EQ(driver.m_ep0_in.size(), 1U);
+		EXPECT_EQ(driver.m_stalls, std::vector<uint8_t>({0x00, 0x80}));
+
+		//the next request starts clean
+		fail_offset = SIZE_MAX;
+		driver.m_stalls.clear();
+		driver.m_ep0_in.clear();
+		stream_in = make_data(10);
+		ASSERT_TRUE(driver.setup(0xC0, 0x40, 0, 0, 10));
+		run();
+		ASSERT_EQ(driver.m_ep0_in.size(), 1U);
+		EXPECT_EQ(driver.m_ep0_in[0], stream_in);
+		EXPECT_TRUE(driver.m_stalls.empty());
+	}
+
+	TEST_F(USB_core_test, remote_wakeup)
+	{
+		driver.post(USB_common::USB_EVENTS::SUSPEND, 0);
+		run();
+		ASSERT_EQ(core.get_link_state(), USB_core::LINK_STATE::L2);
+
+		//the host did not allow it
+		EXPECT_FALSE(core.request_remote_wakeup());
+		EXPECT_FALSE(driver.m_rwusig);
+
+		driver.post(USB_common::USB_EVENTS::WAKEUP, 0);
+		ASSERT_TRUE(driver.setup(0x00, uint8_t(Setup_packet::DEVICE_REQUEST::SET_FEATURE), uint16_t(Setup_packet::FEATURE_SELECTOR::DEVICE_REMOTE_WAKEUP), 0, 0));
+		driver.post(USB_common::USB_EVENTS::SUSPEND, 0);
+		run();
+		EXPECT_TRUE(core.is_remote_wakeup_enabled());
+		ASSERT_EQ(core.get_link_state(), USB_core::LINK_STATE::L2);
+
+		//the caller is not blocked, the usb task ends the signaling on an idle bus
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		EXPECT_TRUE(core.request_remote_wakeup());
+		EXPECT_TRUE(driver.m_rwusig);
+
+		while(driver.m_rwusig && ((std::chrono::steady_clock::now() - start) < std::chrono::seconds(2)))
+		{
+			core.poll_event_loop(true);
+		}
+		EXPECT_FALSE(driver.m_rwusig);
+		EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+
+		driver.post(USB_common::USB_EVENTS::WAKEUP, 0);
+		run();
+		EXPECT_EQ(core.get_link_state(), USB_core::LINK_STATE::L0);
+		EXPECT_EQ(core.get_power_stats().remote_wakeups, 1U);
+	}
+}
@@ -0,0 +1,268 @@
+#include "libusb_dev_cpp/core/usb_coro_std.hpp"
+
+#include "gtest/gtest.h"
+
+#if defined(__cpp_impl_coroutine)
+
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include "../driver/Fake_driver.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef EP_buffer_mgr_lockfree<4, 2, 64, 4> Buffer_mgr;
+
+	class Usb_coro : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			rx_mgr = std::make_unique<Buffer_mgr>();
+			tx_mgr = std::make_unique<Buffer_mgr>();
+			driver.set_rx_buffer(rx_mgr.get());
+			driver.set_tx_buffer(tx_mgr.get());
+
+			exec.initialize(&driver);
+
+			Coro_arena_base::set_default(&arena);
+		}
+
+		void TearDown() override
+		{
+			Coro_arena_base::set_default(nullptr);
+		}
+
+		std::unique_ptr<Buffer_mgr> rx_mgr;
+		std::unique_ptr<Buffer_mgr> tx_mgr;
+		Fake_driver driver;
+		Usb_coro_executor_std exec;
+		Coro_arena<512, 4> arena;
+	};
+
+	Usb_coro_task sum_packets(Usb_coro_ep ep, const size_t num, int* const out_sum)
+	{
+		for(size_t i = 0; i < num; i++)
+		{
+			Buffer_adapter_base* const buf = co_await ep.read();
+			if(buf == nullptr)
+			{
+				*out_sum = -1;
+				co_return;
+			}
+
+			*out_sum += buf->data()[0];
+			ep.release(buf);
+		}
+	}
+
+	Usb_coro_task echo(Usb_coro_ep out_ep, Usb_coro_ep in_ep, size_t* const out_count)
+	{
+		for(;;)
+		{
+			Buffer_adapter_base* const rx_buf = co_await out_ep.read();
+			if(rx_buf == nullptr)
+			{
+				co_return;
+			}
+
+			Buffer_adapter_base* const tx_buf = co_await in_ep.alloc();
+			if(tx_buf == nullptr)
+			{
+				co_return;
+			}
+
+			tx_buf->insert(rx_buf->data()[0] + 1);
+			out_ep.release(rx_buf);
+
+			if(!co_await in_ep.write(tx_buf))
+			{
+				co_return;
+			}
+
+			(*out_count)++;
+		}
+	}
+
+	TEST_F(Usb_coro, read)
+	{
+		ASSERT_TRUE(exec.bind_ep(0x01));
+
+		int sum = 0;
+		const Usb_coro_task task = sum_packets(exec.get_ep(0x01), 3, &sum);
+		ASSERT_TRUE(task.is_valid());
+		EXPECT_EQ(exec.get_num_waiting(), 1U);
+		EXPECT_FALSE(arena.full());
+
+		for(uint8_t i = 1; i <= 3; i++)
+		{
+			ASSERT_TRUE(driver.receive(1, i));
+			EXPECT_EQ(exec.run_pending(), 1U);
+		}
+
+		EXPECT_EQ(sum, 6);
+		EXPECT_EQ(exec.get_num_waiting(), 0U);
+	}
+
+	TEST_F(Usb_coro, read_from_isr_thread)
+	{
+		ASSERT_TRUE(exec.bind_ep(0x02));
+
+		int sum = 0;
+		ASSERT_TRUE(sum_packets(exec.get_ep(0x02), 100, &sum).is_valid());
+
+		std::thread isr([this]()
+			{
+				for(size_t i = 0; i < 100; i++)
+				{
+					while(!driver.receive(2, 1))
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+		);
+
+		EXPECT_TRUE(exec.run_until([this](){return exec.get_num_waiting() == 0;}, std::chrono::milliseconds(5000)));
+		isr.join();
+
+		EXPECT_EQ(sum, 100);
+	}
+
+	TEST_F(Usb_coro, echo_many_eps_one_thread)
+	{
+		//three echo state machines share the calling thread
+		std::array<size_t, 3> counts = {0, 0, 0};
+		for(uint8_t ep = 1; ep <= 3; ep++)
+		{
+			ASSERT_TRUE(exec.bind_ep(ep));
+			ASSERT_TRUE(exec.bind_ep(0x80 | ep));
+			ASSERT_TRUE(echo(exec.get_ep(ep), exec.get_ep(0x80 | ep), &counts[ep - 1]).is_valid());
+		}
+		EXPECT_EQ(exec.get_num_waiting(), 3U);
+		EXPECT_TRUE(arena.full() == false);
+
+		for(uint8_t i = 0; i < 20; i++)
+		{
+			for(uint8_t ep = 1; ep <= 3; ep++)
+			{
+				ASSERT_TRUE(driver.receive(ep, i));
+			}
+			exec.run_pending();
+
+			//each one is blocked in write until the host ACKs
+			for(uint8_t ep = 1; ep <= 3; ep++)
+			{
+				ASSERT_EQ(driver.m_sent[ep].size(), 1U);
+				EXPECT_EQ(driver.m_sent[ep][0]->data()[0], i + 1);
+				EXPECT_EQ(counts[ep - 1], i);
+
+				driver.complete_tx(ep);
+			}
+			exec.run_pending();
+		}
+
+		for(uint8_t ep = 1; ep <= 3; ep++)
+		{
+			EXPECT_EQ(counts[ep - 1], 20U);
+		}
+
+		//bus reset, the frames go back to the arena
+		exec.cancel_all();
+		EXPECT_EQ(exec.get_num_waiting(), 0U);
+		for(size_t i = 0; i < 4; i++)
+		{
+			EXPECT_NE(arena.allocate(512), nullptr);
+		}
+	}
+
+	TEST_F(Usb_coro, cancel_keeps_pending_write)
+	{
+		ASSERT_TRUE(exec.bind_ep(0x01));
+		ASSERT_TRUE(exec.bind_ep(0x81));
+
+		size_t count = 0;
+		ASSERT_TRUE(echo(exec.get_ep(0x01), exec.get_ep(0x81), &count).is_valid());
+
+		ASSERT_TRUE(driver.receive(1, 7));
+		exec.run_pending();
+		ASSERT_EQ(driver.m_sent[1].size(), 1U);
+
+		//the driver still owns the write, the coroutine must not go away
+		exec.cancel_all();
+		EXPECT_EQ(exec.get_num_waiting(), 1U);
+
+		//unconfiguring the ep aborts it
+		driver.ep_unconfig(0x81);
+		exec.cancel_all();
+		EXPECT_EQ(exec.get_num_waiting(), 0U);
+		EXPECT_EQ(count, 0U);
+	}
+
+	TEST_F(Usb_coro, arena)
+	{
+		Coro_arena<64, 1> small;
+		Coro_arena_base::set_default(&small);
+
+		int sum = 0;
+		EXPECT_FALSE(sum_packets(exec.get_ep(0x01), 1, &sum).is_valid());
+		EXPECT_GT(small.get_max_request(), 64U);
+		EXPECT_EQ(exec.get_num_waiting(), 0U);
+
+		Coro_arena_base::set_default(nullptr);
+		EXPECT_FALSE(sum_packets(exec.get_ep(0x01), 1, &sum).is_valid());
+	}
+
+	Usb_coro_task serve_control(Usb_coro_control* const ctrl, size_t* const out_count)
+	{
+		for(;;)
+		{
+			const Usb_coro_control::Request* const req = co_await ctrl->next_setup();
+			if(req == nullptr)
+			{
+				co_return;
+			}
+
+			const uint8_t resp[] = {req->setup.bRequest, uint8_t(req->len)};
+			ctrl->complete(USB_common::USB_RESP::ACK, resp, sizeof(resp));
+			(*out_count)++;
+		}
+	}
+
+	TEST_F(Usb_coro, next_setup)
+	{
+		USB_core core;
+		Usb_coro_control ctrl;
+		ASSERT_TRUE(ctrl.initialize(&core));
+
+		size_t count = 0;
+		ASSERT_TRUE(serve_control(&ctrl, &count).is_valid());
+
+		std::array<uint8_t, 8> rx_mem = {1, 2, 3};
+		std::array<uint8_t, 8> tx_mem;
+		Buffer_adapter_rx rx(rx_mem.data(), rx_mem.size());
+		Buffer_adapter_tx tx(tx_mem.data(), tx_mem.size());
+		rx.resize(3);
+
+		Setup_packet req;
+		req.bmRequestType = 0x40;
+		req.bRequest = 0x21;
+		req.wValue = 0;
+		req.wIndex = 0;
+		req.wLength = 3;
+
+		EXPECT_EQ(Usb_coro_control::handle_request(&ctrl, &req, &rx, &tx), USB_common::USB_RESP::PENDING);
+		EXPECT_EQ(count, 1U);
+
+		//a stage longer than the request buffer is refused
+		req.wLength = Usb_coro_control::MAX_DATA_LEN + 1;
+		EXPECT_EQ(Usb_coro_control::handle_request(&ctrl, &req, &rx, &tx), USB_common::USB_RESP::FAIL);
+
+		ctrl.cancel();
+	}
+}
+
+#endif
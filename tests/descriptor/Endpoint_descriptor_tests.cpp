@@ -1,4 +1,5 @@
 #include "libusb_dev_cpp/descriptor/Endpoint_descriptor.hpp"
+#include "libusb_dev_cpp/driver/usb_driver_base.hpp"
 
 #include "gtest/gtest.h"
 
@@ -8,4 +9,39 @@ namespace
 	{
 		Endpoint_descriptor ep_desc;
 	}
+
+	TEST(Endpoint_descriptor, speed_params)
+	{
+		Endpoint_descriptor ep_desc;
+		ep_desc.bEndpointAddress = 0x81;
+		ep_desc.bmAttributes     = Endpoint_descriptor::build_bmAttributes(Endpoint_descriptor::ATTRIBUTE_TRANSFER::BULK);
+		ep_desc.set_speed_params(
+			usb_driver_base::get_max_bulk_ep_size(USB_common::USB_SPEED::FS), 0,
+			usb_driver_base::get_max_bulk_ep_size(USB_common::USB_SPEED::HS), 0
+			);
+
+		std::array<uint8_t, 16> tx_mem;
+		Buffer_adapter_tx tx;
+
+		tx.reset(tx_mem.data(), tx_mem.size());
+		ASSERT_TRUE(ep_desc.serialize_for_speed(&tx, USB_common::USB_SPEED::HS));
+		EXPECT_EQ(tx_mem[4], 0x00);
+		EXPECT_EQ(tx_mem[5], 0x02);
+
+		tx.reset(tx_mem.data(), tx_mem.size());
+		ASSERT_TRUE(ep_desc.serialize_for_speed(&tx, USB_common::USB_SPEED::FS));
+		EXPECT_EQ(tx_mem[4], 64);
+		EXPECT_EQ(tx_mem[5], 0x00);
+	}
+
+	TEST(usb_driver_base, max_ep_size)
+	{
+		EXPECT_EQ(usb_driver_base::get_max_bulk_ep_size(usb_driver_base::USB_SPEED::LS), 0U);
+		EXPECT_EQ(usb_driver_base::get_max_bulk_ep_size(usb_driver_base::USB_SPEED::FS), 64U);
+		EXPECT_EQ(usb_driver_base::get_max_bulk_ep_size(usb_driver_base::USB_SPEED::HS), 512U);
+
+		EXPECT_EQ(usb_driver_base::get_max_interrupt_ep_size(USB_common::USB_SPEED::LS), 8U);
+		EXPECT_EQ(usb_driver_base::get_max_interrupt_ep_size(USB_common::USB_SPEED::FS), 64U);
+		EXPECT_EQ(usb_driver_base::get_max_interrupt_ep_size(USB_common::USB_SPEED::HS), 1024U);
+	}
 }
@@ -0,0 +1,28 @@
+#include "libusb_dev_cpp/descriptor/Interface_association_descriptor.hpp"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+	TEST(Interface_association_descriptor, serialize)
+	{
+		Interface_association_descriptor iad;
+		iad.bFirstInterface   = 2;
+		iad.bInterfaceCount   = 2;
+		iad.bFunctionClass    = 0x02;
+		iad.bFunctionSubClass = 0x02;
+		iad.bFunctionProtocol = 0x01;
+		iad.iFunction         = 4;
+
+		Interface_association_descriptor::Interface_association_descriptor_array arr;
+		ASSERT_TRUE(iad.serialize(&arr));
+
+		const Interface_association_descriptor::Interface_association_descriptor_array expected = {0x08, 0x0B, 0x02, 0x02, 0x02, 0x02, 0x01, 0x04};
+		EXPECT_EQ(expected, arr);
+
+		Interface_association_descriptor iad2;
+		ASSERT_TRUE(iad2.deserialize(arr));
+		EXPECT_EQ(2, iad2.bFirstInterface);
+		EXPECT_EQ(4, iad2.iFunction);
+	}
+}
@@ -0,0 +1,110 @@
+#include "libusb_dev_cpp/descriptor/MS_OS_20_descriptor.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+namespace
+{
+	TEST(MS_OS_20_descriptor_set, single_function)
+	{
+		MS_OS_20_descriptor_set set(0x20);
+		EXPECT_TRUE(set.add_compatible_id("WINUSB"));
+		EXPECT_TRUE(set.add_device_interface_guid("{88BAE032-5A81-49F0-BC3D-A4FF138216D6}"));
+		EXPECT_TRUE(set.finalize());
+
+		//header 10, compatible id 20, registry property 10 + 42 + 80
+		const std::vector<uint8_t>& data = set.get_data();
+		ASSERT_EQ(data.size(), 162U);
+
+		//set header
+		EXPECT_EQ(data[0], 10);
+		EXPECT_EQ(data[2], 0x00);
+		EXPECT_EQ(data[7], 0x06);
+		EXPECT_EQ(data[8], 162);
+		EXPECT_EQ(data[9], 0);
+
+		//compatible id
+		EXPECT_EQ(data[10], 20);
+		EXPECT_EQ(data[12], 0x03);
+		EXPECT_EQ(0, memcmp(&data[14], "WINUSB\0\0", 8));
+
+		//registry property
+		EXPECT_EQ(data[30], 132);
+		EXPECT_EQ(data[32], 0x04);
+		EXPECT_EQ(data[34], 7);
+		EXPECT_EQ(data[36], 42);
+		EXPECT_EQ(data[38], 'D');
+		EXPECT_EQ(data[39], 0);
+		EXPECT_EQ(data[80], 80);
+		EXPECT_EQ(data[82], '{');
+		EXPECT_EQ(data[158], 0);
+		EXPECT_EQ(data[161], 0);
+	}
+
+	TEST(MS_OS_20_descriptor_set, composite_subsets)
+	{
+		MS_OS_20_descriptor_set set(0x20);
+		set.add_configuration_subset(0);
+		set.add_function_subset(2);
+		EXPECT_TRUE(set.add_compatible_id("WINUSB"));
+		EXPECT_TRUE(set.finalize());
+
+		const std::vector<uint8_t>& data = set.get_data();
+		ASSERT_EQ(data.size(), 46U);
+
+		//configuration subset covers its own header, the function subset and the feature
+		EXPECT_EQ(data[12], 0x01);
+		EXPECT_EQ(data[16], 36);
+
+		//function subset
+		EXPECT_EQ(data[20], 0x02);
+		EXPECT_EQ(data[22], 2);
+		EXPECT_EQ(data[24], 28);
+	}
+
+	TEST(MS_OS_20_descriptor_set, bos)
+	{
+		MS_OS_20_descriptor_set set(0x20);
+		EXPECT_TRUE(set.add_compatible_id("WINUSB"));
+
+		Platform_capability_descriptor cap;
+		EXPECT_FALSE(set.make_platform_capability(&cap));
+
+		EXPECT_TRUE(set.finalize());
+		EXPECT_TRUE(set.make_platform_capability(&cap));
+
+		USB20_extension_descriptor usb20_ext;
+		usb20_ext.set_lpm(true);
+
+		BOS_descriptor bos;
+		bos.get_desc_list().push_back(&usb20_ext);
+		bos.get_desc_list().push_back(&cap);
+
+		EXPECT_EQ(bos.get_total_size(), 40U);
+
+		std::array<uint8_t, 64> tx_mem;
+		Buffer_adapter_tx tx;
+		tx.reset(tx_mem.data(), tx_mem.size());
+
+		EXPECT_TRUE(bos.serialize(&tx));
+		EXPECT_TRUE(usb20_ext.serialize(&tx));
+		EXPECT_TRUE(cap.serialize(&tx));
+		ASSERT_EQ(tx.size(), 40U);
+
+		const std::array<uint8_t, 12> head = {0x05, 0x0F, 40, 0, 2, 0x07, 0x10, 0x02, 0x06, 0x00, 0x00, 0x00};
+		EXPECT_EQ(0, memcmp(tx_mem.data(), head.data(), head.size()));
+
+		//platform capability
+		EXPECT_EQ(tx_mem[12], 28);
+		EXPECT_EQ(tx_mem[13], 0x10);
+		EXPECT_EQ(tx_mem[14], 0x05);
+		EXPECT_EQ(tx_mem[16], 0xDF);
+		EXPECT_EQ(tx_mem[31], 0x9F);
+		//wMSOSDescriptorSetTotalLength and bMS_VendorCode
+		EXPECT_EQ(tx_mem[36], 30);
+		EXPECT_EQ(tx_mem[37], 0);
+		EXPECT_EQ(tx_mem[38], 0x20);
+		EXPECT_EQ(tx_mem[39], 0);
+	}
+}
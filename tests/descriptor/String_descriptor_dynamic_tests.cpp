@@ -0,0 +1,80 @@
+#include "libusb_dev_cpp/descriptor/String_descriptor_dynamic.hpp"
+#include "libusb_dev_cpp/util/Descriptor_table.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	size_t fill_serial(void* ctx, char* const buf, const size_t maxlen)
+	{
+		size_t* const count = static_cast<size_t*>(ctx);
+		(*count)++;
+
+		const char sn[] = "0042001F3138";
+		const size_t len = std::min(sizeof(sn) - 1, maxlen);
+		memcpy(buf, sn, len);
+		return len;
+	}
+
+	TEST(String_descriptor_dynamic, lazy)
+	{
+		size_t count = 0;
+		String_descriptor_dynamic desc(&fill_serial, &count);
+		EXPECT_EQ(count, 0U);
+
+		std::array<uint8_t, 32> tx_mem;
+		Buffer_adapter_tx tx;
+		tx.reset(tx_mem.data(), tx_mem.size());
+		ASSERT_TRUE(desc.serialize(&tx));
+		EXPECT_EQ(count, 1U);
+		ASSERT_EQ(tx.size(), 2U + 2U * 12U);
+
+		EXPECT_EQ(tx_mem[0], 26);
+		EXPECT_EQ(tx_mem[1], 0x03);
+		EXPECT_EQ(tx_mem[2], '0');
+		EXPECT_EQ(tx_mem[3], 0x00);
+		EXPECT_EQ(tx_mem[24], '8');
+
+		//served from the cache
+		tx.reset(tx_mem.data(), tx_mem.size());
+		ASSERT_TRUE(desc.serialize(&tx));
+		EXPECT_EQ(desc.size(), 26U);
+		EXPECT_EQ(count, 1U);
+
+		desc.invalidate();
+		EXPECT_EQ(desc.size(), 26U);
+		EXPECT_EQ(count, 2U);
+	}
+
+	TEST(String_descriptor_dynamic, no_callback)
+	{
+		String_descriptor_dynamic desc;
+		EXPECT_EQ(desc.size(), 2U);
+	}
+
+	TEST(String_descriptor_dynamic, flat_table)
+	{
+		size_t count = 0;
+
+		Descriptor_table table;
+		table.set_string_descriptor(std::make_shared<String_descriptor_dynamic>(&fill_serial, &count), String_descriptor_zero::LANGID::ENUS, 3);
+		ASSERT_TRUE(table.build_flat_table());
+
+		//not generated at build time, and not in the flat table
+		EXPECT_EQ(count, 0U);
+		const uint8_t* ptr = nullptr;
+		size_t len = 0;
+		EXPECT_FALSE(table.get_flat_table().find(static_cast<uint8_t>(USB_common::DESCRIPTOR_TYPE::STRING), 3, static_cast<uint16_t>(String_descriptor_zero::LANGID::ENUS), &ptr, &len));
+
+		table.release_object_tables();
+
+		String_desc_table::String_desc_ptr desc = table.get_string_descriptor(String_descriptor_zero::LANGID::ENUS, 3);
+		ASSERT_TRUE(desc);
+		EXPECT_TRUE(desc->is_dynamic());
+		EXPECT_EQ(desc->size(), 26U);
+		EXPECT_EQ(count, 1U);
+	}
+}
@@ -0,0 +1,133 @@
+#include "libusb_dev_cpp/descriptor/String_descriptor_utf8.hpp"
+#include "libusb_dev_cpp/util/Descriptor_table.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+	//does set_string_descriptor take a T, detected so a rejected call does not break the build
+	template<typename T, typename = void>
+	struct Can_set_string : std::false_type
+	{
+
+	};
+	template<typename T>
+	struct Can_set_string<T, decltype(std::declval<Descriptor_table&>().set_string_descriptor(std::declval<T>(), String_descriptor_zero::LANGID::ENUS, 1), void())> : std::true_type
+	{
+
+	};
+
+	//encoded at compile time
+	constexpr auto ascii_str = make_utf8_string_descriptor("USB");
+	static_assert(ascii_str.size() == 8, "ascii is one code unit per char");
+
+	constexpr auto latin_str = make_utf8_string_descriptor(u8"débit µ");
+	static_assert(latin_str.size() == 2 + 2 * 7, "two byte sequences are one code unit");
+
+	//U+1F50C, outside the BMP
+	constexpr auto emoji_str = make_utf8_string_descriptor(u8"a\U0001F50C");
+	static_assert(emoji_str.size() == 2 + 2 * 3, "surrogate pair is two code units");
+
+	TEST(String_descriptor_utf8, encode)
+	{
+		EXPECT_EQ(ascii_str.buf[1], 0x03);
+		EXPECT_EQ(ascii_str.buf[2], 'U');
+		EXPECT_EQ(ascii_str.buf[3], 0x00);
+
+		//e acute
+		EXPECT_EQ(latin_str.buf[4], 0xE9);
+		EXPECT_EQ(latin_str.buf[5], 0x00);
+		//micro sign
+		EXPECT_EQ(latin_str.buf[14], 0xB5);
+		EXPECT_EQ(latin_str.buf[15], 0x00);
+
+		//D83D DD0C
+		EXPECT_EQ(emoji_str.buf[4], 0x3D);
+		EXPECT_EQ(emoji_str.buf[5], 0xD8);
+		EXPECT_EQ(emoji_str.buf[6], 0x0C);
+		EXPECT_EQ(emoji_str.buf[7], 0xDD);
+	}
+
+	TEST(String_descriptor_utf8, invalid_runtime)
+	{
+		//lone continuation byte and a truncated sequence
+		const char bad[] = {'a', char(0x80), char(0xE2), char(0x82), 'b', 0};
+
+		String_descriptor_base desc;
+		desc.assign(bad);
+		ASSERT_EQ(desc.size(), 2U + 2U * 4U);
+
+		std::array<uint8_t, 16> tx_mem;
+		Buffer_adapter_tx tx;
+		tx.reset(tx_mem.data(), tx_mem.size());
+		ASSERT_TRUE(desc.serialize(&tx));
+		ASSERT_EQ(tx.size(), 10U);
+
+		EXPECT_EQ(tx_mem[2], 'a');
+		EXPECT_EQ(tx_mem[4], 0xFD);
+		EXPECT_EQ(tx_mem[5], 0xFF);
+		EXPECT_EQ(tx_mem[6], 0xFD);
+		EXPECT_EQ(tx_mem[8], 'b');
+	}
+
+	TEST(String_descriptor_utf8, static_desc)
+	{
+		String_descriptor_static desc(emoji_str);
+		EXPECT_EQ(desc.size(), 8U);
+
+		std::array<uint8_t, 16> tx_mem;
+		Buffer_adapter_tx tx;
+		tx.reset(tx_mem.data(), tx_mem.size());
+		ASSERT_TRUE(desc.serialize(&tx));
+		EXPECT_EQ(0, memcmp(tx_mem.data(), emoji_str.data(), 8));
+	}
+
+	TEST(String_descriptor_utf8, langid_zero)
+	{
+		Descriptor_table table;
+		table.set_string_descriptor(ascii_str, static_cast<String_descriptor_zero::LANGID>(0x0407), 1);
+		table.set_string_descriptor(latin_str, String_descriptor_zero::LANGID::ENUS, 1);
+
+		String_desc_table::String_desc_const_ptr zero = static_cast<const Descriptor_table&>(table).get_string_descriptor(String_descriptor_zero::LANGID::NONE, 0);
+		ASSERT_TRUE(zero);
+		ASSERT_EQ(zero->size(), 6U);
+
+		std::array<uint8_t, 16> tx_mem;
+		Buffer_adapter_tx tx;
+		tx.reset(tx_mem.data(), tx_mem.size());
+		ASSERT_TRUE(zero->serialize(&tx));
+
+		const std::array<uint8_t, 6> expected = {0x06, 0x03, 0x07, 0x04, 0x09, 0x04};
+		EXPECT_EQ(0, memcmp(tx_mem.data(), expected.data(), expected.size()));
+
+		String_desc_table::String_desc_const_ptr en = static_cast<const Descriptor_table&>(table).get_string_descriptor(String_descriptor_zero::LANGID::ENUS, 1);
+		ASSERT_TRUE(en);
+		EXPECT_EQ(en->size(), latin_str.size());
+	}
+
+	TEST(String_descriptor_utf8, temporary_rejected)
+	{
+		typedef decltype(make_utf8_string_descriptor("USB")) Data;
+
+		//only a pointer is kept, so a temporary, eg set_string_descriptor(make_utf8_string_descriptor(...)), would dangle
+		static_assert(!Can_set_string<decltype(make_utf8_string_descriptor("USB"))>::value, "temporary must not bind");
+		static_assert(!Can_set_string<const Data&&>::value, "const temporary must not bind");
+		static_assert(!std::is_constructible<String_descriptor_static, Data>::value, "temporary must not bind");
+		static_assert(!std::is_constructible<String_descriptor_static, const Data&&>::value, "const temporary must not bind");
+
+		//an object that outlives the table still works
+		static_assert(Can_set_string<const Data&>::value, "lvalue binds");
+		static_assert(std::is_constructible<String_descriptor_static, const Data&>::value, "lvalue binds");
+
+		Descriptor_table table;
+		table.set_string_descriptor(ascii_str, String_descriptor_zero::LANGID::ENUS, 2);
+
+		String_desc_table::String_desc_ptr desc = table.get_string_descriptor(String_descriptor_zero::LANGID::ENUS, 2);
+		ASSERT_TRUE(desc);
+		EXPECT_EQ(desc->size(), ascii_str.size());
+	}
+}
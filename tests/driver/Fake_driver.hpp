@@ -0,0 +1,217 @@
+#pragma once
+
+#include "libusb_dev_cpp/driver/usb_driver_base.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+//the buffer path of a device driver, the test plays the isr
+class Fake_driver : public usb_driver_base
+{
+public:
+	bool initialize() override {return true;}
+	void get_info() override {}
+	bool enable() override {return true;}
+	bool disable() override {return true;}
+	bool connect() override {return true;}
+	bool disconnect() override {return true;}
+	bool set_address(const uint8_t addr) override {return true;}
+	bool ep_config(const ep_cfg& ep) override
+	{
+		if(ep.num == 0)
+		{
+			m_ep0 = ep;
+		}
+		return true;
+	}
+	bool ep_unconfig(const uint8_t ep) override
+	{
+		const uint8_t ep_addr = USB_common::get_ep_addr(ep);
+
+		//like the hardware drivers, give back everything queued on an IN ep before the tokens are aborted
+		if(USB_common::is_in_ep(ep) && m_tx_buffer)
+		{
+			std::vector<Buffer_adapter_base*> queued;
+			{
+				std::lock_guard<std::mutex> lock(m_sent_mutex);
+				queued.swap(m_sent[ep_addr]);
+			}
+			for(Buffer_adapter_base* const buf : queued)
+			{
+				m_tx_buffer->release_buffer(ep_addr, buf);
+			}
+		}
+
+		tx_token_abort(ep_addr);
+		return true;
+	}
+	bool ep_is_stalled(const uint8_t ep) override {return false;}
+	void ep_stall(const uint8_t ep) override {m_stalls.push_back(ep);}
+	void ep_unstall(const uint8_t ep) override {}
+	int ep_write(const uint8_t ep, const uint8_t* buf, const uint16_t len) override
+	{
+		if(USB_common::get_ep_addr(ep) == 0)
+		{
+			m_ep0_in.emplace_back(buf, buf + len);
+		}
+		return len;
+	}
+	int ep_read(const uint8_t ep, uint8_t* const buf, const uint16_t max_len) override {return 0;}
+	uint16_t get_frame_number() override {return m_frame;}
+	size_t get_serial_number(uint8_t* const buf, const size_t maxlen) override {return 0;}
+	USB_common::USB_SPEED get_speed() const override {return USB_common::USB_SPEED::FS;}
+	//USB_core::poll_driver hands over its event queue, post() then plays the isr
+	void poll(const USB_common::Event_callback& func) override {m_post = func;}
+	bool remote_wakeup() override
+	{
+		m_rwusig = true;
+		return true;
+	}
+	void remote_wakeup_end() override {m_rwusig = false;}
+	const ep_cfg& get_ep0_config() const override {return m_ep0;}
+	bool get_rx_ep_config(const uint8_t addr, ep_cfg* const out_ep) override {return false;}
+	bool get_tx_ep_config(const uint8_t addr, ep_cfg* const out_ep) override {return false;}
+	void set_data0(const uint8_t ep) override {}
+	const Setup_packet::Setup_packet_array* get_last_setup_packet() const override {return &m_setup;}
+
+	Buffer_adapter_base* wait_rx_buffer(const uint8_t ep) override {return nullptr;}
+	void release_rx_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		m_rx_buffer->release_buffer(USB_common::get_ep_addr(ep), buf);
+	}
+	Buffer_adapter_base* wait_tx_buffer(const uint8_t ep) override {return nullptr;}
+	bool enqueue_tx_buffer(const uint8_t ep, Buffer_adapter_base* const buf) override
+	{
+		return enqueue_tx_buffer(ep, buf, nullptr);
+	}
+	bool enqueue_tx_buffer(const uint8_t ep, Buffer_adapter_base* const buf, Tx_token* const token) override
+	{
+		const uint8_t ep_addr = USB_common::get_ep_addr(ep);
+		if(token)
+		{
+			if(!token->queue(ep_addr, buf, get_tx_timestamp()))
+			{
+				return false;
+			}
+			m_tx_tokens[ep_addr].push(token);
+		}
+		std::lock_guard<std::mutex> lock(m_sent_mutex);
+		m_sent[ep_addr].push_back(buf);
+		tx_token_started(ep_addr, buf);
+		return true;
+	}
+
+	//host ACKed the oldest IN buffer
+	bool complete_tx(const uint8_t ep_addr)
+	{
+		Buffer_adapter_base* buf = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_sent_mutex);
+			if(m_sent[ep_addr].empty())
+			{
+				return false;
+			}
+			buf = m_sent[ep_addr].front();
+			m_sent[ep_addr].erase(m_sent[ep_addr].begin());
+			m_acked[ep_addr].insert(m_acked[ep_addr].end(), buf->data(), buf->data() + buf->size());
+		}
+
+		m_frame++;
+		tx_token_finished(ep_addr, buf, Tx_token::STATE::DONE);
+		m_tx_buffer->release_buffer(ep_addr, buf);
+		get_ep_tx_callback(ep_addr)(USB_common::USB_EVENTS::EP_TX, 0x80 | ep_addr);
+		return true;
+	}
+
+	size_t get_sent_count(const uint8_t ep_addr)
+	{
+		std::lock_guard<std::mutex> lock(m_sent_mutex);
+		return m_sent[ep_addr].size();
+	}
+
+	//host sent an OUT packet
+	bool receive(const uint8_t ep_addr, const uint8_t val)
+	{
+		Buffer_adapter_base* const buf = m_rx_buffer->poll_allocate_buffer(ep_addr);
+		if(buf == nullptr)
+		{
+			return false;
+		}
+		buf->reset();
+		buf->insert(val);
+		m_rx_buffer->poll_enqueue_buffer(ep_addr, buf);
+		get_ep_rx_callback(ep_addr)(USB_common::USB_EVENTS::EP_RX, ep_addr);
+		return true;
+	}
+
+	//host sent an OUT packet, posted to the core the way a driver isr does
+	bool receive_posted(const uint8_t ep_addr, const uint8_t val)
+	{
+		Buffer_adapter_base* const buf = m_rx_buffer->poll_allocate_buffer(ep_addr);
+		if(buf == nullptr)
+		{
+			return false;
+		}
+		buf->reset();
+		buf->insert(val);
+		m_rx_buffer->poll_enqueue_buffer(ep_addr, buf);
+		if(claim_ep_rx_event(ep_addr))
+		{
+			post(USB_common::USB_EVENTS::EP_RX, ep_addr);
+		}
+		return true;
+	}
+
+	void post(const USB_common::USB_EVENTS event, const uint8_t ep)
+	{
+		m_post(event, ep);
+	}
+
+	//host sent a setup packet
+	bool setup(const uint8_t bmRequestType, const uint8_t bRequest, const uint16_t wValue, const uint16_t wIndex, const uint16_t wLength)
+	{
+		Setup_packet req;
+		req.bmRequestType = bmRequestType;
+		req.bRequest = bRequest;
+		req.wValue = wValue;
+		req.wIndex = wIndex;
+		req.wLength = wLength;
+		req.serialize(&m_setup);
+
+		post(USB_common::USB_EVENTS::CTRL_SETUP_PHASE_DONE, 0x00);
+		return true;
+	}
+
+	//host sent an ep0 OUT data packet
+	bool receive_ep0(const uint8_t* const data, const size_t len)
+	{
+		Buffer_adapter_base* const buf = m_ep0_buffer->poll_allocate_buffer(0);
+		if(buf == nullptr)
+		{
+			return false;
+		}
+		buf->reset();
+		buf->insert(data, len);
+		m_ep0_buffer->poll_enqueue_buffer(0, buf);
+		post(USB_common::USB_EVENTS::EP_RX, 0x00);
+		return true;
+	}
+
+	std::mutex m_sent_mutex;
+	//loaded IN buffers, oldest first
+	std::array<std::vector<Buffer_adapter_base*>, 4> m_sent;
+	//bytes the host has taken
+	std::array<std::vector<uint8_t>, 4> m_acked;
+	uint16_t m_frame = 0;
+	ep_cfg m_ep0;
+	Setup_packet::Setup_packet_array m_setup;
+
+	USB_common::Event_callback m_post;
+	//each ep0 IN packet written, zlps included
+	std::vector<std::vector<uint8_t>> m_ep0_in;
+	std::vector<uint8_t> m_stalls;
+	//resume signaling
+	std::atomic<bool> m_rwusig{false};
+};
@@ -0,0 +1,304 @@
+#include "libusb_dev_cpp/driver/Rx_flow_control.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	//host threads, give up the cpu instead of spinning
+	template<size_t NUM_CH>
+	class Wait_yield
+	{
+	public:
+		void wait(const size_t ch)
+		{
+			std::this_thread::yield();
+		}
+		void notify(const size_t ch)
+		{
+
+		}
+		void notify_isr(const size_t ch)
+		{
+
+		}
+	};
+
+	struct Event_log
+	{
+		std::vector<Rx_flow_control::EVENT> events;
+		std::vector<size_t> pending;
+
+		static void callback(void* ctx, const uint8_t ep, const Rx_flow_control::EVENT event, const size_t pending)
+		{
+			Event_log* const log = static_cast<Event_log*>(ctx);
+			log->events.push_back(event);
+			log->pending.push_back(pending);
+		}
+	};
+
+	TEST(Rx_flow_control, set_config)
+	{
+		Rx_flow_control flow;
+
+		EXPECT_EQ(flow.get_config(1).policy, Rx_flow_control::POLICY::NAK);
+
+		Rx_flow_control::Config cfg;
+		cfg.policy = Rx_flow_control::POLICY::DROP_OLDEST;
+		cfg.high_watermark = 2;
+		cfg.low_watermark  = 3;
+		EXPECT_FALSE(flow.set_config(1, cfg));
+
+		cfg.low_watermark = 1;
+		EXPECT_TRUE(flow.set_config(1, cfg));
+		EXPECT_FALSE(flow.set_config(Rx_flow_control::MAX_EP, cfg));
+
+		EXPECT_EQ(flow.get_config(1).policy, Rx_flow_control::POLICY::DROP_OLDEST);
+		EXPECT_EQ(flow.get_config(2).policy, Rx_flow_control::POLICY::NAK);
+	}
+
+	TEST(Rx_flow_control, nak_holds_only_its_ep)
+	{
+		Rx_flow_control flow;
+		Event_log log;
+		flow.set_event_callback(&Event_log::callback, &log);
+
+		Rx_flow_control::Config cfg;
+		cfg.high_watermark = 3;
+		cfg.low_watermark  = 1;
+		ASSERT_TRUE(flow.set_config(1, cfg));
+
+		EXPECT_FALSE(flow.on_queued(1));
+		EXPECT_FALSE(flow.on_queued(1));
+		EXPECT_TRUE(flow.on_queued(1));
+		EXPECT_TRUE(flow.is_held(1));
+
+		//no watermark on ep 2
+		for(size_t i = 0; i < 8; i++)
+		{
+			EXPECT_FALSE(flow.on_queued(2));
+		}
+		EXPECT_FALSE(flow.is_held(2));
+
+		ASSERT_EQ(log.events.size(), 1U);
+		EXPECT_EQ(log.events[0], Rx_flow_control::EVENT::HIGH_WATERMARK);
+		EXPECT_EQ(log.pending[0], 3U);
+
+		//hysteresis, stays held until pending is down to the low watermark
+		EXPECT_FALSE(flow.on_released(1));
+		EXPECT_TRUE(flow.is_held(1));
+		EXPECT_TRUE(flow.on_released(1));
+		EXPECT_FALSE(flow.is_held(1));
+		EXPECT_EQ(flow.get_pending(1), 1U);
+
+		ASSERT_EQ(log.events.size(), 2U);
+		EXPECT_EQ(log.events[1], Rx_flow_control::EVENT::LOW_WATERMARK);
+		EXPECT_EQ(log.pending[1], 1U);
+
+		EXPECT_FALSE(flow.on_released(1));
+		EXPECT_FALSE(flow.on_released(1));
+		EXPECT_EQ(flow.get_pending(1), 0U);
+	}
+
+	TEST(Rx_flow_control, watermark_without_nak)
+	{
+		Rx_flow_control flow;
+		Event_log log;
+		flow.set_event_callback(&Event_log::callback, &log);
+
+		Rx_flow_control::Config cfg;
+		cfg.policy = Rx_flow_control::POLICY::DROP_NEWEST;
+		cfg.high_watermark = 2;
+		cfg.low_watermark  = 0;
+		ASSERT_TRUE(flow.set_config(3, cfg));
+
+		EXPECT_FALSE(flow.on_queued(3));
+		EXPECT_FALSE(flow.on_queued(3));
+		EXPECT_FALSE(flow.on_queued(3));
+		EXPECT_FALSE(flow.is_held(3));
+
+		//one edge, not one per packet
+		ASSERT_EQ(log.events.size(), 1U);
+		EXPECT_EQ(log.events[0], Rx_flow_control::EVENT::HIGH_WATERMARK);
+
+		EXPECT_EQ(flow.on_underrun(3), Rx_flow_control::POLICY::DROP_NEWEST);
+		flow.on_drop(3);
+		EXPECT_EQ(flow.get_underrun_count(3), 1U);
+		EXPECT_EQ(flow.get_drop_count(3), 1U);
+
+		EXPECT_FALSE(flow.on_released(3));
+		EXPECT_FALSE(flow.on_released(3));
+		EXPECT_FALSE(flow.on_released(3));
+
+		ASSERT_EQ(log.events.size(), 4U);
+		EXPECT_EQ(log.events[1], Rx_flow_control::EVENT::UNDERRUN);
+		EXPECT_EQ(log.events[2], Rx_flow_control::EVENT::DROP);
+		EXPECT_EQ(log.events[3], Rx_flow_control::EVENT::LOW_WATERMARK);
+	}
+
+	TEST(Rx_flow_control, drop_oldest_reclaims)
+	{
+		Rx_flow_control flow;
+
+		Rx_flow_control::Config cfg;
+		cfg.policy = Rx_flow_control::POLICY::DROP_OLDEST;
+		ASSERT_TRUE(flow.set_config(1, cfg));
+
+		flow.on_queued(1);
+		flow.on_queued(1);
+
+		EXPECT_EQ(flow.on_underrun(1), Rx_flow_control::POLICY::DROP_OLDEST);
+		flow.on_reclaimed(1);
+		flow.on_queued(1);
+
+		EXPECT_EQ(flow.get_pending(1), 2U);
+		EXPECT_EQ(flow.get_drop_count(1), 1U);
+	}
+
+	TEST(Rx_flow_control, drop_oldest_isr_and_app_threads)
+	{
+		constexpr uint8_t  EP       = 1;
+		constexpr uint32_t NUM_ITER = 100000;
+
+		typedef EP_buffer_mgr_lockfree<2, 4, 64, 4, Wait_yield> Mgr;
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		Rx_flow_control flow;
+		Rx_flow_control::Config cfg;
+		cfg.policy = Rx_flow_control::POLICY::DROP_OLDEST;
+		ASSERT_TRUE(flow.set_config(EP, cfg));
+
+		//stands in for masking the usb isr, the flow state is only touched by the isr or with it masked
+		std::mutex isr_mask;
+		std::atomic<bool> isr_done(false);
+		std::atomic<bool> fail(false);
+
+		mgr->set_buffer(EP, mgr->poll_allocate_buffer(EP));
+
+		//the otghs2 RXFLVL path, one packet per pass, reclaiming from the app ring when the pool is dry
+		std::thread isr([&](){
+			for(uint32_t i = 0; i < NUM_ITER; i++)
+			{
+				std::lock_guard<std::mutex> lock(isr_mask);
+
+				Buffer_adapter_base* curr_buf = mgr->get_buffer(EP);
+				curr_buf->reset();
+				curr_buf->insert(reinterpret_cast<const uint8_t*>(&i), sizeof(i));
+
+				Buffer_adapter_base* new_buf = mgr->poll_allocate_buffer(EP);
+				bool enqueue = true;
+				if(new_buf == nullptr)
+				{
+					if(flow.on_underrun(EP) != Rx_flow_control::POLICY::DROP_OLDEST)
+					{
+						fail = true;
+					}
+
+					new_buf = mgr->poll_dequeue_buffer_isr(EP);
+					if(new_buf)
+					{
+						flow.on_reclaimed(EP);
+					}
+					else
+					{
+						new_buf = curr_buf;
+						enqueue = false;
+						flow.on_drop(EP);
+					}
+				}
+
+				if(enqueue)
+				{
+					if(!mgr->poll_enqueue_buffer_isr(EP, curr_buf))
+					{
+						fail = true;
+					}
+					flow.on_queued(EP);
+				}
+
+				mgr->set_buffer(EP, new_buf);
+			}
+			isr_done = true;
+		});
+
+		//the app task, dequeues without masking the isr, so it races the reclaim
+		size_t received = 0;
+		std::thread app([&](){
+			uint32_t last = 0;
+			for(;;)
+			{
+				const bool done = isr_done;
+				Buffer_adapter_base* buf = mgr->poll_dequeue_buffer(EP);
+				if(buf == nullptr)
+				{
+					if(done)
+					{
+						break;
+					}
+					std::this_thread::yield();
+					continue;
+				}
+
+				//packets may be dropped, but never seen twice or out of order
+				uint32_t val = 0;
+				std::copy_n(buf->data(), sizeof(val), reinterpret_cast<uint8_t*>(&val));
+				if((buf->size() != sizeof(val)) || ((received != 0) && (val <= last)))
+				{
+					fail = true;
+				}
+				last = val;
+				received++;
+
+				std::lock_guard<std::mutex> lock(isr_mask);
+				mgr->release_buffer(EP, buf);
+				flow.on_released(EP);
+			}
+		});
+
+		isr.join();
+		app.join();
+
+		EXPECT_FALSE(fail);
+
+		//every packet was either read by the app or counted as a drop
+		EXPECT_EQ(received + flow.get_drop_count(EP), NUM_ITER);
+		EXPECT_EQ(flow.get_pending(EP), 0U);
+
+		//all buffers came back, the active one plus the rest of the pool
+		EXPECT_NE(mgr->get_buffer(EP), nullptr);
+		for(size_t i = 0; i < 3; i++)
+		{
+			EXPECT_NE(mgr->poll_allocate_buffer(EP), nullptr);
+		}
+		EXPECT_EQ(mgr->poll_allocate_buffer(EP), nullptr);
+	}
+
+	TEST(Rx_flow_control, reset)
+	{
+		Rx_flow_control flow;
+
+		Rx_flow_control::Config cfg;
+		cfg.high_watermark = 1;
+		ASSERT_TRUE(flow.set_config(1, cfg));
+
+		EXPECT_TRUE(flow.on_queued(1));
+		flow.on_underrun(1);
+
+		flow.reset_all();
+
+		EXPECT_FALSE(flow.is_held(1));
+		EXPECT_EQ(flow.get_pending(1), 0U);
+		EXPECT_EQ(flow.get_underrun_count(1), 0U);
+		EXPECT_EQ(flow.get_config(1).high_watermark, 1U);
+
+		//out of range is ignored
+		EXPECT_FALSE(flow.on_queued(Rx_flow_control::MAX_EP));
+		EXPECT_EQ(flow.on_underrun(Rx_flow_control::MAX_EP), Rx_flow_control::POLICY::BLOCK);
+	}
+}
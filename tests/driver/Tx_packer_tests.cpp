@@ -0,0 +1,149 @@
+#include "libusb_dev_cpp/driver/Tx_packer.hpp"
+
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_wait_std.hpp"
+
+#include "Fake_driver.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef EP_buffer_mgr_lockfree<2, 4, 64, 4> Buffer_mgr;
+
+	class Tx_packer_test : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			tx_mgr = std::make_unique<Buffer_mgr>();
+			driver.set_tx_buffer(tx_mgr.get());
+		}
+
+		std::unique_ptr<Buffer_mgr> tx_mgr;
+		Fake_driver driver;
+	};
+
+	TEST_F(Tx_packer_test, packs_while_busy)
+	{
+		Tx_packer<8, 16> packer;
+		ASSERT_FALSE(packer.initialize(&driver, 0x01, 16));
+		ASSERT_TRUE(packer.initialize(&driver, 0x81, 16));
+		ASSERT_TRUE(packer.bind_ep());
+
+		//ep idle, the first record goes out on its own
+		const uint8_t rec[] = {0, 1, 2, 3, 4, 5};
+		ASSERT_TRUE(packer.poll_write(rec, sizeof(rec)));
+		ASSERT_EQ(driver.get_sent_count(1), 1U);
+		EXPECT_EQ(driver.m_sent[1][0]->size(), 6U);
+
+		//while that is on the wire, the next ones fill one buffer and spill into another
+		for(size_t i = 0; i < 4; i++)
+		{
+			ASSERT_TRUE(packer.poll_write(rec, sizeof(rec)));
+		}
+		ASSERT_EQ(driver.get_sent_count(1), 2U);
+		EXPECT_EQ(driver.m_sent[1][1]->size(), 16U);
+
+		//the part filled buffer goes once the wire is free
+		ASSERT_TRUE(driver.complete_tx(1));
+		ASSERT_TRUE(driver.complete_tx(1));
+		ASSERT_EQ(driver.get_sent_count(1), 1U);
+		EXPECT_EQ(driver.m_sent[1][0]->size(), 8U);
+		ASSERT_TRUE(driver.complete_tx(1));
+
+		EXPECT_EQ(packer.get_packet_count(), 3U);
+		EXPECT_EQ(packer.get_byte_count(), 30U);
+
+		ASSERT_EQ(driver.m_acked[1].size(), 30U);
+		for(size_t i = 0; i < driver.m_acked[1].size(); i++)
+		{
+			EXPECT_EQ(driver.m_acked[1][i], i % 6);
+		}
+	}
+
+	TEST_F(Tx_packer_test, full)
+	{
+		Tx_packer<8, 2> packer;
+		ASSERT_TRUE(packer.initialize(&driver, 0x81, 64));
+		ASSERT_TRUE(packer.bind_ep());
+
+		const std::array<uint8_t, 16> rec = {};
+		EXPECT_FALSE(packer.wait_write(rec.data(), 17));
+
+		//no buffers left to pack into, the ring fills
+		while(tx_mgr->poll_allocate_buffer(1))
+		{
+
+		}
+		EXPECT_TRUE(packer.poll_write(rec.data(), 16));
+		EXPECT_FALSE(packer.poll_write(rec.data(), 1));
+		EXPECT_EQ(packer.get_full_count(), 1U);
+	}
+
+	//several tasks write records, the usb task plays host and ACKs whatever is loaded
+	TEST_F(Tx_packer_test, many_writers)
+	{
+		static constexpr size_t NUM_WRITER = 4;
+		static constexpr uint32_t NUM_REC = 5000;
+		static constexpr size_t REC_LEN = 5;
+
+		Tx_packer<8, 8, EP_buffer_wait_std> packer;
+		ASSERT_TRUE(packer.initialize(&driver, 0x81, 64));
+		ASSERT_TRUE(packer.bind_ep());
+
+		std::atomic<size_t> done(0);
+		std::vector<std::thread> writers;
+		for(size_t id = 0; id < NUM_WRITER; id++)
+		{
+			writers.emplace_back([&packer, &done, id]()
+				{
+					for(uint32_t seq = 0; seq < NUM_REC; seq++)
+					{
+						const uint8_t rec[REC_LEN] = {uint8_t(id), uint8_t(seq), uint8_t(seq >> 8), uint8_t(seq >> 16), 0xA5};
+						packer.wait_write(rec, sizeof(rec));
+					}
+					done++;
+				}
+			);
+		}
+
+		const size_t total = NUM_WRITER * NUM_REC * REC_LEN;
+		while((done.load() < NUM_WRITER) || (driver.m_acked[1].size() < total))
+		{
+			//no pump from here, the writers' own pumps must drain the ring
+			if(!driver.complete_tx(1))
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		for(std::thread& t : writers)
+		{
+			t.join();
+		}
+
+		//a byte stream of whole records, each writer's in order
+		ASSERT_EQ(driver.m_acked[1].size(), total);
+		std::array<uint32_t, NUM_WRITER> next;
+		next.fill(0);
+		for(size_t i = 0; i < total; i += REC_LEN)
+		{
+			const uint8_t* const rec = driver.m_acked[1].data() + i;
+			ASSERT_LT(rec[0], NUM_WRITER);
+			ASSERT_EQ(rec[4], 0xA5);
+
+			const uint32_t seq = uint32_t(rec[1]) | (uint32_t(rec[2]) << 8) | (uint32_t(rec[3]) << 16);
+			ASSERT_EQ(seq, next[rec[0]]);
+			next[rec[0]]++;
+		}
+
+		//mostly full packets
+		EXPECT_LT(packer.get_packet_count(), (total / 64) * 2);
+	}
+}
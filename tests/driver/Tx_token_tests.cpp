@@ -0,0 +1,185 @@
+#include "libusb_dev_cpp/driver/Tx_token.hpp"
+
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_wait_std.hpp"
+
+#include "Fake_driver.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+#include <thread>
+
+namespace
+{
+	void count_complete(void* ctx, Tx_token* const token)
+	{
+		(*static_cast<int*>(ctx))++;
+	}
+
+	TEST(Tx_token, timestamps)
+	{
+		std::array<uint8_t, 16> mem;
+		Buffer_adapter_base buf(mem.data(), mem.size());
+		buf.resize(10);
+
+		int calls = 0;
+		Tx_token token;
+		token.set_complete_callback(&count_complete, &calls);
+		EXPECT_EQ(token.get_state(), Tx_token::STATE::IDLE);
+
+		Tx_token_queue queue;
+		ASSERT_TRUE(token.queue(1, &buf, 100));
+		queue.push(&token);
+		EXPECT_TRUE(token.is_pending());
+		EXPECT_EQ(token.get_len(), 10U);
+
+		//a pending token can not be queued again
+		EXPECT_FALSE(token.queue(1, &buf, 101));
+
+		queue.on_started(&buf, 110);
+		EXPECT_EQ(token.get_state(), Tx_token::STATE::STARTED);
+
+		queue.on_finished(&buf, Tx_token::STATE::DONE, 125);
+		EXPECT_EQ(token.get_state(), Tx_token::STATE::DONE);
+		EXPECT_TRUE(queue.empty());
+		EXPECT_EQ(calls, 1);
+
+		EXPECT_EQ(token.get_ep(), 1U);
+		EXPECT_EQ(token.get_queued_time(), 100U);
+		EXPECT_EQ(token.get_started_time(), 110U);
+		EXPECT_EQ(token.get_complete_time(), 125U);
+
+		//reusable once complete
+		EXPECT_TRUE(token.queue(1, &buf, 200));
+	}
+
+	TEST(Tx_token, untracked_buffers_in_between)
+	{
+		std::array<uint8_t, 16> mem_a;
+		std::array<uint8_t, 16> mem_b;
+		std::array<uint8_t, 16> mem_c;
+		Buffer_adapter_base a(mem_a.data(), mem_a.size());
+		Buffer_adapter_base b(mem_b.data(), mem_b.size());
+		Buffer_adapter_base c(mem_c.data(), mem_c.size());
+
+		//a and c have tokens, b does not
+		Tx_token token_a;
+		Tx_token token_c;
+		Tx_token_queue queue;
+		token_a.queue(2, &a, 0);
+		queue.push(&token_a);
+		token_c.queue(2, &c, 0);
+		queue.push(&token_c);
+
+		queue.on_started(&a, 1);
+		queue.on_finished(&a, Tx_token::STATE::DONE, 2);
+		EXPECT_EQ(token_a.get_state(), Tx_token::STATE::DONE);
+
+		queue.on_started(&b, 3);
+		queue.on_finished(&b, Tx_token::STATE::DONE, 4);
+		EXPECT_EQ(token_c.get_state(), Tx_token::STATE::QUEUED);
+
+		queue.on_started(&c, 5);
+		queue.on_finished(&c, Tx_token::STATE::ABORTED, 6);
+		EXPECT_EQ(token_c.get_state(), Tx_token::STATE::ABORTED);
+		EXPECT_EQ(token_c.get_started_time(), 5U);
+		EXPECT_TRUE(queue.empty());
+	}
+
+	TEST(Tx_token, abort_all)
+	{
+		std::array<uint8_t, 16> mem;
+		Buffer_adapter_base buf(mem.data(), mem.size());
+
+		int calls = 0;
+		std::array<Tx_token, 3> tokens;
+		Tx_token_queue queue;
+		for(Tx_token& t : tokens)
+		{
+			t.set_complete_callback(&count_complete, &calls);
+			t.queue(1, &buf, 0);
+			queue.push(&t);
+		}
+
+		queue.abort_all(7);
+		EXPECT_TRUE(queue.empty());
+		EXPECT_EQ(calls, 3);
+		for(const Tx_token& t : tokens)
+		{
+			EXPECT_EQ(t.get_state(), Tx_token::STATE::ABORTED);
+			EXPECT_EQ(t.get_complete_time(), 7U);
+		}
+	}
+
+	TEST(Tx_token, unconfig_drops_queued)
+	{
+		typedef EP_buffer_mgr_lockfree<2, 4, 64, 4> Buffer_mgr;
+		std::unique_ptr<Buffer_mgr> tx_mgr = std::make_unique<Buffer_mgr>();
+
+		Fake_driver driver;
+		driver.set_tx_buffer(tx_mgr.get());
+
+		std::array<Tx_token, 3> tokens;
+		for(Tx_token& t : tokens)
+		{
+			Buffer_adapter_base* const buf = tx_mgr->poll_allocate_buffer(1);
+			ASSERT_NE(buf, nullptr);
+			buf->reset();
+			buf->insert(0xA5);
+			ASSERT_TRUE(driver.enqueue_tx_buffer(0x81, buf, &t));
+		}
+		ASSERT_EQ(driver.get_sent_count(1), 3U);
+
+		ASSERT_TRUE(driver.ep_unconfig(0x81));
+
+		usb_driver_base::ep_cfg cfg;
+		cfg.num  = 0x81;
+		cfg.size = 64;
+		cfg.type = usb_driver_base::EP_TYPE::BULK;
+		ASSERT_TRUE(driver.ep_config(cfg));
+
+		//the tokens say not sent, so nothing may go out once the ep is back
+		for(const Tx_token& t : tokens)
+		{
+			EXPECT_EQ(t.get_state(), Tx_token::STATE::ABORTED);
+		}
+		EXPECT_EQ(driver.get_sent_count(1), 0U);
+		EXPECT_FALSE(driver.complete_tx(1));
+		EXPECT_TRUE(driver.m_acked[1].empty());
+
+		//and the buffers are back in the pool
+		for(size_t i = 0; i < 4; i++)
+		{
+			EXPECT_NE(tx_mgr->poll_allocate_buffer(1), nullptr);
+		}
+	}
+
+	TEST(Tx_token, future_wait)
+	{
+		std::array<uint8_t, 16> mem;
+		Buffer_adapter_base buf(mem.data(), mem.size());
+
+		Tx_future<EP_buffer_wait_std> future;
+		Tx_token_queue queue;
+		ASSERT_TRUE(future.queue(1, &buf, 0));
+		queue.push(&future);
+
+		std::thread isr([&queue, &buf]()
+			{
+				queue.on_started(&buf, 1);
+				queue.on_finished(&buf, Tx_token::STATE::DONE, 2);
+			}
+		);
+
+		EXPECT_TRUE(future.wait());
+		isr.join();
+
+		//an aborted write reports false
+		ASSERT_TRUE(future.queue(1, &buf, 3));
+		queue.push(&future);
+		queue.abort_all(4);
+		EXPECT_FALSE(future.wait());
+	}
+}
@@ -0,0 +1,57 @@
+#include "libusb_dev_cpp/util/Buffer_adapter.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <type_traits>
+
+namespace
+{
+	TEST(Buffer_view, not_polymorphic)
+	{
+		EXPECT_FALSE(std::is_polymorphic<Buffer_adapter_base>::value);
+		EXPECT_FALSE(std::is_polymorphic<Buffer_adapter_tx>::value);
+		EXPECT_FALSE(std::is_polymorphic<Buffer_adapter_rx>::value);
+	}
+
+	TEST(Buffer_view, tx_counts_up)
+	{
+		std::array<uint8_t, 4> mem;
+		Buffer_adapter_tx buf(mem.data(), mem.size());
+
+		const uint8_t data[] = {1, 2, 3};
+		EXPECT_EQ(buf.insert(data, sizeof(data)), 3U);
+		EXPECT_EQ(buf.rem_len, 3U);
+
+		EXPECT_EQ(buf.insert(uint8_t(4)), 1U);
+		EXPECT_TRUE(buf.full());
+		EXPECT_EQ(buf.insert(uint8_t(5)), 0U);
+		EXPECT_EQ(buf.insert(data, sizeof(data)), 0U);
+		EXPECT_EQ(buf.rem_len, 4U);
+		EXPECT_EQ(mem[3], 4);
+
+		buf.reset();
+		EXPECT_TRUE(buf.empty());
+		EXPECT_EQ(buf.rem_len, 0U);
+		EXPECT_EQ(buf.curr_ptr, mem.data());
+	}
+
+	TEST(Buffer_view, rx_counts_down)
+	{
+		std::array<uint8_t, 8> mem;
+		Buffer_adapter_rx buf;
+		EXPECT_EQ(buf.max_size(), 0U);
+
+		buf.reset(mem.data(), mem.size());
+		buf.rem_len = 6;
+
+		const uint8_t data[] = {1, 2, 3, 4};
+		EXPECT_EQ(buf.insert(data, sizeof(data)), 4U);
+		EXPECT_EQ(buf.rem_len, 2U);
+		EXPECT_EQ(buf.capacity(), 4U);
+
+		Buffer_adapter_base plain(mem.data(), mem.size());
+		plain.insert(data, sizeof(data));
+		EXPECT_EQ(plain.rem_len, 0U);
+	}
+}
@@ -0,0 +1,201 @@
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+#include "libusb_dev_cpp/util/Lockfree_index_stack.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	//host threads, give up the cpu instead of spinning
+	template<size_t NUM_CH>
+	class Wait_yield
+	{
+	public:
+		void wait(const size_t ch)
+		{
+			std::this_thread::yield();
+		}
+		void notify(const size_t ch)
+		{
+
+		}
+		void notify_isr(const size_t ch)
+		{
+
+		}
+	};
+
+	TEST(EP_buffer_mgr_lockfree, alloc_release)
+	{
+		std::unique_ptr<EP_buffer_mgr_lockfree<2, 4, 64, 32>> mgr = std::make_unique<EP_buffer_mgr_lockfree<2, 4, 64, 32>>();
+
+		std::vector<Buffer_adapter_base*> bufs;
+		for(size_t i = 0; i < 4; i++)
+		{
+			Buffer_adapter_base* buf = mgr->poll_allocate_buffer(1);
+			ASSERT_NE(buf, nullptr);
+			EXPECT_EQ(reinterpret_cast<uintptr_t>(buf->data()) % 32, 0U);
+			EXPECT_EQ(buf->size(), 0U);
+			bufs.push_back(buf);
+		}
+		EXPECT_EQ(mgr->poll_allocate_buffer(1), nullptr);
+
+		//ep 0 has its own pool
+		Buffer_adapter_base* ep0_buf = mgr->poll_allocate_buffer(0);
+		ASSERT_NE(ep0_buf, nullptr);
+
+		//a buffer from another ep is not taken
+		mgr->release_buffer(1, ep0_buf);
+		EXPECT_EQ(mgr->poll_allocate_buffer(1), nullptr);
+
+		mgr->release_buffer(1, bufs[2]);
+		EXPECT_EQ(mgr->poll_allocate_buffer(1), bufs[2]);
+
+		EXPECT_EQ(mgr->poll_allocate_buffer(2), nullptr);
+		EXPECT_FALSE(mgr->set_buffer(2, bufs[0]));
+	}
+
+	TEST(EP_buffer_mgr_lockfree, enqueue_dequeue)
+	{
+		std::unique_ptr<EP_buffer_mgr_lockfree<1, 4, 64, 4>> mgr = std::make_unique<EP_buffer_mgr_lockfree<1, 4, 64, 4>>();
+
+		EXPECT_EQ(mgr->poll_dequeue_buffer(0), nullptr);
+
+		Buffer_adapter_base* a = mgr->poll_allocate_buffer(0);
+		Buffer_adapter_base* b = mgr->poll_allocate_buffer_isr(0);
+		EXPECT_TRUE(mgr->poll_enqueue_buffer(0, a));
+		EXPECT_TRUE(mgr->poll_enqueue_buffer_isr(0, b));
+		EXPECT_FALSE(mgr->poll_enqueue_buffer(0, nullptr));
+
+		EXPECT_EQ(mgr->poll_dequeue_buffer_isr(0), a);
+		EXPECT_EQ(mgr->wait_dequeue_buffer(0), b);
+		EXPECT_EQ(mgr->poll_dequeue_buffer(0), nullptr);
+	}
+
+	TEST(Lockfree_index_stack, stress)
+	{
+		constexpr size_t NUM_IDX     = 8;
+		constexpr size_t NUM_THREADS = 4;
+		constexpr size_t NUM_ITER    = 100000;
+
+		Lockfree_index_stack<NUM_IDX> stack;
+		stack.fill();
+
+		//each index is owned by at most one thread at a time
+		std::array<std::atomic<int>, NUM_IDX> owner;
+		for(std::atomic<int>& o : owner)
+		{
+			o.store(0);
+		}
+		std::atomic<bool> fail(false);
+
+		std::vector<std::thread> threads;
+		for(size_t t = 0; t < NUM_THREADS; t++)
+		{
+			threads.emplace_back([&](){
+				for(size_t i = 0; i < NUM_ITER; i++)
+				{
+					uint16_t idx = 0;
+					if(!stack.pop(&idx))
+					{
+						continue;
+					}
+
+					if(owner[idx].fetch_add(1) != 0)
+					{
+						fail = true;
+					}
+					owner[idx].fetch_sub(1);
+
+					stack.push(idx);
+				}
+			});
+		}
+
+		for(std::thread& t : threads)
+		{
+			t.join();
+		}
+
+		EXPECT_FALSE(fail);
+
+		//nothing lost or duplicated
+		std::array<bool, NUM_IDX> seen {};
+		uint16_t idx = 0;
+		size_t count = 0;
+		while(stack.pop(&idx))
+		{
+			ASSERT_LT(idx, NUM_IDX);
+			EXPECT_FALSE(seen[idx]);
+			seen[idx] = true;
+			count++;
+		}
+		EXPECT_EQ(count, NUM_IDX);
+	}
+
+	TEST(EP_buffer_mgr_lockfree, producer_consumer_stress)
+	{
+		constexpr size_t NUM_EP   = 2;
+		constexpr size_t NUM_ITER = 100000;
+
+		typedef EP_buffer_mgr_lockfree<NUM_EP, 4, 64, 4, Wait_yield> Mgr;
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		std::atomic<bool> fail(false);
+
+		//per ep one producer fills buffers in order, like the driver with OUT packets
+		//and one consumer checks the order and frees them, like the app task
+		std::vector<std::thread> threads;
+		for(uint8_t ep = 0; ep < NUM_EP; ep++)
+		{
+			threads.emplace_back([&, ep](){
+				for(uint32_t i = 0; i < NUM_ITER; i++)
+				{
+					Buffer_adapter_base* buf = mgr->wait_allocate_buffer(ep);
+					buf->insert(reinterpret_cast<const uint8_t*>(&i), sizeof(i));
+					if(!mgr->poll_enqueue_buffer(ep, buf))
+					{
+						fail = true;
+					}
+				}
+			});
+
+			threads.emplace_back([&, ep](){
+				for(uint32_t i = 0; i < NUM_ITER; i++)
+				{
+					Buffer_adapter_base* buf = mgr->wait_dequeue_buffer(ep);
+
+					uint32_t val = 0;
+					std::copy_n(buf->data(), sizeof(val), reinterpret_cast<uint8_t*>(&val));
+					if((buf->size() != sizeof(val)) || (val != i))
+					{
+						fail = true;
+					}
+
+					mgr->release_buffer(ep, buf);
+				}
+			});
+		}
+
+		for(std::thread& t : threads)
+		{
+			t.join();
+		}
+
+		EXPECT_FALSE(fail);
+
+		for(uint8_t ep = 0; ep < NUM_EP; ep++)
+		{
+			EXPECT_EQ(mgr->poll_dequeue_buffer(ep), nullptr);
+			for(size_t i = 0; i < 4; i++)
+			{
+				EXPECT_NE(mgr->poll_allocate_buffer(ep), nullptr);
+			}
+			EXPECT_EQ(mgr->poll_allocate_buffer(ep), nullptr);
+		}
+	}
+}
@@ -0,0 +1,186 @@
+#include "libusb_dev_cpp/util/EP_buffer_mgr_shared.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_lockfree.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef EP_buffer_mgr_shared<3, 8, 64, 4> Mgr;
+
+	TEST(EP_buffer_mgr_shared, set_quota)
+	{
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		EXPECT_EQ(mgr->get_shared_avail(), 8U);
+
+		EXPECT_TRUE(mgr->set_quota(0, 2, 4));
+		EXPECT_TRUE(mgr->set_quota(1, 3, 8));
+		EXPECT_EQ(mgr->get_shared_avail(), 3U);
+
+		EXPECT_FALSE(mgr->set_quota(2, 4, 8));
+		EXPECT_FALSE(mgr->set_quota(2, 2, 1));
+		EXPECT_FALSE(mgr->set_quota(2, 0, 9));
+		EXPECT_FALSE(mgr->set_quota(3, 0, 1));
+
+		EXPECT_TRUE(mgr->set_quota(2, 3, 3));
+		EXPECT_EQ(mgr->get_shared_avail(), 0U);
+	}
+
+	TEST(EP_buffer_mgr_shared, borrow_and_reserve)
+	{
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		ASSERT_TRUE(mgr->set_quota(0, 2, 2));
+		ASSERT_TRUE(mgr->set_quota(1, 1, 8));
+		ASSERT_TRUE(mgr->set_quota(2, 0, 3));
+
+		//ep 1 bursts, its own 1 plus the 5 shared
+		std::vector<Buffer_adapter_base*> ep1;
+		for(;;)
+		{
+			Buffer_adapter_base* buf = mgr->poll_allocate_buffer(1);
+			if(buf == nullptr)
+			{
+				break;
+			}
+			ep1.push_back(buf);
+		}
+		EXPECT_EQ(ep1.size(), 6U);
+		EXPECT_EQ(mgr->get_shared_avail(), 0U);
+
+		//ep 0 still gets its reservation, ep 2 has none and waits for shared
+		Buffer_adapter_base* a = mgr->poll_allocate_buffer(0);
+		Buffer_adapter_base* b = mgr->poll_allocate_buffer(0);
+		EXPECT_NE(a, nullptr);
+		EXPECT_NE(b, nullptr);
+		EXPECT_EQ(mgr->poll_allocate_buffer(0), nullptr);
+		EXPECT_EQ(mgr->poll_allocate_buffer(2), nullptr);
+
+		//borrowed buffers go back to the shared pool
+		mgr->release_buffer(1, ep1.back());
+		ep1.pop_back();
+		EXPECT_EQ(mgr->get_shared_avail(), 1U);
+		EXPECT_EQ(mgr->poll_allocate_buffer(0), nullptr);
+
+		Buffer_adapter_base* c = mgr->poll_allocate_buffer(2);
+		EXPECT_NE(c, nullptr);
+		EXPECT_EQ(mgr->get_used(2), 1U);
+
+		//wrong ep and double release are ignored
+		mgr->release_buffer(0, c);
+		EXPECT_EQ(mgr->get_used(0), 2U);
+		mgr->release_buffer(2, c);
+		mgr->release_buffer(2, c);
+		EXPECT_EQ(mgr->get_used(2), 0U);
+		EXPECT_EQ(mgr->get_shared_avail(), 1U);
+
+		//releasing inside the reservation does not feed the shared pool
+		mgr->release_buffer(0, a);
+		EXPECT_EQ(mgr->get_shared_avail(), 1U);
+		EXPECT_EQ(mgr->poll_allocate_buffer(0), a);
+	}
+
+	TEST(EP_buffer_mgr_shared, max_quota)
+	{
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		ASSERT_TRUE(mgr->set_quota(0, 0, 3));
+
+		for(size_t i = 0; i < 3; i++)
+		{
+			EXPECT_NE(mgr->poll_allocate_buffer(0), nullptr);
+		}
+		EXPECT_EQ(mgr->poll_allocate_buffer(0), nullptr);
+		EXPECT_EQ(mgr->get_shared_avail(), 5U);
+
+		EXPECT_NE(mgr->poll_allocate_buffer(1), nullptr);
+	}
+
+	TEST(EP_buffer_mgr_shared, no_starvation_stress)
+	{
+		constexpr size_t NUM_ITER = 50000;
+
+		typedef EP_buffer_mgr_shared<3, 8, 64, 4> Stress_mgr;
+		std::unique_ptr<Stress_mgr> mgr = std::make_unique<Stress_mgr>();
+
+		ASSERT_TRUE(mgr->set_quota(0, 2, 8));
+		ASSERT_TRUE(mgr->set_quota(1, 2, 8));
+		ASSERT_TRUE(mgr->set_quota(2, 0, 8));
+
+		std::atomic<bool> fail(false);
+		std::atomic<bool> done(false);
+
+		//eps 1 and 2 grab everything they can, hold it for a moment, then let it go
+		std::vector<std::thread> threads;
+		for(uint8_t ep = 1; ep < 3; ep++)
+		{
+			threads.emplace_back([&, ep](){
+				std::vector<Buffer_adapter_base*> held;
+				while(!done)
+				{
+					for(;;)
+					{
+						Buffer_adapter_base* buf = mgr->poll_allocate_buffer(ep);
+						if(buf == nullptr)
+						{
+							break;
+						}
+						held.push_back(buf);
+					}
+
+					std::this_thread::yield();
+
+					for(Buffer_adapter_base* buf : held)
+					{
+						mgr->release_buffer(ep, buf);
+					}
+					held.clear();
+				}
+			});
+		}
+
+		//ep 0 must always get its two
+		threads.emplace_back([&](){
+			for(size_t i = 0; i < NUM_ITER; i++)
+			{
+				Buffer_adapter_base* a = mgr->poll_allocate_buffer(0);
+				Buffer_adapter_base* b = mgr->poll_allocate_buffer(0);
+				if((a == nullptr) || (b == nullptr) || (a == b))
+				{
+					fail = true;
+				}
+
+				mgr->release_buffer(0, a);
+				mgr->release_buffer(0, b);
+
+				std::this_thread::yield();
+			}
+			done = true;
+		});
+
+		for(std::thread& t : threads)
+		{
+			t.join();
+		}
+
+		EXPECT_FALSE(fail);
+
+		//everything came back
+		EXPECT_EQ(mgr->get_shared_avail(), 4U);
+		for(uint8_t ep = 0; ep < 3; ep++)
+		{
+			EXPECT_EQ(mgr->get_used(ep), 0U);
+		}
+	}
+
+	TEST(EP_buffer_mgr_shared, footprint)
+	{
+		//4 eps, 8 buffers in total instead of 4 each
+		EXPECT_LT(sizeof(EP_buffer_mgr_shared<4, 8, 512, 32>), sizeof(EP_buffer_mgr_lockfree<4, 4, 512, 32>));
+	}
+}
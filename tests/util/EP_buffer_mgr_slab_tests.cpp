@@ -0,0 +1,91 @@
+#include "libusb_dev_cpp/util/EP_buffer_mgr_slab.hpp"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+	typedef EP_buffer_mgr_slab<3, 32, EP_buffer_wait_spin, Slab_class<64, 4>, Slab_class<512, 2>, Slab_class<4096, 1>> Mgr;
+
+	TEST(EP_buffer_mgr_slab, size_classes)
+	{
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		EXPECT_EQ(Mgr::TOTAL_BUFFERS, 7U);
+
+		EXPECT_EQ(mgr->get_class_len(1), 64U);
+		EXPECT_EQ(mgr->get_class_len(64), 64U);
+		EXPECT_EQ(mgr->get_class_len(65), 512U);
+		EXPECT_EQ(mgr->get_class_len(4096), 4096U);
+		EXPECT_EQ(mgr->get_class_len(4097), 0U);
+
+		EXPECT_TRUE(mgr->set_ep_buffer_len(1, 8));
+		EXPECT_TRUE(mgr->set_ep_buffer_len(2, 512));
+		EXPECT_FALSE(mgr->set_ep_buffer_len(2, 5000));
+		EXPECT_FALSE(mgr->set_ep_buffer_len(3, 8));
+
+		Buffer_adapter_base* a = mgr->poll_allocate_buffer(1);
+		ASSERT_NE(a, nullptr);
+		EXPECT_EQ(a->max_size(), 64U);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(a->data()) % 32, 0U);
+
+		Buffer_adapter_base* b = mgr->poll_allocate_buffer(2);
+		ASSERT_NE(b, nullptr);
+		EXPECT_EQ(b->max_size(), 512U);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(b->data()) % 32, 0U);
+
+		//per request length
+		Buffer_adapter_base* c = mgr->poll_allocate_buffer(1, 3000);
+		ASSERT_NE(c, nullptr);
+		EXPECT_EQ(c->max_size(), 4096U);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(c->data()) % 32, 0U);
+
+		EXPECT_EQ(mgr->poll_allocate_buffer(1, 5000), nullptr);
+	}
+
+	TEST(EP_buffer_mgr_slab, spill_and_release)
+	{
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		//the 64 byte class runs dry then spills to 512 and 4096
+		std::vector<Buffer_adapter_base*> bufs;
+		for(size_t i = 0; i < 7; i++)
+		{
+			Buffer_adapter_base* buf = mgr->poll_allocate_buffer(0, 8);
+			ASSERT_NE(buf, nullptr);
+			bufs.push_back(buf);
+		}
+		EXPECT_EQ(bufs[3]->max_size(), 64U);
+		EXPECT_EQ(bufs[4]->max_size(), 512U);
+		EXPECT_EQ(bufs[6]->max_size(), 4096U);
+		EXPECT_EQ(mgr->poll_allocate_buffer(0, 8), nullptr);
+
+		//each buffer goes back to its own class
+		mgr->release_buffer(0, bufs[5]);
+		EXPECT_EQ(mgr->poll_allocate_buffer(0, 4096), nullptr);
+		EXPECT_EQ(mgr->poll_allocate_buffer(0, 100), bufs[5]);
+
+		mgr->release_buffer(0, bufs[0]);
+		EXPECT_EQ(mgr->poll_allocate_buffer(0, 1), bufs[0]);
+
+		EP_buffer_array<64, 32> foreign;
+		mgr->release_buffer(0, &foreign);
+		EXPECT_EQ(mgr->poll_allocate_buffer(0, 1), nullptr);
+	}
+
+	TEST(EP_buffer_mgr_slab, enqueue_dequeue)
+	{
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		Buffer_adapter_base* a = mgr->poll_allocate_buffer(2, 10);
+		Buffer_adapter_base* b = mgr->poll_allocate_buffer(2, 1000);
+		EXPECT_TRUE(mgr->poll_enqueue_buffer(2, a));
+		EXPECT_TRUE(mgr->poll_enqueue_buffer_isr(2, b));
+
+		EXPECT_EQ(mgr->poll_dequeue_buffer(1), nullptr);
+		EXPECT_EQ(mgr->wait_dequeue_buffer(2), a);
+		EXPECT_EQ(mgr->poll_dequeue_buffer_isr(2), b);
+	}
+}
@@ -0,0 +1,138 @@
+#include "libusb_dev_cpp/util/EP_buffer_wait_std.hpp"
+#include "libusb_dev_cpp/util/EP_buffer_mgr_shared.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	TEST(EP_buffer_wait_std, wake_on_release)
+	{
+		typedef EP_buffer_mgr_std<1, 2, 64, 4> Mgr;
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		Buffer_adapter_base* a = mgr->poll_allocate_buffer(0);
+		Buffer_adapter_base* b = mgr->poll_allocate_buffer(0);
+		ASSERT_NE(b, nullptr);
+
+		std::atomic<Buffer_adapter_base*> got(nullptr);
+		std::thread waiter([&](){
+			got = mgr->wait_allocate_buffer(0);
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		EXPECT_EQ(got.load(), nullptr);
+
+		mgr->release_buffer(0, a);
+		waiter.join();
+		EXPECT_EQ(got.load(), a);
+	}
+
+	TEST(EP_buffer_wait_std, wake_on_enqueue)
+	{
+		typedef EP_buffer_mgr_std<1, 2, 64, 4> Mgr;
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		std::atomic<Buffer_adapter_base*> got(nullptr);
+		std::thread waiter([&](){
+			got = mgr->wait_dequeue_buffer(0);
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		EXPECT_EQ(got.load(), nullptr);
+
+		Buffer_adapter_base* a = mgr->poll_allocate_buffer(0);
+		EXPECT_TRUE(mgr->poll_enqueue_buffer_isr(0, a));
+		waiter.join();
+		EXPECT_EQ(got.load(), a);
+	}
+
+	TEST(EP_buffer_wait_std, blocking_stream)
+	{
+		constexpr size_t NUM_EP   = 4;
+		constexpr size_t NUM_ITER = 20000;
+
+		typedef EP_buffer_mgr_std<NUM_EP, 2, 64, 4> Mgr;
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		std::atomic<bool> fail(false);
+
+		std::vector<std::thread> threads;
+		for(uint8_t ep = 0; ep < NUM_EP; ep++)
+		{
+			threads.emplace_back([&, ep](){
+				for(uint32_t i = 0; i < NUM_ITER; i++)
+				{
+					Buffer_adapter_base* buf = mgr->wait_allocate_buffer(ep);
+					buf->insert(reinterpret_cast<const uint8_t*>(&i), sizeof(i));
+					if(!mgr->poll_enqueue_buffer(ep, buf))
+					{
+						fail = true;
+					}
+				}
+			});
+
+			threads.emplace_back([&, ep](){
+				for(uint32_t i = 0; i < NUM_ITER; i++)
+				{
+					Buffer_adapter_base* buf = mgr->wait_dequeue_buffer(ep);
+
+					uint32_t val = 0;
+					std::copy_n(buf->data(), sizeof(val), reinterpret_cast<uint8_t*>(&val));
+					if(val != i)
+					{
+						fail = true;
+					}
+
+					mgr->release_buffer(ep, buf);
+				}
+			});
+		}
+
+		for(std::thread& t : threads)
+		{
+			t.join();
+		}
+
+		EXPECT_FALSE(fail);
+	}
+
+	TEST(EP_buffer_wait_std, many_waiters)
+	{
+		constexpr size_t NUM_THREADS = 6;
+		constexpr size_t NUM_ITER    = 5000;
+
+		//more waiters than buffers, every release must reach someone
+		typedef EP_buffer_mgr_shared<2, 2, 64, 4, EP_buffer_wait_std> Mgr;
+		std::unique_ptr<Mgr> mgr = std::make_unique<Mgr>();
+
+		std::atomic<size_t> count(0);
+
+		std::vector<std::thread> threads;
+		for(size_t t = 0; t < NUM_THREADS; t++)
+		{
+			const uint8_t ep = t % 2;
+			threads.emplace_back([&, ep](){
+				for(size_t i = 0; i < NUM_ITER; i++)
+				{
+					Buffer_adapter_base* buf = mgr->wait_allocate_buffer(ep);
+					count++;
+					mgr->release_buffer(ep, buf);
+				}
+			});
+		}
+
+		for(std::thread& t : threads)
+		{
+			t.join();
+		}
+
+		EXPECT_EQ(count.load(), NUM_THREADS * NUM_ITER);
+		EXPECT_EQ(mgr->get_shared_avail(), 2U);
+	}
+}
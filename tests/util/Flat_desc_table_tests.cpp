@@ -0,0 +1,232 @@
+#include "libusb_dev_cpp/util/Descriptor_table.hpp"
+#include "libusb_dev_cpp/util/Flat_desc_table.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	TEST(Flat_desc_table, find)
+	{
+		Flat_desc_table table;
+
+		const uint8_t a[] = {1, 2, 3};
+		const uint8_t b[] = {4, 5};
+
+		EXPECT_TRUE(table.add(0x03, 2, 0x0409, a, sizeof(a)));
+		EXPECT_TRUE(table.add(0x01, 0, 0, b, sizeof(b)));
+		EXPECT_FALSE(table.add(0x01, 0, 0, b, sizeof(b)));
+
+		const uint8_t* ptr = nullptr;
+		size_t len = 0;
+
+		//not usable until finalized
+		EXPECT_FALSE(table.find(0x01, 0, 0, &ptr, &len));
+
+		table.finalize();
+		EXPECT_FALSE(table.add(0x02, 0, 0, b, sizeof(b)));
+
+		ASSERT_TRUE(table.find(0x03, 2, 0x0409, &ptr, &len));
+		ASSERT_EQ(len, 3U);
+		EXPECT_EQ(ptr[2], 3);
+
+		ASSERT_TRUE(table.find(0x01, 0, 0, &ptr, &len));
+		ASSERT_EQ(len, 2U);
+		EXPECT_EQ(ptr[0], 4);
+
+		EXPECT_FALSE(table.find(0x03, 2, 0x0407, &ptr, &len));
+		EXPECT_FALSE(table.find(0x03, 1, 0x0409, &ptr, &len));
+
+		//only the entries of one type
+		size_t count = 0;
+		table.for_each(0x03,
+			[&count](const uint8_t idx, const uint16_t qual, const uint8_t* const ptr, const size_t len)
+			{
+				EXPECT_EQ(idx, 2);
+				EXPECT_EQ(qual, 0x0409);
+				EXPECT_EQ(len, 3U);
+				count++;
+			}
+		);
+		EXPECT_EQ(count, 1U);
+	}
+
+	TEST(Flat_desc_table, build_from_descriptor_table)
+	{
+		Descriptor_table desc_table;
+
+		Device_descriptor dev_desc;
+		dev_desc.bcdUSB             = USB_common::build_bcd(2, 0, 0);
+		dev_desc.bDeviceClass       = 0;
+		dev_desc.bDeviceSubClass    = 0;
+		dev_desc.bDeviceProtocol    = 0;
+		dev_desc.bMaxPacketSize0    = 64;
+		dev_desc.idVendor           = 0x1234;
+		dev_desc.idProduct          = 0x5678;
+		dev_desc.bcdDevice          = USB_common::build_bcd(1, 0, 0);
+		dev_desc.iManufacturer      = 1;
+		dev_desc.iProduct           = 0;
+		dev_desc.iSerialNumber      = 0;
+		dev_desc.bNumConfigurations = 1;
+		desc_table.set_device_descriptor(dev_desc, 0);
+
+		Interface_descriptor iface;
+		iface.bInterfaceNumber   = 0;
+		iface.bAlternateSetting  = 0;
+		iface.bNumEndpoints      = 1;
+		iface.bInterfaceClass    = 0xFF;
+		iface.bInterfaceSubClass = 0;
+		iface.bInterfaceProtocol = 0;
+		iface.iInterface         = 0;
+
+		Endpoint_descriptor ep;
+		ep.bEndpointAddress = 0x81;
+		ep.bmAttributes     = Endpoint_descriptor::build_bmAttributes(Endpoint_descriptor::ATTRIBUTE_TRANSFER::BULK);
+		ep.set_speed_params(64, 0, 512, 0);
+
+		std::shared_ptr<Configuration_descriptor> config = std::make_shared<Configuration_descriptor>();
+		config->bNumInterfaces      = 1;
+		config->bConfigurationValue = 1;
+		config->iConfiguration      = 0;
+		config->bmAttributes        = 0;
+		config->bMaxPower           = 50;
+		config->get_desc_list().push_back(&iface);
+		config->get_desc_list().push_back(&ep);
+		config->wTotalLength = config->get_total_size();
+		desc_table.set_config_descriptor(config, 0);
+
+		String_descriptor_base str;
+		str.assign("Test");
+		desc_table.set_string_descriptor(str, String_descriptor_zero::LANGID::ENUS, 1);
+
+		ASSERT_TRUE(desc_table.build_flat_table());
+		desc_table.release_object_tables();
+
+		const Flat_desc_table& flat = desc_table.get_flat_table();
+		//device, config at both speeds, the string and the generated LANGID list
+		EXPECT_EQ(flat.get_num_entries(), 5U);
+
+		const uint8_t* ptr = nullptr;
+		size_t len = 0;
+
+		ASSERT_TRUE(flat.find(0x01, 0, 0, &ptr, &len));
+		EXPECT_EQ(len, 18U);
+		EXPECT_EQ(ptr[8], 0x34);
+
+		ASSERT_TRUE(flat.find(0x02, 0, static_cast<uint16_t>(USB_common::USB_SPEED::FS), &ptr, &len));
+		ASSERT_EQ(len, 25U);
+		EXPECT_EQ(ptr[22], 64);
+		EXPECT_EQ(ptr[23], 0);
+
+		ASSERT_TRUE(flat.find(0x02, 0, static_cast<uint16_t>(USB_common::USB_SPEED::HS), &ptr, &len));
+		ASSERT_EQ(len, 25U);
+		EXPECT_EQ(ptr[22], 0x00);
+		EXPECT_EQ(ptr[23], 0x02);
+
+		ASSERT_TRUE(flat.find(0x03, 1, 0x0409, &ptr, &len));
+		ASSERT_EQ(len, 10U);
+		EXPECT_EQ(ptr[2], 'T');
+	}
+
+	TEST(Descriptor_table, get_configuration_bytes)
+	{
+		Descriptor_table desc_table;
+
+		Interface_descriptor iface_alt0;
+		iface_alt0.bInterfaceNumber   = 0;
+		iface_alt0.bAlternateSetting  = 0;
+		iface_alt0.bNumEndpoints      = 0;
+		iface_alt0.bInterfaceClass    = 0xFF;
+		iface_alt0.bInterfaceSubClass = 0;
+		iface_alt0.bInterfaceProtocol = 0;
+		iface_alt0.iInterface         = 0;
+
+		Interface_descriptor iface_alt1 = iface_alt0;
+		iface_alt1.bAlternateSetting  = 1;
+		iface_alt1.bNumEndpoints      = 1;
+
+		Endpoint_descriptor ep;
+		ep.bEndpointAddress = 0x81;
+		ep.bmAttributes     = Endpoint_descriptor::build_bmAttributes(Endpoint_descriptor::ATTRIBUTE_TRANSFER::ISOCHRONOUS);
+		ep.set_speed_params(192, 1, 384, 1);
+
+		std::shared_ptr<Configuration_descriptor> config = std::make_shared<Configuration_descriptor>();
+		config->bNumInterfaces      = 1;
+		config->bConfigurationValue = 1;
+		config->iConfiguration      = 0;
+		config->bmAttributes        = 0;
+		config->bMaxPower           = 50;
+		config->get_desc_list().push_back(&iface_alt0);
+		config->get_desc_list().push_back(&iface_alt1);
+		config->get_desc_list().push_back(&ep);
+		config->wTotalLength = config->get_total_size();
+		desc_table.set_config_descriptor(config, 0);
+
+		std::vector<uint8_t> bytes;
+		EXPECT_FALSE(desc_table.get_configuration_bytes(2, USB_common::USB_SPEED::FS, &bytes));
+
+		ASSERT_TRUE(desc_table.get_configuration_bytes(1, USB_common::USB_SPEED::FS, &bytes));
+		ASSERT_EQ(bytes.size(), 34U);
+		EXPECT_EQ(bytes[12], 0);
+		EXPECT_EQ(bytes[21], 1);
+		EXPECT_EQ(bytes[29], 0x81);
+		EXPECT_EQ(bytes[31], 192);
+
+		//same answer once the objects are gone
+		ASSERT_TRUE(desc_table.build_flat_table());
+		desc_table.release_object_tables();
+
+		ASSERT_TRUE(desc_table.get_configuration_bytes(1, USB_common::USB_SPEED::HS, &bytes));
+		ASSERT_EQ(bytes.size(), 34U);
+		EXPECT_EQ(bytes[21], 1);
+		EXPECT_EQ(Byte_util::make_u16(bytes[32], bytes[31]), 384U);
+	}
+
+	TEST(Descriptor_table, get_configuration_bytes_index_gap)
+	{
+		Descriptor_table desc_table;
+
+		Interface_descriptor iface;
+		iface.bInterfaceNumber   = 0;
+		iface.bAlternateSetting  = 0;
+		iface.bNumEndpoints      = 0;
+		iface.bInterfaceClass    = 0xFF;
+		iface.bInterfaceSubClass = 0;
+		iface.bInterfaceProtocol = 0;
+		iface.iInterface         = 0;
+
+		//configurations at index 0 and 2, nothing at 1
+		std::array<std::shared_ptr<Configuration_descriptor>, 2> config;
+		for(size_t i = 0; i < config.size(); i++)
+		{
+			config[i] = std::make_shared<Configuration_descriptor>();
+			config[i]->bNumInterfaces      = 1;
+			config[i]->bConfigurationValue = uint8_t(1 + (i * 2));
+			config[i]->iConfiguration      = 0;
+			config[i]->bmAttributes        = 0;
+			config[i]->bMaxPower           = uint8_t(50 * (i + 1));
+			config[i]->get_desc_list().push_back(&iface);
+			config[i]->wTotalLength = config[i]->get_total_size();
+		}
+		desc_table.set_config_descriptor(config[0], 0);
+		desc_table.set_config_descriptor(config[1], 2);
+
+		ASSERT_TRUE(desc_table.build_flat_table());
+		desc_table.release_object_tables();
+
+		//found in the flat table past the gap, with no objects left to fall back on
+		std::vector<uint8_t> bytes;
+		ASSERT_TRUE(desc_table.get_configuration_bytes(3, USB_common::USB_SPEED::HS, &bytes));
+		ASSERT_EQ(bytes.size(), 18U);
+		EXPECT_EQ(bytes[5], 3);
+		EXPECT_EQ(bytes[8], 100);
+
+		ASSERT_TRUE(desc_table.get_configuration_bytes(1, USB_common::USB_SPEED::FS, &bytes));
+		EXPECT_EQ(bytes[8], 50);
+
+		EXPECT_FALSE(desc_table.get_configuration_bytes(2, USB_common::USB_SPEED::FS, &bytes));
+	}
+}
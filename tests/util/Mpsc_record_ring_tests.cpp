@@ -0,0 +1,126 @@
+#include "libusb_dev_cpp/util/Mpsc_record_ring.hpp"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	TEST(Mpsc_record_ring, split_records)
+	{
+		Mpsc_record_ring<4, 4> ring;
+		EXPECT_EQ(ring.MAX_RECORD_LEN, 16U);
+		EXPECT_TRUE(ring.empty());
+
+		const uint8_t rec[] = {1, 2, 3, 4, 5, 6};
+		EXPECT_TRUE(ring.write(rec, sizeof(rec)));
+		//two slots left
+		EXPECT_FALSE(ring.write(rec, 12));
+		EXPECT_TRUE(ring.write(rec, 1));
+
+		size_t len = 0;
+		const uint8_t* chunk = ring.peek(&len);
+		ASSERT_NE(chunk, nullptr);
+		EXPECT_EQ(len, 4U);
+		EXPECT_EQ(chunk[3], 4);
+		ring.pop();
+
+		chunk = ring.peek(&len);
+		ASSERT_NE(chunk, nullptr);
+		EXPECT_EQ(len, 2U);
+		EXPECT_EQ(chunk[1], 6);
+		ring.pop();
+
+		//wraps
+		EXPECT_TRUE(ring.write(rec, 6));
+
+		chunk = ring.peek(&len);
+		ASSERT_NE(chunk, nullptr);
+		EXPECT_EQ(len, 1U);
+		ring.pop();
+		ring.pop();
+		ring.pop();
+		EXPECT_TRUE(ring.empty());
+
+		EXPECT_FALSE(ring.write(rec, 17));
+	}
+
+	//each producer writes (id, seq) records, the consumer checks none are lost, torn or out of order
+	TEST(Mpsc_record_ring, producers_keep_order)
+	{
+		static constexpr size_t NUM_PRODUCER = 4;
+		static constexpr uint32_t NUM_REC = 20000;
+
+		Mpsc_record_ring<4, 16> ring;
+
+		std::vector<std::thread> producers;
+		for(size_t id = 0; id < NUM_PRODUCER; id++)
+		{
+			producers.emplace_back([&ring, id]()
+				{
+					for(uint32_t seq = 0; seq < NUM_REC; seq++)
+					{
+						//records of 1 or 2 slots
+						std::array<uint8_t, 8> rec;
+						rec.fill(uint8_t(id));
+						rec[1] = uint8_t(seq);
+						rec[2] = uint8_t(seq >> 8);
+						rec[3] = uint8_t(seq >> 16);
+						const size_t len = (seq % 2) ? 8 : 4;
+
+						while(!ring.write(rec.data(), len))
+						{
+							std::this_thread::yield();
+						}
+					}
+				}
+			);
+		}
+
+		std::array<uint32_t, NUM_PRODUCER> next;
+		next.fill(0);
+		size_t total = 0;
+		while(total < (NUM_PRODUCER * NUM_REC))
+		{
+			size_t len = 0;
+			const uint8_t* chunk = ring.peek(&len);
+			if(chunk == nullptr)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			ASSERT_EQ(len, 4U);
+			const uint8_t id = chunk[0];
+			ASSERT_LT(id, NUM_PRODUCER);
+			const uint32_t seq = uint32_t(chunk[1]) | (uint32_t(chunk[2]) << 8) | (uint32_t(chunk[3]) << 16);
+			ASSERT_EQ(seq, next[id]);
+			ring.pop();
+
+			//the second half of an odd record follows right behind, no other producer in between
+			if(seq % 2)
+			{
+				while((chunk = ring.peek(&len)) == nullptr)
+				{
+					std::this_thread::yield();
+				}
+				ASSERT_EQ(len, 4U);
+				EXPECT_EQ(chunk[0], id);
+				EXPECT_EQ(chunk[3], id);
+				ring.pop();
+			}
+
+			next[id]++;
+			total++;
+		}
+
+		for(std::thread& t : producers)
+		{
+			t.join();
+		}
+
+		EXPECT_TRUE(ring.empty());
+	}
+}